@@ -0,0 +1,734 @@
+/*
+ * aksapp.c
+ * ========
+ * 
+ * Implementation of aksapp.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksapp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aksmacro.h"
+
+/* OS-specific headers */
+#ifdef AKS_WIN
+/* Windows headers */
+#include <windows.h>
+
+#else
+/* POSIX headers */
+#include <pthread.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The initial capacity of the pending commit list.
+ */
+#define PEND_INIT (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A record that has been copied but cannot be committed yet, because a
+ * record before it is still being copied.
+ */
+typedef struct {
+  int64_t pos;
+  int64_t end;
+} APP_PEND;
+
+/*
+ * AKSAPP structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSAPP_TAG {
+
+  /*
+   * The next free file offset, which appends advance atomically to
+   * reserve their records.
+   */
+  volatile int64_t tail;
+
+  /*
+   * The length of the file, which only grows, and which appends read
+   * atomically to check that their records fit.
+   */
+  volatile int64_t cap;
+
+  /*
+   * The committed length, which is written while holding the lock but
+   * read atomically at any time.
+   */
+  volatile int64_t commit;
+
+  /*
+   * Non-zero once an append has failed, after which every append fails.
+   */
+  volatile int32_t failed;
+
+  /*
+   * The number of attached writers.
+   */
+  volatile int32_t nwriter;
+
+  /*
+   * The lock that protects growing and the pending list, and the
+   * condition that appends wait on while another thread grows the file.
+   */
+#ifdef AKS_WIN
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE cvGrow;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t cvGrow;
+#endif
+
+  /*
+   * Non-zero while a thread is growing the file.
+   */
+  int growing;
+
+  /*
+   * The growth step in bytes.
+   */
+  int64_t step;
+
+  /*
+   * The records that have been copied but not committed, in no
+   * particular order.
+   * 
+   * pcap is the capacity and npend is the number of records.
+   */
+  APP_PEND *pPend;
+  int32_t pcap;
+  int32_t npend;
+
+  /*
+   * The viewer used to open and trim the file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * A copy of the path, for attaching writers.
+   */
+  char *pPath;
+};
+
+/*
+ * AKSAPPW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSAPPW_TAG {
+
+  /*
+   * The appender this writer is attached to.
+   */
+  AKSAPP *pa;
+
+  /*
+   * The writer's own viewer on the file.
+   */
+  AKSVIEW *pv;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksapp fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksapp warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t load64(volatile int64_t *p);
+static void store64(volatile int64_t *p, int64_t v);
+static int64_t add64(volatile int64_t *p, int64_t d);
+static int32_t load32(volatile int32_t *p);
+static void store32(volatile int32_t *p, int32_t v);
+static int32_t add32(volatile int32_t *p, int32_t d);
+static void lockApp(AKSAPP *pa);
+static void unlockApp(AKSAPP *pa);
+static int growFile(AKSAPPW *pw, int64_t need);
+static void commitRecord(AKSAPP *pa, int64_t pos, int64_t end);
+
+/*
+ * Atomic operations on the shared counters.
+ * 
+ * Loads have acquire semantics and stores have release semantics.  The
+ * additions are sequentially consistent.  add64() and add32() return
+ * the new value.
+ */
+#ifdef AKS_WIN
+
+static int64_t load64(volatile int64_t *p) {
+  return (int64_t) InterlockedCompareExchange64(
+                      (volatile LONG64 *) p, 0, 0);
+}
+
+static void store64(volatile int64_t *p, int64_t v) {
+  InterlockedExchange64((volatile LONG64 *) p, (LONG64) v);
+}
+
+static int64_t add64(volatile int64_t *p, int64_t d) {
+  return ((int64_t) InterlockedExchangeAdd64(
+                      (volatile LONG64 *) p, (LONG64) d)) + d;
+}
+
+static int32_t load32(volatile int32_t *p) {
+  return (int32_t) InterlockedCompareExchange((volatile LONG *) p, 0, 0);
+}
+
+static void store32(volatile int32_t *p, int32_t v) {
+  InterlockedExchange((volatile LONG *) p, (LONG) v);
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return ((int32_t) InterlockedExchangeAdd((volatile LONG *) p, (LONG) d))
+            + d;
+}
+
+#else
+
+static int64_t load64(volatile int64_t *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store64(volatile int64_t *p, int64_t v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int64_t add64(volatile int64_t *p, int64_t d) {
+  return __atomic_add_fetch(p, d, __ATOMIC_SEQ_CST);
+}
+
+static int32_t load32(volatile int32_t *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store32(volatile int32_t *p, int32_t v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return __atomic_add_fetch(p, d, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+/*
+ * Acquire and release the appender lock.
+ * 
+ * Parameters:
+ * 
+ *   pa - the appender
+ */
+static void lockApp(AKSAPP *pa) {
+#ifdef AKS_WIN
+  EnterCriticalSection(&(pa->lock));
+#else
+  if (pthread_mutex_lock(&(pa->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+static void unlockApp(AKSAPP *pa) {
+#ifdef AKS_WIN
+  LeaveCriticalSection(&(pa->lock));
+#else
+  if (pthread_mutex_unlock(&(pa->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+/*
+ * Make sure the file is at least a given length.
+ * 
+ * If another thread is already growing the file, this waits for it.
+ * Otherwise, this thread grows the file through the writer's viewer, by
+ * at least the growth step, without holding the lock, so that appends
+ * whose records already fit are not held up.  If growing fails, the
+ * appender is marked as failed and every waiting append fails too.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ *   need - the minimum length of the file
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be grown
+ */
+static int growFile(AKSAPPW *pw, int64_t need) {
+
+  int status = 1;
+  int ok = 0;
+  AKSAPP *pa = NULL;
+  int64_t newcap = 0;
+
+  /* Check parameters */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  if ((need < 0) || (need > AKSVIEW_MAXLEN)) {
+    fault(__LINE__);
+  }
+  pa = pw->pa;
+
+  lockApp(pa);
+  while (status && (load64(&(pa->cap)) < need)) {
+    if (load32(&(pa->failed))) {
+      /* Another append failed to grow the file */
+      status = 0;
+
+    } else if (pa->growing) {
+      /* Another thread is growing the file, so wait for it */
+#ifdef AKS_WIN
+      if (!SleepConditionVariableCS(&(pa->cvGrow), &(pa->lock), INFINITE)) {
+        fault(__LINE__);
+      }
+#else
+      if (pthread_cond_wait(&(pa->cvGrow), &(pa->lock))) {
+        fault(__LINE__);
+      }
+#endif
+
+    } else {
+      /* Grow the file by at least one step, outside the lock */
+      pa->growing = 1;
+      newcap = load64(&(pa->cap));
+      if (newcap < need) {
+        newcap = need;
+      }
+      if (newcap <= AKSVIEW_MAXLEN - pa->step) {
+        newcap += pa->step;
+      } else {
+        newcap = AKSVIEW_MAXLEN;
+      }
+      unlockApp(pa);
+
+      ok = 0;
+      if (aksview_refresh(pw->pv)) {
+        if (aksview_getlen(pw->pv) >= newcap) {
+          ok = 1;
+        } else {
+          ok = aksview_setlen(pw->pv, newcap);
+        }
+      }
+
+      /* Publish the new length, or the failure, and wake the waiters */
+      lockApp(pa);
+      pa->growing = 0;
+      if (ok) {
+        store64(&(pa->cap), newcap);
+      } else {
+        store32(&(pa->failed), 1);
+        status = 0;
+      }
+#ifdef AKS_WIN
+      WakeAllConditionVariable(&(pa->cvGrow));
+#else
+      if (pthread_cond_broadcast(&(pa->cvGrow))) {
+        fault(__LINE__);
+      }
+#endif
+    }
+  }
+  unlockApp(pa);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Commit a record that has been copied.
+ * 
+ * If the record starts at the committed length, the committed length
+ * moves past it, and then past every pending record that follows on.
+ * Otherwise, the record is added to the pending list, to be committed
+ * when the records before it are.
+ * 
+ * Parameters:
+ * 
+ *   pa - the appender
+ * 
+ *   pos - the file offset of the record
+ * 
+ *   end - the file offset just after the record
+ */
+static void commitRecord(AKSAPP *pa, int64_t pos, int64_t end) {
+
+  APP_PEND *pNew = NULL;
+  int64_t c = 0;
+  int32_t i = 0;
+  int found = 0;
+
+  /* Check parameters */
+  if (pa == NULL) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (end <= pos)) {
+    fault(__LINE__);
+  }
+
+  lockApp(pa);
+  c = load64(&(pa->commit));
+  if (c == pos) {
+    /* Next in order, so advance over it and any pending followers */
+    c = end;
+    do {
+      found = 0;
+      for(i = 0; i < pa->npend; i++) {
+        if ((pa->pPend)[i].pos == c) {
+          c = (pa->pPend)[i].end;
+          (pa->npend)--;
+          (pa->pPend)[i] = (pa->pPend)[pa->npend];
+          found = 1;
+          break;
+        }
+      }
+    } while (found);
+    store64(&(pa->commit), c);
+
+  } else {
+    /* Out of order, so keep it until the records before it commit */
+    if (pa->npend >= pa->pcap) {
+      pNew = (APP_PEND *) realloc(
+                pa->pPend, ((size_t) pa->pcap) * 2 * sizeof(APP_PEND));
+      if (pNew == NULL) {
+        fault(__LINE__);
+      }
+      pa->pPend = pNew;
+      pa->pcap *= 2;
+    }
+    (pa->pPend)[pa->npend].pos = pos;
+    (pa->pPend)[pa->npend].end = end;
+    (pa->npend)++;
+  }
+  unlockApp(pa);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksapp_onerror function.
+ */
+void aksapp_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksapp_errstr function.
+ */
+const char *aksapp_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSAPP_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSAPP_ERR_OPEN:
+      pResult = "Failed to open file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksapp_open function.
+ */
+AKSAPP *aksapp_open(const char *pPath, int64_t step, int *perr) {
+
+  int dummy = 0;
+  AKSAPP *pa = NULL;
+  AKSVIEW *pv = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+  if ((step < AKSAPP_MINSTEP) || (step > AKSVIEW_MAXLEN)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSAPP_ERR_NONE;
+
+  /* Open the file, creating it if necessary */
+  pv = aksview_create(pPath, AKSVIEW_REGULAR | AKSVIEW_SHARE, NULL);
+  if (pv == NULL) {
+    *perr = AKSAPP_ERR_OPEN;
+  }
+
+  /* Allocate the appender, with appends starting at the end */
+  if (pv != NULL) {
+    pa = (AKSAPP *) calloc(1, sizeof(AKSAPP));
+    if (pa == NULL) {
+      fault(__LINE__);
+    }
+    pa->pPath = (char *) malloc(strlen(pPath) + 1);
+    if (pa->pPath == NULL) {
+      fault(__LINE__);
+    }
+    strcpy(pa->pPath, pPath);
+    pa->pcap = PEND_INIT;
+    pa->pPend = (APP_PEND *) malloc(((size_t) pa->pcap) * sizeof(APP_PEND));
+    if (pa->pPend == NULL) {
+      fault(__LINE__);
+    }
+
+    flen = aksview_getlen(pv);
+    pa->pv = pv;
+    pa->step = step;
+    store64(&(pa->tail), flen);
+    store64(&(pa->cap), flen);
+    store64(&(pa->commit), flen);
+
+#ifdef AKS_WIN
+    InitializeCriticalSection(&(pa->lock));
+    InitializeConditionVariable(&(pa->cvGrow));
+#else
+    if (pthread_mutex_init(&(pa->lock), NULL) ||
+        pthread_cond_init(&(pa->cvGrow), NULL)) {
+      fault(__LINE__);
+    }
+#endif
+  }
+
+  /* Return appender or NULL */
+  return pa;
+}
+
+/*
+ * aksapp_close function.
+ */
+int aksapp_close(AKSAPP *pa) {
+
+  int status = 1;
+
+  /* Only proceed if non-NULL value passed */
+  if (pa != NULL) {
+    if (load32(&(pa->nwriter)) != 0) {
+      fault(__LINE__);
+    }
+
+    /* Trim the file to the committed length */
+    if (load32(&(pa->failed))) {
+      status = 0;
+    }
+    if (!aksview_refresh(pa->pv)) {
+      status = 0;
+    } else if (!aksview_setlen(pa->pv, load64(&(pa->commit)))) {
+      status = 0;
+    }
+
+    /* Release the appender */
+    aksview_close(pa->pv);
+#ifdef AKS_WIN
+    DeleteCriticalSection(&(pa->lock));
+#else
+    pthread_cond_destroy(&(pa->cvGrow));
+    pthread_mutex_destroy(&(pa->lock));
+#endif
+    free(pa->pPend);
+    free(pa->pPath);
+    free(pa);
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksapp_attach function.
+ */
+AKSAPPW *aksapp_attach(AKSAPP *pa, int *perr) {
+
+  int dummy = 0;
+  AKSAPPW *pw = NULL;
+  AKSVIEW *pv = NULL;
+
+  /* Check parameter */
+  if (pa == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSAPP_ERR_NONE;
+
+  /* Open the writer's own viewer */
+  pv = aksview_create(pa->pPath, AKSVIEW_EXISTING | AKSVIEW_SHARE, NULL);
+  if (pv == NULL) {
+    *perr = AKSAPP_ERR_OPEN;
+  }
+
+  /* Allocate the writer */
+  if (pv != NULL) {
+    pw = (AKSAPPW *) calloc(1, sizeof(AKSAPPW));
+    if (pw == NULL) {
+      fault(__LINE__);
+    }
+    pw->pa = pa;
+    pw->pv = pv;
+    add32(&(pa->nwriter), 1);
+  }
+
+  /* Return writer or NULL */
+  return pw;
+}
+
+/*
+ * aksapp_detach function.
+ */
+void aksapp_detach(AKSAPPW *pw) {
+  if (pw != NULL) {
+    aksview_close(pw->pv);
+    add32(&(pw->pa->nwriter), -1);
+    free(pw);
+  }
+}
+
+/*
+ * aksapp_append function.
+ */
+int64_t aksapp_append(AKSAPPW *pw, const void *pData, int64_t len) {
+
+  int status = 1;
+  AKSAPP *pa = NULL;
+  int64_t pos = -1;
+  int64_t end = 0;
+
+  /* Check parameters */
+  if ((pw == NULL) || ((pData == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSVIEW_MAXLEN)) {
+    fault(__LINE__);
+  }
+  pa = pw->pa;
+
+  /* Fail at once if an earlier append failed */
+  if (load32(&(pa->failed))) {
+    status = 0;
+  }
+
+  /* Reserve the record by advancing the tail */
+  if (status) {
+    end = add64(&(pa->tail), len);
+    pos = end - len;
+    if (end > AKSVIEW_MAXLEN) {
+      store32(&(pa->failed), 1);
+      status = 0;
+    }
+  }
+
+  /* Only proceed with a non-empty record */
+  if (status && (len > 0)) {
+
+    /* Make sure the file is long enough, and that this writer's viewer
+     * knows it */
+    if (load64(&(pa->cap)) < end) {
+      status = growFile(pw, end);
+    }
+    if (status && (aksview_getlen(pw->pv) < end)) {
+      if (!aksview_refresh(pw->pv)) {
+        store32(&(pa->failed), 1);
+        status = 0;
+      }
+    }
+
+    /* Copy the record, then commit it */
+    if (status) {
+      aksview_writebuf(pw->pv, pos, pData, len);
+      commitRecord(pa, pos, end);
+    }
+  }
+
+  /* Return the file offset or -1 */
+  if (!status) {
+    pos = -1;
+  }
+  return pos;
+}
+
+/*
+ * aksapp_committed function.
+ */
+int64_t aksapp_committed(AKSAPP *pa) {
+
+  /* Check parameter */
+  if (pa == NULL) {
+    fault(__LINE__);
+  }
+
+  return load64(&(pa->commit));
+}
@@ -0,0 +1,212 @@
+#ifndef AKSAPP_H_INCLUDED
+#define AKSAPP_H_INCLUDED
+
+/*
+ * aksapp.h
+ * ========
+ * 
+ * Concurrent appending to an AKSView file from many threads, with an
+ * in-order committed length for readers.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The minimum number of bytes by which the file is grown at a time.
+ */
+#define AKSAPP_MINSTEP (INT64_C(1048576))
+
+/*
+ * Structure prototypes for AKSAPP and AKSAPPW.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSAPP_TAG;
+typedef struct AKSAPP_TAG AKSAPP;
+
+struct AKSAPPW_TAG;
+typedef struct AKSAPPW_TAG AKSAPPW;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksapp_errstr() to convert these to error messages.
+ */
+#define AKSAPP_ERR_NONE (0)
+#define AKSAPP_ERR_OPEN (1)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksapp.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksapp_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSAPP_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksapp_errstr(int code);
+
+/*
+ * Open a file for concurrent appending.
+ * 
+ * The file at pPath is created if it does not exist.  Appends start at
+ * the current end of the file, so an existing file should have been
+ * trimmed by aksapp_close() when it was last appended to.
+ * 
+ * The file is grown step bytes at a time, which must be at least
+ * AKSAPP_MINSTEP.  Larger steps mean fewer growths, each of which
+ * briefly holds up the threads that need the new space.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSAPP_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the file
+ * 
+ *   step - the growth step in bytes
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new appender, or NULL if the function failed
+ */
+AKSAPP *aksapp_open(const char *pPath, int64_t step, int *perr);
+
+/*
+ * Close an appender.
+ * 
+ * Every writer must have been detached first.  The file is trimmed to
+ * the committed length, and the appender is released.
+ * 
+ * If NULL is passed, nothing is done and the function succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pa - the appender, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if an append failed earlier or the file
+ *   could not be trimmed
+ */
+int aksapp_close(AKSAPP *pa);
+
+/*
+ * Attach a writer to an appender.
+ * 
+ * Each thread that appends needs its own writer, which holds its own
+ * viewer on the file, so that threads copy their records in parallel.
+ * A writer may only be used by one thread at a time.  This function may
+ * be called from any thread.
+ * 
+ * perr works in the same way as for aksapp_open().
+ * 
+ * Parameters:
+ * 
+ *   pa - the appender
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new writer, or NULL if the function failed
+ */
+AKSAPPW *aksapp_attach(AKSAPP *pa, int *perr);
+
+/*
+ * Detach a writer from its appender and release it.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer, or NULL
+ */
+void aksapp_detach(AKSAPPW *pw);
+
+/*
+ * Append a record to the file.
+ * 
+ * The space for the record is reserved by atomically advancing the
+ * shared tail, so the records of concurrent appends never overlap and
+ * each is contiguous.  The record is then copied into the file without
+ * any lock.  If the file is not yet long enough, one thread grows it by
+ * the step while the threads whose records already fit carry on.
+ * 
+ * When the copy is done, the record is committed.  The committed length
+ * only advances over records in file order, so it never moves past a
+ * record that is still being copied.
+ * 
+ * If the file cannot be grown, the function fails, and so does every
+ * later append to the same appender, since the committed length can no
+ * longer advance past the missing record.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ *   pData - the record
+ * 
+ *   len - the length of the record in bytes, zero or greater
+ * 
+ * Return:
+ * 
+ *   the file offset of the record, or -1 if the function failed
+ */
+int64_t aksapp_append(AKSAPPW *pw, const void *pData, int64_t len);
+
+/*
+ * Get the committed length of the file.
+ * 
+ * Every byte before this file offset belongs to a record that has been
+ * completely copied, and is visible to viewers on the file in any
+ * thread or process that maps it.  This function may be called from any
+ * thread at any time.
+ * 
+ * Parameters:
+ * 
+ *   pa - the appender
+ * 
+ * Return:
+ * 
+ *   the committed length
+ */
+int64_t aksapp_committed(AKSAPP *pa);
+
+#endif
@@ -0,0 +1,727 @@
+/*
+ * aksblob.c
+ * =========
+ * 
+ * Implementation of aksblob.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksblob.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic numbers at the start of the data and index files.
+ * 
+ * These are stored as little-endian 64-bit integers, so that the files
+ * begin with the ASCII strings "AKSBLOBD" and "AKSBLOBI".
+ */
+#define DATA_MAGIC  (UINT64_C(0x44424f4c42534b41))
+#define INDEX_MAGIC (UINT64_C(0x49424f4c42534b41))
+
+/*
+ * Data file header layout.
+ * 
+ * The header holds the magic number and the logical end of the data,
+ * which is the file offset immediately after the last blob.  The file
+ * itself may be longer than this while it is open for writing.
+ */
+#define DATA_OFF_MAGIC (0)
+#define DATA_OFF_END   (8)
+#define DATA_HEADER    (16)
+
+/*
+ * Index file header layout.
+ * 
+ * The header holds the magic number, the number of allocated blob IDs,
+ * and the number of bytes in the data file occupied by deleted blobs.
+ */
+#define INDEX_OFF_MAGIC (0)
+#define INDEX_OFF_COUNT (8)
+#define INDEX_OFF_DEAD  (16)
+#define INDEX_HEADER    (32)
+
+/*
+ * Index record layout.
+ * 
+ * Each record holds the 64-bit offset of the blob in the data file, the
+ * 32-bit length of the blob, and 32 bits of flags.
+ */
+#define REC_OFF_POS   (0)
+#define REC_OFF_LEN   (8)
+#define REC_OFF_FLAGS (12)
+#define REC_SIZE      (16)
+
+/*
+ * Flags that can be used in the flags field of an index record.
+ */
+#define RECF_DEL (1)  /* Tombstone for deleted blob */
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSBLOB structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSBLOB_TAG {
+
+  /*
+   * The viewer on the data file.
+   */
+  AKSVIEW *pData;
+
+  /*
+   * The viewer on the index file.
+   */
+  AKSVIEW *pIndex;
+
+  /*
+   * The logical end of the data file.
+   * 
+   * Always at least DATA_HEADER.  This is a cached copy of the value in
+   * the data file header.
+   */
+  int64_t dend;
+
+  /*
+   * The number of allocated blob IDs.
+   * 
+   * This is a cached copy of the value in the index file header.
+   */
+  int64_t count;
+
+  /*
+   * The number of bytes occupied by deleted blobs.
+   * 
+   * This is a cached copy of the value in the index file header.
+   */
+  int64_t dead;
+};
+
+/*
+ * Static data
+ * ===========
+ */
+
+/*
+ * Target for the pointer returned for zero-length blobs.
+ */
+static const uint8_t m_empty = 0;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksblob fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksblob warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int initFiles(AKSBLOB *pb);
+static int loadHeaders(AKSBLOB *pb);
+
+/*
+ * Initialize an empty blob store in the data and index files.
+ * 
+ * Both files must be writable and empty.  The cached fields in the
+ * structure are also initialized.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the files could not be resized
+ */
+static int initFiles(AKSBLOB *pb) {
+
+  int status = 1;
+
+  /* Check parameter */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Size the files to hold just the headers */
+  if (!aksview_setlen(pb->pData, DATA_HEADER)) {
+    status = 0;
+  }
+  if (status) {
+    if (!aksview_setlen(pb->pIndex, INDEX_HEADER)) {
+      status = 0;
+    }
+  }
+
+  /* Write the headers */
+  if (status) {
+    aksview_write64u(pb->pData, DATA_OFF_MAGIC, 1, DATA_MAGIC);
+    aksview_write64s(pb->pData, DATA_OFF_END, 1, DATA_HEADER);
+
+    aksview_write64u(pb->pIndex, INDEX_OFF_MAGIC, 1, INDEX_MAGIC);
+    aksview_write64s(pb->pIndex, INDEX_OFF_COUNT, 1, 0);
+    aksview_write64s(pb->pIndex, INDEX_OFF_DEAD, 1, 0);
+    aksview_write64s(pb->pIndex, INDEX_OFF_DEAD + 8, 1, 0);
+
+    pb->dend = DATA_HEADER;
+    pb->count = 0;
+    pb->dead = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Load and verify the headers of an existing blob store.
+ * 
+ * The cached fields in the structure are initialized from the headers.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the files are not a valid blob
+ *   store
+ */
+static int loadHeaders(AKSBLOB *pb) {
+
+  int status = 1;
+
+  /* Check parameter */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Check that headers are present and have the right magic numbers */
+  if ((aksview_getlen(pb->pData) < DATA_HEADER) ||
+      (aksview_getlen(pb->pIndex) < INDEX_HEADER)) {
+    status = 0;
+  }
+  if (status) {
+    if ((aksview_read64u(pb->pData, DATA_OFF_MAGIC, 1) != DATA_MAGIC) ||
+        (aksview_read64u(pb->pIndex, INDEX_OFF_MAGIC, 1)
+          != INDEX_MAGIC)) {
+      status = 0;
+    }
+  }
+
+  /* Read the header fields */
+  if (status) {
+    pb->dend = aksview_read64s(pb->pData, DATA_OFF_END, 1);
+    pb->count = aksview_read64s(pb->pIndex, INDEX_OFF_COUNT, 1);
+    pb->dead = aksview_read64s(pb->pIndex, INDEX_OFF_DEAD, 1);
+  }
+
+  /* Check that the header fields are consistent with the files */
+  if (status) {
+    if ((pb->dend < DATA_HEADER) ||
+        (pb->dend > aksview_getlen(pb->pData))) {
+      status = 0;
+    }
+  }
+  if (status) {
+    if ((pb->count < 0) ||
+        (pb->count > (aksview_getlen(pb->pIndex) - INDEX_HEADER)
+                        / REC_SIZE)) {
+      status = 0;
+    }
+  }
+  if (status) {
+    if ((pb->dead < 0) || (pb->dead > pb->dend - DATA_HEADER)) {
+      status = 0;
+    }
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksblob_onerror function.
+ */
+void aksblob_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksblob_errstr function.
+ */
+const char *aksblob_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSBLOB_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSBLOB_ERR_BADMODE:
+      pResult = "Invalid blob store open mode";
+      break;
+
+    case AKSBLOB_ERR_OPEN:
+      pResult = "Failed to open blob store file";
+      break;
+
+    case AKSBLOB_ERR_FORMAT:
+      pResult = "Blob store files have invalid format";
+      break;
+
+    case AKSBLOB_ERR_RESIZE:
+      pResult = "Failed to resize blob store file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksblob_open function.
+ */
+AKSBLOB *aksblob_open(
+    const char * pDataPath,
+    const char * pIndexPath,
+    int          mode,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSBLOB *pb = NULL;
+
+  /* Check parameters */
+  if ((pDataPath == NULL) || (pIndexPath == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+
+  /* Reset error return code */
+  *perr = AKSBLOB_ERR_NONE;
+
+  /* Check that mode is recognized */
+  if ((mode != AKSVIEW_READONLY) &&
+      (mode != AKSVIEW_EXISTING) &&
+      (mode != AKSVIEW_REGULAR) &&
+      (mode != AKSVIEW_EXCLUSIVE)) {
+    status = 0;
+    *perr = AKSBLOB_ERR_BADMODE;
+  }
+
+  /* Allocate new blob store structure */
+  if (status) {
+    pb = (AKSBLOB *) calloc(1, sizeof(AKSBLOB));
+    if (pb == NULL) {
+      fault(__LINE__);
+    }
+    pb->pData = NULL;
+    pb->pIndex = NULL;
+  }
+
+  /* Open the viewers */
+  if (status) {
+    pb->pData = aksview_create(pDataPath, mode, NULL);
+    if (pb->pData == NULL) {
+      status = 0;
+      *perr = AKSBLOB_ERR_OPEN;
+    }
+  }
+  if (status) {
+    pb->pIndex = aksview_create(pIndexPath, mode, NULL);
+    if (pb->pIndex == NULL) {
+      status = 0;
+      *perr = AKSBLOB_ERR_OPEN;
+    }
+  }
+
+  /* If both files are empty and writable, initialize a new store;
+   * otherwise, load the existing store */
+  if (status) {
+    if ((aksview_getlen(pb->pData) == 0) &&
+        (aksview_getlen(pb->pIndex) == 0) &&
+        (mode != AKSVIEW_READONLY)) {
+      if (!initFiles(pb)) {
+        status = 0;
+        *perr = AKSBLOB_ERR_RESIZE;
+      }
+
+    } else {
+      if (!loadHeaders(pb)) {
+        status = 0;
+        *perr = AKSBLOB_ERR_FORMAT;
+      }
+    }
+  }
+
+  /* If function failed, close any viewers and release structure */
+  if (!status) {
+    if (pb != NULL) {
+      aksview_close(pb->pData);
+      aksview_close(pb->pIndex);
+      free(pb);
+      pb = NULL;
+    }
+  }
+
+  /* Return structure or NULL */
+  return pb;
+}
+
+/*
+ * aksblob_close function.
+ */
+void aksblob_close(AKSBLOB *pb) {
+
+  /* Only proceed if non-NULL value passed */
+  if (pb != NULL) {
+
+    /* If writable, trim files to exactly the length in use */
+    if (aksview_writable(pb->pData)) {
+      if (!aksview_setlen(pb->pData, pb->dend)) {
+        warn(__LINE__);
+      }
+      if (!aksview_setlen(pb->pIndex,
+                INDEX_HEADER + (pb->count * REC_SIZE))) {
+        warn(__LINE__);
+      }
+    }
+
+    /* Close viewers and release structure */
+    aksview_close(pb->pData);
+    aksview_close(pb->pIndex);
+    free(pb);
+  }
+}
+
+/*
+ * aksblob_count function.
+ */
+int64_t aksblob_count(AKSBLOB *pb) {
+
+  /* Check parameter */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Return cached value */
+  return pb->count;
+}
+
+/*
+ * aksblob_dead function.
+ */
+int64_t aksblob_dead(AKSBLOB *pb) {
+
+  /* Check parameter */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Return cached value */
+  return pb->dead;
+}
+
+/*
+ * aksblob_put function.
+ */
+int64_t aksblob_put(AKSBLOB *pb, const void *pData, int32_t len) {
+
+  int64_t result = -1;
+  int64_t rpos = 0;
+
+  /* Check parameters */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSBLOB_MAXBLOB)) {
+    fault(__LINE__);
+  }
+  if ((pData == NULL) && (len > 0)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pb->pData)) {
+    fault(__LINE__);
+  }
+  if (pb->dend > AKSVIEW_MAXLEN - ((int64_t) len)) {
+    fault(__LINE__);
+  }
+
+  /* Figure out where the new index record goes */
+  rpos = INDEX_HEADER + (pb->count * REC_SIZE);
+
+  /* Make room in both files */
+  if (aksview_reserve(pb->pData, pb->dend + ((int64_t) len)) &&
+      aksview_reserve(pb->pIndex, rpos + REC_SIZE)) {
+
+    /* Write the blob data, then the new logical end of data, so that
+     * the data is in place before anything refers to it */
+    aksview_writebuf(pb->pData, pb->dend, pData, (int64_t) len);
+    aksview_write64s(pb->pData, DATA_OFF_END, 1,
+                      pb->dend + ((int64_t) len));
+
+    /* Write the index record, then the new count */
+    aksview_write64s(pb->pIndex, rpos + REC_OFF_POS, 1, pb->dend);
+    aksview_write32s(pb->pIndex, rpos + REC_OFF_LEN, 1, len);
+    aksview_write32u(pb->pIndex, rpos + REC_OFF_FLAGS, 1, 0);
+    aksview_write64s(pb->pIndex, INDEX_OFF_COUNT, 1, pb->count + 1);
+
+    /* Update cached state */
+    result = pb->count;
+    pb->dend += (int64_t) len;
+    (pb->count)++;
+  }
+
+  /* Return new ID or -1 */
+  return result;
+}
+
+/*
+ * aksblob_get function.
+ */
+const uint8_t *aksblob_get(AKSBLOB *pb, int64_t id, int32_t *plen) {
+
+  const uint8_t *pResult = NULL;
+  int64_t rpos = 0;
+  int64_t dpos = 0;
+  int32_t len = 0;
+
+  /* Check parameters */
+  if ((pb == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+  if ((id < 0) || (id >= pb->count)) {
+    fault(__LINE__);
+  }
+
+  /* Look up the index record */
+  rpos = INDEX_HEADER + (id * REC_SIZE);
+  if (aksview_read32u(pb->pIndex, rpos + REC_OFF_FLAGS, 1) & RECF_DEL) {
+    /* Deleted blob */
+    *plen = -1;
+
+  } else {
+    /* Get position and length of blob and check them */
+    dpos = aksview_read64s(pb->pIndex, rpos + REC_OFF_POS, 1);
+    len = aksview_read32s(pb->pIndex, rpos + REC_OFF_LEN, 1);
+    if ((len < 0) || (len > AKSBLOB_MAXBLOB) ||
+        (dpos < DATA_HEADER) || (dpos > pb->dend - ((int64_t) len))) {
+      fault(__LINE__);
+    }
+
+    /* Map the blob as a span, except for empty blobs */
+    if (len > 0) {
+      pResult = aksview_rspan(pb->pData, dpos, len);
+    } else {
+      pResult = &m_empty;
+    }
+    *plen = len;
+  }
+
+  /* Return result */
+  return pResult;
+}
+
+/*
+ * aksblob_del function.
+ */
+void aksblob_del(AKSBLOB *pb, int64_t id) {
+
+  int64_t rpos = 0;
+  uint32_t f = 0;
+
+  /* Check parameters */
+  if (pb == NULL) {
+    fault(__LINE__);
+  }
+  if ((id < 0) || (id >= pb->count)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pb->pIndex)) {
+    fault(__LINE__);
+  }
+
+  /* Only proceed if not already deleted */
+  rpos = INDEX_HEADER + (id * REC_SIZE);
+  f = aksview_read32u(pb->pIndex, rpos + REC_OFF_FLAGS, 1);
+  if (!(f & RECF_DEL)) {
+
+    /* Account for the dead bytes */
+    pb->dead += (int64_t) aksview_read32s(
+                              pb->pIndex, rpos + REC_OFF_LEN, 1);
+    aksview_write64s(pb->pIndex, INDEX_OFF_DEAD, 1, pb->dead);
+
+    /* Write the tombstone */
+    aksview_write32u(pb->pIndex, rpos + REC_OFF_FLAGS, 1, f | RECF_DEL);
+  }
+}
+
+/*
+ * aksblob_compact function.
+ */
+int aksblob_compact(
+    const char * pDataPath,
+    const char * pIndexPath,
+    const char * pNewDataPath,
+    const char * pNewIndexPath,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSBLOB *pOld = NULL;
+  AKSBLOB *pNew = NULL;
+  int64_t id = 0;
+  int64_t rpos = 0;
+  int64_t spos = 0;
+  int32_t len = 0;
+  uint32_t f = 0;
+
+  /* Check parameters */
+  if ((pDataPath == NULL) || (pIndexPath == NULL) ||
+      (pNewDataPath == NULL) || (pNewIndexPath == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSBLOB_ERR_NONE;
+
+  /* Open the old store read-only and create the new store */
+  pOld = aksblob_open(pDataPath, pIndexPath, AKSVIEW_READONLY, perr);
+  if (pOld == NULL) {
+    status = 0;
+  }
+  if (status) {
+    pNew = aksblob_open(
+              pNewDataPath, pNewIndexPath, AKSVIEW_EXCLUSIVE, perr);
+    if (pNew == NULL) {
+      status = 0;
+    }
+  }
+
+  /* Size the new files exactly, so that copying never has to resize
+   * and remap */
+  if (status) {
+    if (!aksview_setlen(pNew->pData,
+            pOld->dend - pOld->dead)) {
+      status = 0;
+      *perr = AKSBLOB_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    if (!aksview_setlen(pNew->pIndex,
+            INDEX_HEADER + (pOld->count * REC_SIZE))) {
+      status = 0;
+      *perr = AKSBLOB_ERR_RESIZE;
+    }
+  }
+
+  /* Copy each live blob and rewrite each index record */
+  if (status) {
+    for(id = 0; id < pOld->count; id++) {
+      rpos = INDEX_HEADER + (id * REC_SIZE);
+      f = aksview_read32u(pOld->pIndex, rpos + REC_OFF_FLAGS, 1);
+
+      if (f & RECF_DEL) {
+        /* Deleted blob, so just write a tombstone */
+        aksview_write64s(pNew->pIndex, rpos + REC_OFF_POS, 1, 0);
+        aksview_write32s(pNew->pIndex, rpos + REC_OFF_LEN, 1, 0);
+
+      } else {
+        /* Live blob, so copy it to the end of the new data */
+        spos = aksview_read64s(pOld->pIndex, rpos + REC_OFF_POS, 1);
+        len = aksview_read32s(pOld->pIndex, rpos + REC_OFF_LEN, 1);
+        if ((len < 0) || (spos < DATA_HEADER) ||
+            (spos > pOld->dend - ((int64_t) len)) ||
+            (pNew->dend > aksview_getlen(pNew->pData)
+                            - ((int64_t) len))) {
+          fault(__LINE__);
+        }
+
+        aksview_copy(
+          pNew->pData, pNew->dend, pOld->pData, spos, (int64_t) len);
+
+        aksview_write64s(pNew->pIndex, rpos + REC_OFF_POS, 1,
+                          pNew->dend);
+        aksview_write32s(pNew->pIndex, rpos + REC_OFF_LEN, 1, len);
+        pNew->dend += (int64_t) len;
+      }
+      aksview_write32u(pNew->pIndex, rpos + REC_OFF_FLAGS, 1, f);
+    }
+
+    /* Write the new headers */
+    pNew->count = pOld->count;
+    aksview_write64s(pNew->pData, DATA_OFF_END, 1, pNew->dend);
+    aksview_write64s(pNew->pIndex, INDEX_OFF_COUNT, 1, pNew->count);
+  }
+
+  /* Close the stores */
+  aksblob_close(pOld);
+  aksblob_close(pNew);
+
+  /* Return status */
+  return status;
+}
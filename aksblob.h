@@ -0,0 +1,296 @@
+#ifndef AKSBLOB_H_INCLUDED
+#define AKSBLOB_H_INCLUDED
+
+/*
+ * aksblob.h
+ * =========
+ * 
+ * Variable-length blob store built on top of AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum length in bytes of a single blob.
+ * 
+ * This is limited to the maximum span length so that blobs can always
+ * be returned as a single span directly into the mapped data file.
+ */
+#define AKSBLOB_MAXBLOB AKSVIEW_MAXSPAN
+
+/*
+ * Structure prototype for AKSBLOB.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSBLOB_TAG;
+typedef struct AKSBLOB_TAG AKSBLOB;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksblob_errstr() to convert these to error messages.
+ */
+#define AKSBLOB_ERR_NONE    (0)
+#define AKSBLOB_ERR_BADMODE (1)
+#define AKSBLOB_ERR_OPEN    (2)
+#define AKSBLOB_ERR_FORMAT  (3)
+#define AKSBLOB_ERR_RESIZE  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksblob.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksblob_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSBLOB_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksblob_errstr(int code);
+
+/*
+ * Open a blob store.
+ * 
+ * A blob store consists of two files.  The data file holds the contents
+ * of all the blobs, appended one after the other.  The index file holds
+ * a fixed-width record for each blob that gives its offset and length
+ * in the data file.  Blobs are identified by their zero-based position
+ * in the index file.
+ * 
+ * mode is one of the AKSVIEW_ modes accepted by aksview_create(), and
+ * it is applied to both files.  If both files are empty when they are
+ * opened (which is always the case for newly created files), a new,
+ * empty blob store is initialized in them, unless the mode is
+ * AKSVIEW_READONLY in which case the open fails with a format error.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSBLOB_ERR_ constants.
+ * 
+ * If a blob store is successfully opened, you should close it
+ * eventually with aksblob_close().
+ * 
+ * Parameters:
+ * 
+ *   pDataPath - path to the data file
+ * 
+ *   pIndexPath - path to the index file
+ * 
+ *   mode - the file mode for opening
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new blob store object or NULL if the function failed
+ */
+AKSBLOB *aksblob_open(
+    const char * pDataPath,
+    const char * pIndexPath,
+    int          mode,
+    int        * perr);
+
+/*
+ * Close a blob store.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * For writable stores, the files are trimmed to exactly the length that
+ * is in use before being closed, since they are grown in large steps
+ * while blobs are appended.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store, or NULL
+ */
+void aksblob_close(AKSBLOB *pb);
+
+/*
+ * Get the number of blob IDs that have been allocated in the store.
+ * 
+ * Valid blob IDs are in range zero up to one less than this count.
+ * Deleted blobs keep their IDs, so this count includes them.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ * Return:
+ * 
+ *   the number of allocated blob IDs
+ */
+int64_t aksblob_count(AKSBLOB *pb);
+
+/*
+ * Get the total number of bytes in the data file that are occupied by
+ * deleted blobs.
+ * 
+ * This is the amount of space that aksblob_compact() would reclaim, so
+ * clients can use it to decide when compaction is worthwhile.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ * Return:
+ * 
+ *   the number of bytes occupied by deleted blobs
+ */
+int64_t aksblob_dead(AKSBLOB *pb);
+
+/*
+ * Append a new blob to the store.
+ * 
+ * A fault occurs if the store was opened read-only.
+ * 
+ * pData points to the contents of the blob and len is its length in
+ * bytes.  len must be in range [0, AKSBLOB_MAXBLOB].  pData may be NULL
+ * only if len is zero.
+ * 
+ * The files are grown with aksview_reserve() as necessary, so appending
+ * is amortized constant time.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ *   pData - the blob contents
+ * 
+ *   len - the length of the blob in bytes
+ * 
+ * Return:
+ * 
+ *   the ID of the new blob, or -1 if the files could not be enlarged
+ */
+int64_t aksblob_put(AKSBLOB *pb, const void *pData, int32_t len);
+
+/*
+ * Get a blob from the store.
+ * 
+ * id must be a valid blob ID, in range zero up to one less than
+ * aksblob_count(), or a fault occurs.
+ * 
+ * If the blob exists, a pointer directly into the mapped data file is
+ * returned, and its length is written to *plen.  No copy is made, so
+ * the cost of this call is one index lookup plus mapping one span of
+ * the data file.  If the blob has been deleted, NULL is returned and
+ * *plen is set to -1.
+ * 
+ * Zero-length blobs return a valid pointer that must not be
+ * dereferenced.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to
+ * any function on the same blob store.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ *   id - the blob ID
+ * 
+ *   plen - receives the length of the blob
+ * 
+ * Return:
+ * 
+ *   pointer to the blob data, or NULL if the blob was deleted
+ */
+const uint8_t *aksblob_get(AKSBLOB *pb, int64_t id, int32_t *plen);
+
+/*
+ * Delete a blob from the store.
+ * 
+ * A fault occurs if the store was opened read-only, or if id is not a
+ * valid blob ID.  Deleting a blob that has already been deleted does
+ * nothing.
+ * 
+ * Deletion only writes a tombstone flag into the index record.  The
+ * blob's bytes remain in the data file until the store is compacted
+ * with aksblob_compact().  The blob ID is never reused.
+ * 
+ * Parameters:
+ * 
+ *   pb - the blob store
+ * 
+ *   id - the blob ID to delete
+ */
+void aksblob_del(AKSBLOB *pb, int64_t id);
+
+/*
+ * Compact a blob store into a new pair of files.
+ * 
+ * The store at pDataPath and pIndexPath is opened read-only, and every
+ * blob that has not been deleted is copied into a new store at
+ * pNewDataPath and pNewIndexPath using aksview_copy().  The new files
+ * must not already exist.  Blob IDs are preserved, with deleted blobs
+ * remaining deleted in the new store, so the new store can replace the
+ * old one (for example, by renaming the files) without invalidating any
+ * IDs held by clients.
+ * 
+ * This function only uses viewer objects that it opens itself, so it is
+ * safe to run it on a background thread while other threads continue
+ * reading the old store through their own blob store objects.  However,
+ * the old store must not be modified while compaction is running.
+ * 
+ * If the function fails, the new files may have been partially written
+ * and should be deleted by the caller.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksblob_open().
+ * 
+ * Parameters:
+ * 
+ *   pDataPath - path to the existing data file
+ * 
+ *   pIndexPath - path to the existing index file
+ * 
+ *   pNewDataPath - path to the new data file to create
+ * 
+ *   pNewIndexPath - path to the new index file to create
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksblob_compact(
+    const char * pDataPath,
+    const char * pIndexPath,
+    const char * pNewDataPath,
+    const char * pNewIndexPath,
+    int        * perr);
+
+#endif
@@ -0,0 +1,778 @@
+/*
+ * akscache.c
+ * ==========
+ * 
+ * Implementation of akscache.h
+ * 
+ * See the header for further information.
+ */
+
+#include "akscache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a cache file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSCACHE".
+ */
+#define CACHE_MAGIC (UINT64_C(0x4548434143534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header is followed by the hash index, then the reference bytes,
+ * and then the slots.
+ */
+#define HDR_OFF_MAGIC  (0)
+#define HDR_OFF_NSLOT  (8)
+#define HDR_OFF_NBUCK  (16)
+#define HDR_OFF_MAXKEY (24)
+#define HDR_OFF_MAXVAL (28)
+#define HDR_OFF_COUNT  (32)
+#define HDR_OFF_HAND   (40)
+#define HDR_SIZE       (64)
+
+/*
+ * Hash index bucket layout.
+ * 
+ * The hash index is an open-addressing table with linear probing.  Each
+ * bucket holds one greater than the index of the slot it refers to, or
+ * zero if it is empty, and the low 32 bits of the hash of the key.  The
+ * table always has at least twice as many buckets as there are slots,
+ * and the number of buckets is a power of two.
+ */
+#define BUCK_OFF_SLOT (0)
+#define BUCK_OFF_TAG  (4)
+#define BUCK_SIZE     (8)
+
+/*
+ * Slot layout.
+ * 
+ * Each slot holds the full hash of the key, the value length, and the
+ * key length, which is zero for an empty slot, followed by the key bytes
+ * and then the value bytes.  Slots are padded to a multiple of eight
+ * bytes.
+ */
+#define SLOT_OFF_HASH (0)
+#define SLOT_OFF_VLEN (8)
+#define SLOT_OFF_KLEN (12)
+#define SLOT_OFF_KEY  (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSCACHE structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSCACHE_TAG {
+
+  /*
+   * The viewer on the cache file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of slots, the number of buckets, and the maximum key and
+   * value lengths.
+   */
+  int64_t nslot;
+  int64_t nbuck;
+  int32_t maxkey;
+  int32_t maxval;
+
+  /*
+   * The file offsets of the reference bytes and the slots, and the size
+   * of each slot.
+   */
+  int64_t refs;
+  int64_t slots;
+  int64_t slotsize;
+
+  /*
+   * The number of entries and the position of the CLOCK hand.
+   * 
+   * These are cached copies of the values in the file header.
+   */
+  int64_t count;
+  int64_t hand;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "akscache fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "akscache warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local data
+ * ==========
+ */
+
+/*
+ * A byte that zero-length values can point to.
+ */
+static const uint8_t m_empty = 0;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint64_t hashBytes(const uint8_t *pb, int32_t len);
+static void layout(AKSCACHE *pc);
+static int64_t buckPos(int64_t b);
+static int64_t slotPos(AKSCACHE *pc, int64_t s);
+static int64_t findKey(
+    AKSCACHE      * pc,
+    uint64_t        h,
+    const uint8_t * pKey,
+    int32_t         klen,
+    int64_t       * pb);
+static void removeBucket(AKSCACHE *pc, int64_t b);
+static void unlinkSlot(AKSCACHE *pc, int64_t s);
+static int64_t sweep(AKSCACHE *pc);
+
+/*
+ * Compute the hash of a key.
+ * 
+ * This is 64-bit FNV-1a, which only depends on the byte values, so the
+ * cache file is portable between platforms.
+ * 
+ * Parameters:
+ * 
+ *   pb - the key
+ * 
+ *   len - the length of the key in bytes
+ * 
+ * Return:
+ * 
+ *   the hash value
+ */
+static uint64_t hashBytes(const uint8_t *pb, int32_t len) {
+
+  uint64_t h = UINT64_C(0xcbf29ce484222325);
+  int32_t i = 0;
+
+  for(i = 0; i < len; i++) {
+    h ^= (uint64_t) pb[i];
+    h *= UINT64_C(0x100000001b3);
+  }
+
+  return h;
+}
+
+/*
+ * Compute the file layout from the slot count, bucket count, and
+ * maximum lengths in the structure.
+ * 
+ * A fault occurs if the file would be too large.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ */
+static void layout(AKSCACHE *pc) {
+
+  int64_t rlen = 0;
+
+  pc->slotsize = SLOT_OFF_KEY + ((int64_t) pc->maxkey)
+                  + ((int64_t) pc->maxval);
+  if ((pc->slotsize % 8) != 0) {
+    pc->slotsize += 8 - (pc->slotsize % 8);
+  }
+
+  rlen = pc->nslot;
+  if ((rlen % 8) != 0) {
+    rlen += 8 - (rlen % 8);
+  }
+
+  pc->refs = buckPos(pc->nbuck);
+  pc->slots = pc->refs + rlen;
+  if (pc->nslot > (AKSVIEW_MAXLEN - pc->slots) / pc->slotsize) {
+    fault(__LINE__);
+  }
+}
+
+/*
+ * Get the file offset of a bucket or a slot.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   b - the bucket index
+ * 
+ *   s - the slot index
+ * 
+ * Return:
+ * 
+ *   the file offset
+ */
+static int64_t buckPos(int64_t b) {
+  return HDR_SIZE + (b * BUCK_SIZE);
+}
+
+static int64_t slotPos(AKSCACHE *pc, int64_t s) {
+  return pc->slots + (s * pc->slotsize);
+}
+
+/*
+ * Look up a key in the hash index.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   h - the hash of the key
+ * 
+ *   pKey - the key
+ * 
+ *   klen - the length of the key
+ * 
+ *   pb - receives the bucket holding the key, or the empty bucket where
+ *   it would be inserted
+ * 
+ * Return:
+ * 
+ *   the slot holding the key, or -1 if the key is not in the cache
+ */
+static int64_t findKey(
+    AKSCACHE      * pc,
+    uint64_t        h,
+    const uint8_t * pKey,
+    int32_t         klen,
+    int64_t       * pb) {
+
+  int64_t result = -1;
+  int64_t b = 0;
+  int64_t s = 0;
+  int64_t spos = 0;
+
+  b = (int64_t) (h & ((uint64_t) (pc->nbuck - 1)));
+  for(;;) {
+    s = ((int64_t) aksview_read32u(pc->pv, buckPos(b) + BUCK_OFF_SLOT, 1))
+          - 1;
+    if (s < 0) {
+      break;
+    }
+
+    /* Compare the tag, then the full hash, then the key bytes */
+    if (aksview_read32u(pc->pv, buckPos(b) + BUCK_OFF_TAG, 1)
+          == (uint32_t) (h & UINT64_C(0xffffffff))) {
+      spos = slotPos(pc, s);
+      if ((aksview_read64u(pc->pv, spos + SLOT_OFF_HASH, 1) == h) &&
+          (aksview_read32s(pc->pv, spos + SLOT_OFF_KLEN, 1) == klen)) {
+        if (memcmp(aksview_rspan(pc->pv, spos + SLOT_OFF_KEY, klen),
+                    pKey, (size_t) klen) == 0) {
+          result = s;
+          break;
+        }
+      }
+    }
+
+    b = (b + 1) & (pc->nbuck - 1);
+  }
+
+  *pb = b;
+  return result;
+}
+
+/*
+ * Empty a bucket of the hash index, shifting later buckets of the same
+ * probe sequence back so that no tombstone is needed.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   b - the bucket to empty
+ */
+static void removeBucket(AKSCACHE *pc, int64_t b) {
+
+  int64_t j = 0;
+  int64_t ideal = 0;
+  uint32_t sv = 0;
+  uint32_t tag = 0;
+  int64_t mask = pc->nbuck - 1;
+
+  j = b;
+  for(;;) {
+    j = (j + 1) & mask;
+    sv = aksview_read32u(pc->pv, buckPos(j) + BUCK_OFF_SLOT, 1);
+    if (sv == 0) {
+      break;
+    }
+    tag = aksview_read32u(pc->pv, buckPos(j) + BUCK_OFF_TAG, 1);
+    ideal = ((int64_t) tag) & mask;
+
+    /* Move j into the hole unless its ideal bucket lies cyclically in
+     * (b, j], in which case the hole does not break its probe */
+    if (((j - ideal) & mask) >= ((j - b) & mask)) {
+      aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_SLOT, 1, sv);
+      aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_TAG, 1, tag);
+      b = j;
+    }
+  }
+
+  aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_SLOT, 1, 0);
+  aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_TAG, 1, 0);
+}
+
+/*
+ * Remove the entry in an occupied slot from the hash index and mark the
+ * slot empty.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   s - the slot index
+ */
+static void unlinkSlot(AKSCACHE *pc, int64_t s) {
+
+  uint64_t h = 0;
+  int64_t b = 0;
+
+  /* Follow the probe sequence of the slot's hash to its bucket */
+  h = aksview_read64u(pc->pv, slotPos(pc, s) + SLOT_OFF_HASH, 1);
+  b = (int64_t) (h & ((uint64_t) (pc->nbuck - 1)));
+  for(;;) {
+    if (((int64_t) aksview_read32u(pc->pv, buckPos(b) + BUCK_OFF_SLOT, 1))
+          == s + 1) {
+      break;
+    }
+    b = (b + 1) & (pc->nbuck - 1);
+  }
+
+  removeBucket(pc, b);
+  aksview_write32s(pc->pv, slotPos(pc, s) + SLOT_OFF_KLEN, 1, 0);
+  aksview_write8u(pc->pv, pc->refs + s, 0);
+  (pc->count)--;
+}
+
+/*
+ * Advance the CLOCK hand to the next slot that can be reused.
+ * 
+ * Empty slots are taken at once.  Occupied slots with their reference
+ * byte set have it cleared and are passed over; the first occupied slot
+ * with its reference byte clear is chosen.  Since the hand clears every
+ * reference byte it passes, it stops within two revolutions.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ * Return:
+ * 
+ *   the chosen slot, which may still be occupied
+ */
+static int64_t sweep(AKSCACHE *pc) {
+
+  int64_t s = 0;
+
+  for(;;) {
+    s = pc->hand;
+    pc->hand = (pc->hand + 1) % pc->nslot;
+
+    if (aksview_read32s(pc->pv, slotPos(pc, s) + SLOT_OFF_KLEN, 1) == 0) {
+      break;
+    }
+    if (aksview_read8u(pc->pv, pc->refs + s) == 0) {
+      break;
+    }
+    aksview_write8u(pc->pv, pc->refs + s, 0);
+  }
+
+  aksview_write64s(pc->pv, HDR_OFF_HAND, 1, pc->hand);
+  return s;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * akscache_onerror function.
+ */
+void akscache_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * akscache_errstr function.
+ */
+const char *akscache_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSCACHE_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSCACHE_ERR_BADMODE:
+      pResult = "Invalid cache mode";
+      break;
+
+    case AKSCACHE_ERR_OPEN:
+      pResult = "Failed to open cache file";
+      break;
+
+    case AKSCACHE_ERR_FORMAT:
+      pResult = "Cache file has invalid format";
+      break;
+
+    case AKSCACHE_ERR_RESIZE:
+      pResult = "Failed to resize cache file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * akscache_open function.
+ */
+AKSCACHE *akscache_open(
+    const char * pPath,
+    int          mode,
+    int64_t      nslot,
+    int32_t      maxkey,
+    int32_t      maxval,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSCACHE *pc = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSCACHE_ERR_NONE;
+
+  /* Check that mode is recognized */
+  if ((mode != AKSVIEW_READONLY) &&
+      (mode != AKSVIEW_EXISTING) &&
+      (mode != AKSVIEW_REGULAR) &&
+      (mode != AKSVIEW_EXCLUSIVE)) {
+    status = 0;
+    *perr = AKSCACHE_ERR_BADMODE;
+  }
+
+  /* Allocate the structure and open the viewer */
+  if (status) {
+    pc = (AKSCACHE *) calloc(1, sizeof(AKSCACHE));
+    if (pc == NULL) {
+      fault(__LINE__);
+    }
+    pc->pv = aksview_create(pPath, mode, NULL);
+    if (pc->pv == NULL) {
+      status = 0;
+      *perr = AKSCACHE_ERR_OPEN;
+    }
+  }
+
+  if (status) {
+    flen = aksview_getlen(pc->pv);
+    if ((flen == 0) && (mode != AKSVIEW_READONLY)) {
+      /* Create a new cache, which starts out zero-filled */
+      if ((nslot < 1) || (nslot > AKSCACHE_MAXSLOT) ||
+          (maxkey < 1) || (maxkey > AKSCACHE_MAXKEY) ||
+          (maxval < 0) || (maxval > AKSCACHE_MAXVAL)) {
+        fault(__LINE__);
+      }
+      pc->nslot = nslot;
+      pc->maxkey = maxkey;
+      pc->maxval = maxval;
+      pc->nbuck = 1;
+      while (pc->nbuck < nslot * 2) {
+        pc->nbuck *= 2;
+      }
+      layout(pc);
+
+      if (!aksview_setlen(pc->pv, slotPos(pc, nslot))) {
+        status = 0;
+        *perr = AKSCACHE_ERR_RESIZE;
+      }
+      if (status) {
+        aksview_write64s(pc->pv, HDR_OFF_NSLOT, 1, pc->nslot);
+        aksview_write64s(pc->pv, HDR_OFF_NBUCK, 1, pc->nbuck);
+        aksview_write32s(pc->pv, HDR_OFF_MAXKEY, 1, pc->maxkey);
+        aksview_write32s(pc->pv, HDR_OFF_MAXVAL, 1, pc->maxval);
+        aksview_write64u(pc->pv, HDR_OFF_MAGIC, 1, CACHE_MAGIC);
+      }
+
+    } else {
+      /* Check the header of an existing cache */
+      if (flen < HDR_SIZE) {
+        status = 0;
+      }
+      if (status) {
+        pc->nslot = aksview_read64s(pc->pv, HDR_OFF_NSLOT, 1);
+        pc->nbuck = aksview_read64s(pc->pv, HDR_OFF_NBUCK, 1);
+        pc->maxkey = aksview_read32s(pc->pv, HDR_OFF_MAXKEY, 1);
+        pc->maxval = aksview_read32s(pc->pv, HDR_OFF_MAXVAL, 1);
+        pc->count = aksview_read64s(pc->pv, HDR_OFF_COUNT, 1);
+        pc->hand = aksview_read64s(pc->pv, HDR_OFF_HAND, 1);
+        if ((aksview_read64u(pc->pv, HDR_OFF_MAGIC, 1) != CACHE_MAGIC) ||
+            (pc->nslot < 1) || (pc->nslot > AKSCACHE_MAXSLOT) ||
+            (pc->nbuck < pc->nslot * 2) ||
+            ((pc->nbuck & (pc->nbuck - 1)) != 0) ||
+            (pc->maxkey < 1) || (pc->maxkey > AKSCACHE_MAXKEY) ||
+            (pc->maxval < 0) || (pc->maxval > AKSCACHE_MAXVAL) ||
+            (pc->count < 0) || (pc->count > pc->nslot) ||
+            (pc->hand < 0) || (pc->hand >= pc->nslot)) {
+          status = 0;
+        }
+      }
+      if (status) {
+        layout(pc);
+        if (flen != slotPos(pc, pc->nslot)) {
+          status = 0;
+        }
+      }
+      if (!status) {
+        *perr = AKSCACHE_ERR_FORMAT;
+      }
+    }
+  }
+
+  /* If function failed, release everything */
+  if ((!status) && (pc != NULL)) {
+    aksview_close(pc->pv);
+    free(pc);
+    pc = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pc;
+}
+
+/*
+ * akscache_close function.
+ */
+void akscache_close(AKSCACHE *pc) {
+  if (pc != NULL) {
+    aksview_close(pc->pv);
+    free(pc);
+  }
+}
+
+/*
+ * akscache_count function.
+ */
+int64_t akscache_count(AKSCACHE *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->count;
+}
+
+/*
+ * akscache_capacity function.
+ */
+int64_t akscache_capacity(AKSCACHE *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->nslot;
+}
+
+/*
+ * akscache_get function.
+ */
+const uint8_t *akscache_get(
+    AKSCACHE   * pc,
+    const void * pKey,
+    int32_t      klen,
+    int32_t    * plen) {
+
+  const uint8_t *pResult = NULL;
+  int64_t s = 0;
+  int64_t b = 0;
+  int32_t vlen = 0;
+
+  /* Check parameters */
+  if ((pc == NULL) || (pKey == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+  if ((klen < 1) || (klen > pc->maxkey)) {
+    fault(__LINE__);
+  }
+
+  *plen = -1;
+  s = findKey(pc, hashBytes((const uint8_t *) pKey, klen),
+                (const uint8_t *) pKey, klen, &b);
+  if (s >= 0) {
+    /* Set the reference byte, avoiding a write if already set */
+    if (aksview_writable(pc->pv)) {
+      if (aksview_read8u(pc->pv, pc->refs + s) == 0) {
+        aksview_write8u(pc->pv, pc->refs + s, 1);
+      }
+    }
+
+    vlen = aksview_read32s(pc->pv, slotPos(pc, s) + SLOT_OFF_VLEN, 1);
+    if ((vlen < 0) || (vlen > pc->maxval)) {
+      fault(__LINE__);
+    }
+    if (vlen > 0) {
+      pResult = aksview_rspan(
+                  pc->pv, slotPos(pc, s) + SLOT_OFF_KEY + klen, vlen);
+    } else {
+      pResult = &m_empty;
+    }
+    *plen = vlen;
+  }
+
+  return pResult;
+}
+
+/*
+ * akscache_put function.
+ */
+void akscache_put(
+    AKSCACHE   * pc,
+    const void * pKey,
+    int32_t      klen,
+    const void * pVal,
+    int32_t      vlen) {
+
+  uint64_t h = 0;
+  int64_t s = 0;
+  int64_t b = 0;
+  int64_t spos = 0;
+
+  /* Check parameters */
+  if ((pc == NULL) || (pKey == NULL) || ((pVal == NULL) && (vlen > 0))) {
+    fault(__LINE__);
+  }
+  if ((klen < 1) || (klen > pc->maxkey) ||
+      (vlen < 0) || (vlen > pc->maxval)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pc->pv)) {
+    fault(__LINE__);
+  }
+
+  h = hashBytes((const uint8_t *) pKey, klen);
+  s = findKey(pc, h, (const uint8_t *) pKey, klen, &b);
+
+  if (s < 0) {
+    /* Take a slot from the CLOCK hand, evicting its entry */
+    s = sweep(pc);
+    if (aksview_read32s(pc->pv, slotPos(pc, s) + SLOT_OFF_KLEN, 1) != 0) {
+      unlinkSlot(pc, s);
+      findKey(pc, h, (const uint8_t *) pKey, klen, &b);
+    }
+
+    /* Write the key and link the slot into the index */
+    spos = slotPos(pc, s);
+    aksview_write64u(pc->pv, spos + SLOT_OFF_HASH, 1, h);
+    aksview_write32s(pc->pv, spos + SLOT_OFF_KLEN, 1, klen);
+    aksview_writebuf(pc->pv, spos + SLOT_OFF_KEY, pKey, klen);
+    aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_SLOT, 1,
+                      (uint32_t) (s + 1));
+    aksview_write32u(pc->pv, buckPos(b) + BUCK_OFF_TAG, 1,
+                      (uint32_t) (h & UINT64_C(0xffffffff)));
+    (pc->count)++;
+    aksview_write64s(pc->pv, HDR_OFF_COUNT, 1, pc->count);
+  }
+
+  /* Write the value and mark the entry referenced */
+  spos = slotPos(pc, s);
+  aksview_write32s(pc->pv, spos + SLOT_OFF_VLEN, 1, vlen);
+  if (vlen > 0) {
+    aksview_writebuf(pc->pv, spos + SLOT_OFF_KEY + klen, pVal, vlen);
+  }
+  aksview_write8u(pc->pv, pc->refs + s, 1);
+}
+
+/*
+ * akscache_del function.
+ */
+int akscache_del(AKSCACHE *pc, const void *pKey, int32_t klen) {
+
+  int result = 0;
+  int64_t s = 0;
+  int64_t b = 0;
+
+  /* Check parameters */
+  if ((pc == NULL) || (pKey == NULL)) {
+    fault(__LINE__);
+  }
+  if ((klen < 1) || (klen > pc->maxkey)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pc->pv)) {
+    fault(__LINE__);
+  }
+
+  s = findKey(pc, hashBytes((const uint8_t *) pKey, klen),
+                (const uint8_t *) pKey, klen, &b);
+  if (s >= 0) {
+    unlinkSlot(pc, s);
+    aksview_write64s(pc->pv, HDR_OFF_COUNT, 1, pc->count);
+    result = 1;
+  }
+
+  return result;
+}
@@ -0,0 +1,262 @@
+#ifndef AKSCACHE_H_INCLUDED
+#define AKSCACHE_H_INCLUDED
+
+/*
+ * akscache.h
+ * ==========
+ * 
+ * Persistent fixed-capacity cache file with CLOCK eviction, built on
+ * top of AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum number of slots in a cache.
+ */
+#define AKSCACHE_MAXSLOT (INT64_C(1073741824))
+
+/*
+ * The maximum key length in bytes.
+ */
+#define AKSCACHE_MAXKEY (INT32_C(65535))
+
+/*
+ * The maximum value length in bytes.
+ */
+#define AKSCACHE_MAXVAL (INT32_C(16777216))
+
+/*
+ * Structure prototype for AKSCACHE.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSCACHE_TAG;
+typedef struct AKSCACHE_TAG AKSCACHE;
+
+/*
+ * Error code definitions.
+ * 
+ * Use akscache_errstr() to convert these to error messages.
+ */
+#define AKSCACHE_ERR_NONE    (0)
+#define AKSCACHE_ERR_BADMODE (1)
+#define AKSCACHE_ERR_OPEN    (2)
+#define AKSCACHE_ERR_FORMAT  (3)
+#define AKSCACHE_ERR_RESIZE  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the akscache.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void akscache_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSCACHE_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *akscache_errstr(int code);
+
+/*
+ * Open a cache file.
+ * 
+ * A cache file holds a hash index, a slab of nslot fixed-size slots, and
+ * one reference bit per slot for CLOCK eviction.  Each slot holds one
+ * entry, with a key of up to maxkey bytes and a value of up to maxval
+ * bytes.  The whole file is allocated when the cache is created, so the
+ * cache never grows.
+ * 
+ * mode is one of the AKSVIEW_ modes accepted by aksview_create().  If
+ * the file is empty when it is opened and the mode is not
+ * AKSVIEW_READONLY, a new, empty cache is created with the given nslot,
+ * maxkey, and maxval, which must be in range [1, AKSCACHE_MAXSLOT],
+ * [1, AKSCACHE_MAXKEY], and [0, AKSCACHE_MAXVAL].  Otherwise, the
+ * existing cache is opened, and nslot, maxkey, and maxval are ignored.
+ * Opening an existing cache only reads the header, so nothing needs to
+ * be rebuilt on restart.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSCACHE_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the cache file
+ * 
+ *   mode - the file mode for opening
+ * 
+ *   nslot - the number of slots for a new cache
+ * 
+ *   maxkey - the maximum key length for a new cache
+ * 
+ *   maxval - the maximum value length for a new cache
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new cache object or NULL if the function failed
+ */
+AKSCACHE *akscache_open(
+    const char * pPath,
+    int          mode,
+    int64_t      nslot,
+    int32_t      maxkey,
+    int32_t      maxval,
+    int        * perr);
+
+/*
+ * Close a cache.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache, or NULL
+ */
+void akscache_close(AKSCACHE *pc);
+
+/*
+ * Get the number of entries in a cache.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ * Return:
+ * 
+ *   the number of entries
+ */
+int64_t akscache_count(AKSCACHE *pc);
+
+/*
+ * Get the number of slots in a cache, which is the maximum number of
+ * entries.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ * Return:
+ * 
+ *   the number of slots
+ */
+int64_t akscache_capacity(AKSCACHE *pc);
+
+/*
+ * Look up an entry in a cache.
+ * 
+ * If the key is found, a pointer directly into the mapped file is
+ * returned and the value length is written to *plen.  No copy is made.
+ * If the cache is writable, the reference bit of the entry is set, so
+ * that it survives the next pass of the CLOCK hand.  If the key is not
+ * found, NULL is returned and *plen is set to -1.
+ * 
+ * Zero-length values return a valid pointer that must not be
+ * dereferenced.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to
+ * any function on the same cache.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   pKey - the key
+ * 
+ *   klen - the length of the key, in range [1, maxkey]
+ * 
+ *   plen - receives the value length
+ * 
+ * Return:
+ * 
+ *   pointer to the value, or NULL if the key was not found
+ */
+const uint8_t *akscache_get(
+    AKSCACHE   * pc,
+    const void * pKey,
+    int32_t      klen,
+    int32_t    * plen);
+
+/*
+ * Store an entry in a cache.
+ * 
+ * A fault occurs if the cache was opened read-only.
+ * 
+ * If the key is already in the cache, its value is replaced.
+ * Otherwise, the CLOCK hand sweeps the slots for an empty slot or an
+ * entry whose reference bit is clear, clearing reference bits as it
+ * passes, and the entry found there is evicted to make room.  In both
+ * cases, the reference bit of the stored entry is set.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   pKey - the key
+ * 
+ *   klen - the length of the key, in range [1, maxkey]
+ * 
+ *   pVal - the value, which may be NULL only if vlen is zero
+ * 
+ *   vlen - the length of the value, in range [0, maxval]
+ */
+void akscache_put(
+    AKSCACHE   * pc,
+    const void * pKey,
+    int32_t      klen,
+    const void * pVal,
+    int32_t      vlen);
+
+/*
+ * Remove an entry from a cache.
+ * 
+ * A fault occurs if the cache was opened read-only.
+ * 
+ * Parameters:
+ * 
+ *   pc - the cache
+ * 
+ *   pKey - the key
+ * 
+ *   klen - the length of the key, in range [1, maxkey]
+ * 
+ * Return:
+ * 
+ *   non-zero if the entry was removed, zero if the key was not found
+ */
+int akscache_del(AKSCACHE *pc, const void *pKey, int32_t klen);
+
+#endif
@@ -0,0 +1,985 @@
+/*
+ * akscol.c
+ * ========
+ * 
+ * Implementation of akscol.h
+ * 
+ * See the header for further information.
+ */
+
+#include "akscol.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start and at the end of a columnar file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins and ends with the ASCII string "AKSCOL01".
+ */
+#define COL_MAGIC (UINT64_C(0x31304c4f43534b41))
+
+/*
+ * Header layout.
+ * 
+ * The fixed header is followed by one little-endian 32-bit type code
+ * per column, padded to a multiple of eight bytes.  Blocks begin
+ * immediately after the header.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_NCOL  (8)
+#define HDR_OFF_BLEN  (12)
+#define HDR_OFF_TYPES (16)
+
+/*
+ * Trailer layout.
+ * 
+ * The trailer is the last 32 bytes of the file.  It gives the position
+ * of the footer index, the number of blocks, and the number of rows.
+ */
+#define TRL_OFF_INDEX (0)
+#define TRL_OFF_NBLK  (8)
+#define TRL_OFF_NROWS (16)
+#define TRL_OFF_MAGIC (24)
+#define TRL_SIZE      (32)
+
+/*
+ * Footer index entry layout.
+ * 
+ * There is one entry per block.  Each entry is a sequence of 64-bit
+ * little-endian words: the index of the first row in the block, the
+ * number of rows in the block, and then three words for each column,
+ * giving the file offset of the column's values within the block and
+ * the minimum and maximum values.  Floating-point minimums and
+ * maximums are stored as their bit patterns.
+ */
+#define ENT_FIRST (0)
+#define ENT_COUNT (1)
+#define ENT_COLS  (2)
+#define COL_OFF   (0)
+#define COL_MIN   (1)
+#define COL_MAX   (2)
+#define COL_WORDS (3)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSCOLW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSCOLW_TAG {
+
+  /*
+   * The viewer on the file being written.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The logical end of the file, where the next block is written.
+   */
+  int64_t fend;
+
+  /*
+   * The number of columns, the type of each column, and the number of
+   * rows in a full block.
+   */
+  int32_t ncol;
+  int *pTypes;
+  int32_t blocklen;
+
+  /*
+   * Buffers for each column of the current block.
+   * 
+   * Each buffer has blocklen elements, and is an int64_t array for
+   * AKSCOL_I64 columns or a double array for AKSCOL_F64 columns.
+   * nbuf is the number of rows currently buffered.
+   */
+  void **ppCol;
+  int32_t nbuf;
+
+  /*
+   * The number of rows written so far, not including buffered rows.
+   */
+  int64_t nrows;
+
+  /*
+   * The footer index being built in memory.
+   * 
+   * This is an array of 64-bit words in exactly the format of the
+   * footer index in the file.  nblk is the number of entries and
+   * icap is the allocated capacity in entries.
+   */
+  uint64_t *pIdx;
+  int64_t nblk;
+  int64_t icap;
+};
+
+/*
+ * AKSCOL structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSCOL_TAG {
+
+  /*
+   * The viewer on the file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of columns, the type of each column, and the number of
+   * rows in a full block.
+   */
+  int32_t ncol;
+  int *pTypes;
+  int32_t blocklen;
+
+  /*
+   * The file offset of the footer index, the number of blocks, and the
+   * number of rows.
+   */
+  int64_t idx;
+  int64_t nblk;
+  int64_t nrows;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "akscol fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "akscol warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t headerSize(int32_t ncol);
+static int flushBlock(AKSCOLW *pw);
+static int64_t entryPos(AKSCOL *pc, int64_t blk, int32_t col, int word);
+
+/*
+ * Compute the size of the file header for a given number of columns.
+ * 
+ * Parameters:
+ * 
+ *   ncol - the number of columns
+ * 
+ * Return:
+ * 
+ *   the size of the header in bytes
+ */
+static int64_t headerSize(int32_t ncol) {
+
+  int64_t result = 0;
+
+  /* Check parameter */
+  if ((ncol < 1) || (ncol > AKSCOL_MAXCOL)) {
+    fault(__LINE__);
+  }
+
+  /* Fixed header plus type codes, padded */
+  result = HDR_OFF_TYPES + (((int64_t) ncol) * 4);
+  if ((result % 8) != 0) {
+    result = ((result / 8) + 1) * 8;
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * Write out the buffered rows of a columnar writer as a block.
+ * 
+ * Each column is written with one bulk store, and its statistics are
+ * recorded in the in-memory footer index.  If there are no buffered
+ * rows, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pw - the columnar writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int flushBlock(AKSCOLW *pw) {
+
+  int status = 1;
+  int64_t bsize = 0;
+  int64_t ewords = 0;
+  int64_t ncap = 0;
+  uint64_t *pNew = NULL;
+  uint64_t *pe = NULL;
+  int64_t *pi = NULL;
+  double *pf = NULL;
+  int64_t imin = 0;
+  int64_t imax = 0;
+  double fmin = 0.0;
+  double fmax = 0.0;
+  int64_t cpos = 0;
+  int32_t c = 0;
+  int32_t r = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Only proceed if there are buffered rows */
+  if (pw->nbuf > 0) {
+
+    /* Make room in the file for the whole block */
+    bsize = ((int64_t) pw->ncol) * ((int64_t) pw->nbuf) * 8;
+    if (pw->fend > AKSVIEW_MAXLEN - bsize) {
+      fault(__LINE__);
+    }
+    if (!aksview_reserve(pw->pv, pw->fend + bsize)) {
+      status = 0;
+    }
+
+    /* Make room for another footer index entry */
+    ewords = ENT_COLS + (((int64_t) pw->ncol) * COL_WORDS);
+    if (status && (pw->nblk >= pw->icap)) {
+      ncap = pw->icap * 2;
+      pNew = (uint64_t *) realloc(
+                pw->pIdx, (size_t) (ncap * ewords * 8));
+      if (pNew == NULL) {
+        fault(__LINE__);
+      }
+      pw->pIdx = pNew;
+      pw->icap = ncap;
+    }
+
+    /* Write each column and record its statistics */
+    if (status) {
+      pe = &((pw->pIdx)[pw->nblk * ewords]);
+      pe[ENT_FIRST] = (uint64_t) pw->nrows;
+      pe[ENT_COUNT] = (uint64_t) pw->nbuf;
+
+      cpos = pw->fend;
+      for(c = 0; c < pw->ncol; c++) {
+        if ((pw->pTypes)[c] == AKSCOL_I64) {
+          pi = (int64_t *) (pw->ppCol)[c];
+          imin = pi[0];
+          imax = pi[0];
+          for(r = 1; r < pw->nbuf; r++) {
+            if (pi[r] < imin) {
+              imin = pi[r];
+            }
+            if (pi[r] > imax) {
+              imax = pi[r];
+            }
+          }
+          aksview_writev64s(pw->pv, cpos, 1, pi, pw->nbuf);
+          memcpy(&(pe[ENT_COLS + (c * COL_WORDS) + COL_MIN]), &imin, 8);
+          memcpy(&(pe[ENT_COLS + (c * COL_WORDS) + COL_MAX]), &imax, 8);
+
+        } else {
+          pf = (double *) (pw->ppCol)[c];
+          fmin = HUGE_VAL;
+          fmax = -HUGE_VAL;
+          for(r = 0; r < pw->nbuf; r++) {
+            if (pf[r] < fmin) {
+              fmin = pf[r];
+            }
+            if (pf[r] > fmax) {
+              fmax = pf[r];
+            }
+          }
+          aksview_writev64f(pw->pv, cpos, 1, pf, pw->nbuf);
+          memcpy(&(pe[ENT_COLS + (c * COL_WORDS) + COL_MIN]), &fmin, 8);
+          memcpy(&(pe[ENT_COLS + (c * COL_WORDS) + COL_MAX]), &fmax, 8);
+        }
+
+        pe[ENT_COLS + (c * COL_WORDS) + COL_OFF] = (uint64_t) cpos;
+        cpos += ((int64_t) pw->nbuf) * 8;
+      }
+
+      /* Update state */
+      pw->fend = cpos;
+      pw->nrows += (int64_t) pw->nbuf;
+      pw->nbuf = 0;
+      (pw->nblk)++;
+    }
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Compute the file offset of a word in the footer index.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file
+ * 
+ *   blk - the block index
+ * 
+ *   col - the column index, or -1 for the block words
+ * 
+ *   word - the word within the column (COL_) or block (ENT_)
+ * 
+ * Return:
+ * 
+ *   the file offset of the word
+ */
+static int64_t entryPos(AKSCOL *pc, int64_t blk, int32_t col, int word) {
+
+  int64_t result = 0;
+  int64_t ewords = 0;
+
+  /* Check parameters */
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  if ((blk < 0) || (blk >= pc->nblk) || (col < -1) ||
+      (col >= pc->ncol)) {
+    fault(__LINE__);
+  }
+
+  /* Compute the word index */
+  ewords = ENT_COLS + (((int64_t) pc->ncol) * COL_WORDS);
+  result = blk * ewords;
+  if (col >= 0) {
+    result += ENT_COLS + (((int64_t) col) * COL_WORDS);
+  }
+  result += (int64_t) word;
+
+  /* Return file offset */
+  return pc->idx + (result * 8);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * akscol_onerror function.
+ */
+void akscol_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * akscol_errstr function.
+ */
+const char *akscol_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSCOL_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSCOL_ERR_OPEN:
+      pResult = "Failed to open columnar file";
+      break;
+
+    case AKSCOL_ERR_FORMAT:
+      pResult = "Columnar file has invalid format";
+      break;
+
+    case AKSCOL_ERR_RESIZE:
+      pResult = "Failed to resize columnar file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * akscolw_new function.
+ */
+AKSCOLW *akscolw_new(
+    const char * pPath,
+    int32_t      ncol,
+    const int  * pTypes,
+    int32_t      blocklen,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSCOLW *pw = NULL;
+  int64_t hsize = 0;
+  int32_t c = 0;
+
+  /* Check parameters */
+  if ((pPath == NULL) || (pTypes == NULL)) {
+    fault(__LINE__);
+  }
+  if ((ncol < 1) || (ncol > AKSCOL_MAXCOL) ||
+      (blocklen < 1) || (blocklen > AKSCOL_MAXBLOCK)) {
+    fault(__LINE__);
+  }
+  for(c = 0; c < ncol; c++) {
+    if ((pTypes[c] != AKSCOL_I64) && (pTypes[c] != AKSCOL_F64)) {
+      fault(__LINE__);
+    }
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSCOL_ERR_NONE;
+
+  /* Allocate the writer structure */
+  pw = (AKSCOLW *) calloc(1, sizeof(AKSCOLW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file, discarding any existing contents */
+  pw->pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pw->pv == NULL) {
+    status = 0;
+    *perr = AKSCOL_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pw->pv, 0)) {
+      status = 0;
+      *perr = AKSCOL_ERR_RESIZE;
+    }
+  }
+
+  /* Write the header */
+  hsize = headerSize(ncol);
+  if (status) {
+    if (!aksview_reserve(pw->pv, hsize)) {
+      status = 0;
+      *perr = AKSCOL_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    aksview_write64u(pw->pv, HDR_OFF_MAGIC, 1, COL_MAGIC);
+    aksview_write32s(pw->pv, HDR_OFF_NCOL, 1, ncol);
+    aksview_write32s(pw->pv, HDR_OFF_BLEN, 1, blocklen);
+    for(c = 0; c < ncol; c++) {
+      aksview_write32s(pw->pv, HDR_OFF_TYPES + (c * 4), 1, pTypes[c]);
+    }
+    if (hsize > HDR_OFF_TYPES + (ncol * 4)) {
+      aksview_write32s(pw->pv, HDR_OFF_TYPES + (ncol * 4), 1, 0);
+    }
+    pw->fend = hsize;
+  }
+
+  /* Allocate the buffers */
+  if (status) {
+    pw->ncol = ncol;
+    pw->blocklen = blocklen;
+
+    pw->pTypes = (int *) malloc(((size_t) ncol) * sizeof(int));
+    if (pw->pTypes == NULL) {
+      fault(__LINE__);
+    }
+    memcpy(pw->pTypes, pTypes, ((size_t) ncol) * sizeof(int));
+
+    pw->ppCol = (void **) calloc((size_t) ncol, sizeof(void *));
+    if (pw->ppCol == NULL) {
+      fault(__LINE__);
+    }
+    for(c = 0; c < ncol; c++) {
+      (pw->ppCol)[c] = malloc(((size_t) blocklen) * 8);
+      if ((pw->ppCol)[c] == NULL) {
+        fault(__LINE__);
+      }
+    }
+
+    pw->icap = 64;
+    pw->pIdx = (uint64_t *) malloc(
+                  (size_t) (pw->icap * (ENT_COLS + (ncol * COL_WORDS)) * 8));
+    if (pw->pIdx == NULL) {
+      fault(__LINE__);
+    }
+
+    pw->nbuf = 0;
+    pw->nrows = 0;
+    pw->nblk = 0;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pw->pv);
+    free(pw);
+    pw = NULL;
+  }
+
+  /* Return writer or NULL */
+  return pw;
+}
+
+/*
+ * akscolw_append function.
+ */
+int akscolw_append(AKSCOLW *pw, const AKSCOL_VAL *pRow) {
+
+  int status = 1;
+  int32_t c = 0;
+
+  /* Check parameters */
+  if ((pw == NULL) || (pRow == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* If the block buffer is full, write it out first */
+  if (pw->nbuf >= pw->blocklen) {
+    status = flushBlock(pw);
+  }
+
+  /* Buffer the row */
+  if (status) {
+    for(c = 0; c < pw->ncol; c++) {
+      if ((pw->pTypes)[c] == AKSCOL_I64) {
+        ((int64_t *) (pw->ppCol)[c])[pw->nbuf] = pRow[c].i;
+      } else {
+        ((double *) (pw->ppCol)[c])[pw->nbuf] = pRow[c].f;
+      }
+    }
+    (pw->nbuf)++;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akscolw_finish function.
+ */
+int akscolw_finish(AKSCOLW *pw) {
+
+  int status = 1;
+  int64_t isize = 0;
+  int64_t flen = 0;
+  int32_t c = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Write any partial block */
+  status = flushBlock(pw);
+
+  /* Size the file to hold the footer index and the trailer */
+  if (status) {
+    isize = pw->nblk * (ENT_COLS + (((int64_t) pw->ncol) * COL_WORDS));
+    flen = pw->fend + (isize * 8) + TRL_SIZE;
+    if (!aksview_setlen(pw->pv, flen)) {
+      status = 0;
+    }
+  }
+
+  /* Write the footer index with one bulk store, then the trailer */
+  if (status) {
+    aksview_writev64u(pw->pv, pw->fend, 1, pw->pIdx, isize);
+    aksview_write64s(pw->pv, flen - TRL_SIZE + TRL_OFF_INDEX, 1,
+                      pw->fend);
+    aksview_write64s(pw->pv, flen - TRL_SIZE + TRL_OFF_NBLK, 1,
+                      pw->nblk);
+    aksview_write64s(pw->pv, flen - TRL_SIZE + TRL_OFF_NROWS, 1,
+                      pw->nrows);
+    aksview_write64u(pw->pv, flen - TRL_SIZE + TRL_OFF_MAGIC, 1,
+                      COL_MAGIC);
+  }
+
+  /* Release the writer */
+  aksview_close(pw->pv);
+  for(c = 0; c < pw->ncol; c++) {
+    free((pw->ppCol)[c]);
+  }
+  free(pw->ppCol);
+  free(pw->pTypes);
+  free(pw->pIdx);
+  free(pw);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akscol_open function.
+ */
+AKSCOL *akscol_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSCOL *pc = NULL;
+  int64_t flen = 0;
+  int64_t hsize = 0;
+  int64_t ewords = 0;
+  int32_t c = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSCOL_ERR_NONE;
+
+  /* Allocate the structure */
+  pc = (AKSCOL *) calloc(1, sizeof(AKSCOL));
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pc->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pc->pv == NULL) {
+    status = 0;
+    *perr = AKSCOL_ERR_OPEN;
+  }
+
+  /* Check the magic numbers and read the header */
+  if (status) {
+    flen = aksview_getlen(pc->pv);
+    if (flen < HDR_OFF_TYPES + TRL_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    if ((aksview_read64u(pc->pv, HDR_OFF_MAGIC, 1) != COL_MAGIC) ||
+        (aksview_read64u(pc->pv, flen - TRL_SIZE + TRL_OFF_MAGIC, 1)
+          != COL_MAGIC)) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pc->ncol = aksview_read32s(pc->pv, HDR_OFF_NCOL, 1);
+    pc->blocklen = aksview_read32s(pc->pv, HDR_OFF_BLEN, 1);
+    if ((pc->ncol < 1) || (pc->ncol > AKSCOL_MAXCOL) ||
+        (pc->blocklen < 1) || (pc->blocklen > AKSCOL_MAXBLOCK)) {
+      status = 0;
+    }
+  }
+  if (status) {
+    hsize = headerSize(pc->ncol);
+    if (hsize > flen - TRL_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pc->pTypes = (int *) malloc(((size_t) pc->ncol) * sizeof(int));
+    if (pc->pTypes == NULL) {
+      fault(__LINE__);
+    }
+    for(c = 0; c < pc->ncol; c++) {
+      (pc->pTypes)[c] = (int) aksview_read32s(
+                                pc->pv, HDR_OFF_TYPES + (c * 4), 1);
+      if (((pc->pTypes)[c] != AKSCOL_I64) &&
+          ((pc->pTypes)[c] != AKSCOL_F64)) {
+        status = 0;
+      }
+    }
+  }
+
+  /* Read the trailer and check that the footer index fits */
+  if (status) {
+    pc->idx = aksview_read64s(pc->pv, flen - TRL_SIZE + TRL_OFF_INDEX, 1);
+    pc->nblk = aksview_read64s(pc->pv, flen - TRL_SIZE + TRL_OFF_NBLK, 1);
+    pc->nrows = aksview_read64s(
+                  pc->pv, flen - TRL_SIZE + TRL_OFF_NROWS, 1);
+    ewords = ENT_COLS + (((int64_t) pc->ncol) * COL_WORDS);
+    if ((pc->idx < hsize) || (pc->idx > flen - TRL_SIZE) ||
+        (pc->nblk < 0) ||
+        (pc->nblk != (flen - TRL_SIZE - pc->idx) / (ewords * 8)) ||
+        (pc->nrows < 0) ||
+        (pc->nrows > pc->nblk * ((int64_t) pc->blocklen))) {
+      status = 0;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    if (*perr == AKSCOL_ERR_NONE) {
+      *perr = AKSCOL_ERR_FORMAT;
+    }
+    aksview_close(pc->pv);
+    free(pc->pTypes);
+    free(pc);
+    pc = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pc;
+}
+
+/*
+ * akscol_close function.
+ */
+void akscol_close(AKSCOL *pc) {
+  if (pc != NULL) {
+    aksview_close(pc->pv);
+    free(pc->pTypes);
+    free(pc);
+  }
+}
+
+/*
+ * akscol_ncol function.
+ */
+int32_t akscol_ncol(AKSCOL *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->ncol;
+}
+
+/*
+ * akscol_type function.
+ */
+int akscol_type(AKSCOL *pc, int32_t col) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  if ((col < 0) || (col >= pc->ncol)) {
+    fault(__LINE__);
+  }
+  return (pc->pTypes)[col];
+}
+
+/*
+ * akscol_nrows function.
+ */
+int64_t akscol_nrows(AKSCOL *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->nrows;
+}
+
+/*
+ * akscol_nblocks function.
+ */
+int64_t akscol_nblocks(AKSCOL *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->nblk;
+}
+
+/*
+ * akscol_blocklen function.
+ */
+int32_t akscol_blocklen(AKSCOL *pc) {
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  return pc->blocklen;
+}
+
+/*
+ * akscol_stats function.
+ */
+void akscol_stats(
+    AKSCOL     * pc,
+    int64_t      blk,
+    int32_t      col,
+    AKSCOL_VAL * pMin,
+    AKSCOL_VAL * pMax,
+    int32_t    * pCount,
+    int64_t    * pFirst) {
+
+  uint64_t w = 0;
+
+  /* Check parameters */
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  if ((col < 0) || (col >= pc->ncol)) {
+    fault(__LINE__);
+  }
+
+  /* Read the requested words, reinterpreting the bit patterns of
+   * floating-point statistics */
+  if (pMin != NULL) {
+    w = aksview_read64u(pc->pv, entryPos(pc, blk, col, COL_MIN), 1);
+    if ((pc->pTypes)[col] == AKSCOL_I64) {
+      memcpy(&(pMin->i), &w, 8);
+    } else {
+      memcpy(&(pMin->f), &w, 8);
+    }
+  }
+  if (pMax != NULL) {
+    w = aksview_read64u(pc->pv, entryPos(pc, blk, col, COL_MAX), 1);
+    if ((pc->pTypes)[col] == AKSCOL_I64) {
+      memcpy(&(pMax->i), &w, 8);
+    } else {
+      memcpy(&(pMax->f), &w, 8);
+    }
+  }
+  if (pCount != NULL) {
+    *pCount = (int32_t) aksview_read64s(
+                          pc->pv, entryPos(pc, blk, -1, ENT_COUNT), 1);
+  }
+  if (pFirst != NULL) {
+    *pFirst = aksview_read64s(
+                pc->pv, entryPos(pc, blk, -1, ENT_FIRST), 1);
+  }
+}
+
+/*
+ * akscol_next function.
+ */
+int64_t akscol_next(
+    AKSCOL     * pc,
+    int32_t      col,
+    AKSCOL_VAL   lo,
+    AKSCOL_VAL   hi,
+    int64_t      start) {
+
+  int64_t result = -1;
+  int64_t blk = 0;
+  AKSCOL_VAL vmin;
+  AKSCOL_VAL vmax;
+
+  /* Initialize structures */
+  memset(&vmin, 0, sizeof(AKSCOL_VAL));
+  memset(&vmax, 0, sizeof(AKSCOL_VAL));
+
+  /* Check parameters */
+  if (pc == NULL) {
+    fault(__LINE__);
+  }
+  if ((col < 0) || (col >= pc->ncol) || (start < 0)) {
+    fault(__LINE__);
+  }
+
+  /* Scan the footer index for an overlapping block */
+  for(blk = start; blk < pc->nblk; blk++) {
+    akscol_stats(pc, blk, col, &vmin, &vmax, NULL, NULL);
+    if ((pc->pTypes)[col] == AKSCOL_I64) {
+      if ((vmax.i >= lo.i) && (vmin.i <= hi.i)) {
+        result = blk;
+        break;
+      }
+    } else {
+      if ((vmax.f >= lo.f) && (vmin.f <= hi.f)) {
+        result = blk;
+        break;
+      }
+    }
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * akscol_readi function.
+ */
+int32_t akscol_readi(AKSCOL *pc, int64_t blk, int32_t col, int64_t *pBuf) {
+
+  int32_t count = 0;
+  int64_t pos = 0;
+
+  /* Check parameters */
+  if ((pc == NULL) || (pBuf == NULL)) {
+    fault(__LINE__);
+  }
+  if ((col < 0) || (col >= pc->ncol)) {
+    fault(__LINE__);
+  }
+  if ((pc->pTypes)[col] != AKSCOL_I64) {
+    fault(__LINE__);
+  }
+
+  /* Locate the column within the block */
+  akscol_stats(pc, blk, col, NULL, NULL, &count, NULL);
+  pos = aksview_read64s(pc->pv, entryPos(pc, blk, col, COL_OFF), 1);
+  if ((count < 1) || (count > pc->blocklen)) {
+    fault(__LINE__);
+  }
+
+  /* Decode with a bulk load, which checks the range */
+  aksview_readv64s(pc->pv, pos, 1, pBuf, count);
+  return count;
+}
+
+/*
+ * akscol_readf function.
+ */
+int32_t akscol_readf(AKSCOL *pc, int64_t blk, int32_t col, double *pBuf) {
+
+  int32_t count = 0;
+  int64_t pos = 0;
+
+  /* Check parameters */
+  if ((pc == NULL) || (pBuf == NULL)) {
+    fault(__LINE__);
+  }
+  if ((col < 0) || (col >= pc->ncol)) {
+    fault(__LINE__);
+  }
+  if ((pc->pTypes)[col] != AKSCOL_F64) {
+    fault(__LINE__);
+  }
+
+  /* Locate the column within the block */
+  akscol_stats(pc, blk, col, NULL, NULL, &count, NULL);
+  pos = aksview_read64s(pc->pv, entryPos(pc, blk, col, COL_OFF), 1);
+  if ((count < 1) || (count > pc->blocklen)) {
+    fault(__LINE__);
+  }
+
+  /* Decode with a bulk load, which checks the range */
+  aksview_readv64f(pc->pv, pos, 1, pBuf, count);
+  return count;
+}
@@ -0,0 +1,350 @@
+#ifndef AKSCOL_H_INCLUDED
+#define AKSCOL_H_INCLUDED
+
+/*
+ * akscol.h
+ * ========
+ * 
+ * Columnar file format with block statistics, built on top of AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum number of columns in a columnar file.
+ */
+#define AKSCOL_MAXCOL (INT32_C(4096))
+
+/*
+ * The maximum number of rows in a block.
+ */
+#define AKSCOL_MAXBLOCK (INT32_C(1048576))
+
+/*
+ * Column types.
+ * 
+ * AKSCOL_I64 columns hold signed 64-bit integers.  AKSCOL_F64 columns
+ * hold double-precision floating-point values.
+ */
+#define AKSCOL_I64 (1)
+#define AKSCOL_F64 (2)
+
+/*
+ * A single value in a column.
+ * 
+ * The i field is used for AKSCOL_I64 columns and the f field is used
+ * for AKSCOL_F64 columns.
+ */
+typedef union {
+  int64_t i;
+  double f;
+} AKSCOL_VAL;
+
+/*
+ * Structure prototypes for AKSCOL and AKSCOLW.
+ * 
+ * AKSCOL is a columnar file open for reading.  AKSCOLW is a columnar
+ * file that is being written.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSCOL_TAG;
+typedef struct AKSCOL_TAG AKSCOL;
+
+struct AKSCOLW_TAG;
+typedef struct AKSCOLW_TAG AKSCOLW;
+
+/*
+ * Error code definitions.
+ * 
+ * Use akscol_errstr() to convert these to error messages.
+ */
+#define AKSCOL_ERR_NONE   (0)
+#define AKSCOL_ERR_OPEN   (1)
+#define AKSCOL_ERR_FORMAT (2)
+#define AKSCOL_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the akscol.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void akscol_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSCOL_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *akscol_errstr(int code);
+
+/*
+ * Begin writing a new columnar file.
+ * 
+ * The file at pPath is created if it does not exist, and truncated to
+ * length zero if it does.
+ * 
+ * ncol is the number of columns, in range [1, AKSCOL_MAXCOL].  pTypes
+ * points to an array of ncol column types, each of which is one of the
+ * AKSCOL_ type constants.
+ * 
+ * blocklen is the number of rows in each block, in range [1,
+ * AKSCOL_MAXBLOCK].  Rows are buffered in memory until a whole block
+ * has been collected, so the writer uses about 8 * ncol * blocklen bytes
+ * of memory.  Larger blocks make the footer index smaller but make
+ * block skipping less selective.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSCOL_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the file to write
+ * 
+ *   ncol - the number of columns
+ * 
+ *   pTypes - the type of each column
+ * 
+ *   blocklen - the number of rows per block
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new columnar writer or NULL if the function failed
+ */
+AKSCOLW *akscolw_new(
+    const char * pPath,
+    int32_t      ncol,
+    const int  * pTypes,
+    int32_t      blocklen,
+    int        * perr);
+
+/*
+ * Append a row to a columnar file that is being written.
+ * 
+ * pRow points to an array of one value per column.
+ * 
+ * Whenever a block's worth of rows has been collected, each column of
+ * the block is written to the file with a bulk store, and its minimum,
+ * maximum, and row count are recorded for the footer index.
+ * 
+ * Parameters:
+ * 
+ *   pw - the columnar writer
+ * 
+ *   pRow - the values of the row
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int akscolw_append(AKSCOLW *pw, const AKSCOL_VAL *pRow);
+
+/*
+ * Finish writing a columnar file.
+ * 
+ * Any partial block is written, the footer index is written after the
+ * last block, the file is trimmed to its exact length, and the writer
+ * is released.  The writer may not be used again after this call,
+ * regardless of whether it succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pw - the columnar writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be resized
+ */
+int akscolw_finish(AKSCOLW *pw);
+
+/*
+ * Open a columnar file for reading.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for akscolw_new().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the columnar file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new columnar file object or NULL if the function failed
+ */
+AKSCOL *akscol_open(const char *pPath, int *perr);
+
+/*
+ * Close a columnar file.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file, or NULL
+ */
+void akscol_close(AKSCOL *pc);
+
+/*
+ * Get the shape of a columnar file.
+ * 
+ * akscol_ncol() returns the number of columns, akscol_type() returns
+ * the AKSCOL_ type of a given column, akscol_nrows() returns the total
+ * number of rows, akscol_nblocks() returns the number of blocks, and
+ * akscol_blocklen() returns the number of rows in a full block.  All
+ * blocks except possibly the last one are full.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file
+ * 
+ *   col - (akscol_type only) the column index
+ * 
+ * Return:
+ * 
+ *   the requested value
+ */
+int32_t akscol_ncol(AKSCOL *pc);
+int akscol_type(AKSCOL *pc, int32_t col);
+int64_t akscol_nrows(AKSCOL *pc);
+int64_t akscol_nblocks(AKSCOL *pc);
+int32_t akscol_blocklen(AKSCOL *pc);
+
+/*
+ * Get the statistics of one column of one block.
+ * 
+ * blk is the block index and col is the column index.  The minimum and
+ * maximum values of the column within the block are written to *pMin
+ * and *pMax, the number of rows in the block is written to *pCount, and
+ * the index of the first row of the block is written to *pFirst.  Any
+ * of the output pointers may be NULL if the value is not required.
+ * 
+ * For AKSCOL_F64 columns, NaN values are ignored when computing the
+ * statistics.  If all values in a block are NaN, the minimum is
+ * positive infinity and the maximum is negative infinity, so the block
+ * never matches any range.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file
+ * 
+ *   blk - the block index
+ * 
+ *   col - the column index
+ * 
+ *   pMin - receives the minimum, or NULL
+ * 
+ *   pMax - receives the maximum, or NULL
+ * 
+ *   pCount - receives the number of rows, or NULL
+ * 
+ *   pFirst - receives the index of the first row, or NULL
+ */
+void akscol_stats(
+    AKSCOL     * pc,
+    int64_t      blk,
+    int32_t      col,
+    AKSCOL_VAL * pMin,
+    AKSCOL_VAL * pMax,
+    int32_t    * pCount,
+    int64_t    * pFirst);
+
+/*
+ * Find the next block that might contain values of a column within a
+ * given range.
+ * 
+ * This is the predicate pushdown operation.  Only the footer index is
+ * consulted, so blocks that are skipped are never touched.
+ * 
+ * Blocks are searched starting at block index start.  The range is
+ * given by lo and hi, inclusive, and it is interpreted according to the
+ * type of the column.  A block matches if its range of values from the
+ * statistics overlaps [lo, hi].  Matching blocks may still contain rows
+ * outside the range, so callers must filter the decoded values.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file
+ * 
+ *   col - the column index
+ * 
+ *   lo - the lower bound of the range
+ * 
+ *   hi - the upper bound of the range
+ * 
+ *   start - the block index to start searching at
+ * 
+ * Return:
+ * 
+ *   the index of the next matching block, or -1 if there are none
+ */
+int64_t akscol_next(
+    AKSCOL     * pc,
+    int32_t      col,
+    AKSCOL_VAL   lo,
+    AKSCOL_VAL   hi,
+    int64_t      start);
+
+/*
+ * Decode one column of one block.
+ * 
+ * akscol_readi() may only be used with AKSCOL_I64 columns and
+ * akscol_readf() may only be used with AKSCOL_F64 columns, or a fault
+ * occurs.
+ * 
+ * pBuf must have room for at least akscol_blocklen() values.  The
+ * values are decoded with a single bulk load.
+ * 
+ * Parameters:
+ * 
+ *   pc - the columnar file
+ * 
+ *   blk - the block index
+ * 
+ *   col - the column index
+ * 
+ *   pBuf - receives the values
+ * 
+ * Return:
+ * 
+ *   the number of values decoded, which is the number of rows in the
+ *   block
+ */
+int32_t akscol_readi(AKSCOL *pc, int64_t blk, int32_t col, int64_t *pBuf);
+int32_t akscol_readf(AKSCOL *pc, int64_t blk, int32_t col, double *pBuf);
+
+#endif
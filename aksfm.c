@@ -0,0 +1,1352 @@
+/*
+ * aksfm.c
+ * =======
+ * 
+ * Implementation of aksfm.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksfm.h"
+#include "akspool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of an index file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSFMIX1".
+ */
+#define FM_MAGIC (UINT64_C(0x3158494d46534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header gives the length of the text, the row of the transform
+ * that holds the end-of-text marker, the sample rate, the number of
+ * suffix array samples, and the file offsets of the tables.  It is
+ * followed by the C table, which gives for each byte value one more
+ * than the number of text bytes less than it.
+ */
+#define HDR_OFF_MAGIC   (0)
+#define HDR_OFF_LEN     (8)
+#define HDR_OFF_PRIMARY (16)
+#define HDR_OFF_SRATE   (24)
+#define HDR_OFF_NSAMP   (32)
+#define HDR_OFF_SUP     (40)
+#define HDR_OFF_BLK     (48)
+#define HDR_OFF_MBASE   (56)
+#define HDR_OFF_MARK    (64)
+#define HDR_OFF_SAMP    (72)
+#define HDR_OFF_BWT     (80)
+#define HDR_OFF_CTAB    (128)
+#define HDR_SIZE        (HDR_OFF_CTAB + (256 * 8))
+
+/*
+ * Occurrence table intervals.
+ * 
+ * The transform is divided into superblocks of SUPER_ROWS rows and
+ * blocks of BLOCK_ROWS rows.  For each superblock, the superblock table
+ * holds 256 64-bit counts of each byte value before the superblock.
+ * For each block, the block table holds 256 16-bit counts of each byte
+ * value between the start of its superblock and the start of the
+ * block.  Both tables have one extra entry at the end.
+ */
+#define SUPER_ROWS   (65536)
+#define BLOCK_ROWS   (512)
+#define SUPER_BLOCKS (SUPER_ROWS / BLOCK_ROWS)
+
+/*
+ * Sample marks.
+ * 
+ * The mark bit vector has a bit set for each row whose suffix array
+ * entry is sampled, and the mark base table holds the number of marks
+ * before every block of BLOCK_ROWS rows.  The samples are stored in
+ * row order, so the rank of a row's mark is the index of its sample.
+ */
+#define BLOCK_WORDS (BLOCK_ROWS / 64)
+
+/*
+ * The number of superblocks in each build task.
+ */
+#define TASK_SUPERS (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSFM structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSFM_TAG {
+
+  /*
+   * The viewer on the index file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The length of the text, the row holding the end-of-text marker, and
+   * the sample rate.
+   */
+  int64_t len;
+  int64_t primary;
+  int64_t srate;
+
+  /*
+   * The C table.
+   */
+  int64_t ctab[256];
+
+  /*
+   * The file offsets of the tables.
+   */
+  int64_t sup;
+  int64_t blk;
+  int64_t mbase;
+  int64_t mark;
+  int64_t samp;
+  int64_t bwt;
+};
+
+/*
+ * SAIS_TEXT structure.
+ * 
+ * A text being sorted by SA-IS.  The last symbol is a sentinel that is
+ * smaller than every other symbol.  At the top level, p8 is the original
+ * text, whose bytes are shifted up by one to make room for a virtual
+ * sentinel.  At lower levels, p64 is the reduced text, which includes
+ * its sentinel.
+ */
+typedef struct {
+  const uint8_t *p8;
+  const int64_t *p64;
+  int64_t n;
+} SAIS_TEXT;
+
+/*
+ * FM_BUILD structure.
+ * 
+ * The state shared by the tasks that compute the index tables from the
+ * suffix array.  Each task handles a range of whole superblocks, so
+ * tasks never write to the same memory.
+ */
+typedef struct {
+
+  /*
+   * The text and its suffix array, including the empty suffix.
+   */
+  const uint8_t *pText;
+  const int64_t *pSA;
+  int64_t rows;
+  int64_t srate;
+
+  /*
+   * The transform, the block table, and the mark bit vector, in the
+   * format of the index file.
+   */
+  uint8_t *pBwt;
+  uint16_t *pBlk;
+  uint64_t *pMark;
+  int64_t nblk;
+
+  /*
+   * The counts of each byte value within each superblock, and the
+   * number of marks within each superblock.
+   */
+  int64_t *pSupCnt;
+  int64_t *pSupMark;
+
+  /*
+   * The offset of the first sample of each superblock, and the samples.
+   */
+  int64_t *pSupOff;
+  int64_t *pSamp;
+
+  /*
+   * The row holding the end-of-text marker.
+   */
+  int64_t primary;
+
+} FM_BUILD;
+
+/*
+ * FM_TASK structure.
+ * 
+ * One build task, covering superblocks [s0, s1).
+ */
+typedef struct {
+  FM_BUILD *pb;
+  int64_t s0;
+  int64_t s1;
+} FM_TASK;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksfm fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksfm warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t popCount(uint64_t w);
+static int64_t sym(const SAIS_TEXT *ps, int64_t i);
+static int tget(const uint8_t *pt, int64_t i);
+static void tset(uint8_t *pt, int64_t i, int v);
+static int isLMS(const uint8_t *pt, int64_t i);
+static void getBuckets(
+    const SAIS_TEXT * ps,
+    int64_t         * pBkt,
+    int64_t           k,
+    int               end);
+static void induce(
+    const SAIS_TEXT * ps,
+    const uint8_t   * pt,
+    int64_t         * pSA,
+    int64_t         * pBkt,
+    int64_t           k);
+static void sais(const SAIS_TEXT *ps, int64_t *pSA, int64_t k);
+static int64_t *suffixArray(AKSVIEW *pText, int64_t pos, int64_t n,
+                            uint8_t **ppText);
+static void tableTask(void *pArg);
+static void sampleTask(void *pArg);
+static void runTasks(
+    AKSPOOL  * pPool,
+    FM_TASK  * pTasks,
+    int64_t    ntask,
+    void    (* fp)(void *));
+static int64_t occ(AKSFM *pf, int c, int64_t i);
+static int64_t lf(AKSFM *pf, int64_t i);
+
+/*
+ * Count the set bits in a 64-bit word.
+ * 
+ * Parameters:
+ * 
+ *   w - the word
+ * 
+ * Return:
+ * 
+ *   the number of set bits
+ */
+static int64_t popCount(uint64_t w) {
+  w = w - ((w >> 1) & UINT64_C(0x5555555555555555));
+  w = (w & UINT64_C(0x3333333333333333)) +
+        ((w >> 2) & UINT64_C(0x3333333333333333));
+  w = (w + (w >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (int64_t) ((w * UINT64_C(0x0101010101010101)) >> 56);
+}
+
+/*
+ * Get a symbol of a text being sorted.
+ * 
+ * Parameters:
+ * 
+ *   ps - the text
+ * 
+ *   i - the index of the symbol
+ * 
+ * Return:
+ * 
+ *   the symbol
+ */
+static int64_t sym(const SAIS_TEXT *ps, int64_t i) {
+
+  int64_t result = 0;
+
+  if (ps->p8 != NULL) {
+    if (i < ps->n - 1) {
+      result = ((int64_t) (ps->p8)[i]) + 1;
+    }
+  } else {
+    result = (ps->p64)[i];
+  }
+
+  return result;
+}
+
+/*
+ * Get and set entries of a suffix type bit array.
+ * 
+ * A set bit marks an S-type suffix, which is smaller than the suffix
+ * that follows it.  A clear bit marks an L-type suffix.
+ * 
+ * Parameters:
+ * 
+ *   pt - the type array
+ * 
+ *   i - the index of the suffix
+ * 
+ *   v - (tset only) the type to set
+ * 
+ * Return:
+ * 
+ *   (tget only) the type
+ */
+static int tget(const uint8_t *pt, int64_t i) {
+  return (pt[i >> 3] >> (i & 7)) & 1;
+}
+
+static void tset(uint8_t *pt, int64_t i, int v) {
+  if (v) {
+    pt[i >> 3] |= (uint8_t) (1 << (i & 7));
+  } else {
+    pt[i >> 3] &= (uint8_t) ~(1 << (i & 7));
+  }
+}
+
+/*
+ * Check whether a suffix is a leftmost S-type (LMS) suffix.
+ * 
+ * Parameters:
+ * 
+ *   pt - the type array
+ * 
+ *   i - the index of the suffix, or -1
+ * 
+ * Return:
+ * 
+ *   non-zero if the suffix is LMS, zero otherwise
+ */
+static int isLMS(const uint8_t *pt, int64_t i) {
+  return (i > 0) && tget(pt, i) && (!tget(pt, i - 1));
+}
+
+/*
+ * Compute the start or end of each symbol's bucket in the suffix array.
+ * 
+ * Parameters:
+ * 
+ *   ps - the text
+ * 
+ *   pBkt - receives k + 1 bucket positions
+ * 
+ *   k - the largest symbol in the text
+ * 
+ *   end - non-zero for bucket ends, zero for bucket starts
+ */
+static void getBuckets(
+    const SAIS_TEXT * ps,
+    int64_t         * pBkt,
+    int64_t           k,
+    int               end) {
+
+  int64_t i = 0;
+  int64_t sum = 0;
+
+  memset(pBkt, 0, (size_t) ((k + 1) * 8));
+  for(i = 0; i < ps->n; i++) {
+    (pBkt[sym(ps, i)])++;
+  }
+  for(i = 0; i <= k; i++) {
+    sum += pBkt[i];
+    if (end) {
+      pBkt[i] = sum;
+    } else {
+      pBkt[i] = sum - pBkt[i];
+    }
+  }
+}
+
+/*
+ * Induce the order of L-type and then S-type suffixes from the suffixes
+ * already placed in the suffix array.
+ * 
+ * Parameters:
+ * 
+ *   ps - the text
+ * 
+ *   pt - the type array
+ * 
+ *   pSA - the suffix array
+ * 
+ *   pBkt - workspace for k + 1 bucket positions
+ * 
+ *   k - the largest symbol in the text
+ */
+static void induce(
+    const SAIS_TEXT * ps,
+    const uint8_t   * pt,
+    int64_t         * pSA,
+    int64_t         * pBkt,
+    int64_t           k) {
+
+  int64_t i = 0;
+  int64_t j = 0;
+  int64_t c = 0;
+
+  getBuckets(ps, pBkt, k, 0);
+  for(i = 0; i < ps->n; i++) {
+    j = pSA[i] - 1;
+    if ((j >= 0) && (!tget(pt, j))) {
+      c = sym(ps, j);
+      pSA[pBkt[c]] = j;
+      (pBkt[c])++;
+    }
+  }
+
+  getBuckets(ps, pBkt, k, 1);
+  for(i = ps->n - 1; i >= 0; i--) {
+    j = pSA[i] - 1;
+    if ((j >= 0) && tget(pt, j)) {
+      c = sym(ps, j);
+      (pBkt[c])--;
+      pSA[pBkt[c]] = j;
+    }
+  }
+}
+
+/*
+ * Sort the suffixes of a text with the SA-IS algorithm.
+ * 
+ * The text must have at least two symbols and end with a unique
+ * sentinel of zero.  The LMS substrings are sorted by induction, named,
+ * and the reduced text of names is sorted recursively in the upper part
+ * of the suffix array, from which the full order is induced.
+ * 
+ * Parameters:
+ * 
+ *   ps - the text
+ * 
+ *   pSA - receives the suffix array, with ps->n entries
+ * 
+ *   k - the largest symbol in the text
+ */
+static void sais(const SAIS_TEXT *ps, int64_t *pSA, int64_t k) {
+
+  int64_t n = ps->n;
+  uint8_t *pt = NULL;
+  int64_t *pBkt = NULL;
+  int64_t *pS1 = NULL;
+  SAIS_TEXT t1;
+  int64_t n1 = 0;
+  int64_t name = 0;
+  int64_t prev = 0;
+  int64_t p = 0;
+  int64_t d = 0;
+  int diff = 0;
+  int64_t i = 0;
+  int64_t j = 0;
+  int64_t c = 0;
+
+  pt = (uint8_t *) calloc((size_t) ((n / 8) + 1), 1);
+  pBkt = (int64_t *) malloc((size_t) ((k + 1) * 8));
+  if ((pt == NULL) || (pBkt == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Classify the suffixes; the sentinel is S-type and the suffix
+   * before it is L-type */
+  tset(pt, n - 1, 1);
+  tset(pt, n - 2, 0);
+  for(i = n - 3; i >= 0; i--) {
+    c = sym(ps, i) - sym(ps, i + 1);
+    tset(pt, i, (c < 0) || ((c == 0) && tget(pt, i + 1)));
+  }
+
+  /* Sort the LMS substrings by placing the LMS suffixes at the ends of
+   * their buckets and inducing */
+  getBuckets(ps, pBkt, k, 1);
+  for(i = 0; i < n; i++) {
+    pSA[i] = -1;
+  }
+  for(i = 1; i < n; i++) {
+    if (isLMS(pt, i)) {
+      c = sym(ps, i);
+      (pBkt[c])--;
+      pSA[pBkt[c]] = i;
+    }
+  }
+  induce(ps, pt, pSA, pBkt, k);
+
+  /* Gather the sorted LMS substrings at the start of the array */
+  n1 = 0;
+  for(i = 0; i < n; i++) {
+    if (isLMS(pt, pSA[i])) {
+      pSA[n1] = pSA[i];
+      n1++;
+    }
+  }
+
+  /* Name the LMS substrings, storing each name at half its position in
+   * the upper part of the array, which keeps them in text order */
+  for(i = n1; i < n; i++) {
+    pSA[i] = -1;
+  }
+  name = 0;
+  prev = -1;
+  for(i = 0; i < n1; i++) {
+    p = pSA[i];
+    diff = 0;
+    for(d = 0; d < n; d++) {
+      if ((prev < 0) ||
+          (sym(ps, p + d) != sym(ps, prev + d)) ||
+          (tget(pt, p + d) != tget(pt, prev + d))) {
+        diff = 1;
+        break;
+      } else if ((d > 0) && (isLMS(pt, p + d) || isLMS(pt, prev + d))) {
+        break;
+      }
+    }
+    if (diff) {
+      name++;
+      prev = p;
+    }
+    pSA[n1 + (p / 2)] = name - 1;
+  }
+  for(i = n - 1, j = n - 1; i >= n1; i--) {
+    if (pSA[i] >= 0) {
+      pSA[j] = pSA[i];
+      j--;
+    }
+  }
+
+  /* Sort the reduced text, recursing unless the names are unique */
+  pS1 = &(pSA[n - n1]);
+  if (name < n1) {
+    t1.p8 = NULL;
+    t1.p64 = pS1;
+    t1.n = n1;
+    sais(&t1, pSA, name - 1);
+  } else {
+    for(i = 0; i < n1; i++) {
+      pSA[pS1[i]] = i;
+    }
+  }
+
+  /* Map the sorted reduced suffixes back to LMS positions, place them
+   * at the ends of their buckets in order, and induce the rest */
+  getBuckets(ps, pBkt, k, 1);
+  for(i = 1, j = 0; i < n; i++) {
+    if (isLMS(pt, i)) {
+      pS1[j] = i;
+      j++;
+    }
+  }
+  for(i = 0; i < n1; i++) {
+    pSA[i] = pS1[pSA[i]];
+  }
+  for(i = n1; i < n; i++) {
+    pSA[i] = -1;
+  }
+  for(i = n1 - 1; i >= 0; i--) {
+    j = pSA[i];
+    pSA[i] = -1;
+    c = sym(ps, j);
+    (pBkt[c])--;
+    pSA[pBkt[c]] = j;
+  }
+  induce(ps, pt, pSA, pBkt, k);
+
+  free(pt);
+  free(pBkt);
+}
+
+/*
+ * Load a text into memory and build its suffix array.
+ * 
+ * The suffix array includes the empty suffix, which is always first, so
+ * it has n + 1 entries.
+ * 
+ * Parameters:
+ * 
+ *   pText - the viewer holding the text
+ * 
+ *   pos - the file offset of the text
+ * 
+ *   n - the length of the text
+ * 
+ *   ppText - receives the text buffer, which the caller must free
+ * 
+ * Return:
+ * 
+ *   the suffix array, which the caller must free
+ */
+static int64_t *suffixArray(AKSVIEW *pText, int64_t pos, int64_t n,
+                            uint8_t **ppText) {
+
+  int64_t *pSA = NULL;
+  uint8_t *pt = NULL;
+  SAIS_TEXT t;
+
+  /* Check parameters */
+  if ((pText == NULL) || (ppText == NULL)) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (n < 0) || (pos > aksview_getlen(pText) - n)) {
+    fault(__LINE__);
+  }
+  if ((uint64_t) n >= (((uint64_t) SIZE_MAX) / 8) - 1) {
+    fault(__LINE__);
+  }
+
+  /* Copy the text into memory */
+  pt = (uint8_t *) malloc((size_t) (n + 1));
+  pSA = (int64_t *) malloc((size_t) ((n + 1) * 8));
+  if ((pt == NULL) || (pSA == NULL)) {
+    fault(__LINE__);
+  }
+  aksview_readbuf(pText, pos, pt, n);
+
+  /* Sort the text with its virtual sentinel */
+  if (n > 0) {
+    t.p8 = pt;
+    t.p64 = NULL;
+    t.n = n + 1;
+    sais(&t, pSA, 256);
+  } else {
+    pSA[0] = 0;
+  }
+
+  *ppText = pt;
+  return pSA;
+}
+
+/*
+ * Build task that computes the transform, the block table, and the
+ * marks for a range of superblocks.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the FM_TASK
+ */
+static void tableTask(void *pArg) {
+
+  FM_TASK *pk = (FM_TASK *) pArg;
+  FM_BUILD *pb = pk->pb;
+  int64_t cnt[256];
+  int64_t marks = 0;
+  int64_t s = 0;
+  int64_t b = 0;
+  int64_t bend = 0;
+  int64_t i = 0;
+  int64_t iend = 0;
+  int64_t p = 0;
+  int c = 0;
+
+  for(s = pk->s0; s < pk->s1; s++) {
+    memset(cnt, 0, sizeof(cnt));
+    marks = 0;
+
+    bend = (s + 1) * SUPER_BLOCKS;
+    if (bend > pb->nblk) {
+      bend = pb->nblk;
+    }
+    for(b = s * SUPER_BLOCKS; b < bend; b++) {
+      for(c = 0; c < 256; c++) {
+        (pb->pBlk)[(b * 256) + c] = (uint16_t) cnt[c];
+      }
+
+      iend = (b + 1) * BLOCK_ROWS;
+      if (iend > pb->rows) {
+        iend = pb->rows;
+      }
+      for(i = b * BLOCK_ROWS; i < iend; i++) {
+        p = (pb->pSA)[i];
+        if (p > 0) {
+          c = (int) (pb->pText)[p - 1];
+          (pb->pBwt)[i] = (uint8_t) c;
+          (cnt[c])++;
+        } else {
+          (pb->pBwt)[i] = 0;
+          pb->primary = i;
+        }
+        if ((p % pb->srate) == 0) {
+          (pb->pMark)[i / 64] |= ((uint64_t) 1) << (i % 64);
+          marks++;
+        }
+      }
+    }
+
+    memcpy(&((pb->pSupCnt)[s * 256]), cnt, sizeof(cnt));
+    (pb->pSupMark)[s] = marks;
+  }
+}
+
+/*
+ * Build task that gathers the suffix array samples for a range of
+ * superblocks.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the FM_TASK
+ */
+static void sampleTask(void *pArg) {
+
+  FM_TASK *pk = (FM_TASK *) pArg;
+  FM_BUILD *pb = pk->pb;
+  int64_t off = 0;
+  int64_t i = 0;
+  int64_t iend = 0;
+
+  off = (pb->pSupOff)[pk->s0];
+  iend = pk->s1 * SUPER_ROWS;
+  if (iend > pb->rows) {
+    iend = pb->rows;
+  }
+  for(i = pk->s0 * SUPER_ROWS; i < iend; i++) {
+    if (((pb->pSA)[i] % pb->srate) == 0) {
+      (pb->pSamp)[off] = (pb->pSA)[i];
+      off++;
+    }
+  }
+}
+
+/*
+ * Run a set of build tasks on a pool, or on the calling thread if the
+ * pool is NULL, and wait for them to finish.
+ * 
+ * Parameters:
+ * 
+ *   pPool - the pool, or NULL
+ * 
+ *   pTasks - the tasks
+ * 
+ *   ntask - the number of tasks
+ * 
+ *   fp - the task function
+ */
+static void runTasks(
+    AKSPOOL  * pPool,
+    FM_TASK  * pTasks,
+    int64_t    ntask,
+    void    (* fp)(void *)) {
+
+  int64_t t = 0;
+
+  for(t = 0; t < ntask; t++) {
+    if (pPool != NULL) {
+      akspool_submit(pPool, fp, &(pTasks[t]));
+    } else {
+      fp(&(pTasks[t]));
+    }
+  }
+  if (pPool != NULL) {
+    akspool_wait(pPool);
+  }
+}
+
+/*
+ * Count the occurrences of a byte value in the transform before a row.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index
+ * 
+ *   c - the byte value
+ * 
+ *   i - the row, in range [0, len + 1]
+ * 
+ * Return:
+ * 
+ *   the number of occurrences of c in rows [0, i), not counting the
+ *   end-of-text marker
+ */
+static int64_t occ(AKSFM *pf, int c, int64_t i) {
+
+  int64_t result = 0;
+  int64_t b = 0;
+  int32_t n = 0;
+  const uint8_t *pb = NULL;
+  int32_t j = 0;
+
+  b = i / BLOCK_ROWS;
+  result = aksview_read64s(
+            pf->pv, pf->sup + ((((i / SUPER_ROWS) * 256) + c) * 8), 1);
+  result += (int64_t) aksview_read16u(
+                        pf->pv, pf->blk + (((b * 256) + c) * 2), 1);
+
+  /* Scan the transform from the start of the block */
+  n = (int32_t) (i - (b * BLOCK_ROWS));
+  if (n > 0) {
+    pb = aksview_rspan(pf->pv, pf->bwt + (b * BLOCK_ROWS), n);
+    for(j = 0; j < n; j++) {
+      if (pb[j] == (uint8_t) c) {
+        result++;
+      }
+    }
+    if ((c == 0) && (pf->primary >= b * BLOCK_ROWS) &&
+        (pf->primary < i)) {
+      result--;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Map a row to the row of the suffix that starts one byte earlier.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index
+ * 
+ *   i - the row, which must not be the end-of-text row
+ * 
+ * Return:
+ * 
+ *   the row of the preceding suffix
+ */
+static int64_t lf(AKSFM *pf, int64_t i) {
+
+  int c = 0;
+
+  c = (int) aksview_read8u(pf->pv, pf->bwt + i);
+  return (pf->ctab)[c] + occ(pf, c, i);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksfm_onerror function.
+ */
+void aksfm_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksfm_errstr function.
+ */
+const char *aksfm_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSFM_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSFM_ERR_OPEN:
+      pResult = "Failed to open index file";
+      break;
+
+    case AKSFM_ERR_FORMAT:
+      pResult = "Index file has invalid format";
+      break;
+
+    case AKSFM_ERR_RESIZE:
+      pResult = "Failed to resize index file";
+      break;
+
+    case AKSFM_ERR_THREAD:
+      pResult = "Failed to start worker threads";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksfm_sa function.
+ */
+int aksfm_sa(
+    AKSVIEW * pText,
+    int64_t   pos,
+    int64_t   n,
+    AKSVIEW * pOut,
+    int64_t   opos) {
+
+  int status = 1;
+  int64_t *pSA = NULL;
+  uint8_t *pt = NULL;
+
+  /* Check parameters */
+  if (pOut == NULL) {
+    fault(__LINE__);
+  }
+  if ((opos < 0) || (n < 0) || (opos > AKSVIEW_MAXLEN - (n * 8))) {
+    fault(__LINE__);
+  }
+
+  /* Build the suffix array */
+  pSA = suffixArray(pText, pos, n, &pt);
+  free(pt);
+
+  /* Write it without the empty suffix in a single bulk store */
+  if (!aksview_reserve(pOut, opos + (n * 8))) {
+    status = 0;
+  }
+  if (status) {
+    aksview_writev64s(pOut, opos, 1, &(pSA[1]), n);
+  }
+
+  free(pSA);
+  return status;
+}
+
+/*
+ * aksfm_build function.
+ */
+int aksfm_build(
+    AKSVIEW    * pText,
+    int64_t      pos,
+    int64_t      n,
+    int32_t      srate,
+    int          nthreads,
+    const char * pPath,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pv = NULL;
+  AKSPOOL *pPool = NULL;
+  uint8_t *pt = NULL;
+  FM_BUILD b;
+  FM_TASK *pTasks = NULL;
+  int64_t ntask = 0;
+  int64_t nsup = 0;
+  int64_t nword = 0;
+  int64_t nmb = 0;
+  int64_t nsamp = 0;
+  int64_t *pSup = NULL;
+  int64_t *pMBase = NULL;
+  int64_t tot[256];
+  int64_t ctab[256];
+  int64_t offSup = 0;
+  int64_t offBlk = 0;
+  int64_t offMBase = 0;
+  int64_t offMark = 0;
+  int64_t offSamp = 0;
+  int64_t offBwt = 0;
+  int64_t s = 0;
+  int64_t t = 0;
+  int64_t m = 0;
+  int c = 0;
+
+  /* Check parameters */
+  if ((pText == NULL) || (pPath == NULL)) {
+    fault(__LINE__);
+  }
+  if ((srate < 1) || (srate > AKSFM_MAXRATE) ||
+      (nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSFM_ERR_NONE;
+
+  /* Open the index file, discarding any existing contents */
+  pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pv == NULL) {
+    status = 0;
+    *perr = AKSFM_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pv, 0)) {
+      status = 0;
+      *perr = AKSFM_ERR_RESIZE;
+    }
+  }
+
+  /* Start the worker threads */
+  if (status && (nthreads > 0)) {
+    pPool = akspool_new(nthreads);
+    if (pPool == NULL) {
+      status = 0;
+      *perr = AKSFM_ERR_THREAD;
+    }
+  }
+
+  /* Build the suffix array and allocate the tables */
+  memset(&b, 0, sizeof(FM_BUILD));
+  if (status) {
+    b.pSA = suffixArray(pText, pos, n, &pt);
+    b.pText = pt;
+    b.rows = n + 1;
+    b.srate = srate;
+    b.nblk = (b.rows / BLOCK_ROWS) + 1;
+    nsup = (b.rows / SUPER_ROWS) + 1;
+    nword = (b.rows / 64) + 1;
+    nmb = b.nblk;
+
+    b.pBwt = (uint8_t *) malloc((size_t) b.rows);
+    b.pBlk = (uint16_t *) malloc((size_t) (b.nblk * 256 * 2));
+    b.pMark = (uint64_t *) calloc((size_t) nword, 8);
+    b.pSupCnt = (int64_t *) malloc((size_t) (nsup * 256 * 8));
+    b.pSupMark = (int64_t *) malloc((size_t) (nsup * 8));
+    b.pSupOff = (int64_t *) malloc((size_t) (nsup * 8));
+    pSup = (int64_t *) malloc((size_t) (nsup * 256 * 8));
+    pMBase = (int64_t *) malloc((size_t) (nmb * 8));
+    if ((b.pBwt == NULL) || (b.pBlk == NULL) || (b.pMark == NULL) ||
+        (b.pSupCnt == NULL) || (b.pSupMark == NULL) ||
+        (b.pSupOff == NULL) || (pSup == NULL) || (pMBase == NULL)) {
+      fault(__LINE__);
+    }
+
+    ntask = (nsup + TASK_SUPERS - 1) / TASK_SUPERS;
+    pTasks = (FM_TASK *) malloc((size_t) (ntask * sizeof(FM_TASK)));
+    if (pTasks == NULL) {
+      fault(__LINE__);
+    }
+    for(t = 0; t < ntask; t++) {
+      pTasks[t].pb = &b;
+      pTasks[t].s0 = t * TASK_SUPERS;
+      pTasks[t].s1 = (t + 1) * TASK_SUPERS;
+      if (pTasks[t].s1 > nsup) {
+        pTasks[t].s1 = nsup;
+      }
+    }
+  }
+
+  /* Compute the transform, block counts, and marks in parallel */
+  if (status) {
+    runTasks(pPool, pTasks, ntask, &tableTask);
+
+    /* Accumulate the superblock counts and the sample offsets */
+    memset(tot, 0, sizeof(tot));
+    nsamp = 0;
+    for(s = 0; s < nsup; s++) {
+      for(c = 0; c < 256; c++) {
+        pSup[(s * 256) + c] = tot[c];
+        tot[c] += (b.pSupCnt)[(s * 256) + c];
+      }
+      (b.pSupOff)[s] = nsamp;
+      nsamp += (b.pSupMark)[s];
+    }
+
+    /* Gather the samples in parallel */
+    b.pSamp = (int64_t *) malloc((size_t) ((nsamp + 1) * 8));
+    if (b.pSamp == NULL) {
+      fault(__LINE__);
+    }
+    runTasks(pPool, pTasks, ntask, &sampleTask);
+
+    /* Compute the mark base table and the C table */
+    m = 0;
+    for(s = 0; s < nmb; s++) {
+      pMBase[s] = m;
+      for(t = s * BLOCK_WORDS; (t < (s + 1) * BLOCK_WORDS) && (t < nword);
+          t++) {
+        m += popCount((b.pMark)[t]);
+      }
+    }
+    ctab[0] = 1;
+    for(c = 1; c < 256; c++) {
+      ctab[c] = ctab[c - 1] + tot[c - 1];
+    }
+  }
+
+  /* Free the suffix array and text before writing */
+  free((void *) b.pSA);
+  b.pSA = NULL;
+  free(pt);
+  pt = NULL;
+
+  /* Size the file */
+  if (status) {
+    offSup = HDR_SIZE;
+    offBlk = offSup + (nsup * 256 * 8);
+    offMBase = offBlk + (b.nblk * 256 * 2);
+    offMark = offMBase + (nmb * 8);
+    offSamp = offMark + (nword * 8);
+    offBwt = offSamp + (nsamp * 8);
+    if (offBwt > AKSVIEW_MAXLEN - b.rows) {
+      fault(__LINE__);
+    }
+    if (!aksview_setlen(pv, offBwt + b.rows)) {
+      status = 0;
+      *perr = AKSFM_ERR_RESIZE;
+    }
+  }
+
+  /* Write every table with a bulk store, and the header last */
+  if (status) {
+    aksview_writev64s(pv, offSup, 1, pSup, nsup * 256);
+    aksview_writev16u(pv, offBlk, 1, b.pBlk, b.nblk * 256);
+    aksview_writev64s(pv, offMBase, 1, pMBase, nmb);
+    aksview_writev64u(pv, offMark, 1, b.pMark, nword);
+    aksview_writev64s(pv, offSamp, 1, b.pSamp, nsamp);
+    aksview_writebuf(pv, offBwt, b.pBwt, b.rows);
+
+    aksview_writev64s(pv, HDR_OFF_CTAB, 1, ctab, 256);
+    aksview_write64s(pv, HDR_OFF_LEN, 1, n);
+    aksview_write64s(pv, HDR_OFF_PRIMARY, 1, b.primary);
+    aksview_write64s(pv, HDR_OFF_SRATE, 1, srate);
+    aksview_write64s(pv, HDR_OFF_NSAMP, 1, nsamp);
+    aksview_write64s(pv, HDR_OFF_SUP, 1, offSup);
+    aksview_write64s(pv, HDR_OFF_BLK, 1, offBlk);
+    aksview_write64s(pv, HDR_OFF_MBASE, 1, offMBase);
+    aksview_write64s(pv, HDR_OFF_MARK, 1, offMark);
+    aksview_write64s(pv, HDR_OFF_SAMP, 1, offSamp);
+    aksview_write64s(pv, HDR_OFF_BWT, 1, offBwt);
+    aksview_write64u(pv, HDR_OFF_MAGIC, 1, FM_MAGIC);
+  }
+
+  /* Release everything */
+  akspool_free(pPool);
+  aksview_close(pv);
+  free(b.pBwt);
+  free(b.pBlk);
+  free(b.pMark);
+  free(b.pSupCnt);
+  free(b.pSupMark);
+  free(b.pSupOff);
+  free(b.pSamp);
+  free(pSup);
+  free(pMBase);
+  free(pTasks);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksfm_open function.
+ */
+AKSFM *aksfm_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSFM *pf = NULL;
+  int64_t flen = 0;
+  int64_t rows = 0;
+  int64_t nsamp = 0;
+  int c = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSFM_ERR_NONE;
+
+  /* Allocate the structure */
+  pf = (AKSFM *) calloc(1, sizeof(AKSFM));
+  if (pf == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pf->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pf->pv == NULL) {
+    status = 0;
+    *perr = AKSFM_ERR_OPEN;
+  }
+
+  /* Each query alternates between the count tables and the transform,
+   * which are far apart in large files, so use the largest window to
+   * avoid remapping on every step */
+  if (status) {
+    aksview_sethint(pf->pv, AKSVIEW_MAXSPAN);
+  }
+
+  /* Read the header and check that the tables have the sizes implied
+   * by the text length */
+  if (status) {
+    flen = aksview_getlen(pf->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pf->len = aksview_read64s(pf->pv, HDR_OFF_LEN, 1);
+    pf->primary = aksview_read64s(pf->pv, HDR_OFF_PRIMARY, 1);
+    pf->srate = aksview_read64s(pf->pv, HDR_OFF_SRATE, 1);
+    nsamp = aksview_read64s(pf->pv, HDR_OFF_NSAMP, 1);
+    pf->sup = aksview_read64s(pf->pv, HDR_OFF_SUP, 1);
+    pf->blk = aksview_read64s(pf->pv, HDR_OFF_BLK, 1);
+    pf->mbase = aksview_read64s(pf->pv, HDR_OFF_MBASE, 1);
+    pf->mark = aksview_read64s(pf->pv, HDR_OFF_MARK, 1);
+    pf->samp = aksview_read64s(pf->pv, HDR_OFF_SAMP, 1);
+    pf->bwt = aksview_read64s(pf->pv, HDR_OFF_BWT, 1);
+    aksview_readv64s(pf->pv, HDR_OFF_CTAB, 1, pf->ctab, 256);
+
+    rows = pf->len + 1;
+    if ((aksview_read64u(pf->pv, HDR_OFF_MAGIC, 1) != FM_MAGIC) ||
+        (pf->len < 0) || (pf->len >= flen) ||
+        (pf->primary < 0) || (pf->primary >= rows) ||
+        (pf->srate < 1) || (pf->srate > AKSFM_MAXRATE) ||
+        (nsamp < 0) || (nsamp > rows) ||
+        (pf->sup != HDR_SIZE) ||
+        (pf->blk != pf->sup + (((rows / SUPER_ROWS) + 1) * 256 * 8)) ||
+        (pf->mbase != pf->blk + (((rows / BLOCK_ROWS) + 1) * 256 * 2)) ||
+        (pf->mark != pf->mbase + (((rows / BLOCK_ROWS) + 1) * 8)) ||
+        (pf->samp != pf->mark + (((rows / 64) + 1) * 8)) ||
+        (pf->bwt != pf->samp + (nsamp * 8)) ||
+        (flen != pf->bwt + rows)) {
+      status = 0;
+    }
+    for(c = 0; status && (c < 256); c++) {
+      if (((pf->ctab)[c] < 1) || ((pf->ctab)[c] > rows) ||
+          ((c > 0) && ((pf->ctab)[c] < (pf->ctab)[c - 1]))) {
+        status = 0;
+      }
+    }
+    if (!status) {
+      *perr = AKSFM_ERR_FORMAT;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pf->pv);
+    free(pf);
+    pf = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pf;
+}
+
+/*
+ * aksfm_close function.
+ */
+void aksfm_close(AKSFM *pf) {
+  if (pf != NULL) {
+    aksview_close(pf->pv);
+    free(pf);
+  }
+}
+
+/*
+ * aksfm_len function.
+ */
+int64_t aksfm_len(AKSFM *pf) {
+  if (pf == NULL) {
+    fault(__LINE__);
+  }
+  return pf->len;
+}
+
+/*
+ * aksfm_count function.
+ */
+int64_t aksfm_count(
+    AKSFM      * pf,
+    const void * pPat,
+    int32_t      plen,
+    int64_t    * pFirst) {
+
+  const uint8_t *pp = (const uint8_t *) pPat;
+  int64_t sp = 0;
+  int64_t ep = 0;
+  int32_t j = 0;
+  int c = 0;
+
+  /* Check parameters */
+  if ((pf == NULL) || ((pPat == NULL) && (plen > 0)) || (plen < 0)) {
+    fault(__LINE__);
+  }
+
+  /* Backward search, narrowing the row range one byte at a time */
+  sp = 0;
+  ep = pf->len + 1;
+  for(j = plen - 1; (j >= 0) && (sp < ep); j--) {
+    c = (int) pp[j];
+    sp = (pf->ctab)[c] + occ(pf, c, sp);
+    ep = (pf->ctab)[c] + occ(pf, c, ep);
+  }
+  if (sp > ep) {
+    ep = sp;
+  }
+
+  if (pFirst != NULL) {
+    *pFirst = sp;
+  }
+  return ep - sp;
+}
+
+/*
+ * aksfm_locate function.
+ */
+int64_t aksfm_locate(AKSFM *pf, int64_t row) {
+
+  int64_t steps = 0;
+  int64_t b = 0;
+  int64_t w = 0;
+  int64_t r = 0;
+  uint64_t x = 0;
+
+  /* Check parameters */
+  if (pf == NULL) {
+    fault(__LINE__);
+  }
+  if ((row < 0) || (row > pf->len)) {
+    fault(__LINE__);
+  }
+
+  /* Step backward through the text until reaching a sampled row */
+  for(;;) {
+    x = aksview_read64u(pf->pv, pf->mark + ((row / 64) * 8), 1);
+    if ((x >> (row % 64)) & 1) {
+      break;
+    }
+    if ((row == pf->primary) || (steps >= pf->srate)) {
+      fault(__LINE__);
+    }
+    row = lf(pf, row);
+    steps++;
+  }
+
+  /* The rank of the mark is the index of the sample */
+  b = row / BLOCK_ROWS;
+  r = aksview_read64s(pf->pv, pf->mbase + (b * 8), 1);
+  for(w = b * BLOCK_WORDS; w < row / 64; w++) {
+    r += popCount(aksview_read64u(pf->pv, pf->mark + (w * 8), 1));
+  }
+  r += popCount(x & ((((uint64_t) 1) << (row % 64)) - 1));
+
+  return aksview_read64s(pf->pv, pf->samp + (r * 8), 1) + steps;
+}
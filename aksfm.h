@@ -0,0 +1,277 @@
+#ifndef AKSFM_H_INCLUDED
+#define AKSFM_H_INCLUDED
+
+/*
+ * aksfm.h
+ * =======
+ * 
+ * Suffix array construction and FM-index substring search over text
+ * stored in AKSView files.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum suffix array sample rate of an FM-index.
+ */
+#define AKSFM_MAXRATE (INT32_C(65536))
+
+/*
+ * Structure prototype for AKSFM.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSFM_TAG;
+typedef struct AKSFM_TAG AKSFM;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksfm_errstr() to convert these to error messages.
+ */
+#define AKSFM_ERR_NONE   (0)
+#define AKSFM_ERR_OPEN   (1)
+#define AKSFM_ERR_FORMAT (2)
+#define AKSFM_ERR_RESIZE (3)
+#define AKSFM_ERR_THREAD (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksfm.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksfm_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSFM_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksfm_errstr(int code);
+
+/*
+ * Build the suffix array of a text.
+ * 
+ * The text is the n bytes in pText starting at file offset pos.  Bytes
+ * are compared as unsigned values, and a suffix that is a prefix of
+ * another suffix sorts first.
+ * 
+ * The suffix array is constructed with the SA-IS algorithm, which takes
+ * time linear in n regardless of how repetitive the text is.  The text
+ * and the suffix array are held in memory during construction, which
+ * takes about 9 * n bytes plus up to 4.5 * n bytes for recursion.
+ * 
+ * The result is written to pOut at file offset opos as n little-endian
+ * 64-bit integers, giving the starting offsets of the suffixes within
+ * the text in ascending order.  The file is grown with aksview_reserve()
+ * as necessary, so pOut must be writable.
+ * 
+ * Parameters:
+ * 
+ *   pText - the viewer holding the text
+ * 
+ *   pos - the file offset of the text
+ * 
+ *   n - the length of the text in bytes
+ * 
+ *   pOut - the viewer to write the suffix array to
+ * 
+ *   opos - the file offset to write the suffix array at
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if pOut could not be enlarged
+ */
+int aksfm_sa(
+    AKSVIEW * pText,
+    int64_t   pos,
+    int64_t   n,
+    AKSVIEW * pOut,
+    int64_t   opos);
+
+/*
+ * Build an FM-index file for a text.
+ * 
+ * The text is the n bytes in pText starting at file offset pos.  The
+ * suffix array is constructed as for aksfm_sa(), and the index file at
+ * pPath is written from it.  The file is created if it does not exist,
+ * and truncated to length zero if it does.
+ * 
+ * The index holds the Burrows-Wheeler transform of the text, occurrence
+ * counts for every byte value at regular intervals, and the suffix
+ * array entries for every text position that is a multiple of srate.
+ * srate must be in range [1, AKSFM_MAXRATE].  Larger values make the
+ * index smaller but make aksfm_locate() proportionally slower.  The
+ * index takes about (2 + 8 / srate) * n bytes.
+ * 
+ * Once the suffix array is built, the transform and count tables are
+ * computed in slices by nthreads worker threads, which must be in range
+ * [0, AKSPOOL_MAXTHREAD] (see akspool.h).  If nthreads is zero,
+ * everything runs on the calling thread.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSFM_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pText - the viewer holding the text
+ * 
+ *   pos - the file offset of the text
+ * 
+ *   n - the length of the text in bytes
+ * 
+ *   srate - the suffix array sample rate
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ *   pPath - path to the index file to write
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksfm_build(
+    AKSVIEW    * pText,
+    int64_t      pos,
+    int64_t      n,
+    int32_t      srate,
+    int          nthreads,
+    const char * pPath,
+    int        * perr);
+
+/*
+ * Open an FM-index file for queries.
+ * 
+ * Only the header is read.  The original text is not needed.  The
+ * index file is mapped with a window hint of AKSVIEW_MAXSPAN, since
+ * queries jump between tables that are far apart.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksfm_build().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the index file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new index object or NULL if the function failed
+ */
+AKSFM *aksfm_open(const char *pPath, int *perr);
+
+/*
+ * Close an FM-index.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index, or NULL
+ */
+void aksfm_close(AKSFM *pf);
+
+/*
+ * Get the length of the indexed text in bytes.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index
+ * 
+ * Return:
+ * 
+ *   the length of the text
+ */
+int64_t aksfm_len(AKSFM *pf);
+
+/*
+ * Count the occurrences of a pattern in the indexed text.
+ * 
+ * The occurrences of the pattern correspond to a contiguous range of
+ * rows of the index, which is found by backward search.  Each pattern
+ * byte costs two occurrence queries, and each occurrence query reads
+ * one count from each of two tables and scans at most 511 bytes of the
+ * transform, so the cost depends on the pattern length but not on the
+ * text length.
+ * 
+ * If pFirst is not NULL, the first row of the range is written to it.
+ * The rows can then be passed to aksfm_locate().  An empty pattern
+ * occurs at every position, including the end of the text.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index
+ * 
+ *   pPat - the pattern
+ * 
+ *   plen - the length of the pattern in bytes
+ * 
+ *   pFirst - receives the first matching row, or NULL
+ * 
+ * Return:
+ * 
+ *   the number of occurrences
+ */
+int64_t aksfm_count(
+    AKSFM      * pf,
+    const void * pPat,
+    int32_t      plen,
+    int64_t    * pFirst);
+
+/*
+ * Get the text position of a row of the index.
+ * 
+ * row must be in range zero up to the length of the text, inclusive.
+ * Rows are numbered in the order of the suffix array, with row zero
+ * being the empty suffix at the end of the text.
+ * 
+ * The transform is followed backward from the row until a sampled text
+ * position is reached, which takes fewer than srate steps.
+ * 
+ * Parameters:
+ * 
+ *   pf - the index
+ * 
+ *   row - the row
+ * 
+ * Return:
+ * 
+ *   the offset in the text where the suffix of the row starts
+ */
+int64_t aksfm_locate(AKSFM *pf, int64_t row);
+
+#endif
@@ -0,0 +1,601 @@
+/*
+ * aksheap.c
+ * =========
+ * 
+ * Implementation of aksheap.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksheap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a heap file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSHEAP1".
+ */
+#define HEAP_MAGIC (UINT64_C(0x3150414548534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header is one cache line.  It is followed by the entries, each of
+ * which is a little-endian 64-bit key followed by a little-endian 64-bit
+ * value.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_COUNT (8)
+#define HDR_OFF_ARITY (16)
+#define HDR_SIZE      (64)
+
+/*
+ * Entry layout.
+ * 
+ * Entry i is stored at slot i + SLOT_SKIP, so that the children of each
+ * node, which begin at entry (ARITY * i) + 1, begin on a cache line
+ * boundary.
+ */
+#define ENT_SIZE  (16)
+#define SLOT_SKIP (AKSHEAP_ARITY - 1)
+
+/*
+ * The number of entries staged in memory at a time by aksheap_pushv().
+ */
+#define STAGE_LEN (4096)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSHEAP structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSHEAP_TAG {
+
+  /*
+   * The viewer on the heap file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of entries.
+   * 
+   * This is a cached copy of the value in the file header.
+   */
+  int64_t count;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksheap fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksheap warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t entPos(int64_t i);
+static int64_t fileLen(int64_t count);
+static void setCount(AKSHEAP *ph, int64_t count);
+static void siftUp(AKSHEAP *ph, int64_t i, int64_t key, int64_t val);
+static void siftDown(AKSHEAP *ph, int64_t i, int64_t key, int64_t val);
+
+/*
+ * Get the file offset of a heap entry.
+ * 
+ * Parameters:
+ * 
+ *   i - the entry index
+ * 
+ * Return:
+ * 
+ *   the file offset of the entry
+ */
+static int64_t entPos(int64_t i) {
+  return HDR_SIZE + ((i + SLOT_SKIP) * ENT_SIZE);
+}
+
+/*
+ * Get the length of the file that holds a given number of entries.
+ * 
+ * Parameters:
+ * 
+ *   count - the number of entries
+ * 
+ * Return:
+ * 
+ *   the file length
+ */
+static int64_t fileLen(int64_t count) {
+  return entPos(count);
+}
+
+/*
+ * Update the number of entries in the structure and the file header.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   count - the new number of entries
+ */
+static void setCount(AKSHEAP *ph, int64_t count) {
+  ph->count = count;
+  aksview_write64s(ph->pv, HDR_OFF_COUNT, 1, count);
+}
+
+/*
+ * Move an entry up from a hole towards the root until its parent has a
+ * key that is not greater, and store it there.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   i - the index of the hole to start from
+ * 
+ *   key - the key of the entry
+ * 
+ *   val - the value of the entry
+ */
+static void siftUp(AKSHEAP *ph, int64_t i, int64_t key, int64_t val) {
+
+  int64_t p = 0;
+  int64_t pkey = 0;
+
+  while (i > 0) {
+    p = (i - 1) / AKSHEAP_ARITY;
+    pkey = aksview_read64s(ph->pv, entPos(p), 1);
+    if (pkey <= key) {
+      break;
+    }
+
+    /* Move the parent down into the hole */
+    aksview_write64s(ph->pv, entPos(i), 1, pkey);
+    aksview_write64s(ph->pv, entPos(i) + 8, 1,
+                      aksview_read64s(ph->pv, entPos(p) + 8, 1));
+    i = p;
+  }
+
+  aksview_write64s(ph->pv, entPos(i), 1, key);
+  aksview_write64s(ph->pv, entPos(i) + 8, 1, val);
+}
+
+/*
+ * Move an entry down from a hole towards the leaves until none of its
+ * children has a lower key, and store it there.
+ * 
+ * All the children of a node share one cache line, so each level of
+ * the descent touches only one new cache line.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   i - the index of the hole to start from
+ * 
+ *   key - the key of the entry
+ * 
+ *   val - the value of the entry
+ */
+static void siftDown(AKSHEAP *ph, int64_t i, int64_t key, int64_t val) {
+
+  int64_t c = 0;
+  int64_t last = 0;
+  int64_t best = 0;
+  int64_t bkey = 0;
+  int64_t ckey = 0;
+
+  for(;;) {
+    /* Find the child with the lowest key */
+    c = (i * AKSHEAP_ARITY) + 1;
+    if (c >= ph->count) {
+      break;
+    }
+    last = c + AKSHEAP_ARITY;
+    if (last > ph->count) {
+      last = ph->count;
+    }
+
+    best = c;
+    bkey = aksview_read64s(ph->pv, entPos(c), 1);
+    for(c++; c < last; c++) {
+      ckey = aksview_read64s(ph->pv, entPos(c), 1);
+      if (ckey < bkey) {
+        best = c;
+        bkey = ckey;
+      }
+    }
+    if (bkey >= key) {
+      break;
+    }
+
+    /* Move the child up into the hole */
+    aksview_write64s(ph->pv, entPos(i), 1, bkey);
+    aksview_write64s(ph->pv, entPos(i) + 8, 1,
+                      aksview_read64s(ph->pv, entPos(best) + 8, 1));
+    i = best;
+  }
+
+  aksview_write64s(ph->pv, entPos(i), 1, key);
+  aksview_write64s(ph->pv, entPos(i) + 8, 1, val);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksheap_onerror function.
+ */
+void aksheap_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksheap_errstr function.
+ */
+const char *aksheap_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSHEAP_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSHEAP_ERR_BADMODE:
+      pResult = "Invalid heap mode";
+      break;
+
+    case AKSHEAP_ERR_OPEN:
+      pResult = "Failed to open heap file";
+      break;
+
+    case AKSHEAP_ERR_FORMAT:
+      pResult = "Heap file has invalid format";
+      break;
+
+    case AKSHEAP_ERR_RESIZE:
+      pResult = "Failed to resize heap file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksheap_open function.
+ */
+AKSHEAP *aksheap_open(const char *pPath, int mode, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSHEAP *ph = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSHEAP_ERR_NONE;
+
+  /* Check that mode is recognized */
+  if ((mode != AKSVIEW_READONLY) &&
+      (mode != AKSVIEW_EXISTING) &&
+      (mode != AKSVIEW_REGULAR) &&
+      (mode != AKSVIEW_EXCLUSIVE)) {
+    status = 0;
+    *perr = AKSHEAP_ERR_BADMODE;
+  }
+
+  /* Allocate the structure and open the viewer */
+  if (status) {
+    ph = (AKSHEAP *) calloc(1, sizeof(AKSHEAP));
+    if (ph == NULL) {
+      fault(__LINE__);
+    }
+    ph->pv = aksview_create(pPath, mode, NULL);
+    if (ph->pv == NULL) {
+      status = 0;
+      *perr = AKSHEAP_ERR_OPEN;
+    }
+  }
+
+  if (status) {
+    flen = aksview_getlen(ph->pv);
+    if ((flen == 0) && (mode != AKSVIEW_READONLY)) {
+      /* Initialize a new heap */
+      if (!aksview_setlen(ph->pv, fileLen(0))) {
+        status = 0;
+        *perr = AKSHEAP_ERR_RESIZE;
+      }
+      if (status) {
+        aksview_write32s(ph->pv, HDR_OFF_ARITY, 1, AKSHEAP_ARITY);
+        setCount(ph, 0);
+        aksview_write64u(ph->pv, HDR_OFF_MAGIC, 1, HEAP_MAGIC);
+      }
+
+    } else {
+      /* Check the header of an existing heap */
+      if (flen < fileLen(0)) {
+        status = 0;
+      }
+      if (status) {
+        ph->count = aksview_read64s(ph->pv, HDR_OFF_COUNT, 1);
+        if ((aksview_read64u(ph->pv, HDR_OFF_MAGIC, 1) != HEAP_MAGIC) ||
+            (aksview_read32s(ph->pv, HDR_OFF_ARITY, 1) != AKSHEAP_ARITY) ||
+            (ph->count < 0) ||
+            (ph->count > (flen - fileLen(0)) / ENT_SIZE)) {
+          status = 0;
+        }
+      }
+      if (!status) {
+        *perr = AKSHEAP_ERR_FORMAT;
+      }
+    }
+  }
+
+  /* If function failed, release everything */
+  if ((!status) && (ph != NULL)) {
+    aksview_close(ph->pv);
+    free(ph);
+    ph = NULL;
+  }
+
+  /* Return structure or NULL */
+  return ph;
+}
+
+/*
+ * aksheap_close function.
+ */
+void aksheap_close(AKSHEAP *ph) {
+  if (ph != NULL) {
+    if (aksview_writable(ph->pv)) {
+      if (!aksview_setlen(ph->pv, fileLen(ph->count))) {
+        warn(__LINE__);
+      }
+    }
+    aksview_close(ph->pv);
+    free(ph);
+  }
+}
+
+/*
+ * aksheap_count function.
+ */
+int64_t aksheap_count(AKSHEAP *ph) {
+  if (ph == NULL) {
+    fault(__LINE__);
+  }
+  return ph->count;
+}
+
+/*
+ * aksheap_push function.
+ */
+int aksheap_push(AKSHEAP *ph, int64_t key, int64_t val) {
+
+  int status = 1;
+
+  /* Check parameters */
+  if (ph == NULL) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(ph->pv)) {
+    fault(__LINE__);
+  }
+  if (ph->count >= (AKSVIEW_MAXLEN / ENT_SIZE) - SLOT_SKIP - HDR_SIZE) {
+    fault(__LINE__);
+  }
+
+  /* Make room for the new entry */
+  if (!aksview_reserve(ph->pv, fileLen(ph->count + 1))) {
+    status = 0;
+  }
+
+  /* Sift the entry up from a hole at the end */
+  if (status) {
+    siftUp(ph, ph->count, key, val);
+    setCount(ph, ph->count + 1);
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksheap_pushv function.
+ */
+int aksheap_pushv(
+    AKSHEAP       * ph,
+    const int64_t * pKeys,
+    const int64_t * pVals,
+    int64_t         n) {
+
+  int status = 1;
+  int64_t *pStage = NULL;
+  int64_t done = 0;
+  int64_t k = 0;
+  int64_t j = 0;
+  int64_t i = 0;
+
+  /* Check parameters */
+  if ((ph == NULL) || (((pKeys == NULL) || (pVals == NULL)) && (n > 0))) {
+    fault(__LINE__);
+  }
+  if (n < 0) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(ph->pv)) {
+    fault(__LINE__);
+  }
+  if (ph->count > (AKSVIEW_MAXLEN / ENT_SIZE) - SLOT_SKIP - HDR_SIZE - n) {
+    fault(__LINE__);
+  }
+
+  if (n <= ph->count / 2) {
+    /* Few entries relative to the heap, so push them one at a time */
+    for(i = 0; i < n; i++) {
+      if (!aksheap_push(ph, pKeys[i], pVals[i])) {
+        status = 0;
+        break;
+      }
+    }
+
+  } else {
+    /* Append all entries with bulk stores, then rebuild the heap */
+    if (!aksview_reserve(ph->pv, fileLen(ph->count + n))) {
+      status = 0;
+    }
+    if (status) {
+      pStage = (int64_t *) malloc(((size_t) STAGE_LEN) * 2 * sizeof(int64_t));
+      if (pStage == NULL) {
+        fault(__LINE__);
+      }
+      for(done = 0; done < n; done += k) {
+        k = n - done;
+        if (k > STAGE_LEN) {
+          k = STAGE_LEN;
+        }
+        for(j = 0; j < k; j++) {
+          pStage[2 * j] = pKeys[done + j];
+          pStage[(2 * j) + 1] = pVals[done + j];
+        }
+        aksview_writev64s(ph->pv, entPos(ph->count + done), 1, pStage, 2 * k);
+      }
+      free(pStage);
+
+      /* Sift down every internal node, from the last one to the root */
+      ph->count += n;
+      for(i = (ph->count - 2) / AKSHEAP_ARITY; i >= 0; i--) {
+        siftDown(ph, i,
+                  aksview_read64s(ph->pv, entPos(i), 1),
+                  aksview_read64s(ph->pv, entPos(i) + 8, 1));
+      }
+      setCount(ph, ph->count);
+    }
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksheap_peek function.
+ */
+int aksheap_peek(AKSHEAP *ph, int64_t *pKey, int64_t *pVal) {
+
+  int result = 0;
+
+  /* Check parameter */
+  if (ph == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Read the root, if any */
+  if (ph->count > 0) {
+    if (pKey != NULL) {
+      *pKey = aksview_read64s(ph->pv, entPos(0), 1);
+    }
+    if (pVal != NULL) {
+      *pVal = aksview_read64s(ph->pv, entPos(0) + 8, 1);
+    }
+    result = 1;
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * aksheap_pop function.
+ */
+int aksheap_pop(AKSHEAP *ph, int64_t *pKey, int64_t *pVal) {
+
+  int result = 0;
+  int64_t last = 0;
+
+  /* Check parameter */
+  if (ph == NULL) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(ph->pv)) {
+    fault(__LINE__);
+  }
+
+  /* Take the root, and sift the last entry down from the root hole */
+  if (aksheap_peek(ph, pKey, pVal)) {
+    last = ph->count - 1;
+    setCount(ph, last);
+    if (last > 0) {
+      siftDown(ph, 0,
+                aksview_read64s(ph->pv, entPos(last), 1),
+                aksview_read64s(ph->pv, entPos(last) + 8, 1));
+    }
+    result = 1;
+  }
+
+  /* Return result */
+  return result;
+}
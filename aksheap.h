@@ -0,0 +1,228 @@
+#ifndef AKSHEAP_H_INCLUDED
+#define AKSHEAP_H_INCLUDED
+
+/*
+ * aksheap.h
+ * =========
+ * 
+ * Persistent priority queue stored as a d-ary heap in an AKSView file.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The number of children of each heap node.
+ * 
+ * Each entry is 16 bytes, so the children of a node exactly fill one
+ * 64-byte cache line, and they are laid out so that they start on a
+ * cache line boundary in the file.
+ */
+#define AKSHEAP_ARITY (4)
+
+/*
+ * Structure prototype for AKSHEAP.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSHEAP_TAG;
+typedef struct AKSHEAP_TAG AKSHEAP;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksheap_errstr() to convert these to error messages.
+ */
+#define AKSHEAP_ERR_NONE    (0)
+#define AKSHEAP_ERR_BADMODE (1)
+#define AKSHEAP_ERR_OPEN    (2)
+#define AKSHEAP_ERR_FORMAT  (3)
+#define AKSHEAP_ERR_RESIZE  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksheap.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksheap_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSHEAP_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksheap_errstr(int code);
+
+/*
+ * Open a heap file.
+ * 
+ * The heap is a min-heap of entries, each of which has a 64-bit integer
+ * key, such as a deadline, and a 64-bit integer value, such as a task
+ * ID.  The entry with the lowest key is at the top.
+ * 
+ * mode is one of the AKSVIEW_ modes accepted by aksview_create().  If
+ * the file is empty when it is opened and the mode is not
+ * AKSVIEW_READONLY, a new, empty heap is initialized in it.  Otherwise,
+ * the existing heap is opened, which only reads the header, so that
+ * opening a heap of any size is instant.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSHEAP_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the heap file
+ * 
+ *   mode - the file mode for opening
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new heap object or NULL if the function failed
+ */
+AKSHEAP *aksheap_open(const char *pPath, int mode, int *perr);
+
+/*
+ * Close a heap.
+ * 
+ * If NULL is passed, nothing is done.  For writable heaps, the file is
+ * trimmed to exactly the length that is in use.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap, or NULL
+ */
+void aksheap_close(AKSHEAP *ph);
+
+/*
+ * Get the number of entries in a heap.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ * Return:
+ * 
+ *   the number of entries
+ */
+int64_t aksheap_count(AKSHEAP *ph);
+
+/*
+ * Add an entry to a heap.
+ * 
+ * A fault occurs if the heap was opened read-only.  The file is grown
+ * with aksview_reserve() as necessary.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   key - the key of the entry
+ * 
+ *   val - the value of the entry
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int aksheap_push(AKSHEAP *ph, int64_t key, int64_t val);
+
+/*
+ * Add many entries to a heap at once.
+ * 
+ * This has the same effect as calling aksheap_push() for each entry,
+ * but when many entries are added relative to the size of the heap, the
+ * entries are appended in one bulk store and the whole heap is rebuilt
+ * bottom-up in linear time.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   pKeys - the keys of the entries
+ * 
+ *   pVals - the values of the entries
+ * 
+ *   n - the number of entries, zero or greater
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int aksheap_pushv(
+    AKSHEAP       * ph,
+    const int64_t * pKeys,
+    const int64_t * pVals,
+    int64_t         n);
+
+/*
+ * Get the entry with the lowest key without removing it.
+ * 
+ * If several entries have the lowest key, it is unspecified which of
+ * them is returned.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   pKey - receives the key, or NULL
+ * 
+ *   pVal - receives the value, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if an entry was returned, zero if the heap is empty
+ */
+int aksheap_peek(AKSHEAP *ph, int64_t *pKey, int64_t *pVal);
+
+/*
+ * Remove the entry with the lowest key.
+ * 
+ * A fault occurs if the heap was opened read-only.
+ * 
+ * Parameters:
+ * 
+ *   ph - the heap
+ * 
+ *   pKey - receives the key, or NULL
+ * 
+ *   pVal - receives the value, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if an entry was removed, zero if the heap is empty
+ */
+int aksheap_pop(AKSHEAP *ph, int64_t *pKey, int64_t *pVal);
+
+#endif
@@ -0,0 +1,1201 @@
+/*
+ * aksinv.c
+ * ========
+ * 
+ * Implementation of aksinv.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksinv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Blocks are unpacked with byte shuffles and per-lane shifts when the
+ * compiler targets a processor that has AVX2, and with a portable loop
+ * otherwise.
+ */
+#if defined(__AVX2__)
+#define INV_AVX2
+#include <immintrin.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of an index segment.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSINV01".
+ */
+#define INV_MAGIC (UINT64_C(0x3130564e49534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header gives the number of terms, the file offset of the term
+ * dictionary, and the file offset of the term strings.  Posting lists
+ * begin immediately after the header.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_NTERM (8)
+#define HDR_OFF_DICT  (16)
+#define HDR_OFF_STRS  (24)
+#define HDR_SIZE      (32)
+
+/*
+ * Term dictionary record layout.
+ * 
+ * There is one record per term, in ascending term order.  Each record
+ * gives the offset of the term within the term strings, the file offset
+ * of the posting list, the length of the term, and the number of
+ * documents in the posting list.
+ */
+#define REC_OFF_SOFF  (0)
+#define REC_OFF_POST  (8)
+#define REC_OFF_TLEN  (16)
+#define REC_OFF_NDOCS (20)
+#define REC_SIZE      (24)
+#define REC_WORDS     (3)
+
+/*
+ * Skip entry layout.
+ * 
+ * Each posting list begins with one skip entry per block, giving the
+ * last document ID in the block, the bit width of the block, and the
+ * file offset of the packed block.  The packed blocks follow the skip
+ * entries.
+ */
+#define SKIP_OFF_LAST  (0)
+#define SKIP_OFF_WIDTH (4)
+#define SKIP_OFF_POS   (8)
+#define SKIP_SIZE      (16)
+
+/*
+ * The number of bytes in a packed block with a bit width of one.
+ * 
+ * A block always holds AKSINV_BLOCK values, with the unused values of a
+ * partial block packed as zero, so a block with bit width w takes
+ * exactly w times this many bytes.
+ */
+#define PACK_UNIT (AKSINV_BLOCK / 8)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSINVW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSINVW_TAG {
+
+  /*
+   * The viewer on the file being written.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The logical end of the file, where the next posting list is
+   * written.
+   */
+  int64_t fend;
+
+  /*
+   * The term strings, concatenated.
+   * 
+   * slen is the number of bytes in use and scap is the allocated
+   * capacity.
+   */
+  uint8_t *pStr;
+  int64_t slen;
+  int64_t scap;
+
+  /*
+   * The term dictionary being built in memory.
+   * 
+   * This is an array of 64-bit words in exactly the format of the term
+   * dictionary in the file.  nterm is the number of records and dcap is
+   * the allocated capacity in records.
+   */
+  uint64_t *pDict;
+  int64_t nterm;
+  int64_t dcap;
+};
+
+/*
+ * AKSINV structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSINV_TAG {
+
+  /*
+   * The viewer on the file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of terms, and the file offsets of the term dictionary and
+   * the term strings.
+   */
+  int64_t nterm;
+  int64_t dict;
+  int64_t strs;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksinv fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksinv warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t bitWidth(uint32_t v);
+static void packBlock(const uint32_t *pGap, int32_t w, uint8_t *pOut);
+static void unpackBlock(const uint8_t *pIn, int32_t w, uint32_t *pGap);
+static int64_t recPos(AKSINV *pi, int64_t t);
+static int compareTerm(
+    AKSINV        * pi,
+    int64_t         t,
+    const uint8_t * pTerm,
+    int32_t         tlen);
+static int32_t decodeBlock(
+    AKSINV  * pi,
+    int64_t   post,
+    int32_t   ndocs,
+    int32_t   blk,
+    int32_t * pOut);
+static int32_t seekBlock(
+    AKSINV  * pi,
+    int64_t   post,
+    int32_t   nblk,
+    int32_t   blk,
+    int32_t   doc);
+
+/*
+ * Return the number of bits needed to represent a value.
+ * 
+ * Parameters:
+ * 
+ *   v - the value
+ * 
+ * Return:
+ * 
+ *   the bit width, in range [0, 32]
+ */
+static int32_t bitWidth(uint32_t v) {
+
+  int32_t result = 0;
+
+  while (v != 0) {
+    result++;
+    v >>= 1;
+  }
+
+  return result;
+}
+
+/*
+ * Pack a block of values with a given bit width.
+ * 
+ * Values are packed least significant bit first, each value following
+ * on directly from the previous one.
+ * 
+ * Parameters:
+ * 
+ *   pGap - the AKSINV_BLOCK values to pack
+ * 
+ *   w - the bit width, in range [1, 32]
+ * 
+ *   pOut - receives w * PACK_UNIT bytes
+ */
+static void packBlock(const uint32_t *pGap, int32_t w, uint8_t *pOut) {
+
+  uint64_t acc = 0;
+  int32_t have = 0;
+  int32_t i = 0;
+
+  for(i = 0; i < AKSINV_BLOCK; i++) {
+    acc |= ((uint64_t) pGap[i]) << have;
+    have += w;
+    while (have >= 8) {
+      *pOut = (uint8_t) (acc & 0xff);
+      pOut++;
+      acc >>= 8;
+      have -= 8;
+    }
+  }
+}
+
+/*
+ * Unpack a block of values with a given bit width.
+ * 
+ * This is the inverse of packBlock().  Every group of eight values
+ * begins on a byte boundary, since it occupies exactly w bytes, so the
+ * groups are unpacked independently.
+ * 
+ * With AVX2, each group is unpacked at once.  Each half of the group,
+ * four values, lies within the 16 bytes that start at the byte where
+ * the half starts, so both halves are loaded into one register.  A
+ * shuffle then gives each value the four bytes that it starts in, and a
+ * second shuffle gives it the fifth byte that values straddling more
+ * than 32 bits need.  Shifting those right and left by the bit offset of
+ * each value and masking them yields the values.  The shuffles, shifts,
+ * and mask only depend on w.  The input is read straight from the
+ * mapping, so the last groups, whose loads would run past the block,
+ * are first copied into a zero-padded buffer.
+ * 
+ * Without AVX2, the values of each group are assembled a byte at a time.
+ * 
+ * Parameters:
+ * 
+ *   pIn - the w * PACK_UNIT packed bytes
+ * 
+ *   w - the bit width, in range [1, 32]
+ * 
+ *   pGap - receives the AKSINV_BLOCK values
+ */
+static void unpackBlock(const uint8_t *pIn, int32_t w, uint32_t *pGap) {
+
+  uint64_t mask = 0;
+  int32_t g = 0;
+  int32_t i = 0;
+#ifdef INV_AVX2
+  uint8_t lo[32];
+  uint8_t hi[32];
+  int32_t shr[8];
+  int32_t shl[8];
+  uint8_t tail[64];
+  int32_t half = 0;
+  int32_t bit = 0;
+  int32_t left = 0;
+  int padded = 0;
+  int32_t j = 0;
+  __m256i vlo;
+  __m256i vhi;
+  __m256i vshr;
+  __m256i vshl;
+  __m256i vmask;
+  __m256i x;
+#else
+  uint64_t acc = 0;
+  int32_t have = 0;
+#endif
+
+  mask = (((uint64_t) 1) << w) - 1;
+
+#ifdef INV_AVX2
+  /*
+   * Build the shuffles and shifts for each value of a group, relative to
+   * the byte where its half starts; shuffle indices of 0x80 give zero
+   */
+  half = (4 * w) / 8;
+  for(i = 0; i < 8; i++) {
+    bit = (i * w) - ((i < 4) ? 0 : (half * 8));
+    for(j = 0; j < 4; j++) {
+      lo[(i * 4) + j] = (uint8_t) ((bit / 8) + j);
+      hi[(i * 4) + j] = 0x80;
+    }
+    if ((bit % 8) + w > 32) {
+      hi[i * 4] = (uint8_t) ((bit / 8) + 4);
+    }
+    shr[i] = bit % 8;
+    shl[i] = 32 - (bit % 8);
+  }
+  vlo = _mm256_loadu_si256((const __m256i *) lo);
+  vhi = _mm256_loadu_si256((const __m256i *) hi);
+  vshr = _mm256_loadu_si256((const __m256i *) shr);
+  vshl = _mm256_loadu_si256((const __m256i *) shl);
+  vmask = _mm256_set1_epi32((int) ((uint32_t) mask));
+
+  /* Unpack each group, switching to the padded copy near the end */
+  left = w * PACK_UNIT;
+  for(g = 0; g < AKSINV_BLOCK; g += 8) {
+    if ((!padded) && (left < half + 16)) {
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, pIn, (size_t) left);
+      pIn = tail;
+      padded = 1;
+    }
+    x = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) pIn)),
+          _mm_loadu_si128((const __m128i *) (pIn + half)),
+          1);
+    x = _mm256_and_si256(
+          _mm256_or_si256(
+            _mm256_srlv_epi32(_mm256_shuffle_epi8(x, vlo), vshr),
+            _mm256_sllv_epi32(_mm256_shuffle_epi8(x, vhi), vshl)),
+          vmask);
+    _mm256_storeu_si256((__m256i *) (pGap + g), x);
+    pIn += w;
+    left -= w;
+  }
+#else
+  for(g = 0; g < AKSINV_BLOCK; g += 8) {
+    acc = 0;
+    have = 0;
+    for(i = 0; i < 8; i++) {
+      while (have < w) {
+        acc |= ((uint64_t) *pIn) << have;
+        pIn++;
+        have += 8;
+      }
+      pGap[g + i] = (uint32_t) (acc & mask);
+      acc >>= w;
+      have -= w;
+    }
+  }
+#endif
+}
+
+/*
+ * Get the file offset of a term dictionary record.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   t - the term number
+ * 
+ * Return:
+ * 
+ *   the file offset of the record
+ */
+static int64_t recPos(AKSINV *pi, int64_t t) {
+  if ((t < 0) || (t >= pi->nterm)) {
+    fault(__LINE__);
+  }
+  return pi->dict + (t * REC_SIZE);
+}
+
+/*
+ * Compare a term in the dictionary to a given term.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   t - the term number
+ * 
+ *   pTerm - the term to compare to
+ * 
+ *   tlen - the length of the term to compare to
+ * 
+ * Return:
+ * 
+ *   less than, equal to, or greater than zero as the dictionary term
+ *   sorts before, equal to, or after the given term
+ */
+static int compareTerm(
+    AKSINV        * pi,
+    int64_t         t,
+    const uint8_t * pTerm,
+    int32_t         tlen) {
+
+  int result = 0;
+  const uint8_t *pb = NULL;
+  int32_t len = 0;
+
+  pb = aksinv_term(pi, t, &len);
+  result = memcmp(pb, pTerm, (size_t) ((len < tlen) ? len : tlen));
+  if (result == 0) {
+    if (len < tlen) {
+      result = -1;
+    } else if (len > tlen) {
+      result = 1;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Decode one block of a posting list.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   post - the file offset of the posting list
+ * 
+ *   ndocs - the number of documents in the posting list
+ * 
+ *   blk - the block index
+ * 
+ *   pOut - receives up to AKSINV_BLOCK document IDs
+ * 
+ * Return:
+ * 
+ *   the number of document IDs in the block
+ */
+static int32_t decodeBlock(
+    AKSINV  * pi,
+    int64_t   post,
+    int32_t   ndocs,
+    int32_t   blk,
+    int32_t * pOut) {
+
+  uint32_t gap[AKSINV_BLOCK];
+  int32_t count = 0;
+  int32_t w = 0;
+  int64_t doc = 0;
+  int32_t i = 0;
+
+  count = ndocs - (blk * AKSINV_BLOCK);
+  if (count > AKSINV_BLOCK) {
+    count = AKSINV_BLOCK;
+  }
+
+  w = aksview_read32s(pi->pv, post + (blk * SKIP_SIZE) + SKIP_OFF_WIDTH, 1);
+  if ((w < 0) || (w > 32)) {
+    fault(__LINE__);
+  }
+  if (w > 0) {
+    unpackBlock(
+      aksview_rspan(
+        pi->pv,
+        aksview_read64s(pi->pv, post + (blk * SKIP_SIZE) + SKIP_OFF_POS, 1),
+        w * PACK_UNIT),
+      w, gap);
+  } else {
+    memset(gap, 0, sizeof(gap));
+  }
+
+  /* Each gap is one less than the difference from the previous ID */
+  doc = -1;
+  if (blk > 0) {
+    doc = aksview_read32s(
+            pi->pv, post + ((blk - 1) * SKIP_SIZE) + SKIP_OFF_LAST, 1);
+  }
+  for(i = 0; i < count; i++) {
+    doc += ((int64_t) gap[i]) + 1;
+    pOut[i] = (int32_t) doc;
+  }
+
+  return count;
+}
+
+/*
+ * Find the first block of a posting list, at or after a given block,
+ * whose last document ID is at least a given ID.
+ * 
+ * The skip entries are searched by galloping forward from the starting
+ * block and then by binary search, so a sequence of ascending probes
+ * costs time proportional to the distance skipped, in the logarithm.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   post - the file offset of the posting list
+ * 
+ *   nblk - the number of blocks in the posting list
+ * 
+ *   blk - the block to start at
+ * 
+ *   doc - the document ID
+ * 
+ * Return:
+ * 
+ *   the block index, or nblk if no block qualifies
+ */
+static int32_t seekBlock(
+    AKSINV  * pi,
+    int64_t   post,
+    int32_t   nblk,
+    int32_t   blk,
+    int32_t   doc) {
+
+  int32_t lo = blk;
+  int32_t hi = blk;
+  int32_t step = 1;
+  int32_t mid = 0;
+
+  /* Gallop to find hi such that the answer is in [lo, hi] */
+  for(;;) {
+    if (hi >= nblk) {
+      hi = nblk;
+      break;
+    }
+    if (aksview_read32s(pi->pv, post + (hi * SKIP_SIZE) + SKIP_OFF_LAST, 1)
+          >= doc) {
+      break;
+    }
+    lo = hi + 1;
+    if (hi > nblk - step) {
+      hi = nblk;
+    } else {
+      hi += step;
+    }
+    step *= 2;
+  }
+
+  /* Binary search within [lo, hi] */
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    if (aksview_read32s(pi->pv, post + (mid * SKIP_SIZE) + SKIP_OFF_LAST, 1)
+          >= doc) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  return lo;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksinv_onerror function.
+ */
+void aksinv_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksinv_errstr function.
+ */
+const char *aksinv_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSINV_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSINV_ERR_OPEN:
+      pResult = "Failed to open index segment";
+      break;
+
+    case AKSINV_ERR_FORMAT:
+      pResult = "Index segment has invalid format";
+      break;
+
+    case AKSINV_ERR_RESIZE:
+      pResult = "Failed to resize index segment";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksinvw_new function.
+ */
+AKSINVW *aksinvw_new(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSINVW *pw = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSINV_ERR_NONE;
+
+  /* Allocate the writer structure */
+  pw = (AKSINVW *) calloc(1, sizeof(AKSINVW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file, discarding any existing contents */
+  pw->pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pw->pv == NULL) {
+    status = 0;
+    *perr = AKSINV_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pw->pv, 0)) {
+      status = 0;
+      *perr = AKSINV_ERR_RESIZE;
+    }
+  }
+
+  /* Leave room for the header, which is written last */
+  if (status) {
+    if (!aksview_reserve(pw->pv, HDR_SIZE)) {
+      status = 0;
+      *perr = AKSINV_ERR_RESIZE;
+    }
+  }
+
+  /* Allocate the buffers */
+  if (status) {
+    pw->fend = HDR_SIZE;
+
+    pw->scap = 4096;
+    pw->pStr = (uint8_t *) malloc((size_t) pw->scap);
+    if (pw->pStr == NULL) {
+      fault(__LINE__);
+    }
+
+    pw->dcap = 256;
+    pw->pDict = (uint64_t *) malloc(
+                  (size_t) (pw->dcap * REC_WORDS * 8));
+    if (pw->pDict == NULL) {
+      fault(__LINE__);
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pw->pv);
+    free(pw);
+    pw = NULL;
+  }
+
+  /* Return writer or NULL */
+  return pw;
+}
+
+/*
+ * aksinvw_add function.
+ */
+int aksinvw_add(
+    AKSINVW       * pw,
+    const void    * pTerm,
+    int32_t         tlen,
+    const int32_t * pDocs,
+    int32_t         n) {
+
+  int status = 1;
+  uint32_t gap[AKSINV_BLOCK];
+  uint8_t pack[32 * PACK_UNIT];
+  const uint8_t *pPrev = NULL;
+  int32_t plen = 0;
+  int c = 0;
+  int32_t nblk = 0;
+  int32_t blk = 0;
+  int32_t count = 0;
+  int32_t w = 0;
+  int32_t i = 0;
+  int64_t prev = 0;
+  int64_t size = 0;
+  int64_t bpos = 0;
+  int64_t ncap = 0;
+  uint8_t *pNewStr = NULL;
+  uint64_t *pNewDict = NULL;
+  uint64_t *pr = NULL;
+
+  /* Check parameters */
+  if ((pw == NULL) || (pTerm == NULL) || (pDocs == NULL)) {
+    fault(__LINE__);
+  }
+  if ((tlen < 1) || (tlen > AKSINV_MAXTERM) || (n < 1)) {
+    fault(__LINE__);
+  }
+
+  /* Check that the term sorts after the previous term */
+  if (pw->nterm > 0) {
+    pr = &((pw->pDict)[(pw->nterm - 1) * REC_WORDS]);
+    pPrev = &((pw->pStr)[pr[REC_OFF_SOFF / 8]]);
+    plen = (int32_t) (pr[REC_OFF_TLEN / 8] & UINT64_C(0xffffffff));
+    c = memcmp(pPrev, pTerm, (size_t) ((plen < tlen) ? plen : tlen));
+    if ((c > 0) || ((c == 0) && (plen >= tlen))) {
+      fault(__LINE__);
+    }
+  }
+
+  /* Check the document IDs and compute the size of the posting list */
+  nblk = (n + AKSINV_BLOCK - 1) / AKSINV_BLOCK;
+  size = ((int64_t) nblk) * SKIP_SIZE;
+  prev = -1;
+  for(blk = 0; blk < nblk; blk++) {
+    count = n - (blk * AKSINV_BLOCK);
+    if (count > AKSINV_BLOCK) {
+      count = AKSINV_BLOCK;
+    }
+    w = 0;
+    for(i = 0; i < count; i++) {
+      if (pDocs[(blk * AKSINV_BLOCK) + i] <= prev) {
+        fault(__LINE__);
+      }
+      c = (int) bitWidth(
+                  (uint32_t) (pDocs[(blk * AKSINV_BLOCK) + i] - prev - 1));
+      if (c > w) {
+        w = c;
+      }
+      prev = pDocs[(blk * AKSINV_BLOCK) + i];
+    }
+    size += ((int64_t) w) * PACK_UNIT;
+  }
+
+  /* Make room in the file for the whole posting list */
+  if (pw->fend > AKSVIEW_MAXLEN - size) {
+    fault(__LINE__);
+  }
+  if (!aksview_reserve(pw->pv, pw->fend + size)) {
+    status = 0;
+  }
+
+  /* Write the skip entries and the packed blocks */
+  if (status) {
+    bpos = pw->fend + (((int64_t) nblk) * SKIP_SIZE);
+    prev = -1;
+    for(blk = 0; blk < nblk; blk++) {
+      count = n - (blk * AKSINV_BLOCK);
+      if (count > AKSINV_BLOCK) {
+        count = AKSINV_BLOCK;
+      }
+      w = 0;
+      for(i = 0; i < AKSINV_BLOCK; i++) {
+        if (i < count) {
+          gap[i] = (uint32_t) (pDocs[(blk * AKSINV_BLOCK) + i] - prev - 1);
+          prev = pDocs[(blk * AKSINV_BLOCK) + i];
+          if (bitWidth(gap[i]) > w) {
+            w = bitWidth(gap[i]);
+          }
+        } else {
+          gap[i] = 0;
+        }
+      }
+
+      aksview_write32s(pw->pv, pw->fend + (blk * SKIP_SIZE) + SKIP_OFF_LAST,
+                        1, (int32_t) prev);
+      aksview_write32s(pw->pv, pw->fend + (blk * SKIP_SIZE) + SKIP_OFF_WIDTH,
+                        1, w);
+      aksview_write64s(pw->pv, pw->fend + (blk * SKIP_SIZE) + SKIP_OFF_POS,
+                        1, bpos);
+      if (w > 0) {
+        packBlock(gap, w, pack);
+        aksview_writebuf(pw->pv, bpos, pack, w * PACK_UNIT);
+        bpos += ((int64_t) w) * PACK_UNIT;
+      }
+    }
+  }
+
+  /* Record the term in memory */
+  if (status) {
+    if (pw->slen + tlen > pw->scap) {
+      ncap = pw->scap * 2;
+      while (pw->slen + tlen > ncap) {
+        ncap *= 2;
+      }
+      pNewStr = (uint8_t *) realloc(pw->pStr, (size_t) ncap);
+      if (pNewStr == NULL) {
+        fault(__LINE__);
+      }
+      pw->pStr = pNewStr;
+      pw->scap = ncap;
+    }
+
+    if (pw->nterm >= pw->dcap) {
+      ncap = pw->dcap * 2;
+      pNewDict = (uint64_t *) realloc(
+                    pw->pDict, (size_t) (ncap * REC_WORDS * 8));
+      if (pNewDict == NULL) {
+        fault(__LINE__);
+      }
+      pw->pDict = pNewDict;
+      pw->dcap = ncap;
+    }
+
+    pr = &((pw->pDict)[pw->nterm * REC_WORDS]);
+    pr[REC_OFF_SOFF / 8] = (uint64_t) pw->slen;
+    pr[REC_OFF_POST / 8] = (uint64_t) pw->fend;
+    pr[REC_OFF_TLEN / 8] = ((uint64_t) (uint32_t) tlen) |
+                            (((uint64_t) (uint32_t) n) << 32);
+    memcpy(&((pw->pStr)[pw->slen]), pTerm, (size_t) tlen);
+
+    pw->slen += tlen;
+    (pw->nterm)++;
+    pw->fend += size;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksinvw_finish function.
+ */
+int aksinvw_finish(AKSINVW *pw) {
+
+  int status = 1;
+  int64_t dsize = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Size the file to hold the dictionary and the term strings */
+  dsize = pw->nterm * REC_SIZE;
+  if (pw->fend > AKSVIEW_MAXLEN - dsize - pw->slen) {
+    fault(__LINE__);
+  }
+  if (!aksview_setlen(pw->pv, pw->fend + dsize + pw->slen)) {
+    status = 0;
+  }
+
+  /* Write the dictionary with one bulk store, then the strings, and
+   * then the header with the magic number last */
+  if (status) {
+    aksview_writev64u(pw->pv, pw->fend, 1, pw->pDict,
+                      pw->nterm * REC_WORDS);
+    if (pw->slen > 0) {
+      aksview_writebuf(pw->pv, pw->fend + dsize, pw->pStr, pw->slen);
+    }
+    aksview_write64s(pw->pv, HDR_OFF_NTERM, 1, pw->nterm);
+    aksview_write64s(pw->pv, HDR_OFF_DICT, 1, pw->fend);
+    aksview_write64s(pw->pv, HDR_OFF_STRS, 1, pw->fend + dsize);
+    aksview_write64u(pw->pv, HDR_OFF_MAGIC, 1, INV_MAGIC);
+  }
+
+  /* Release the writer */
+  aksview_close(pw->pv);
+  free(pw->pStr);
+  free(pw->pDict);
+  free(pw);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksinv_open function.
+ */
+AKSINV *aksinv_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSINV *pi = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSINV_ERR_NONE;
+
+  /* Allocate the structure */
+  pi = (AKSINV *) calloc(1, sizeof(AKSINV));
+  if (pi == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pi->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pi->pv == NULL) {
+    status = 0;
+    *perr = AKSINV_ERR_OPEN;
+  }
+
+  /* Read and check the header */
+  if (status) {
+    flen = aksview_getlen(pi->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pi->nterm = aksview_read64s(pi->pv, HDR_OFF_NTERM, 1);
+    pi->dict = aksview_read64s(pi->pv, HDR_OFF_DICT, 1);
+    pi->strs = aksview_read64s(pi->pv, HDR_OFF_STRS, 1);
+    if ((aksview_read64u(pi->pv, HDR_OFF_MAGIC, 1) != INV_MAGIC) ||
+        (pi->dict < HDR_SIZE) || (pi->dict > flen) ||
+        (pi->nterm < 0) || (pi->nterm > (flen - pi->dict) / REC_SIZE) ||
+        (pi->strs != pi->dict + (pi->nterm * REC_SIZE))) {
+      status = 0;
+    }
+    if (!status) {
+      *perr = AKSINV_ERR_FORMAT;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pi->pv);
+    free(pi);
+    pi = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pi;
+}
+
+/*
+ * aksinv_close function.
+ */
+void aksinv_close(AKSINV *pi) {
+  if (pi != NULL) {
+    aksview_close(pi->pv);
+    free(pi);
+  }
+}
+
+/*
+ * aksinv_nterm function.
+ */
+int64_t aksinv_nterm(AKSINV *pi) {
+  if (pi == NULL) {
+    fault(__LINE__);
+  }
+  return pi->nterm;
+}
+
+/*
+ * aksinv_find function.
+ */
+int64_t aksinv_find(AKSINV *pi, const void *pTerm, int32_t tlen) {
+
+  int64_t lo = 0;
+  int64_t hi = 0;
+  int64_t mid = 0;
+  int c = 0;
+
+  /* Check parameters */
+  if ((pi == NULL) || (pTerm == NULL)) {
+    fault(__LINE__);
+  }
+  if (tlen < 0) {
+    fault(__LINE__);
+  }
+
+  /* Binary search for the first term not less than the given term */
+  lo = 0;
+  hi = pi->nterm;
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    c = compareTerm(pi, mid, (const uint8_t *) pTerm, tlen);
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (lo < pi->nterm) {
+    if (compareTerm(pi, lo, (const uint8_t *) pTerm, tlen) != 0) {
+      lo = -1;
+    }
+  } else {
+    lo = -1;
+  }
+
+  return lo;
+}
+
+/*
+ * aksinv_term function.
+ */
+const uint8_t *aksinv_term(AKSINV *pi, int64_t t, int32_t *plen) {
+
+  int64_t rpos = 0;
+  int64_t soff = 0;
+  int32_t tlen = 0;
+
+  /* Check parameters */
+  if ((pi == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Read the record and check the term is within the file */
+  rpos = recPos(pi, t);
+  soff = aksview_read64s(pi->pv, rpos + REC_OFF_SOFF, 1);
+  tlen = aksview_read32s(pi->pv, rpos + REC_OFF_TLEN, 1);
+  if ((tlen < 1) || (tlen > AKSINV_MAXTERM) || (soff < 0) ||
+      (soff > aksview_getlen(pi->pv) - pi->strs - tlen)) {
+    fault(__LINE__);
+  }
+
+  *plen = tlen;
+  return aksview_rspan(pi->pv, pi->strs + soff, tlen);
+}
+
+/*
+ * aksinv_ndocs function.
+ */
+int32_t aksinv_ndocs(AKSINV *pi, int64_t t) {
+
+  int32_t result = 0;
+
+  /* Check parameters */
+  if (pi == NULL) {
+    fault(__LINE__);
+  }
+
+  result = aksview_read32s(pi->pv, recPos(pi, t) + REC_OFF_NDOCS, 1);
+  if (result < 1) {
+    fault(__LINE__);
+  }
+
+  return result;
+}
+
+/*
+ * aksinv_postings function.
+ */
+int32_t aksinv_postings(AKSINV *pi, int64_t t, int32_t *pDocs) {
+
+  int32_t ndocs = 0;
+  int32_t nblk = 0;
+  int32_t blk = 0;
+  int64_t post = 0;
+
+  /* Check parameters */
+  if ((pi == NULL) || (pDocs == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Decode every block in turn */
+  ndocs = aksinv_ndocs(pi, t);
+  post = aksview_read64s(pi->pv, recPos(pi, t) + REC_OFF_POST, 1);
+  nblk = (ndocs + AKSINV_BLOCK - 1) / AKSINV_BLOCK;
+  for(blk = 0; blk < nblk; blk++) {
+    decodeBlock(pi, post, ndocs, blk, &(pDocs[blk * AKSINV_BLOCK]));
+  }
+
+  return ndocs;
+}
+
+/*
+ * aksinv_and function.
+ */
+int32_t aksinv_and(
+    AKSINV        * pi,
+    const int64_t * pTerms,
+    int32_t         nterm,
+    int32_t       * pDocs) {
+
+  int64_t ord[AKSINV_MAXQUERY];
+  int32_t len[AKSINV_MAXQUERY];
+  int32_t buf[AKSINV_BLOCK];
+  int64_t tv = 0;
+  int32_t lv = 0;
+  int32_t ncand = 0;
+  int32_t m = 0;
+  int32_t q = 0;
+  int32_t i = 0;
+  int32_t j = 0;
+  int64_t post = 0;
+  int32_t nblk = 0;
+  int32_t blk = 0;
+  int32_t loaded = 0;
+  int32_t count = 0;
+
+  /* Check parameters */
+  if ((pi == NULL) || (pTerms == NULL) || (pDocs == NULL)) {
+    fault(__LINE__);
+  }
+  if ((nterm < 1) || (nterm > AKSINV_MAXQUERY)) {
+    fault(__LINE__);
+  }
+
+  /* Order the terms by increasing posting list length */
+  for(q = 0; q < nterm; q++) {
+    tv = pTerms[q];
+    lv = aksinv_ndocs(pi, tv);
+    for(i = q; (i > 0) && (len[i - 1] > lv); i--) {
+      ord[i] = ord[i - 1];
+      len[i] = len[i - 1];
+    }
+    ord[i] = tv;
+    len[i] = lv;
+  }
+
+  /* The candidates start as the whole shortest posting list */
+  ncand = aksinv_postings(pi, ord[0], pDocs);
+
+  /* Keep only the candidates found in each other posting list */
+  for(q = 1; (q < nterm) && (ncand > 0); q++) {
+    post = aksview_read64s(pi->pv, recPos(pi, ord[q]) + REC_OFF_POST, 1);
+    nblk = (len[q] + AKSINV_BLOCK - 1) / AKSINV_BLOCK;
+    blk = 0;
+    loaded = -1;
+    count = 0;
+    j = 0;
+    m = 0;
+
+    for(i = 0; i < ncand; i++) {
+      blk = seekBlock(pi, post, nblk, blk, pDocs[i]);
+      if (blk >= nblk) {
+        break;
+      }
+      if (blk != loaded) {
+        count = decodeBlock(pi, post, len[q], blk, buf);
+        loaded = blk;
+        j = 0;
+      }
+      while ((j < count - 1) && (buf[j] < pDocs[i])) {
+        j++;
+      }
+      if (buf[j] == pDocs[i]) {
+        pDocs[m] = pDocs[i];
+        m++;
+      }
+    }
+
+    ncand = m;
+  }
+
+  return ncand;
+}
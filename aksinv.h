@@ -0,0 +1,336 @@
+#ifndef AKSINV_H_INCLUDED
+#define AKSINV_H_INCLUDED
+
+/*
+ * aksinv.h
+ * ========
+ * 
+ * Inverted index segments with bit-packed posting lists, built on top of
+ * AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The number of document IDs in each block of a posting list.
+ * 
+ * Each block is bit-packed with a single bit width, and each block has
+ * one skip entry.
+ */
+#define AKSINV_BLOCK (128)
+
+/*
+ * The maximum length in bytes of a term.
+ */
+#define AKSINV_MAXTERM (INT32_C(65535))
+
+/*
+ * The maximum number of terms in a conjunctive query.
+ */
+#define AKSINV_MAXQUERY (64)
+
+/*
+ * Structure prototypes for AKSINV and AKSINVW.
+ * 
+ * AKSINV is an index segment open for reading.  AKSINVW is an index
+ * segment that is being written.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSINV_TAG;
+typedef struct AKSINV_TAG AKSINV;
+
+struct AKSINVW_TAG;
+typedef struct AKSINVW_TAG AKSINVW;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksinv_errstr() to convert these to error messages.
+ */
+#define AKSINV_ERR_NONE   (0)
+#define AKSINV_ERR_OPEN   (1)
+#define AKSINV_ERR_FORMAT (2)
+#define AKSINV_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksinv.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksinv_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSINV_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksinv_errstr(int code);
+
+/*
+ * Begin writing a new index segment.
+ * 
+ * The file at pPath is created if it does not exist, and truncated to
+ * length zero if it does.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSINV_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the file to write
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new segment writer or NULL if the function failed
+ */
+AKSINVW *aksinvw_new(const char *pPath, int *perr);
+
+/*
+ * Add a term and its posting list to a segment that is being written.
+ * 
+ * Terms must be added in strictly ascending order, comparing bytes as
+ * unsigned values with a shorter term sorting before any longer term
+ * that it is a prefix of, or a fault occurs.  tlen must be in range
+ * [1, AKSINV_MAXTERM].
+ * 
+ * pDocs points to n document IDs, which must be non-negative and
+ * strictly ascending, or a fault occurs.  n must be at least one.
+ * 
+ * The posting list is written to the file at once.  Only the term
+ * itself is kept in memory until the segment is finished.
+ * 
+ * Parameters:
+ * 
+ *   pw - the segment writer
+ * 
+ *   pTerm - the term
+ * 
+ *   tlen - the length of the term in bytes
+ * 
+ *   pDocs - the document IDs
+ * 
+ *   n - the number of document IDs
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int aksinvw_add(
+    AKSINVW       * pw,
+    const void    * pTerm,
+    int32_t         tlen,
+    const int32_t * pDocs,
+    int32_t         n);
+
+/*
+ * Finish writing an index segment.
+ * 
+ * The term dictionary is written after the last posting list, the file
+ * is trimmed to its exact length, and the writer is released.  The
+ * writer may not be used again after this call, regardless of whether
+ * it succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pw - the segment writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be resized
+ */
+int aksinvw_finish(AKSINVW *pw);
+
+/*
+ * Open an index segment for reading.
+ * 
+ * Only the header is read, so opening a segment of any size is
+ * constant time.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksinvw_new().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the segment file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new segment object or NULL if the function failed
+ */
+AKSINV *aksinv_open(const char *pPath, int *perr);
+
+/*
+ * Close an index segment.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment, or NULL
+ */
+void aksinv_close(AKSINV *pi);
+
+/*
+ * Get the number of terms in an index segment.
+ * 
+ * Terms are numbered from zero in ascending order.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ * Return:
+ * 
+ *   the number of terms
+ */
+int64_t aksinv_nterm(AKSINV *pi);
+
+/*
+ * Find a term in an index segment.
+ * 
+ * The term dictionary is searched with a binary search, so this touches
+ * about log2(n) dictionary entries.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   pTerm - the term
+ * 
+ *   tlen - the length of the term in bytes
+ * 
+ * Return:
+ * 
+ *   the term number, or -1 if the term is not in the segment
+ */
+int64_t aksinv_find(AKSINV *pi, const void *pTerm, int32_t tlen);
+
+/*
+ * Get a term from an index segment.
+ * 
+ * t must be in range zero up to one less than aksinv_nterm().  The
+ * term is returned as a pointer directly into the mapped file, and its
+ * length is written to *plen.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to
+ * any function on the same segment.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   t - the term number
+ * 
+ *   plen - receives the length of the term
+ * 
+ * Return:
+ * 
+ *   pointer to the term bytes
+ */
+const uint8_t *aksinv_term(AKSINV *pi, int64_t t, int32_t *plen);
+
+/*
+ * Get the number of documents in the posting list of a term.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   t - the term number
+ * 
+ * Return:
+ * 
+ *   the number of documents
+ */
+int32_t aksinv_ndocs(AKSINV *pi, int64_t t);
+
+/*
+ * Decode the whole posting list of a term.
+ * 
+ * pDocs must have room for aksinv_ndocs() document IDs.  The IDs are
+ * written in ascending order.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   t - the term number
+ * 
+ *   pDocs - receives the document IDs
+ * 
+ * Return:
+ * 
+ *   the number of document IDs written
+ */
+int32_t aksinv_postings(AKSINV *pi, int64_t t, int32_t *pDocs);
+
+/*
+ * Intersect the posting lists of several terms.
+ * 
+ * pTerms points to nterm term numbers, where nterm is in range [1,
+ * AKSINV_MAXQUERY].  The document IDs that appear in every posting list
+ * are written to pDocs in ascending order.  pDocs must have room for
+ * the smallest aksinv_ndocs() of the terms.
+ * 
+ * The shortest posting list is decoded in full.  The others are then
+ * probed in order of increasing length, using their skip entries to
+ * jump to the only block that can hold each candidate, so blocks that
+ * contain no candidates are never decoded or touched.
+ * 
+ * Parameters:
+ * 
+ *   pi - the segment
+ * 
+ *   pTerms - the term numbers
+ * 
+ *   nterm - the number of terms
+ * 
+ *   pDocs - receives the matching document IDs
+ * 
+ * Return:
+ * 
+ *   the number of matching document IDs
+ */
+int32_t aksinv_and(
+    AKSINV        * pi,
+    const int64_t * pTerms,
+    int32_t         nterm,
+    int32_t       * pDocs);
+
+#endif
@@ -0,0 +1,1053 @@
+/*
+ * aksjoin.c
+ * =========
+ * 
+ * Implementation of aksjoin.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksjoin.h"
+#include "akspool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The target size in bytes of a left partition.
+ * 
+ * A partition of this size, together with its hash table, fits in the
+ * second-level cache of most processors.
+ */
+#define PART_BYTES (INT64_C(262144))
+
+/*
+ * The maximum number of partition bits.
+ */
+#define MAXBITS (12)
+
+/*
+ * The number of bytes of input records that are mapped at a time.
+ */
+#define CHUNK_BYTES (INT32_C(1048576))
+
+/*
+ * The size in bytes of the staging buffer for each partition while
+ * partitioning.
+ * 
+ * Records are gathered into these buffers and copied to the partition
+ * stores in runs, so that partitioning writes to a few cache lines per
+ * partition at a time rather than one scattered record at a time.
+ */
+#define STAGE_BYTES (2048)
+
+/*
+ * The number of partitions joined by each task in a batch.
+ */
+#define TASK_PARTS (16)
+
+/*
+ * The maximum length of the task number suffix on scratch paths,
+ * including the dot and the terminating nul.
+ */
+#define SUFFIX_MAX (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * JOIN structure.
+ * 
+ * The state shared by all the tasks of a join.
+ * 
+ * The records of each side are split among ntask partitioning tasks by
+ * record index.  Each partitioning task has its own store, which is
+ * either a heap buffer or a scratch file.  The store holds all of the
+ * task's left records grouped by partition, followed by all of its
+ * right records grouped by partition.  Each task has a store of its own
+ * because writable viewers cannot share a file on every platform.
+ */
+typedef struct {
+
+  /*
+   * The two inputs, left first.
+   */
+  AKSJOIN_SIDE side[2];
+
+  /*
+   * The number of partition bits and partitions.
+   */
+  int32_t nbits;
+  int64_t npart;
+
+  /*
+   * The number of partitioning tasks and stores.
+   */
+  int32_t ntask;
+
+  /*
+   * For each side, the number of records and the byte offset within the
+   * store of each partition of each task, indexed by task and then by
+   * partition.
+   */
+  int64_t *pCnt[2];
+  int64_t *pOff[2];
+
+  /*
+   * Non-zero if the stores are scratch files, in which case ppPath has
+   * the path of each.  Otherwise, ppMem has the buffer of each.
+   */
+  int scratch;
+  char **ppPath;
+  uint8_t **ppMem;
+
+} JOIN;
+
+/*
+ * JOIN_TASK structure.
+ * 
+ * One task of a join.  Partitioning tasks use t, and join tasks use the
+ * partition range [p0, p1).  Join tasks leave their output rows in
+ * pRows, which holds nrows rows and has room for cap bytes.  err is set
+ * to an error code if the task fails.
+ */
+typedef struct {
+  JOIN *pj;
+  int32_t t;
+  int64_t p0;
+  int64_t p1;
+  uint8_t *pRows;
+  int64_t nrows;
+  int64_t cap;
+  int err;
+} JOIN_TASK;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksjoin fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksjoin warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint64_t getKey(const uint8_t *p);
+static uint64_t hashKey(uint64_t k);
+static int64_t partOf(const JOIN *pj, uint64_t h);
+static void taskRange(
+    const JOIN * pj,
+    int          s,
+    int32_t      t,
+    int64_t    * pr0,
+    int64_t    * pr1);
+static void storeRun(
+    AKSVIEW       * pvStore,
+    uint8_t       * pMem,
+    int64_t         pos,
+    const uint8_t * pSrc,
+    int64_t         len);
+static void histTask(void *pArg);
+static void scatterTask(void *pArg);
+static void joinTask(void *pArg);
+static void runTasks(
+    AKSPOOL   * pPool,
+    JOIN_TASK * pTasks,
+    int64_t     ntask,
+    void     (* fp)(void *));
+
+/*
+ * Decode a little-endian 64-bit key.
+ * 
+ * Parameters:
+ * 
+ *   p - pointer to the eight bytes of the key
+ * 
+ * Return:
+ * 
+ *   the key
+ */
+static uint64_t getKey(const uint8_t *p) {
+
+  uint64_t k = 0;
+  int i = 0;
+
+  for(i = 7; i >= 0; i--) {
+    k = (k << 8) | ((uint64_t) p[i]);
+  }
+
+  return k;
+}
+
+/*
+ * Hash a key.
+ * 
+ * The high bits of the hash select the partition and the low bits
+ * select the bucket within the partition's hash table, so all of the
+ * bits must depend on all of the bits of the key.  This uses the
+ * finalizer of the SplitMix64 generator.
+ * 
+ * Parameters:
+ * 
+ *   k - the key
+ * 
+ * Return:
+ * 
+ *   the hash
+ */
+static uint64_t hashKey(uint64_t k) {
+  k ^= k >> 30;
+  k *= UINT64_C(0xbf58476d1ce4e5b9);
+  k ^= k >> 27;
+  k *= UINT64_C(0x94d049bb133111eb);
+  k ^= k >> 31;
+  return k;
+}
+
+/*
+ * Get the partition of a key hash.
+ * 
+ * Parameters:
+ * 
+ *   pj - the join
+ * 
+ *   h - the hash
+ * 
+ * Return:
+ * 
+ *   the partition index
+ */
+static int64_t partOf(const JOIN *pj, uint64_t h) {
+
+  int64_t result = 0;
+
+  if (pj->nbits > 0) {
+    result = (int64_t) (h >> (64 - pj->nbits));
+  }
+
+  return result;
+}
+
+/*
+ * Get the range of record indices of one side that a partitioning task
+ * handles.
+ * 
+ * Parameters:
+ * 
+ *   pj - the join
+ * 
+ *   s - the side, 0 for left or 1 for right
+ * 
+ *   t - the task
+ * 
+ *   pr0 - receives the first record index
+ * 
+ *   pr1 - receives one past the last record index
+ */
+static void taskRange(
+    const JOIN * pj,
+    int          s,
+    int32_t      t,
+    int64_t    * pr0,
+    int64_t    * pr1) {
+
+  int64_t n = (pj->side)[s].n;
+
+  *pr0 = (n / pj->ntask) * t + ((n % pj->ntask) * t) / pj->ntask;
+  *pr1 = (n / pj->ntask) * (t + 1) +
+          ((n % pj->ntask) * (t + 1)) / pj->ntask;
+}
+
+/*
+ * Copy a run of staged records into a store.
+ * 
+ * Parameters:
+ * 
+ *   pvStore - the viewer on the scratch file, or NULL
+ * 
+ *   pMem - the heap buffer if pvStore is NULL
+ * 
+ *   pos - the byte offset in the store
+ * 
+ *   pSrc - the records
+ * 
+ *   len - the length of the records in bytes
+ */
+static void storeRun(
+    AKSVIEW       * pvStore,
+    uint8_t       * pMem,
+    int64_t         pos,
+    const uint8_t * pSrc,
+    int64_t         len) {
+
+  if (pvStore != NULL) {
+    aksview_writebuf(pvStore, pos, pSrc, len);
+  } else {
+    memcpy(pMem + pos, pSrc, (size_t) len);
+  }
+}
+
+/*
+ * Partitioning task that counts the records of each partition in the
+ * task's share of both inputs.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the JOIN_TASK
+ */
+static void histTask(void *pArg) {
+
+  JOIN_TASK *pk = (JOIN_TASK *) pArg;
+  JOIN *pj = pk->pj;
+  const AKSJOIN_SIDE *pd = NULL;
+  AKSVIEW *pv = NULL;
+  const uint8_t *pc = NULL;
+  int64_t *pCnt = NULL;
+  int64_t r0 = 0;
+  int64_t r1 = 0;
+  int64_t r = 0;
+  int64_t k = 0;
+  int64_t chunk = 0;
+  int64_t j = 0;
+  int s = 0;
+
+  for(s = 0; (s < 2) && (pk->err == AKSJOIN_ERR_NONE); s++) {
+    pd = &((pj->side)[s]);
+    pCnt = &((pj->pCnt)[s][pk->t * pj->npart]);
+    taskRange(pj, s, pk->t, &r0, &r1);
+    if (r0 >= r1) {
+      continue;
+    }
+
+    pv = aksview_create(pd->pPath, AKSVIEW_READONLY, NULL);
+    if (pv == NULL) {
+      pk->err = AKSJOIN_ERR_OPEN;
+      continue;
+    }
+
+    chunk = CHUNK_BYTES / pd->stride;
+    for(r = r0; r < r1; r += k) {
+      k = r1 - r;
+      if (k > chunk) {
+        k = chunk;
+      }
+      pc = aksview_rspan(pv, pd->pos + (r * pd->stride),
+                          (int32_t) (k * pd->stride));
+      for(j = 0; j < k; j++) {
+        (pCnt[partOf(pj,
+            hashKey(getKey(pc + (j * pd->stride) + pd->keyoff)))])++;
+      }
+    }
+
+    aksview_close(pv);
+  }
+}
+
+/*
+ * Partitioning task that copies the task's share of both inputs into
+ * its store, grouped by partition.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the JOIN_TASK
+ */
+static void scatterTask(void *pArg) {
+
+  JOIN_TASK *pk = (JOIN_TASK *) pArg;
+  JOIN *pj = pk->pj;
+  const AKSJOIN_SIDE *pd = NULL;
+  AKSVIEW *pv = NULL;
+  AKSVIEW *pvStore = NULL;
+  uint8_t *pMem = NULL;
+  uint8_t *pStage = NULL;
+  int64_t *pFill = NULL;
+  int64_t *pWpos = NULL;
+  const uint8_t *pc = NULL;
+  const uint8_t *pRec = NULL;
+  int64_t stage = 0;
+  int64_t r0 = 0;
+  int64_t r1 = 0;
+  int64_t r = 0;
+  int64_t k = 0;
+  int64_t chunk = 0;
+  int64_t j = 0;
+  int64_t p = 0;
+  int s = 0;
+
+  /* Open the store */
+  if (pj->scratch) {
+    pvStore = aksview_create((pj->ppPath)[pk->t], AKSVIEW_EXISTING, NULL);
+    if (pvStore == NULL) {
+      pk->err = AKSJOIN_ERR_SCRATCH;
+    } else {
+      /* Runs are written all over the store, so map as much of it as
+       * possible at once */
+      aksview_sethint(pvStore, AKSVIEW_MAXSPAN);
+    }
+  } else {
+    pMem = (pj->ppMem)[pk->t];
+  }
+
+  /* Allocate the staging buffers */
+  pFill = (int64_t *) malloc((size_t) (pj->npart * 8));
+  pWpos = (int64_t *) malloc((size_t) (pj->npart * 8));
+  if ((pFill == NULL) || (pWpos == NULL)) {
+    fault(__LINE__);
+  }
+
+  for(s = 0; (s < 2) && (pk->err == AKSJOIN_ERR_NONE); s++) {
+    pd = &((pj->side)[s]);
+    taskRange(pj, s, pk->t, &r0, &r1);
+    if (r0 >= r1) {
+      continue;
+    }
+
+    pv = aksview_create(pd->pPath, AKSVIEW_READONLY, NULL);
+    if (pv == NULL) {
+      pk->err = AKSJOIN_ERR_OPEN;
+      continue;
+    }
+
+    /* Each partition has room for at least one record of staging */
+    stage = STAGE_BYTES / pd->stride;
+    if (stage < 1) {
+      stage = 1;
+    }
+    free(pStage);
+    pStage = (uint8_t *) malloc((size_t) (pj->npart * stage * pd->stride));
+    if (pStage == NULL) {
+      fault(__LINE__);
+    }
+    memset(pFill, 0, (size_t) (pj->npart * 8));
+    memcpy(pWpos, &((pj->pOff)[s][pk->t * pj->npart]),
+            (size_t) (pj->npart * 8));
+
+    /* Stage each record in its partition, copying full runs out */
+    chunk = CHUNK_BYTES / pd->stride;
+    for(r = r0; r < r1; r += k) {
+      k = r1 - r;
+      if (k > chunk) {
+        k = chunk;
+      }
+      pc = aksview_rspan(pv, pd->pos + (r * pd->stride),
+                          (int32_t) (k * pd->stride));
+      for(j = 0; j < k; j++) {
+        pRec = pc + (j * pd->stride);
+        p = partOf(pj, hashKey(getKey(pRec + pd->keyoff)));
+        memcpy(pStage + (((p * stage) + pFill[p]) * pd->stride), pRec,
+                (size_t) pd->stride);
+        (pFill[p])++;
+        if (pFill[p] >= stage) {
+          storeRun(pvStore, pMem, pWpos[p],
+                    pStage + (p * stage * pd->stride), stage * pd->stride);
+          pWpos[p] += stage * pd->stride;
+          pFill[p] = 0;
+        }
+      }
+    }
+
+    /* Copy out the partly filled runs */
+    for(p = 0; p < pj->npart; p++) {
+      if (pFill[p] > 0) {
+        storeRun(pvStore, pMem, pWpos[p],
+                  pStage + (p * stage * pd->stride), pFill[p] * pd->stride);
+      }
+    }
+
+    aksview_close(pv);
+  }
+
+  /* Release everything */
+  aksview_close(pvStore);
+  free(pStage);
+  free(pFill);
+  free(pWpos);
+}
+
+/*
+ * Join task that joins a range of partitions.
+ * 
+ * For each partition, the left records are gathered from every store
+ * into one buffer and a chained hash table is built over their keys.
+ * The right records are then streamed from every store and looked up
+ * in the table.  The keys are kept in their own array so that a lookup
+ * only touches the records of keys that match.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the JOIN_TASK
+ */
+static void joinTask(void *pArg) {
+
+  JOIN_TASK *pk = (JOIN_TASK *) pArg;
+  JOIN *pj = pk->pj;
+  const AKSJOIN_SIDE *pl = &((pj->side)[0]);
+  const AKSJOIN_SIDE *pr = &((pj->side)[1]);
+  AKSVIEW **ppv = NULL;
+  uint8_t *pLeft = NULL;
+  uint64_t *pKeys = NULL;
+  int64_t *pNext = NULL;
+  int64_t *pHeads = NULL;
+  const uint8_t *pc = NULL;
+  const uint8_t *pRec = NULL;
+  int64_t lmax = 0;
+  int64_t hmax = 0;
+  int64_t rowlen = 0;
+  int64_t lc = 0;
+  int64_t rc = 0;
+  int64_t nb = 0;
+  int64_t seg = 0;
+  int64_t off = 0;
+  int64_t x = 0;
+  int64_t len = 0;
+  int64_t chunk = 0;
+  int64_t p = 0;
+  int64_t i = 0;
+  int64_t j = 0;
+  uint64_t key = 0;
+  uint64_t h = 0;
+  int32_t t = 0;
+
+  rowlen = pl->stride + pr->stride;
+  chunk = (CHUNK_BYTES / pr->stride) * pr->stride;
+
+  /* Open every scratch store read-only */
+  if (pj->scratch) {
+    ppv = (AKSVIEW **) calloc((size_t) pj->ntask, sizeof(AKSVIEW *));
+    if (ppv == NULL) {
+      fault(__LINE__);
+    }
+    for(t = 0; t < pj->ntask; t++) {
+      ppv[t] = aksview_create((pj->ppPath)[t], AKSVIEW_READONLY, NULL);
+      if (ppv[t] == NULL) {
+        pk->err = AKSJOIN_ERR_SCRATCH;
+      }
+    }
+  }
+
+  for(p = pk->p0; (p < pk->p1) && (pk->err == AKSJOIN_ERR_NONE); p++) {
+
+    /* Count both sides, skipping the partition if either is empty */
+    lc = 0;
+    rc = 0;
+    for(t = 0; t < pj->ntask; t++) {
+      lc += (pj->pCnt)[0][(t * pj->npart) + p];
+      rc += (pj->pCnt)[1][(t * pj->npart) + p];
+    }
+    if ((lc < 1) || (rc < 1)) {
+      continue;
+    }
+
+    /* Grow the buffers as necessary */
+    if (lc > lmax) {
+      lmax = lc;
+      free(pLeft);
+      free(pKeys);
+      free(pNext);
+      pLeft = (uint8_t *) malloc((size_t) (lmax * pl->stride));
+      pKeys = (uint64_t *) malloc((size_t) (lmax * 8));
+      pNext = (int64_t *) malloc((size_t) (lmax * 8));
+      if ((pLeft == NULL) || (pKeys == NULL) || (pNext == NULL)) {
+        fault(__LINE__);
+      }
+    }
+    nb = 16;
+    while (nb < lc) {
+      nb *= 2;
+    }
+    if (nb > hmax) {
+      hmax = nb;
+      free(pHeads);
+      pHeads = (int64_t *) malloc((size_t) (hmax * 8));
+      if (pHeads == NULL) {
+        fault(__LINE__);
+      }
+    }
+
+    /* Gather the left records */
+    off = 0;
+    for(t = 0; t < pj->ntask; t++) {
+      seg = (pj->pCnt)[0][(t * pj->npart) + p] * pl->stride;
+      if (seg < 1) {
+        continue;
+      }
+      if (pj->scratch) {
+        aksview_readbuf(ppv[t], (pj->pOff)[0][(t * pj->npart) + p],
+                        pLeft + off, seg);
+      } else {
+        memcpy(pLeft + off,
+                (pj->ppMem)[t] + (pj->pOff)[0][(t * pj->npart) + p],
+                (size_t) seg);
+      }
+      off += seg;
+    }
+
+    /* Build the hash table */
+    for(i = 0; i < nb; i++) {
+      pHeads[i] = -1;
+    }
+    for(i = 0; i < lc; i++) {
+      pKeys[i] = getKey(pLeft + (i * pl->stride) + pl->keyoff);
+      h = hashKey(pKeys[i]) & ((uint64_t) (nb - 1));
+      pNext[i] = pHeads[h];
+      pHeads[h] = i;
+    }
+
+    /* Stream the right records past the table */
+    for(t = 0; t < pj->ntask; t++) {
+      seg = (pj->pCnt)[1][(t * pj->npart) + p] * pr->stride;
+      off = (pj->pOff)[1][(t * pj->npart) + p];
+      for(x = 0; x < seg; x += len) {
+        len = seg - x;
+        if (len > chunk) {
+          len = chunk;
+        }
+        if (pj->scratch) {
+          pc = aksview_rspan(ppv[t], off + x, (int32_t) len);
+        } else {
+          pc = (pj->ppMem)[t] + off + x;
+        }
+
+        for(j = 0; j < len; j += pr->stride) {
+          pRec = pc + j;
+          key = getKey(pRec + pr->keyoff);
+          h = hashKey(key) & ((uint64_t) (nb - 1));
+          for(i = pHeads[h]; i >= 0; i = pNext[i]) {
+            if (pKeys[i] != key) {
+              continue;
+            }
+
+            /* Emit a row, doubling the row buffer when it is full */
+            if ((pk->nrows + 1) * rowlen > pk->cap) {
+              pk->cap = (pk->cap > 0) ? (pk->cap * 2) : (rowlen * 1024);
+              pk->pRows = (uint8_t *) realloc(pk->pRows, (size_t) pk->cap);
+              if (pk->pRows == NULL) {
+                fault(__LINE__);
+              }
+            }
+            memcpy(pk->pRows + (pk->nrows * rowlen),
+                    pLeft + (i * pl->stride), (size_t) pl->stride);
+            memcpy(pk->pRows + (pk->nrows * rowlen) + pl->stride, pRec,
+                    (size_t) pr->stride);
+            (pk->nrows)++;
+          }
+        }
+      }
+    }
+  }
+
+  /* Release everything */
+  if (ppv != NULL) {
+    for(t = 0; t < pj->ntask; t++) {
+      aksview_close(ppv[t]);
+    }
+    free(ppv);
+  }
+  free(pLeft);
+  free(pKeys);
+  free(pNext);
+  free(pHeads);
+}
+
+/*
+ * Run a set of tasks on a pool, or on the calling thread if the pool is
+ * NULL, and wait for them to finish.
+ * 
+ * Parameters:
+ * 
+ *   pPool - the pool, or NULL
+ * 
+ *   pTasks - the tasks
+ * 
+ *   ntask - the number of tasks
+ * 
+ *   fp - the task function
+ */
+static void runTasks(
+    AKSPOOL   * pPool,
+    JOIN_TASK * pTasks,
+    int64_t     ntask,
+    void     (* fp)(void *)) {
+
+  int64_t t = 0;
+
+  for(t = 0; t < ntask; t++) {
+    if (pPool != NULL) {
+      akspool_submit(pPool, fp, &(pTasks[t]));
+    } else {
+      fp(&(pTasks[t]));
+    }
+  }
+  if (pPool != NULL) {
+    akspool_wait(pPool);
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksjoin_onerror function.
+ */
+void aksjoin_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksjoin_errstr function.
+ */
+const char *aksjoin_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSJOIN_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSJOIN_ERR_OPEN:
+      pResult = "Failed to open input file";
+      break;
+
+    case AKSJOIN_ERR_SCRATCH:
+      pResult = "Failed to create scratch file";
+      break;
+
+    case AKSJOIN_ERR_RESIZE:
+      pResult = "Failed to resize output file";
+      break;
+
+    case AKSJOIN_ERR_THREAD:
+      pResult = "Failed to start worker threads";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksjoin_run function.
+ */
+int64_t aksjoin_run(
+    const AKSJOIN_SIDE * pLeft,
+    const AKSJOIN_SIDE * pRight,
+    const char         * pScratch,
+    int                  nthreads,
+    AKSVIEW            * pOut,
+    int64_t              opos,
+    int                * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  JOIN j;
+  JOIN_TASK *pTasks = NULL;
+  AKSVIEW *pv = NULL;
+  const AKSJOIN_SIDE *pd = NULL;
+  AKSPOOL *pPool = NULL;
+  int64_t result = 0;
+  int64_t olen = 0;
+  int64_t rowlen = 0;
+  int64_t bytes = 0;
+  int64_t target = 0;
+  int64_t off = 0;
+  int64_t p = 0;
+  int64_t p0 = 0;
+  int64_t len = 0;
+  size_t plen = 0;
+  int32_t t = 0;
+  int s = 0;
+
+  /* Check parameters */
+  if ((pLeft == NULL) || (pRight == NULL) || (pOut == NULL)) {
+    fault(__LINE__);
+  }
+  if ((nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD) ||
+      (opos < 0) || (opos > AKSVIEW_MAXLEN)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pOut)) {
+    fault(__LINE__);
+  }
+  for(s = 0; s < 2; s++) {
+    pd = (s == 0) ? pLeft : pRight;
+    if ((pd->pPath == NULL) || (pd->pos < 0) || (pd->n < 0) ||
+        (pd->stride < 8) || (pd->stride > AKSJOIN_MAXSTRIDE) ||
+        (pd->keyoff < 0) || (pd->keyoff > pd->stride - 8)) {
+      fault(__LINE__);
+    }
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSJOIN_ERR_NONE;
+
+  /* Check that both inputs can be opened and hold their records */
+  memset(&j, 0, sizeof(JOIN));
+  for(s = 0; status && (s < 2); s++) {
+    pd = (s == 0) ? pLeft : pRight;
+    (j.side)[s] = *pd;
+    pv = aksview_create(pd->pPath, AKSVIEW_READONLY, NULL);
+    if (pv == NULL) {
+      status = 0;
+      *perr = AKSJOIN_ERR_OPEN;
+    } else {
+      if ((pd->pos > aksview_getlen(pv)) ||
+          (pd->n > (aksview_getlen(pv) - pd->pos) / pd->stride)) {
+        fault(__LINE__);
+      }
+      bytes += pd->n * pd->stride;
+      aksview_close(pv);
+      pv = NULL;
+    }
+  }
+
+  /* Start the worker threads */
+  if (status && (nthreads > 0)) {
+    pPool = akspool_new(nthreads);
+    if (pPool == NULL) {
+      status = 0;
+      *perr = AKSJOIN_ERR_THREAD;
+    }
+  }
+
+  /* Choose enough partitions that the left partitions fit in cache */
+  if (status) {
+    target = ((pLeft->n * pLeft->stride) + PART_BYTES - 1) / PART_BYTES;
+    while ((j.nbits < MAXBITS) && ((INT64_C(1) << j.nbits) < target)) {
+      (j.nbits)++;
+    }
+    j.npart = INT64_C(1) << j.nbits;
+    j.ntask = (nthreads > 0) ? nthreads : 1;
+    j.scratch = ((pScratch != NULL) && (bytes > AKSJOIN_HEAPMAX));
+
+    for(s = 0; s < 2; s++) {
+      (j.pCnt)[s] = (int64_t *) calloc((size_t) (j.ntask * j.npart), 8);
+      (j.pOff)[s] = (int64_t *) malloc((size_t) (j.ntask * j.npart * 8));
+      if (((j.pCnt)[s] == NULL) || ((j.pOff)[s] == NULL)) {
+        fault(__LINE__);
+      }
+    }
+    j.ppPath = (char **) calloc((size_t) j.ntask, sizeof(char *));
+    j.ppMem = (uint8_t **) calloc((size_t) j.ntask, sizeof(uint8_t *));
+    pTasks = (JOIN_TASK *) calloc((size_t) j.ntask, sizeof(JOIN_TASK));
+    if ((j.ppPath == NULL) || (j.ppMem == NULL) || (pTasks == NULL)) {
+      fault(__LINE__);
+    }
+    for(t = 0; t < j.ntask; t++) {
+      pTasks[t].pj = &j;
+      pTasks[t].t = t;
+    }
+  }
+
+  /* Count the records of each partition in parallel */
+  if (status) {
+    runTasks(pPool, pTasks, j.ntask, &histTask);
+    for(t = 0; status && (t < j.ntask); t++) {
+      if (pTasks[t].err != AKSJOIN_ERR_NONE) {
+        status = 0;
+        *perr = pTasks[t].err;
+      }
+    }
+  }
+
+  /* Lay out each store and create it */
+  for(t = 0; status && (t < j.ntask); t++) {
+    off = 0;
+    for(s = 0; s < 2; s++) {
+      for(p = 0; p < j.npart; p++) {
+        (j.pOff)[s][(t * j.npart) + p] = off;
+        off += (j.pCnt)[s][(t * j.npart) + p] * (j.side)[s].stride;
+      }
+    }
+
+    if (j.scratch) {
+      plen = strlen(pScratch) + SUFFIX_MAX;
+      (j.ppPath)[t] = (char *) malloc(plen);
+      if ((j.ppPath)[t] == NULL) {
+        fault(__LINE__);
+      }
+      sprintf((j.ppPath)[t], "%s.%d", pScratch, (int) t);
+
+      pv = aksview_create((j.ppPath)[t], AKSVIEW_REGULAR, NULL);
+      if (pv == NULL) {
+        status = 0;
+      } else if (!aksview_setlen(pv, 0) || !aksview_setlen(pv, off)) {
+        status = 0;
+      }
+      aksview_close(pv);
+      pv = NULL;
+      if (!status) {
+        *perr = AKSJOIN_ERR_SCRATCH;
+      }
+
+    } else {
+      (j.ppMem)[t] = (uint8_t *) malloc((size_t) ((off > 0) ? off : 1));
+      if ((j.ppMem)[t] == NULL) {
+        fault(__LINE__);
+      }
+    }
+  }
+
+  /* Partition both inputs in parallel */
+  if (status) {
+    runTasks(pPool, pTasks, j.ntask, &scatterTask);
+    for(t = 0; status && (t < j.ntask); t++) {
+      if (pTasks[t].err != AKSJOIN_ERR_NONE) {
+        status = 0;
+        *perr = pTasks[t].err;
+      }
+    }
+  }
+
+  /* Join the partitions in batches, writing the rows of each batch in
+   * task order before starting the next, so that only one batch of
+   * rows is held in memory */
+  if (status) {
+    olen = aksview_getlen(pOut);
+    rowlen = pLeft->stride + pRight->stride;
+  }
+  for(p0 = 0; status && (p0 < j.npart); p0 += j.ntask * TASK_PARTS) {
+    for(t = 0; t < j.ntask; t++) {
+      pTasks[t].p0 = p0 + (t * TASK_PARTS);
+      pTasks[t].p1 = pTasks[t].p0 + TASK_PARTS;
+      if (pTasks[t].p0 > j.npart) {
+        pTasks[t].p0 = j.npart;
+      }
+      if (pTasks[t].p1 > j.npart) {
+        pTasks[t].p1 = j.npart;
+      }
+      pTasks[t].nrows = 0;
+    }
+    runTasks(pPool, pTasks, j.ntask, &joinTask);
+
+    for(t = 0; status && (t < j.ntask); t++) {
+      if (pTasks[t].err != AKSJOIN_ERR_NONE) {
+        status = 0;
+        *perr = pTasks[t].err;
+      }
+    }
+    for(t = 0; status && (t < j.ntask); t++) {
+      len = pTasks[t].nrows * rowlen;
+      if (len < 1) {
+        continue;
+      }
+      if (len > AKSVIEW_MAXLEN - (opos + (result * rowlen))) {
+        fault(__LINE__);
+      }
+      if (!aksview_reserve(pOut, opos + (result * rowlen) + len)) {
+        status = 0;
+        *perr = AKSJOIN_ERR_RESIZE;
+      }
+      if (status) {
+        aksview_writebuf(pOut, opos + (result * rowlen), pTasks[t].pRows,
+                          len);
+        result += pTasks[t].nrows;
+      }
+    }
+  }
+
+  /* Trim off any growth beyond the end of the output */
+  if (status) {
+    len = opos + (result * rowlen);
+    if (len < olen) {
+      len = olen;
+    }
+    if (aksview_getlen(pOut) > len) {
+      if (!aksview_setlen(pOut, len)) {
+        status = 0;
+        *perr = AKSJOIN_ERR_RESIZE;
+      }
+    }
+  }
+
+  /* Empty the scratch files */
+  if (j.scratch && (j.ppPath != NULL)) {
+    for(t = 0; t < j.ntask; t++) {
+      if ((j.ppPath)[t] != NULL) {
+        pv = aksview_create((j.ppPath)[t], AKSVIEW_EXISTING, NULL);
+        if (pv != NULL) {
+          aksview_setlen(pv, 0);
+          aksview_close(pv);
+        }
+      }
+    }
+  }
+
+  /* Release everything */
+  akspool_free(pPool);
+  for(s = 0; s < 2; s++) {
+    free((j.pCnt)[s]);
+    free((j.pOff)[s]);
+  }
+  for(t = 0; t < j.ntask; t++) {
+    if (j.ppPath != NULL) {
+      free((j.ppPath)[t]);
+    }
+    if (j.ppMem != NULL) {
+      free((j.ppMem)[t]);
+    }
+    if (pTasks != NULL) {
+      free(pTasks[t].pRows);
+    }
+  }
+  free(j.ppPath);
+  free(j.ppMem);
+  free(pTasks);
+
+  /* Return row count or -1 */
+  if (!status) {
+    result = -1;
+  }
+  return result;
+}
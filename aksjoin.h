@@ -0,0 +1,167 @@
+#ifndef AKSJOIN_H_INCLUDED
+#define AKSJOIN_H_INCLUDED
+
+/*
+ * aksjoin.h
+ * =========
+ * 
+ * Radix-partitioned hash join over two files of fixed-width records
+ * stored in AKSView files.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum length in bytes of a record.
+ */
+#define AKSJOIN_MAXSTRIDE (INT32_C(65536))
+
+/*
+ * The largest total input size in bytes that is partitioned in memory
+ * when a scratch path is given.  Larger inputs are partitioned into
+ * scratch files.
+ */
+#define AKSJOIN_HEAPMAX (INT64_C(67108864))
+
+/*
+ * AKSJOIN_SIDE structure.
+ * 
+ * Describes one input of a join: the n fixed-width records in the file
+ * at pPath starting at file offset pos, each of which is stride bytes
+ * long, with a little-endian 64-bit key at byte offset keyoff within
+ * each record.
+ */
+typedef struct {
+  const char *pPath;
+  int64_t pos;
+  int64_t n;
+  int32_t stride;
+  int32_t keyoff;
+} AKSJOIN_SIDE;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksjoin_errstr() to convert these to error messages.
+ */
+#define AKSJOIN_ERR_NONE    (0)
+#define AKSJOIN_ERR_OPEN    (1)
+#define AKSJOIN_ERR_SCRATCH (2)
+#define AKSJOIN_ERR_RESIZE  (3)
+#define AKSJOIN_ERR_THREAD  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksjoin.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksjoin_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSJOIN_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksjoin_errstr(int code);
+
+/*
+ * Join two record files on equal keys.
+ * 
+ * For every pair of a record in pLeft and a record in pRight that have
+ * the same key, an output row is written to pOut that consists of the
+ * left record followed by the right record.  Rows are written one after
+ * the other starting at file offset opos, in no particular order.  pOut
+ * must be writable.  It is grown with aksview_reserve() as necessary,
+ * and trimmed afterwards so that it is no longer than the end of the
+ * output or its original length, whichever is greater.
+ * 
+ * Both inputs are opened read-only by path, so that worker threads can
+ * read them through their own viewers.  The strides must be in range
+ * [8, AKSJOIN_MAXSTRIDE] and each key must fit within its record.  The
+ * left input is loaded into hash tables, so it should be the smaller of
+ * the two.
+ * 
+ * Both inputs are first split by a hash of their keys into partitions
+ * that are small enough for the hash table of each left partition to
+ * stay in the processor cache.  Each partition of the right input is
+ * then streamed past the hash table of the matching left partition.
+ * 
+ * The partitions are held in memory if pScratch is NULL or if the two
+ * inputs together are at most AKSJOIN_HEAPMAX bytes.  Otherwise, they
+ * are written to scratch files whose paths are pScratch followed by a
+ * dot and a task number, which are created or truncated as necessary.
+ * The scratch files are left with length zero when the function
+ * returns, and the client may delete them.
+ * 
+ * Partitioning and partition joins are spread over nthreads worker
+ * threads, which must be in range [0, AKSPOOL_MAXTHREAD] (see
+ * akspool.h).  If nthreads is zero, everything runs on the calling
+ * thread.  The rows of a batch of partitions are held in memory until
+ * they are written to pOut, so keys that are repeated many times in
+ * both inputs can take a lot of memory.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSJOIN_ERR_ constants.  If the function fails, rows may have been
+ * partially written to pOut.
+ * 
+ * Parameters:
+ * 
+ *   pLeft - the left input
+ * 
+ *   pRight - the right input
+ * 
+ *   pScratch - prefix of scratch file paths, or NULL
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ *   pOut - the viewer to write the output rows to
+ * 
+ *   opos - the file offset to write the output rows at
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   the number of output rows, or -1 if error
+ */
+int64_t aksjoin_run(
+    const AKSJOIN_SIDE * pLeft,
+    const AKSJOIN_SIDE * pRight,
+    const char         * pScratch,
+    int                  nthreads,
+    AKSVIEW            * pOut,
+    int64_t              opos,
+    int                * perr);
+
+#endif
@@ -0,0 +1,783 @@
+/*
+ * akslog.c
+ * ========
+ * 
+ * Implementation of akslog.h
+ * 
+ * See the header for further information.
+ */
+
+#include "akslog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aksmacro.h"
+
+/* OS-specific headers */
+#ifdef AKS_WIN
+/* Windows headers */
+#include <windows.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a log file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSLOG01".
+ */
+#define LOG_MAGIC (UINT64_C(0x3130474f4c534b41))
+
+/*
+ * File layout.
+ * 
+ * The first cache line holds the little-endian header fields, which
+ * never change after the log is created.  The claim counter, which is
+ * the sequence number of the most recently claimed block, has its own
+ * cache line, and is stored in native byte order since it is updated
+ * with atomic operations directly in the shared mapping.  The data area
+ * of fixed-size blocks begins after these.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_CAP   (8)
+#define HDR_OFF_BLOCK (16)
+#define HDR_OFF_CLAIM (64)
+#define HDR_SIZE      (128)
+
+/*
+ * Block and record layout.
+ * 
+ * Every block begins with a header holding the native 64-bit sequence
+ * number of the claim that last wrote it, padded to BLK_HDR bytes.
+ * Sequence numbers start at one, and the block that a sequence number s
+ * claims is (s - 1) modulo the number of blocks.
+ * 
+ * Records follow the block header.  Each record begins with a header
+ * holding the native 64-bit sequence number of its block, which is the
+ * tag that is stored last, followed by the native 32-bit record length
+ * and the native 32-bit index of the record within its block.  Records
+ * are padded to multiples of REC_ALIGN.
+ * 
+ * A record sequence number combines the block sequence number and the
+ * record index, which is always less than 2 to the REC_IDXBITS since
+ * records take at least REC_HDR bytes of a block.
+ */
+#define BLK_HDR (16)
+
+#define REC_OFF_TAG (0)
+#define REC_OFF_LEN (8)
+#define REC_OFF_IDX (12)
+#define REC_HDR     (16)
+#define REC_ALIGN   (8)
+#define REC_IDXBITS (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A block that holds records, as found by a reader.
+ */
+typedef struct {
+  uint64_t seq;
+  int64_t index;
+} LOG_BLOCK;
+
+/*
+ * AKSLOG structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSLOG_TAG {
+
+  /*
+   * The viewer on the file, and the span covering the whole file, which
+   * stays valid because no other function is called on the viewer until
+   * it is closed.
+   */
+  AKSVIEW *pv;
+  uint8_t *pBase;
+
+  /*
+   * The data area, the block size, and the mask that converts block
+   * sequence numbers into block indices.
+   */
+  uint8_t *pData;
+  int32_t blen;
+  uint64_t mask;
+
+  /*
+   * Pointer to the shared claim counter in the mapping.
+   */
+  volatile uint64_t *pClaim;
+
+  /*
+   * The number of attached writers.
+   */
+  volatile int32_t nwriters;
+};
+
+/*
+ * AKSLOGW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSLOGW_TAG {
+
+  /*
+   * The log object.
+   */
+  AKSLOG *pl;
+
+  /*
+   * The block the writer has claimed, or NULL if it has not claimed one
+   * yet, and the sequence number of that claim.
+   */
+  uint8_t *pBlk;
+  uint64_t bseq;
+
+  /*
+   * The offset within the block of the next record, and the index of
+   * that record.
+   */
+  int32_t off;
+  int32_t idx;
+};
+
+/*
+ * AKSLOGR structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSLOGR_TAG {
+
+  /*
+   * The read-only viewer on the file, the data area within its span,
+   * and the block size.
+   */
+  AKSVIEW *pv;
+  const uint8_t *pData;
+  int32_t blen;
+
+  /*
+   * The blocks that hold records, in the order they were claimed.
+   */
+  LOG_BLOCK *pBlock;
+  int64_t nblock;
+
+  /*
+   * The current block, the offset within it of the next record, and
+   * the index that record must have.
+   */
+  int64_t cur;
+  int32_t off;
+  int32_t idx;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "akslog fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "akslog warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint64_t load64(volatile uint64_t *p);
+static void store64(volatile uint64_t *p, uint64_t v);
+static uint64_t add64(volatile uint64_t *p, uint64_t d);
+static int32_t add32(volatile int32_t *p, int32_t d);
+static int checkHeader(AKSVIEW *pv, int64_t *pcap, int32_t *pblen);
+static void claimBlock(AKSLOGW *pw);
+static int blockCmp(const void *pA, const void *pB);
+
+/*
+ * Atomic operations on the claim counter, the record tags, and the
+ * writer count.
+ * 
+ * Loads have acquire semantics and stores have release semantics, so a
+ * reader that sees a tag also sees the rest of its record and the header
+ * of its block, and a writer that sees a block header also sees that the
+ * block was claimed again.
+ */
+#ifdef AKS_WIN
+
+static uint64_t load64(volatile uint64_t *p) {
+  return (uint64_t) InterlockedCompareExchange64(
+                      (volatile LONG64 *) p, 0, 0);
+}
+
+static void store64(volatile uint64_t *p, uint64_t v) {
+  InterlockedExchange64((volatile LONG64 *) p, (LONG64) v);
+}
+
+static uint64_t add64(volatile uint64_t *p, uint64_t d) {
+  return ((uint64_t) InterlockedExchangeAdd64(
+                        (volatile LONG64 *) p, (LONG64) d)) + d;
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return ((int32_t) InterlockedExchangeAdd((volatile LONG *) p, (LONG) d))
+            + d;
+}
+
+#else
+
+static uint64_t load64(volatile uint64_t *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store64(volatile uint64_t *p, uint64_t v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static uint64_t add64(volatile uint64_t *p, uint64_t d) {
+  return __atomic_add_fetch(p, d, __ATOMIC_ACQ_REL);
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return __atomic_add_fetch(p, d, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+/*
+ * Check the header of a log file.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer on the file
+ * 
+ *   pcap - receives the data capacity
+ * 
+ *   pblen - receives the block size
+ * 
+ * Return:
+ * 
+ *   non-zero if the header is valid, zero if not
+ */
+static int checkHeader(AKSVIEW *pv, int64_t *pcap, int32_t *pblen) {
+
+  int status = 1;
+  int64_t flen = 0;
+
+  flen = aksview_getlen(pv);
+  if (flen < HDR_SIZE) {
+    status = 0;
+  }
+
+  if (status) {
+    *pcap = aksview_read64s(pv, HDR_OFF_CAP, 1);
+    *pblen = aksview_read32s(pv, HDR_OFF_BLOCK, 1);
+    if ((aksview_read64u(pv, HDR_OFF_MAGIC, 1) != LOG_MAGIC) ||
+        (*pcap < AKSLOG_MINCAP) || (*pcap > AKSLOG_MAXCAP) ||
+        ((*pcap & (*pcap - 1)) != 0) ||
+        (*pblen < AKSLOG_MINBLOCK) || (*pblen > AKSLOG_MAXBLOCK) ||
+        ((*pblen & (*pblen - 1)) != 0) ||
+        (*pcap < AKSLOG_MINBLOCKS * ((int64_t) *pblen)) ||
+        (flen != HDR_SIZE + *pcap)) {
+      status = 0;
+    }
+  }
+
+  return status;
+}
+
+/*
+ * Claim the next block of the log for a writer.
+ * 
+ * The block header is stored before any record in the block, so a block
+ * that a crash interrupts holds either its old records or a prefix of
+ * its new ones.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ */
+static void claimBlock(AKSLOGW *pw) {
+
+  AKSLOG *pl = pw->pl;
+
+  pw->bseq = add64(pl->pClaim, 1);
+  pw->pBlk = pl->pData +
+              ((size_t) ((pw->bseq - 1) & pl->mask)) * ((size_t) pl->blen);
+  store64((volatile uint64_t *) pw->pBlk, pw->bseq);
+  pw->off = BLK_HDR;
+  pw->idx = 0;
+}
+
+/*
+ * Comparison function for sorting blocks by sequence number.
+ * 
+ * Parameters:
+ * 
+ *   pA - the first LOG_BLOCK
+ * 
+ *   pB - the second LOG_BLOCK
+ * 
+ * Return:
+ * 
+ *   less than, equal to, or greater than zero
+ */
+static int blockCmp(const void *pA, const void *pB) {
+
+  const LOG_BLOCK *pX = (const LOG_BLOCK *) pA;
+  const LOG_BLOCK *pY = (const LOG_BLOCK *) pB;
+  int result = 0;
+
+  if (pX->seq < pY->seq) {
+    result = -1;
+  } else if (pX->seq > pY->seq) {
+    result = 1;
+  }
+
+  return result;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * akslog_onerror function.
+ */
+void akslog_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * akslog_errstr function.
+ */
+const char *akslog_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSLOG_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSLOG_ERR_OPEN:
+      pResult = "Failed to open log file";
+      break;
+
+    case AKSLOG_ERR_FORMAT:
+      pResult = "Log file has invalid format";
+      break;
+
+    case AKSLOG_ERR_RESIZE:
+      pResult = "Failed to resize log file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * akslog_create function.
+ */
+int akslog_create(const char *pPath, int64_t cap, int32_t blen, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pv = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+  if ((cap < AKSLOG_MINCAP) || (cap > AKSLOG_MAXCAP) ||
+      ((cap & (cap - 1)) != 0) ||
+      (blen < AKSLOG_MINBLOCK) || (blen > AKSLOG_MAXBLOCK) ||
+      ((blen & (blen - 1)) != 0) ||
+      (cap < AKSLOG_MINBLOCKS * ((int64_t) blen))) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSLOG_ERR_NONE;
+
+  /* Create the file at its full length, which starts out zero-filled */
+  pv = aksview_create(pPath, AKSVIEW_EXCLUSIVE, NULL);
+  if (pv == NULL) {
+    status = 0;
+    *perr = AKSLOG_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pv, HDR_SIZE + cap)) {
+      status = 0;
+      *perr = AKSLOG_ERR_RESIZE;
+    }
+  }
+
+  /* Write the header, with the magic number last */
+  if (status) {
+    aksview_write64s(pv, HDR_OFF_CAP, 1, cap);
+    aksview_write32s(pv, HDR_OFF_BLOCK, 1, blen);
+    aksview_flush(pv);
+    aksview_write64u(pv, HDR_OFF_MAGIC, 1, LOG_MAGIC);
+  }
+
+  /* Close the file */
+  aksview_close(pv);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akslog_open function.
+ */
+AKSLOG *akslog_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSLOG *pl = NULL;
+  int64_t cap = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSLOG_ERR_NONE;
+
+  /* Allocate the structure */
+  pl = (AKSLOG *) calloc(1, sizeof(AKSLOG));
+  if (pl == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the existing file and check the header */
+  pl->pv = aksview_create(pPath, AKSVIEW_EXISTING | AKSVIEW_SHARE, NULL);
+  if (pl->pv == NULL) {
+    status = 0;
+    *perr = AKSLOG_ERR_OPEN;
+  }
+  if (status) {
+    if (!checkHeader(pl->pv, &cap, &(pl->blen))) {
+      status = 0;
+      *perr = AKSLOG_ERR_FORMAT;
+    }
+  }
+
+  /* Map the whole file and locate the claim counter */
+  if (status) {
+    pl->pBase = aksview_wspan(pl->pv, 0, (int32_t) (HDR_SIZE + cap));
+    pl->pData = pl->pBase + HDR_SIZE;
+    pl->mask = ((uint64_t) (cap / pl->blen)) - 1;
+    pl->pClaim = (volatile uint64_t *) (pl->pBase + HDR_OFF_CLAIM);
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pl->pv);
+    free(pl);
+    pl = NULL;
+  }
+
+  /* Return log object or NULL */
+  return pl;
+}
+
+/*
+ * akslog_close function.
+ */
+void akslog_close(AKSLOG *pl) {
+  if (pl != NULL) {
+    if (add32(&(pl->nwriters), 0) != 0) {
+      fault(__LINE__);
+    }
+    aksview_close(pl->pv);
+    free(pl);
+  }
+}
+
+/*
+ * akslog_maxrec function.
+ */
+int32_t akslog_maxrec(AKSLOG *pl) {
+  if (pl == NULL) {
+    fault(__LINE__);
+  }
+  return pl->blen - BLK_HDR - REC_HDR;
+}
+
+/*
+ * akslog_attach function.
+ */
+AKSLOGW *akslog_attach(AKSLOG *pl) {
+
+  AKSLOGW *pw = NULL;
+
+  /* Check parameters */
+  if (pl == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Allocate the writer, which claims its first block on first write */
+  pw = (AKSLOGW *) calloc(1, sizeof(AKSLOGW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  pw->pl = pl;
+  add32(&(pl->nwriters), 1);
+
+  /* Return the writer */
+  return pw;
+}
+
+/*
+ * akslog_detach function.
+ */
+void akslog_detach(AKSLOGW *pw) {
+  if (pw != NULL) {
+    add32(&(pw->pl->nwriters), -1);
+    free(pw);
+  }
+}
+
+/*
+ * akslog_write function.
+ */
+void akslog_write(AKSLOGW *pw, const void *pData, int32_t len) {
+
+  uint8_t *pRec = NULL;
+  int32_t rlen = 0;
+
+  /* Check parameters */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > pw->pl->blen - BLK_HDR - REC_HDR) ||
+      ((pData == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /*
+   * Claim a new block if the record does not fit in the current one, or
+   * if other writers have lapped the log and claimed the current block
+   * again, so that an idle writer never writes over their records
+   */
+  rlen = REC_HDR + ((len + REC_ALIGN - 1) & ~(REC_ALIGN - 1));
+  if ((pw->pBlk == NULL) || (rlen > pw->pl->blen - pw->off) ||
+      (load64((volatile uint64_t *) pw->pBlk) != pw->bseq)) {
+    claimBlock(pw);
+  }
+
+  /* Copy the record and its header, storing the tag last */
+  pRec = pw->pBlk + pw->off;
+  if (len > 0) {
+    memcpy(pRec + REC_HDR, pData, (size_t) len);
+  }
+  memcpy(pRec + REC_OFF_LEN, &len, 4);
+  memcpy(pRec + REC_OFF_IDX, &(pw->idx), 4);
+  store64((volatile uint64_t *) (pRec + REC_OFF_TAG), pw->bseq);
+
+  /* Move past the record */
+  pw->off += rlen;
+  (pw->idx)++;
+}
+
+/*
+ * akslog_ropen function.
+ */
+AKSLOGR *akslog_ropen(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSLOGR *pr = NULL;
+  const uint8_t *pBase = NULL;
+  int64_t cap = 0;
+  int64_t count = 0;
+  int64_t i = 0;
+  uint64_t claim = 0;
+  uint64_t seq = 0;
+  uint64_t mask = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSLOG_ERR_NONE;
+
+  /* Allocate the structure */
+  pr = (AKSLOGR *) calloc(1, sizeof(AKSLOGR));
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the existing file read-only and check the header */
+  pr->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pr->pv == NULL) {
+    status = 0;
+    *perr = AKSLOG_ERR_OPEN;
+  }
+  if (status) {
+    if (!checkHeader(pr->pv, &cap, &(pr->blen))) {
+      status = 0;
+      *perr = AKSLOG_ERR_FORMAT;
+    }
+  }
+
+  /* Map the whole file and allocate the block list */
+  if (status) {
+    pBase = aksview_rspan(pr->pv, 0, (int32_t) (HDR_SIZE + cap));
+    pr->pData = pBase + HDR_SIZE;
+    memcpy(&claim, pBase + HDR_OFF_CLAIM, 8);
+    count = cap / pr->blen;
+    mask = ((uint64_t) count) - 1;
+    pr->pBlock = (LOG_BLOCK *) calloc((size_t) count, sizeof(LOG_BLOCK));
+    if (pr->pBlock == NULL) {
+      fault(__LINE__);
+    }
+  }
+
+  /*
+   * Gather the blocks whose headers hold a claim that was made and that
+   * belongs to them, and sort them into the order of their claims
+   */
+  if (status) {
+    for(i = 0; i < count; i++) {
+      memcpy(&seq, pr->pData + i * pr->blen, 8);
+      if ((seq != 0) && (seq <= claim) &&
+          (((seq - 1) & mask) == (uint64_t) i)) {
+        pr->pBlock[pr->nblock].seq = seq;
+        pr->pBlock[pr->nblock].index = i;
+        (pr->nblock)++;
+      }
+    }
+    qsort(pr->pBlock, (size_t) pr->nblock, sizeof(LOG_BLOCK), &blockCmp);
+    pr->off = BLK_HDR;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    akslog_rclose(pr);
+    pr = NULL;
+  }
+
+  /* Return reader or NULL */
+  return pr;
+}
+
+/*
+ * akslog_rclose function.
+ */
+void akslog_rclose(AKSLOGR *pr) {
+  if (pr != NULL) {
+    aksview_close(pr->pv);
+    free(pr->pBlock);
+    free(pr);
+  }
+}
+
+/*
+ * akslog_read function.
+ */
+const uint8_t *akslog_read(AKSLOGR *pr, int32_t *plen, uint64_t *pseq) {
+
+  const uint8_t *pResult = NULL;
+  const uint8_t *pRec = NULL;
+  LOG_BLOCK *pb = NULL;
+  uint64_t tag = 0;
+  int32_t len = 0;
+  int32_t idx = 0;
+
+  /* Check parameters */
+  if ((pr == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+
+  /*
+   * Take the next record of the current block if its tag, length, and
+   * index are all consistent, or else move on to the next block
+   */
+  while ((pResult == NULL) && (pr->cur < pr->nblock)) {
+    pb = &(pr->pBlock[pr->cur]);
+    if (pr->off <= pr->blen - REC_HDR) {
+      pRec = pr->pData + pb->index * pr->blen + pr->off;
+      memcpy(&tag, pRec + REC_OFF_TAG, 8);
+      memcpy(&len, pRec + REC_OFF_LEN, 4);
+      memcpy(&idx, pRec + REC_OFF_IDX, 4);
+      if ((tag == pb->seq) && (idx == pr->idx) &&
+          (len >= 0) && (len <= pr->blen - pr->off - REC_HDR)) {
+        pResult = pRec + REC_HDR;
+        *plen = len;
+        if (pseq != NULL) {
+          *pseq = (pb->seq << REC_IDXBITS) | ((uint64_t) idx);
+        }
+        pr->off += REC_HDR + ((len + REC_ALIGN - 1) & ~(REC_ALIGN - 1));
+        (pr->idx)++;
+      }
+    }
+    if (pResult == NULL) {
+      (pr->cur)++;
+      pr->off = BLK_HDR;
+      pr->idx = 0;
+    }
+  }
+
+  /* Return record or NULL */
+  return pResult;
+}
@@ -0,0 +1,320 @@
+#ifndef AKSLOG_H_INCLUDED
+#define AKSLOG_H_INCLUDED
+
+/*
+ * akslog.h
+ * ========
+ * 
+ * Fixed-size circular log files on AKSView, which overwrite their oldest
+ * records, for always-on tracing that survives crashes.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The minimum and maximum data capacity of a log in bytes.
+ * 
+ * The capacity must be a power of two within this range.  The maximum
+ * is limited so that the whole log file fits in a single span.
+ */
+#define AKSLOG_MINCAP (INT64_C(65536))
+#define AKSLOG_MAXCAP (INT64_C(268435456))
+
+/*
+ * The minimum and maximum block size of a log in bytes.
+ * 
+ * The block size must be a power of two within this range, and the
+ * capacity must hold at least AKSLOG_MINBLOCKS blocks.
+ */
+#define AKSLOG_MINBLOCK (INT32_C(1024))
+#define AKSLOG_MAXBLOCK (INT32_C(1048576))
+#define AKSLOG_MINBLOCKS (INT64_C(8))
+
+/*
+ * Structure prototypes for AKSLOG, AKSLOGW, and AKSLOGR.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSLOG_TAG;
+typedef struct AKSLOG_TAG AKSLOG;
+
+struct AKSLOGW_TAG;
+typedef struct AKSLOGW_TAG AKSLOGW;
+
+struct AKSLOGR_TAG;
+typedef struct AKSLOGR_TAG AKSLOGR;
+
+/*
+ * Error code definitions.
+ * 
+ * Use akslog_errstr() to convert these to error messages.
+ */
+#define AKSLOG_ERR_NONE   (0)
+#define AKSLOG_ERR_OPEN   (1)
+#define AKSLOG_ERR_FORMAT (2)
+#define AKSLOG_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the akslog.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void akslog_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSLOG_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *akslog_errstr(int code);
+
+/*
+ * Create a new log file.
+ * 
+ * The file at pPath must not already exist.  cap is the data capacity in
+ * bytes, which must be a power of two in range [AKSLOG_MINCAP,
+ * AKSLOG_MAXCAP].  blen is the block size in bytes, which must be a
+ * power of two in range [AKSLOG_MINBLOCK, AKSLOG_MAXBLOCK], and cap must
+ * be at least AKSLOG_MINBLOCKS times blen.
+ * 
+ * The file is given its full length here, and never changes length
+ * afterwards.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSLOG_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the log file to create
+ * 
+ *   cap - the data capacity in bytes
+ * 
+ *   blen - the block size in bytes
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int akslog_create(const char *pPath, int64_t cap, int32_t blen, int *perr);
+
+/*
+ * Open a log file for writing.
+ * 
+ * The whole file is mapped as a single span when the log is opened, and
+ * the mapping is shared with every other process that opens the file.
+ * On Windows, the file is opened with AKSVIEW_SHARE for this purpose.
+ * The shared counter is stored in native byte order, so a log file may
+ * only be shared between processes on platforms of the same byte order.
+ * 
+ * One log object is enough for all the threads of a process.  Each
+ * thread that writes attaches its own writer with akslog_attach().
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for akslog_create().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the log file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new log object, or NULL if the function failed
+ */
+AKSLOG *akslog_open(const char *pPath, int *perr);
+
+/*
+ * Close a log object.
+ * 
+ * Every writer must have been detached first.  The mapping is flushed
+ * as the file is closed.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pl - the log object, or NULL
+ */
+void akslog_close(AKSLOG *pl);
+
+/*
+ * Get the largest record length that a log accepts.
+ * 
+ * This is the block size less the space taken by the block header and
+ * one record header.
+ * 
+ * Parameters:
+ * 
+ *   pl - the log object
+ * 
+ * Return:
+ * 
+ *   the maximum record length in bytes
+ */
+int32_t akslog_maxrec(AKSLOG *pl);
+
+/*
+ * Attach a writer to a log object.
+ * 
+ * Each thread that writes needs its own writer.  A writer may only be
+ * used by one thread at a time.  This function may be called from any
+ * thread.
+ * 
+ * Parameters:
+ * 
+ *   pl - the log object
+ * 
+ * Return:
+ * 
+ *   a new writer
+ */
+AKSLOGW *akslog_attach(AKSLOG *pl);
+
+/*
+ * Detach a writer from its log object and release it.
+ * 
+ * The rest of the writer's current block is left unused.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer, or NULL
+ */
+void akslog_detach(AKSLOGW *pw);
+
+/*
+ * Write a record to the log.
+ * 
+ * Each writer fills a block of the log that it has claimed for itself,
+ * so records are copied straight into the mapping without any lock or
+ * atomic read-modify-write.  When a record does not fit in the rest of
+ * the block, the writer claims the next block of the log by atomically
+ * advancing the shared block sequence number, overwriting whatever the
+ * oldest block held.  Before each record, the writer also checks that
+ * its block has not been claimed again by other writers lapping the log
+ * while it was idle, and claims a new block if it has.
+ * 
+ * The function never changes the length of the file, never flushes, and
+ * never makes a system call.  The record reaches the page cache at once,
+ * so it survives a crash of the process, but not of the system.
+ * 
+ * That check leaves one race.  If the other writers lap the whole log
+ * while a writer is in the middle of copying a single record, that copy
+ * may overwrite part of a record that another writer has just written in
+ * the same place, and the reader cannot detect this.  Make the log large
+ * enough that a lap takes far longer than any one copy.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ *   pData - the record
+ * 
+ *   len - the length of the record, in range [0, akslog_maxrec()]
+ */
+void akslog_write(AKSLOGW *pw, const void *pData, int32_t len);
+
+/*
+ * Open a log file for reading.
+ * 
+ * This is intended for reading a log after its writers have stopped,
+ * for example after a crash.  The file is mapped read-only, every block
+ * is checked, and the blocks that hold records are put in the order in
+ * which they were claimed.
+ * 
+ * perr works in the same way as for akslog_create().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the log file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new reader, or NULL if the function failed
+ */
+AKSLOGR *akslog_ropen(const char *pPath, int *perr);
+
+/*
+ * Close a reader.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reader, or NULL
+ */
+void akslog_rclose(AKSLOGR *pr);
+
+/*
+ * Get the next record from a reader.
+ * 
+ * Records are returned oldest first.  The records of each block are
+ * returned in the order that they were written, and blocks in the order
+ * that they were claimed, so the records of any one writer are always
+ * in order, while the records of different writers are ordered by the
+ * blocks that hold them.
+ * 
+ * Each record header carries the sequence number of its block, which
+ * is stored after the rest of the record.  A record whose header does
+ * not match its block was torn by a crash, or is left over from an
+ * earlier lap of the log, and ends the block.
+ * 
+ * If a record is available, a pointer to it in the mapping is returned,
+ * its length is written to *plen, and its sequence number is written to
+ * *pseq.  Sequence numbers increase in the order that records are
+ * returned.  The pointers stay valid until the reader is closed.
+ * 
+ * If no further record is available, NULL is returned.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reader
+ * 
+ *   plen - receives the length of the record
+ * 
+ *   pseq - receives the sequence number of the record, or NULL
+ * 
+ * Return:
+ * 
+ *   pointer to the record, or NULL if none is left
+ */
+const uint8_t *akslog_read(AKSLOGR *pr, int32_t *plen, uint64_t *pseq);
+
+#endif
@@ -0,0 +1,493 @@
+/*
+ * akspool.c
+ * =========
+ * 
+ * Implementation of akspool.h
+ * 
+ * See the header for further information.
+ */
+
+#include "akspool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aksmacro.h"
+
+/* OS-specific headers */
+#ifdef AKS_WIN
+/* Windows headers */
+#include <windows.h>
+
+#else
+/* POSIX headers */
+#include <pthread.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The initial capacity of the task queue.
+ */
+#define QUEUE_INIT (64)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A queued task.
+ */
+typedef struct {
+  void (*fp)(void *);
+  void *pArg;
+} POOL_TASK;
+
+/*
+ * AKSPOOL structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSPOOL_TAG {
+
+  /*
+   * The number of worker threads and their handles.
+   */
+  int nthreads;
+#ifdef AKS_WIN
+  HANDLE *pThreads;
+#else
+  pthread_t *pThreads;
+#endif
+
+  /*
+   * The lock that protects the rest of the structure, the condition
+   * that workers wait on for new tasks, and the condition that waiters
+   * wait on for all tasks to finish.
+   */
+#ifdef AKS_WIN
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE cvTask;
+  CONDITION_VARIABLE cvIdle;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t cvTask;
+  pthread_cond_t cvIdle;
+#endif
+
+  /*
+   * The task queue, as a circular buffer.
+   * 
+   * qcap is the capacity, qhead is the index of the next task to run,
+   * and qlen is the number of queued tasks.
+   */
+  POOL_TASK *pQueue;
+  int32_t qcap;
+  int32_t qhead;
+  int32_t qlen;
+
+  /*
+   * The number of tasks that have been submitted but not yet finished,
+   * including queued tasks.
+   */
+  int32_t pending;
+
+  /*
+   * Set when workers should exit once the queue is empty.
+   */
+  int stop;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "akspool fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "akspool warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void lockPool(AKSPOOL *pp);
+static void unlockPool(AKSPOOL *pp);
+static void runWorker(AKSPOOL *pp);
+static void stopWorkers(AKSPOOL *pp, int count);
+#ifdef AKS_WIN
+static DWORD WINAPI workerMain(LPVOID pParam);
+#else
+static void *workerMain(void *pParam);
+#endif
+
+/*
+ * Acquire and release the pool lock.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ */
+static void lockPool(AKSPOOL *pp) {
+#ifdef AKS_WIN
+  EnterCriticalSection(&(pp->lock));
+#else
+  if (pthread_mutex_lock(&(pp->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+static void unlockPool(AKSPOOL *pp) {
+#ifdef AKS_WIN
+  LeaveCriticalSection(&(pp->lock));
+#else
+  if (pthread_mutex_unlock(&(pp->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+/*
+ * The body of a worker thread.
+ * 
+ * Repeatedly takes the next task from the queue and runs it, until the
+ * pool is stopped and the queue is empty.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ */
+static void runWorker(AKSPOOL *pp) {
+
+  POOL_TASK t;
+
+  /* Initialize structures */
+  memset(&t, 0, sizeof(POOL_TASK));
+
+  lockPool(pp);
+  for(;;) {
+
+    /* Wait for a task or for the stop signal */
+    while ((pp->qlen < 1) && (!(pp->stop))) {
+#ifdef AKS_WIN
+      if (!SleepConditionVariableCS(&(pp->cvTask), &(pp->lock),
+            INFINITE)) {
+        fault(__LINE__);
+      }
+#else
+      if (pthread_cond_wait(&(pp->cvTask), &(pp->lock))) {
+        fault(__LINE__);
+      }
+#endif
+    }
+    if (pp->qlen < 1) {
+      break;
+    }
+
+    /* Dequeue the task and run it without holding the lock */
+    memcpy(&t, &((pp->pQueue)[pp->qhead]), sizeof(POOL_TASK));
+    pp->qhead = (pp->qhead + 1) % pp->qcap;
+    (pp->qlen)--;
+    unlockPool(pp);
+
+    (t.fp)(t.pArg);
+
+    /* Record completion, waking waiters if this was the last task */
+    lockPool(pp);
+    (pp->pending)--;
+    if (pp->pending < 1) {
+#ifdef AKS_WIN
+      WakeAllConditionVariable(&(pp->cvIdle));
+#else
+      if (pthread_cond_broadcast(&(pp->cvIdle))) {
+        fault(__LINE__);
+      }
+#endif
+    }
+  }
+  unlockPool(pp);
+}
+
+/*
+ * Thread entry point for workers.
+ */
+#ifdef AKS_WIN
+static DWORD WINAPI workerMain(LPVOID pParam) {
+  runWorker((AKSPOOL *) pParam);
+  return 0;
+}
+#else
+static void *workerMain(void *pParam) {
+  runWorker((AKSPOOL *) pParam);
+  return NULL;
+}
+#endif
+
+/*
+ * Signal the first count worker threads to stop, and wait for them to
+ * exit.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ * 
+ *   count - the number of threads that were started
+ */
+static void stopWorkers(AKSPOOL *pp, int count) {
+
+  int i = 0;
+
+  lockPool(pp);
+  pp->stop = 1;
+#ifdef AKS_WIN
+  WakeAllConditionVariable(&(pp->cvTask));
+#else
+  if (pthread_cond_broadcast(&(pp->cvTask))) {
+    fault(__LINE__);
+  }
+#endif
+  unlockPool(pp);
+
+  for(i = 0; i < count; i++) {
+#ifdef AKS_WIN
+    if (WaitForSingleObject((pp->pThreads)[i], INFINITE) != WAIT_OBJECT_0) {
+      fault(__LINE__);
+    }
+    CloseHandle((pp->pThreads)[i]);
+#else
+    if (pthread_join((pp->pThreads)[i], NULL)) {
+      fault(__LINE__);
+    }
+#endif
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * akspool_onerror function.
+ */
+void akspool_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * akspool_new function.
+ */
+AKSPOOL *akspool_new(int nthreads) {
+
+  AKSPOOL *pp = NULL;
+  int started = 0;
+
+  /* Check parameter */
+  if ((nthreads < 1) || (nthreads > AKSPOOL_MAXTHREAD)) {
+    fault(__LINE__);
+  }
+
+  /* Allocate the structure, thread handles, and queue */
+  pp = (AKSPOOL *) calloc(1, sizeof(AKSPOOL));
+  if (pp == NULL) {
+    fault(__LINE__);
+  }
+#ifdef AKS_WIN
+  pp->pThreads = (HANDLE *) calloc((size_t) nthreads, sizeof(HANDLE));
+#else
+  pp->pThreads = (pthread_t *) calloc((size_t) nthreads, sizeof(pthread_t));
+#endif
+  if (pp->pThreads == NULL) {
+    fault(__LINE__);
+  }
+  pp->qcap = QUEUE_INIT;
+  pp->pQueue = (POOL_TASK *) calloc((size_t) pp->qcap, sizeof(POOL_TASK));
+  if (pp->pQueue == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Initialize the synchronization objects */
+#ifdef AKS_WIN
+  InitializeCriticalSection(&(pp->lock));
+  InitializeConditionVariable(&(pp->cvTask));
+  InitializeConditionVariable(&(pp->cvIdle));
+#else
+  if (pthread_mutex_init(&(pp->lock), NULL) ||
+      pthread_cond_init(&(pp->cvTask), NULL) ||
+      pthread_cond_init(&(pp->cvIdle), NULL)) {
+    fault(__LINE__);
+  }
+#endif
+
+  /* Start the workers */
+  for(started = 0; started < nthreads; started++) {
+#ifdef AKS_WIN
+    (pp->pThreads)[started] = CreateThread(
+                                NULL, 0, &workerMain, pp, 0, NULL);
+    if ((pp->pThreads)[started] == NULL) {
+      break;
+    }
+#else
+    if (pthread_create(&((pp->pThreads)[started]), NULL,
+          &workerMain, pp)) {
+      break;
+    }
+#endif
+  }
+  pp->nthreads = started;
+
+  /* If not all workers could be started, shut down the ones that were */
+  if (started < nthreads) {
+    warn(__LINE__);
+    akspool_free(pp);
+    pp = NULL;
+  }
+
+  /* Return pool or NULL */
+  return pp;
+}
+
+/*
+ * akspool_free function.
+ */
+void akspool_free(AKSPOOL *pp) {
+  if (pp != NULL) {
+    stopWorkers(pp, pp->nthreads);
+#ifdef AKS_WIN
+    DeleteCriticalSection(&(pp->lock));
+#else
+    pthread_cond_destroy(&(pp->cvIdle));
+    pthread_cond_destroy(&(pp->cvTask));
+    pthread_mutex_destroy(&(pp->lock));
+#endif
+    free(pp->pQueue);
+    free(pp->pThreads);
+    free(pp);
+  }
+}
+
+/*
+ * akspool_size function.
+ */
+int akspool_size(AKSPOOL *pp) {
+  if (pp == NULL) {
+    fault(__LINE__);
+  }
+  return pp->nthreads;
+}
+
+/*
+ * akspool_submit function.
+ */
+void akspool_submit(AKSPOOL *pp, void (*fp)(void *), void *pArg) {
+
+  POOL_TASK *pNew = NULL;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if ((pp == NULL) || (fp == NULL)) {
+    fault(__LINE__);
+  }
+
+  lockPool(pp);
+
+  /* Grow the queue if full, unrolling it into the new buffer */
+  if (pp->qlen >= pp->qcap) {
+    if (pp->qcap > INT32_MAX / 2) {
+      fault(__LINE__);
+    }
+    pNew = (POOL_TASK *) calloc((size_t) (pp->qcap * 2), sizeof(POOL_TASK));
+    if (pNew == NULL) {
+      fault(__LINE__);
+    }
+    for(i = 0; i < pp->qlen; i++) {
+      memcpy(&(pNew[i]), &((pp->pQueue)[(pp->qhead + i) % pp->qcap]),
+              sizeof(POOL_TASK));
+    }
+    free(pp->pQueue);
+    pp->pQueue = pNew;
+    pp->qcap = pp->qcap * 2;
+    pp->qhead = 0;
+  }
+
+  /* Enqueue the task and wake a worker */
+  i = (pp->qhead + pp->qlen) % pp->qcap;
+  (pp->pQueue)[i].fp = fp;
+  (pp->pQueue)[i].pArg = pArg;
+  (pp->qlen)++;
+  (pp->pending)++;
+#ifdef AKS_WIN
+  WakeConditionVariable(&(pp->cvTask));
+#else
+  if (pthread_cond_signal(&(pp->cvTask))) {
+    fault(__LINE__);
+  }
+#endif
+
+  unlockPool(pp);
+}
+
+/*
+ * akspool_wait function.
+ */
+void akspool_wait(AKSPOOL *pp) {
+
+  /* Check parameter */
+  if (pp == NULL) {
+    fault(__LINE__);
+  }
+
+  lockPool(pp);
+  while (pp->pending > 0) {
+#ifdef AKS_WIN
+    if (!SleepConditionVariableCS(&(pp->cvIdle), &(pp->lock), INFINITE)) {
+      fault(__LINE__);
+    }
+#else
+    if (pthread_cond_wait(&(pp->cvIdle), &(pp->lock))) {
+      fault(__LINE__);
+    }
+#endif
+  }
+  unlockPool(pp);
+}
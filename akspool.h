@@ -0,0 +1,135 @@
+#ifndef AKSPOOL_H_INCLUDED
+#define AKSPOOL_H_INCLUDED
+
+/*
+ * akspool.h
+ * =========
+ * 
+ * Portable worker thread pool used by AKSView modules that perform work
+ * in parallel.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The maximum number of worker threads in a pool.
+ */
+#define AKSPOOL_MAXTHREAD (256)
+
+/*
+ * Structure prototype for AKSPOOL.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSPOOL_TAG;
+typedef struct AKSPOOL_TAG AKSPOOL;
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the akspool.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void akspool_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Create a new worker pool.
+ * 
+ * nthreads is the number of worker threads to start, which must be in
+ * range [1, AKSPOOL_MAXTHREAD].
+ * 
+ * The pool must eventually be released with akspool_free().
+ * 
+ * Parameters:
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ * Return:
+ * 
+ *   a new pool, or NULL if the worker threads could not be started
+ */
+AKSPOOL *akspool_new(int nthreads);
+
+/*
+ * Release a worker pool.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * All tasks that have been submitted are completed before the worker
+ * threads are stopped.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool, or NULL
+ */
+void akspool_free(AKSPOOL *pp);
+
+/*
+ * Get the number of worker threads in a pool.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ * 
+ * Return:
+ * 
+ *   the number of worker threads
+ */
+int akspool_size(AKSPOOL *pp);
+
+/*
+ * Submit a task to a worker pool.
+ * 
+ * The task function fp will be called with pArg on one of the worker
+ * threads.  Tasks are started in the order they are submitted, but
+ * since several workers run at once, they may finish in any order.
+ * 
+ * The task function must not call any function on the same pool.  Any
+ * data that the task shares with the submitting thread must not be
+ * accessed by the submitting thread until akspool_wait() returns.
+ * 
+ * Only the thread that created the pool may submit tasks or wait for
+ * them.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ * 
+ *   fp - the task function
+ * 
+ *   pArg - the argument to pass to the task function
+ */
+void akspool_submit(AKSPOOL *pp, void (*fp)(void *), void *pArg);
+
+/*
+ * Wait until all tasks submitted to a worker pool have completed.
+ * 
+ * When this function returns, everything that the tasks wrote to memory
+ * is visible to the calling thread.
+ * 
+ * Parameters:
+ * 
+ *   pp - the pool
+ */
+void akspool_wait(AKSPOOL *pp);
+
+#endif
@@ -0,0 +1,705 @@
+/*
+ * aksrank.c
+ * =========
+ * 
+ * Implementation of aksrank.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksrank.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Bits are counted with the processor's population count instruction
+ * when the compiler provides it, and with a portable routine otherwise.
+ * 
+ * GCC and Clang only emit the instruction on x86 when the target has it,
+ * for example with -mpopcnt or -march=native, and otherwise call a
+ * library routine that is slower than the portable one, so x86 targets
+ * without it keep the portable routine.
+ */
+#if defined(_MSC_VER) && defined(_M_X64)
+#define RANK_POPCNT_MSC
+#include <intrin.h>
+#elif defined(__GNUC__) && \
+      (defined(__POPCNT__) || \
+        (!defined(__x86_64__) && !defined(__i386__)))
+#define RANK_POPCNT_GCC
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a sidecar file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSRANK1".
+ */
+#define RANK_MAGIC (UINT64_C(0x314b4e4152534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header gives the number of bits and one bits in the vector, the
+ * number of rank directory entries, and the number of select samples.
+ * The rank directory follows the header, and the select samples follow
+ * the rank directory.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_NBITS (8)
+#define HDR_OFF_ONES  (16)
+#define HDR_OFF_NBLK  (24)
+#define HDR_OFF_NSAMP (32)
+#define HDR_SIZE      (64)
+
+/*
+ * Rank directory entry layout.
+ * 
+ * There is one entry per block of AKSRANK_BLOCK bits, plus a final
+ * entry that holds the total.  The first word is the number of one bits
+ * before the block.  The second word packs seven 9-bit counts, where
+ * count j (starting at one) is the number of one bits in the first j
+ * words of the block and is stored at bit 9 * (j - 1).
+ */
+#define ENT_OFF_BASE (0)
+#define ENT_OFF_SUB  (8)
+#define ENT_SIZE     (16)
+
+/*
+ * The number of 64-bit words in a block.
+ */
+#define BLOCK_WORDS (AKSRANK_BLOCK / 64)
+
+/*
+ * The number of blocks read at a time while building.
+ */
+#define BUILD_BLOCKS (512)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSRANK structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSRANK_TAG {
+
+  /*
+   * The viewer holding the bit vector and the offset of the vector.
+   */
+  AKSVIEW *pBits;
+  int64_t pos;
+
+  /*
+   * The viewer on the sidecar file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of bits, the number of one bits, the number of rank
+   * directory entries, and the number of select samples.
+   */
+  int64_t nbits;
+  int64_t ones;
+  int64_t nblk;
+  int64_t nsamp;
+
+  /*
+   * The file offset of the select samples in the sidecar.
+   */
+  int64_t samp;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksrank fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksrank warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local data
+ * ==========
+ */
+
+/*
+ * De Bruijn table for finding the lowest set bit of a 64-bit word.
+ */
+static const int m_debruijn[64] = {
+   0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+  62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+  63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+  46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t popCount(uint64_t w);
+static int32_t lowBit(uint64_t w);
+static int64_t subCount(uint64_t sub, int32_t j);
+static int64_t wordCount(int64_t nbits);
+
+/*
+ * Count the set bits in a 64-bit word.
+ * 
+ * Parameters:
+ * 
+ *   w - the word
+ * 
+ * Return:
+ * 
+ *   the number of set bits
+ */
+static int64_t popCount(uint64_t w) {
+#if defined(RANK_POPCNT_MSC)
+  return (int64_t) __popcnt64(w);
+#elif defined(RANK_POPCNT_GCC)
+  return (int64_t) __builtin_popcountll((unsigned long long) w);
+#else
+  w = w - ((w >> 1) & UINT64_C(0x5555555555555555));
+  w = (w & UINT64_C(0x3333333333333333)) +
+        ((w >> 2) & UINT64_C(0x3333333333333333));
+  w = (w + (w >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (int64_t) ((w * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/*
+ * Find the lowest set bit in a non-zero 64-bit word.
+ * 
+ * Parameters:
+ * 
+ *   w - the word, which must not be zero
+ * 
+ * Return:
+ * 
+ *   the index of the lowest set bit
+ */
+static int32_t lowBit(uint64_t w) {
+  return m_debruijn[
+          ((w & (~w + 1)) * UINT64_C(0x03f79d71b4cb0a89)) >> 58];
+}
+
+/*
+ * Extract a count from the packed second word of a directory entry.
+ * 
+ * Parameters:
+ * 
+ *   sub - the packed counts
+ * 
+ *   j - the number of leading words of the block, in range [0, 7]
+ * 
+ * Return:
+ * 
+ *   the number of one bits in the first j words of the block
+ */
+static int64_t subCount(uint64_t sub, int32_t j) {
+
+  int64_t result = 0;
+
+  if (j > 0) {
+    result = (int64_t) ((sub >> (9 * (j - 1))) & 0x1ff);
+  }
+
+  return result;
+}
+
+/*
+ * Get the number of 64-bit words holding a bit vector.
+ * 
+ * Parameters:
+ * 
+ *   nbits - the number of bits
+ * 
+ * Return:
+ * 
+ *   the number of words
+ */
+static int64_t wordCount(int64_t nbits) {
+  return (nbits / 64) + (((nbits % 64) != 0) ? 1 : 0);
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksrank_onerror function.
+ */
+void aksrank_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksrank_errstr function.
+ */
+const char *aksrank_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSRANK_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSRANK_ERR_OPEN:
+      pResult = "Failed to open sidecar file";
+      break;
+
+    case AKSRANK_ERR_FORMAT:
+      pResult = "Sidecar file has invalid format";
+      break;
+
+    case AKSRANK_ERR_RESIZE:
+      pResult = "Failed to resize sidecar file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksrank_build function.
+ */
+int aksrank_build(
+    AKSVIEW    * pBits,
+    int64_t      pos,
+    int64_t      nbits,
+    const char * pPath,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pv = NULL;
+  uint64_t *pWords = NULL;
+  uint64_t *pDir = NULL;
+  int64_t nword = 0;
+  int64_t nblk = 0;
+  int64_t samp = 0;
+  int64_t nsamp = 0;
+  int64_t next = 0;
+  int64_t ones = 0;
+  int64_t w = 0;
+  int64_t nw = 0;
+  int64_t b = 0;
+  int64_t nb = 0;
+  int64_t c = 0;
+  int32_t j = 0;
+  uint64_t sub = 0;
+
+  /* Check parameters */
+  if ((pBits == NULL) || (pPath == NULL)) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (nbits < 0)) {
+    fault(__LINE__);
+  }
+  nword = wordCount(nbits);
+  if (pos > aksview_getlen(pBits) - (nword * 8)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRANK_ERR_NONE;
+
+  /* Open the sidecar, discarding any existing contents */
+  pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pv == NULL) {
+    status = 0;
+    *perr = AKSRANK_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pv, 0)) {
+      status = 0;
+      *perr = AKSRANK_ERR_RESIZE;
+    }
+  }
+
+  /* Make room for the header and the rank directory */
+  nblk = (nbits / AKSRANK_BLOCK) +
+          (((nbits % AKSRANK_BLOCK) != 0) ? 1 : 0) + 1;
+  samp = HDR_SIZE + (nblk * ENT_SIZE);
+  if (status) {
+    if (!aksview_reserve(pv, samp)) {
+      status = 0;
+      *perr = AKSRANK_ERR_RESIZE;
+    }
+  }
+
+  /* Allocate the buffers */
+  if (status) {
+    pWords = (uint64_t *) malloc(BUILD_BLOCKS * BLOCK_WORDS * 8);
+    pDir = (uint64_t *) malloc(BUILD_BLOCKS * 2 * 8);
+    if ((pWords == NULL) || (pDir == NULL)) {
+      fault(__LINE__);
+    }
+  }
+
+  /* Read the vector a batch of blocks at a time */
+  for(w = 0; status && (w < nword); w += nw) {
+    nw = nword - w;
+    if (nw > BUILD_BLOCKS * BLOCK_WORDS) {
+      nw = BUILD_BLOCKS * BLOCK_WORDS;
+    }
+    aksview_readv64u(pBits, pos + (w * 8), 1, pWords, nw);
+
+    /* Pad the batch to whole blocks, and clear bits beyond the end */
+    if (w + nw >= nword) {
+      if ((nbits % 64) != 0) {
+        pWords[nw - 1] &= (((uint64_t) 1) << (nbits % 64)) - 1;
+      }
+      while ((nw % BLOCK_WORDS) != 0) {
+        pWords[nw] = 0;
+        nw++;
+      }
+    }
+
+    /* Build the directory entries of the batch */
+    nb = nw / BLOCK_WORDS;
+    for(b = 0; b < nb; b++) {
+      c = 0;
+      sub = 0;
+      for(j = 0; j < BLOCK_WORDS; j++) {
+        if (j > 0) {
+          sub |= ((uint64_t) c) << (9 * (j - 1));
+        }
+        c += popCount(pWords[(b * BLOCK_WORDS) + j]);
+      }
+      pDir[2 * b] = (uint64_t) ones;
+      pDir[(2 * b) + 1] = sub;
+
+      /* Record a sample for each sampled one bit in this block */
+      while (next < ones + c) {
+        if (!aksview_reserve(pv, samp + ((nsamp + 1) * 8))) {
+          status = 0;
+          *perr = AKSRANK_ERR_RESIZE;
+          break;
+        }
+        aksview_write64s(pv, samp + (nsamp * 8), 1, (w / BLOCK_WORDS) + b);
+        nsamp++;
+        next += AKSRANK_SAMPLE;
+      }
+      ones += c;
+    }
+    if (status) {
+      aksview_writev64u(pv, HDR_SIZE + ((w / BLOCK_WORDS) * ENT_SIZE), 1,
+                        pDir, nb * 2);
+    }
+  }
+
+  /* Write the final entry, trim the file, and write the header with the
+   * magic number last */
+  if (status) {
+    aksview_write64s(pv, HDR_SIZE + ((nblk - 1) * ENT_SIZE) + ENT_OFF_BASE,
+                      1, ones);
+    aksview_write64u(pv, HDR_SIZE + ((nblk - 1) * ENT_SIZE) + ENT_OFF_SUB,
+                      1, 0);
+    if (!aksview_setlen(pv, samp + (nsamp * 8))) {
+      status = 0;
+      *perr = AKSRANK_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    aksview_write64s(pv, HDR_OFF_NBITS, 1, nbits);
+    aksview_write64s(pv, HDR_OFF_ONES, 1, ones);
+    aksview_write64s(pv, HDR_OFF_NBLK, 1, nblk);
+    aksview_write64s(pv, HDR_OFF_NSAMP, 1, nsamp);
+    aksview_write64u(pv, HDR_OFF_MAGIC, 1, RANK_MAGIC);
+  }
+
+  /* Release everything */
+  aksview_close(pv);
+  free(pWords);
+  free(pDir);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksrank_open function.
+ */
+AKSRANK *aksrank_open(
+    AKSVIEW    * pBits,
+    int64_t      pos,
+    const char * pPath,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSRANK *pr = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if ((pBits == NULL) || (pPath == NULL) || (pos < 0)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRANK_ERR_NONE;
+
+  /* Allocate the structure */
+  pr = (AKSRANK *) calloc(1, sizeof(AKSRANK));
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  pr->pBits = pBits;
+  pr->pos = pos;
+
+  /* Open the sidecar */
+  pr->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pr->pv == NULL) {
+    status = 0;
+    *perr = AKSRANK_ERR_OPEN;
+  }
+
+  /* Read and check the header against the file and the vector */
+  if (status) {
+    flen = aksview_getlen(pr->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pr->nbits = aksview_read64s(pr->pv, HDR_OFF_NBITS, 1);
+    pr->ones = aksview_read64s(pr->pv, HDR_OFF_ONES, 1);
+    pr->nblk = aksview_read64s(pr->pv, HDR_OFF_NBLK, 1);
+    pr->nsamp = aksview_read64s(pr->pv, HDR_OFF_NSAMP, 1);
+    if ((aksview_read64u(pr->pv, HDR_OFF_MAGIC, 1) != RANK_MAGIC) ||
+        (pr->nbits < 0) || (pr->ones < 0) || (pr->ones > pr->nbits) ||
+        (pr->nblk != (pr->nbits / AKSRANK_BLOCK) +
+                      (((pr->nbits % AKSRANK_BLOCK) != 0) ? 1 : 0) + 1) ||
+        (pr->nsamp != (pr->ones / AKSRANK_SAMPLE) +
+                      (((pr->ones % AKSRANK_SAMPLE) != 0) ? 1 : 0)) ||
+        (flen != HDR_SIZE + (pr->nblk * ENT_SIZE) + (pr->nsamp * 8)) ||
+        (pos > aksview_getlen(pBits) - (wordCount(pr->nbits) * 8))) {
+      status = 0;
+    }
+    pr->samp = HDR_SIZE + (pr->nblk * ENT_SIZE);
+    if (!status) {
+      *perr = AKSRANK_ERR_FORMAT;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pr->pv);
+    free(pr);
+    pr = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pr;
+}
+
+/*
+ * aksrank_close function.
+ */
+void aksrank_close(AKSRANK *pr) {
+  if (pr != NULL) {
+    aksview_close(pr->pv);
+    free(pr);
+  }
+}
+
+/*
+ * aksrank_nbits function.
+ */
+int64_t aksrank_nbits(AKSRANK *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return pr->nbits;
+}
+
+/*
+ * aksrank_ones function.
+ */
+int64_t aksrank_ones(AKSRANK *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return pr->ones;
+}
+
+/*
+ * aksrank_get function.
+ */
+int aksrank_get(AKSRANK *pr, int64_t i) {
+
+  /* Check parameters */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  if ((i < 0) || (i >= pr->nbits)) {
+    fault(__LINE__);
+  }
+
+  return (int) ((aksview_read64u(pr->pBits, pr->pos + ((i / 64) * 8), 1)
+                  >> (i % 64)) & 1);
+}
+
+/*
+ * aksrank_rank1 function.
+ */
+int64_t aksrank_rank1(AKSRANK *pr, int64_t i) {
+
+  int64_t result = 0;
+  int64_t epos = 0;
+  uint64_t w = 0;
+
+  /* Check parameters */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  if ((i < 0) || (i > pr->nbits)) {
+    fault(__LINE__);
+  }
+
+  /* Count up to the start of the word from the directory entry */
+  epos = HDR_SIZE + ((i / AKSRANK_BLOCK) * ENT_SIZE);
+  result = aksview_read64s(pr->pv, epos + ENT_OFF_BASE, 1);
+  result += subCount(aksview_read64u(pr->pv, epos + ENT_OFF_SUB, 1),
+                      (int32_t) ((i / 64) % BLOCK_WORDS));
+
+  /* Count within the word */
+  if ((i % 64) != 0) {
+    w = aksview_read64u(pr->pBits, pr->pos + ((i / 64) * 8), 1);
+    result += popCount(w & ((((uint64_t) 1) << (i % 64)) - 1));
+  }
+
+  return result;
+}
+
+/*
+ * aksrank_rank0 function.
+ */
+int64_t aksrank_rank0(AKSRANK *pr, int64_t i) {
+  return i - aksrank_rank1(pr, i);
+}
+
+/*
+ * aksrank_select1 function.
+ */
+int64_t aksrank_select1(AKSRANK *pr, int64_t k) {
+
+  int64_t result = -1;
+  int64_t s = 0;
+  int64_t lo = 0;
+  int64_t hi = 0;
+  int64_t mid = 0;
+  uint64_t sub = 0;
+  uint64_t w = 0;
+  int32_t j = 0;
+
+  /* Check parameters */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  if ((k >= 0) && (k < pr->ones)) {
+    /* The samples bound the blocks that can hold the bit */
+    s = k / AKSRANK_SAMPLE;
+    lo = aksview_read64s(pr->pv, pr->samp + (s * 8), 1);
+    if (s + 1 < pr->nsamp) {
+      hi = aksview_read64s(pr->pv, pr->samp + ((s + 1) * 8), 1);
+    } else {
+      hi = pr->nblk - 2;
+    }
+    if ((lo < 0) || (hi < lo) || (hi > pr->nblk - 2)) {
+      fault(__LINE__);
+    }
+
+    /* Find the last block in range with at most k one bits before it */
+    while (lo < hi) {
+      mid = lo + ((hi - lo + 1) / 2);
+      if (aksview_read64s(pr->pv, HDR_SIZE + (mid * ENT_SIZE) +
+                            ENT_OFF_BASE, 1) <= k) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+    k -= aksview_read64s(pr->pv, HDR_SIZE + (lo * ENT_SIZE) +
+                          ENT_OFF_BASE, 1);
+    sub = aksview_read64u(pr->pv, HDR_SIZE + (lo * ENT_SIZE) +
+                            ENT_OFF_SUB, 1);
+
+    /* Find the word within the block */
+    j = 0;
+    while ((j < BLOCK_WORDS - 1) && (subCount(sub, j + 1) <= k)) {
+      j++;
+    }
+    k -= subCount(sub, j);
+
+    /* Find the bit within the word */
+    w = aksview_read64u(pr->pBits,
+          pr->pos + (((lo * BLOCK_WORDS) + j) * 8), 1);
+    for( ; k > 0; k--) {
+      w &= w - 1;
+    }
+    if (w == 0) {
+      fault(__LINE__);
+    }
+    result = (((lo * BLOCK_WORDS) + j) * 64) + lowBit(w);
+  }
+
+  return result;
+}
@@ -0,0 +1,252 @@
+#ifndef AKSRANK_H_INCLUDED
+#define AKSRANK_H_INCLUDED
+
+/*
+ * aksrank.h
+ * =========
+ * 
+ * Rank and select over bit vectors stored in AKSView files, using a
+ * precomputed sidecar file.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The number of bits in each block of the rank directory.
+ * 
+ * Each block has one 16-byte directory entry, so the rank directory
+ * adds 25% to the size of the bit vector.
+ */
+#define AKSRANK_BLOCK (512)
+
+/*
+ * The number of one bits between select samples.
+ * 
+ * Each sample is an eight-byte block index, so the samples add at most
+ * 1/64 bit per one bit.
+ */
+#define AKSRANK_SAMPLE (512)
+
+/*
+ * Structure prototype for AKSRANK.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSRANK_TAG;
+typedef struct AKSRANK_TAG AKSRANK;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksrank_errstr() to convert these to error messages.
+ */
+#define AKSRANK_ERR_NONE   (0)
+#define AKSRANK_ERR_OPEN   (1)
+#define AKSRANK_ERR_FORMAT (2)
+#define AKSRANK_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksrank.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksrank_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSRANK_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksrank_errstr(int code);
+
+/*
+ * Build the rank and select sidecar for a bit vector.
+ * 
+ * The bit vector is nbits bits long and is stored in pBits starting at
+ * file offset pos, as a sequence of little-endian 64-bit words in which
+ * bit i is bit (i % 64) of word (i / 64).  This is the layout produced
+ * by writing the words with aksview_write64u() or aksview_writev64u()
+ * in little-endian mode.  Bits in the last word beyond nbits are
+ * ignored.
+ * 
+ * The bit vector is read once from start to end with bulk loads.  The
+ * sidecar file at pPath is created if it does not exist, and truncated
+ * to length zero if it does.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSRANK_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pBits - the viewer holding the bit vector
+ * 
+ *   pos - the file offset of the bit vector
+ * 
+ *   nbits - the number of bits in the bit vector
+ * 
+ *   pPath - path to the sidecar file to write
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksrank_build(
+    AKSVIEW    * pBits,
+    int64_t      pos,
+    int64_t      nbits,
+    const char * pPath,
+    int        * perr);
+
+/*
+ * Open a bit vector together with its sidecar for queries.
+ * 
+ * pBits and pos must give the same bit vector that the sidecar was
+ * built from.  The object refers to pBits, so the viewer must stay open
+ * for as long as the object is used.  The sidecar at pPath is opened
+ * read-only, and only its header is read.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksrank_build().
+ * 
+ * Parameters:
+ * 
+ *   pBits - the viewer holding the bit vector
+ * 
+ *   pos - the file offset of the bit vector
+ * 
+ *   pPath - path to the sidecar file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new rank object or NULL if the function failed
+ */
+AKSRANK *aksrank_open(
+    AKSVIEW    * pBits,
+    int64_t      pos,
+    const char * pPath,
+    int        * perr);
+
+/*
+ * Close a rank object.
+ * 
+ * The sidecar is closed, but the bit vector viewer is not.  If NULL is
+ * passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pr - the rank object, or NULL
+ */
+void aksrank_close(AKSRANK *pr);
+
+/*
+ * Get the number of bits and the number of one bits in the vector.
+ * 
+ * Parameters:
+ * 
+ *   pr - the rank object
+ * 
+ * Return:
+ * 
+ *   the requested count
+ */
+int64_t aksrank_nbits(AKSRANK *pr);
+int64_t aksrank_ones(AKSRANK *pr);
+
+/*
+ * Get a single bit of the vector.
+ * 
+ * Parameters:
+ * 
+ *   pr - the rank object
+ * 
+ *   i - the bit index, in range [0, nbits - 1]
+ * 
+ * Return:
+ * 
+ *   the bit value, zero or one
+ */
+int aksrank_get(AKSRANK *pr, int64_t i);
+
+/*
+ * Count the one bits or the zero bits before a position.
+ * 
+ * aksrank_rank1() returns the number of one bits with index less than
+ * i, and aksrank_rank0() returns the number of zero bits with index
+ * less than i.
+ * 
+ * Each query reads one directory entry from the sidecar and one word
+ * of the bit vector, so it takes constant time and touches two cache
+ * lines.
+ * 
+ * Parameters:
+ * 
+ *   pr - the rank object
+ * 
+ *   i - the position, in range [0, nbits]
+ * 
+ * Return:
+ * 
+ *   the number of matching bits before position i
+ */
+int64_t aksrank_rank1(AKSRANK *pr, int64_t i);
+int64_t aksrank_rank0(AKSRANK *pr, int64_t i);
+
+/*
+ * Find the position of a one bit by its rank.
+ * 
+ * This is the inverse of aksrank_rank1(): it returns the index of the
+ * one bit that has exactly k one bits before it.
+ * 
+ * The select samples narrow the search to the blocks between two
+ * samples, the directory entries of those blocks are binary searched,
+ * and then a single word of the bit vector is scanned.
+ * 
+ * Parameters:
+ * 
+ *   pr - the rank object
+ * 
+ *   k - the rank of the one bit, starting at zero
+ * 
+ * Return:
+ * 
+ *   the index of the one bit, or -1 if k is not less than the number
+ *   of one bits
+ */
+int64_t aksrank_select1(AKSRANK *pr, int64_t k);
+
+#endif
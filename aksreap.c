@@ -0,0 +1,529 @@
+/*
+ * aksreap.c
+ * =========
+ * 
+ * Implementation of aksreap.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksreap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aksmacro.h"
+
+/* OS-specific headers */
+#ifdef AKS_WIN
+/* Windows headers */
+#include <windows.h>
+
+#else
+/* POSIX headers */
+#include <pthread.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The initial capacity of the close queue.
+ */
+#define QUEUE_INIT (64)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSREAP structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSREAP_TAG {
+
+  /*
+   * The handle of the background thread.
+   */
+#ifdef AKS_WIN
+  HANDLE hThread;
+#else
+  pthread_t thread;
+#endif
+
+  /*
+   * The lock that protects the rest of the structure, the condition
+   * that the background thread waits on for new viewers, and the
+   * condition that waiters wait on for closes to finish.
+   */
+#ifdef AKS_WIN
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE cvWork;
+  CONDITION_VARIABLE cvDone;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t cvWork;
+  pthread_cond_t cvDone;
+#endif
+
+  /*
+   * The queue of viewers waiting to be closed, in the order they were
+   * handed over.
+   * 
+   * qcap is the capacity and qlen is the number of queued viewers.
+   */
+  AKSVIEW **pQueue;
+  int32_t qcap;
+  int32_t qlen;
+
+  /*
+   * The batch of viewers that the background thread is closing.
+   * 
+   * The background thread takes the whole queue at once by swapping it
+   * with this buffer, so the lock is not held while closing.  bcap is
+   * the capacity.
+   */
+  AKSVIEW **pBatch;
+  int32_t bcap;
+
+  /*
+   * The ticket of the most recently queued viewer, and the ticket of
+   * the most recently closed viewer.
+   * 
+   * Tickets start at one, so both are zero initially.
+   */
+  int64_t queued;
+  int64_t done;
+
+  /*
+   * Set when the background thread should exit once the queue is
+   * empty.
+   */
+  int stop;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksreap fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksreap warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static void lockReap(AKSREAP *pr);
+static void unlockReap(AKSREAP *pr);
+static void growQueue(AKSREAP *pr, int32_t n);
+static void runReaper(AKSREAP *pr);
+#ifdef AKS_WIN
+static DWORD WINAPI reaperMain(LPVOID pParam);
+#else
+static void *reaperMain(void *pParam);
+#endif
+
+/*
+ * Acquire and release the reaper lock.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ */
+static void lockReap(AKSREAP *pr) {
+#ifdef AKS_WIN
+  EnterCriticalSection(&(pr->lock));
+#else
+  if (pthread_mutex_lock(&(pr->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+static void unlockReap(AKSREAP *pr) {
+#ifdef AKS_WIN
+  LeaveCriticalSection(&(pr->lock));
+#else
+  if (pthread_mutex_unlock(&(pr->lock))) {
+    fault(__LINE__);
+  }
+#endif
+}
+
+/*
+ * Make room in the queue for n more viewers.
+ * 
+ * The caller must hold the reaper lock.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ * 
+ *   n - the number of viewers about to be queued
+ */
+static void growQueue(AKSREAP *pr, int32_t n) {
+
+  AKSVIEW **pNew = NULL;
+  int32_t cap = 0;
+
+  /* Check parameter */
+  if (n < 0) {
+    fault(__LINE__);
+  }
+
+  /* Only proceed if the queue is too small */
+  if (n > pr->qcap - pr->qlen) {
+
+    /* Double the capacity until it is large enough */
+    if (n > INT32_MAX / 2 - pr->qlen) {
+      fault(__LINE__);
+    }
+    cap = pr->qcap;
+    while (cap - pr->qlen < n) {
+      cap = cap * 2;
+    }
+
+    pNew = (AKSVIEW **) realloc(
+              pr->pQueue, ((size_t) cap) * sizeof(AKSVIEW *));
+    if (pNew == NULL) {
+      fault(__LINE__);
+    }
+    pr->pQueue = pNew;
+    pr->qcap = cap;
+  }
+}
+
+/*
+ * The body of the background thread.
+ * 
+ * Repeatedly takes every queued viewer at once and closes them in
+ * order, until the reaper is stopped and the queue is empty.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ */
+static void runReaper(AKSREAP *pr) {
+
+  AKSVIEW **pSwap = NULL;
+  int32_t cap = 0;
+  int32_t n = 0;
+  int32_t i = 0;
+
+  lockReap(pr);
+  for(;;) {
+
+    /* Wait for viewers or for the stop signal */
+    while ((pr->qlen < 1) && (!(pr->stop))) {
+#ifdef AKS_WIN
+      if (!SleepConditionVariableCS(&(pr->cvWork), &(pr->lock),
+            INFINITE)) {
+        fault(__LINE__);
+      }
+#else
+      if (pthread_cond_wait(&(pr->cvWork), &(pr->lock))) {
+        fault(__LINE__);
+      }
+#endif
+    }
+    if (pr->qlen < 1) {
+      break;
+    }
+
+    /* Take the whole queue as the next batch, leaving the previous
+     * batch buffer behind as the new, empty queue */
+    pSwap = pr->pBatch;
+    cap = pr->bcap;
+    pr->pBatch = pr->pQueue;
+    pr->bcap = pr->qcap;
+    pr->pQueue = pSwap;
+    pr->qcap = cap;
+    n = pr->qlen;
+    pr->qlen = 0;
+    unlockReap(pr);
+
+    /* Close the batch without holding the lock */
+    for(i = 0; i < n; i++) {
+      aksview_close((pr->pBatch)[i]);
+      (pr->pBatch)[i] = NULL;
+    }
+
+    /* Record completion and wake waiters */
+    lockReap(pr);
+    pr->done += (int64_t) n;
+#ifdef AKS_WIN
+    WakeAllConditionVariable(&(pr->cvDone));
+#else
+    if (pthread_cond_broadcast(&(pr->cvDone))) {
+      fault(__LINE__);
+    }
+#endif
+  }
+  unlockReap(pr);
+}
+
+/*
+ * Thread entry point for the background thread.
+ */
+#ifdef AKS_WIN
+static DWORD WINAPI reaperMain(LPVOID pParam) {
+  runReaper((AKSREAP *) pParam);
+  return 0;
+}
+#else
+static void *reaperMain(void *pParam) {
+  runReaper((AKSREAP *) pParam);
+  return NULL;
+}
+#endif
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksreap_onerror function.
+ */
+void aksreap_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksreap_new function.
+ */
+AKSREAP *aksreap_new(void) {
+
+  AKSREAP *pr = NULL;
+  int status = 1;
+
+  /* Allocate the structure and both queue buffers */
+  pr = (AKSREAP *) calloc(1, sizeof(AKSREAP));
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  pr->qcap = QUEUE_INIT;
+  pr->pQueue = (AKSVIEW **) calloc((size_t) pr->qcap, sizeof(AKSVIEW *));
+  if (pr->pQueue == NULL) {
+    fault(__LINE__);
+  }
+  pr->bcap = QUEUE_INIT;
+  pr->pBatch = (AKSVIEW **) calloc((size_t) pr->bcap, sizeof(AKSVIEW *));
+  if (pr->pBatch == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Initialize the synchronization objects */
+#ifdef AKS_WIN
+  InitializeCriticalSection(&(pr->lock));
+  InitializeConditionVariable(&(pr->cvWork));
+  InitializeConditionVariable(&(pr->cvDone));
+#else
+  if (pthread_mutex_init(&(pr->lock), NULL) ||
+      pthread_cond_init(&(pr->cvWork), NULL) ||
+      pthread_cond_init(&(pr->cvDone), NULL)) {
+    fault(__LINE__);
+  }
+#endif
+
+  /* Start the background thread */
+#ifdef AKS_WIN
+  pr->hThread = CreateThread(NULL, 0, &reaperMain, pr, 0, NULL);
+  if (pr->hThread == NULL) {
+    status = 0;
+  }
+#else
+  if (pthread_create(&(pr->thread), NULL, &reaperMain, pr)) {
+    status = 0;
+  }
+#endif
+
+  /* If the thread could not be started, release everything */
+  if (!status) {
+    warn(__LINE__);
+#ifdef AKS_WIN
+    DeleteCriticalSection(&(pr->lock));
+#else
+    pthread_cond_destroy(&(pr->cvDone));
+    pthread_cond_destroy(&(pr->cvWork));
+    pthread_mutex_destroy(&(pr->lock));
+#endif
+    free(pr->pBatch);
+    free(pr->pQueue);
+    free(pr);
+    pr = NULL;
+  }
+
+  /* Return reaper or NULL */
+  return pr;
+}
+
+/*
+ * aksreap_free function.
+ */
+void aksreap_free(AKSREAP *pr) {
+  if (pr != NULL) {
+    /* Signal the background thread to stop once the queue is empty */
+    lockReap(pr);
+    pr->stop = 1;
+#ifdef AKS_WIN
+    WakeAllConditionVariable(&(pr->cvWork));
+#else
+    if (pthread_cond_broadcast(&(pr->cvWork))) {
+      fault(__LINE__);
+    }
+#endif
+    unlockReap(pr);
+
+    /* Wait for it to exit */
+#ifdef AKS_WIN
+    if (WaitForSingleObject(pr->hThread, INFINITE) != WAIT_OBJECT_0) {
+      fault(__LINE__);
+    }
+    CloseHandle(pr->hThread);
+    DeleteCriticalSection(&(pr->lock));
+#else
+    if (pthread_join(pr->thread, NULL)) {
+      fault(__LINE__);
+    }
+    pthread_cond_destroy(&(pr->cvDone));
+    pthread_cond_destroy(&(pr->cvWork));
+    pthread_mutex_destroy(&(pr->lock));
+#endif
+
+    free(pr->pBatch);
+    free(pr->pQueue);
+    free(pr);
+  }
+}
+
+/*
+ * aksreap_close function.
+ */
+int64_t aksreap_close(AKSREAP *pr, AKSVIEW *pv) {
+  return aksreap_closev(pr, &pv, 1);
+}
+
+/*
+ * aksreap_closev function.
+ */
+int64_t aksreap_closev(AKSREAP *pr, AKSVIEW **ppv, int32_t n) {
+
+  int64_t result = 0;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if ((pr == NULL) || (n < 0)) {
+    fault(__LINE__);
+  }
+  if ((ppv == NULL) && (n > 0)) {
+    fault(__LINE__);
+  }
+
+  lockReap(pr);
+
+  /* Queue every non-NULL viewer, issuing a ticket for each */
+  growQueue(pr, n);
+  for(i = 0; i < n; i++) {
+    if (ppv[i] != NULL) {
+      (pr->pQueue)[pr->qlen] = ppv[i];
+      (pr->qlen)++;
+      (pr->queued)++;
+    }
+  }
+  result = pr->queued;
+
+  /* Wake the background thread if anything was queued */
+  if (pr->qlen > 0) {
+#ifdef AKS_WIN
+    WakeConditionVariable(&(pr->cvWork));
+#else
+    if (pthread_cond_signal(&(pr->cvWork))) {
+      fault(__LINE__);
+    }
+#endif
+  }
+
+  unlockReap(pr);
+
+  /* Return the ticket of the last viewer */
+  return result;
+}
+
+/*
+ * aksreap_wait function.
+ */
+void aksreap_wait(AKSREAP *pr, int64_t ticket) {
+
+  /* Check parameters */
+  if ((pr == NULL) || (ticket < -1)) {
+    fault(__LINE__);
+  }
+
+  lockReap(pr);
+
+  /* Replace -1 with the most recent ticket, and make sure the ticket
+   * has actually been issued so the wait can finish */
+  if (ticket < 0) {
+    ticket = pr->queued;
+  }
+  if (ticket > pr->queued) {
+    fault(__LINE__);
+  }
+
+  /* Wait until the background thread has closed that far */
+  while (pr->done < ticket) {
+#ifdef AKS_WIN
+    if (!SleepConditionVariableCS(&(pr->cvDone), &(pr->lock), INFINITE)) {
+      fault(__LINE__);
+    }
+#else
+    if (pthread_cond_wait(&(pr->cvDone), &(pr->lock))) {
+      fault(__LINE__);
+    }
+#endif
+  }
+
+  unlockReap(pr);
+}
@@ -0,0 +1,161 @@
+#ifndef AKSREAP_H_INCLUDED
+#define AKSREAP_H_INCLUDED
+
+/*
+ * aksreap.h
+ * =========
+ * 
+ * Background closing of AKSView viewer objects.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * Structure prototype for AKSREAP.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSREAP_TAG;
+typedef struct AKSREAP_TAG AKSREAP;
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksreap.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksreap_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Create a new reaper.
+ * 
+ * A reaper owns a single background thread that closes viewer objects
+ * handed to it with aksreap_close() or aksreap_closev().  Closing a
+ * viewer flushes its window, unmaps it, closes the file, and updates
+ * the file timestamp, all of which may block for a long time, so
+ * handing viewers to a reaper keeps that work off threads that must
+ * respond quickly.
+ * 
+ * The reaper must eventually be released with aksreap_free().
+ * 
+ * Return:
+ * 
+ *   a new reaper, or NULL if the background thread could not be
+ *   started
+ */
+AKSREAP *aksreap_new(void);
+
+/*
+ * Release a reaper.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Every viewer that has been handed to the reaper is closed before the
+ * background thread is stopped.
+ * 
+ * No other thread may be using the reaper when it is released.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper, or NULL
+ */
+void aksreap_free(AKSREAP *pr);
+
+/*
+ * Hand a viewer object to a reaper to be closed in the background.
+ * 
+ * This is the asynchronous equivalent of aksview_close().  It only adds
+ * the viewer to the reaper's queue and returns immediately.  If NULL is
+ * passed for pv, nothing is queued.
+ * 
+ * Ownership of the viewer passes to the reaper, so the caller must not
+ * use it again in any way after this call.
+ * 
+ * The return value is a ticket that can be passed to aksreap_wait() to
+ * wait until this viewer, and every viewer handed to the reaper before
+ * it, has been closed.  Tickets increase by one for each viewer queued.
+ * 
+ * This function may be called from any thread.
+ * 
+ * CAUTION: Until the viewer is actually closed, the file remains open.
+ * On Windows, writable files are opened without sharing, so wait for
+ * the ticket before opening the same file again.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ * 
+ *   pv - the viewer to close, or NULL
+ * 
+ * Return:
+ * 
+ *   the ticket for the close
+ */
+int64_t aksreap_close(AKSREAP *pr, AKSVIEW *pv);
+
+/*
+ * Hand an array of viewer objects to a reaper to be closed in the
+ * background.
+ * 
+ * This is equivalent to calling aksreap_close() on each element of the
+ * array in order, except that the whole array is queued under a single
+ * acquisition of the reaper's lock.  NULL elements are skipped.
+ * 
+ * The return value is the ticket of the last viewer in the array, so
+ * waiting on it waits for the whole batch.  If n is zero, the ticket of
+ * the most recently queued viewer is returned.
+ * 
+ * This function may be called from any thread.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ * 
+ *   ppv - the array of viewers to close
+ * 
+ *   n - the number of elements in the array
+ * 
+ * Return:
+ * 
+ *   the ticket for the last close in the batch
+ */
+int64_t aksreap_closev(AKSREAP *pr, AKSVIEW **ppv, int32_t n);
+
+/*
+ * Wait until a reaper has finished closing the viewer with a given
+ * ticket.
+ * 
+ * Viewers are closed in the order they were queued, so when this
+ * function returns, every viewer with a ticket less than or equal to
+ * the given ticket has been closed.  Passing -1 waits for every viewer
+ * that had been queued when the call was made.
+ * 
+ * This function may be called from any thread.
+ * 
+ * Parameters:
+ * 
+ *   pr - the reaper
+ * 
+ *   ticket - the ticket to wait for, or -1
+ */
+void aksreap_wait(AKSREAP *pr, int64_t ticket);
+
+#endif
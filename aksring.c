@@ -0,0 +1,906 @@
+/*
+ * aksring.c
+ * =========
+ * 
+ * Implementation of aksring.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aksmacro.h"
+
+/* OS-specific headers */
+#ifdef AKS_WIN
+/* Windows headers */
+#include <windows.h>
+
+#else
+/* POSIX headers */
+#include <limits.h>
+#include <time.h>
+
+/*
+ * On Linux, waits use a futex in the shared mapping.
+ * 
+ * The C library only declares syscall() when _DEFAULT_SOURCE or
+ * _GNU_SOURCE is defined, so it is declared here as well.  The futex
+ * timeout is passed in a local structure with the layout of the
+ * kernel's timespec, which does not depend on feature-test macros.
+ */
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define RING_FUTEX
+long syscall(long number, ...);
+
+typedef struct {
+  long tv_sec;
+  long tv_nsec;
+} RING_TIMEOUT;
+#endif
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a ring file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSRING1".
+ */
+#define RING_MAGIC (UINT64_C(0x31474e4952534b41))
+
+/*
+ * File layout.
+ * 
+ * The first cache line holds the little-endian header fields, which
+ * never change after the ring is created.  The tail counter, which the
+ * producers update, and the head counter, which the consumer updates,
+ * each have their own cache line, as do the event count and waiter
+ * count used for wakeups.  The data area begins after these.
+ * 
+ * The counters are stored in native byte order, since they are updated
+ * with atomic operations directly in the shared mapping.
+ */
+#define HDR_OFF_MAGIC   (0)
+#define HDR_OFF_CAP     (8)
+#define HDR_OFF_MODE    (16)
+#define HDR_OFF_TAIL    (64)
+#define HDR_OFF_HEAD    (128)
+#define HDR_OFF_PEND    (136)
+#define HDR_OFF_EVENT   (192)
+#define HDR_OFF_WAITERS (196)
+#define HDR_SIZE        (256)
+
+/*
+ * Frame layout.
+ * 
+ * Every frame in the data area begins with two native 32-bit integers.
+ * The first is the state word: zero for space that has not been
+ * claimed, the negated frame size for a reserved frame that has not
+ * been committed, and the frame size for a committed frame.  The second
+ * is the record length, or FRAME_PAD for a padding frame that fills the
+ * end of the data area when a record does not fit there.
+ * 
+ * Frame sizes include the header and are multiples of FRAME_ALIGN.
+ */
+#define FRAME_HDR   (8)
+#define FRAME_ALIGN (8)
+#define FRAME_PAD   (-1)
+
+/*
+ * The initial capacity of a producer's batch list.
+ */
+#define BATCH_INIT (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSRING structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSRING_TAG {
+
+  /*
+   * The viewer on the file, and the span covering the whole file, which
+   * stays valid because no other function is called on the viewer until
+   * it is closed.
+   */
+  AKSVIEW *pv;
+  uint8_t *pBase;
+
+  /*
+   * The data area, its capacity, the mask that converts positions into
+   * offsets in the data area, and the ring mode.
+   */
+  uint8_t *pData;
+  int64_t cap;
+  uint64_t mask;
+  int mode;
+
+  /*
+   * Pointers to the shared counters in the mapping.
+   * 
+   * The tail and head are positions that only ever increase; they are
+   * converted to data area offsets with the mask.  pend is the head
+   * position that a release in progress will store.
+   */
+  volatile uint64_t *pTail;
+  volatile uint64_t *pHead;
+  volatile uint64_t *pPend;
+  volatile int32_t *pEvent;
+  volatile int32_t *pWaiters;
+
+  /*
+   * (Producers) Positions of the frames reserved since the last commit.
+   */
+  uint64_t *pBatch;
+  int32_t nbatch;
+  int32_t bcap;
+
+  /*
+   * (Consumer) The position of the next frame to peek, and whether it
+   * has been initialized from the head.
+   */
+  uint64_t cursor;
+  int cvalid;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksring fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksring warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint64_t load64(volatile uint64_t *p);
+static void store64(volatile uint64_t *p, uint64_t v);
+static int cas64(volatile uint64_t *p, uint64_t vOld, uint64_t vNew);
+static int32_t load32(volatile int32_t *p);
+static void store32(volatile int32_t *p, int32_t v);
+static int32_t add32(volatile int32_t *p, int32_t d);
+static volatile int32_t *frameState(AKSRING *pr, uint64_t pos);
+static int32_t *frameLen(AKSRING *pr, uint64_t pos);
+static void clearRange(AKSRING *pr, uint64_t first, uint64_t last);
+static void signalEvent(AKSRING *pr);
+#ifndef RING_FUTEX
+static int pollSleep(void);
+#endif
+static AKSRING *attach(const char *pPath, int *perr);
+
+/*
+ * Atomic operations on the shared counters.
+ * 
+ * Loads have acquire semantics and stores have release semantics.  The
+ * event and waiter counts use sequentially consistent operations, so
+ * that a waiter registering itself and a signaller bumping the event
+ * count cannot both miss each other.
+ */
+#ifdef AKS_WIN
+
+static uint64_t load64(volatile uint64_t *p) {
+  return (uint64_t) InterlockedCompareExchange64(
+                      (volatile LONG64 *) p, 0, 0);
+}
+
+static void store64(volatile uint64_t *p, uint64_t v) {
+  InterlockedExchange64((volatile LONG64 *) p, (LONG64) v);
+}
+
+static int cas64(volatile uint64_t *p, uint64_t vOld, uint64_t vNew) {
+  return ((uint64_t) InterlockedCompareExchange64(
+                        (volatile LONG64 *) p, (LONG64) vNew, (LONG64) vOld)
+            == vOld);
+}
+
+static int32_t load32(volatile int32_t *p) {
+  return (int32_t) InterlockedCompareExchange((volatile LONG *) p, 0, 0);
+}
+
+static void store32(volatile int32_t *p, int32_t v) {
+  InterlockedExchange((volatile LONG *) p, (LONG) v);
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return ((int32_t) InterlockedExchangeAdd((volatile LONG *) p, (LONG) d))
+            + d;
+}
+
+#else
+
+static uint64_t load64(volatile uint64_t *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void store64(volatile uint64_t *p, uint64_t v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int cas64(volatile uint64_t *p, uint64_t vOld, uint64_t vNew) {
+  return __atomic_compare_exchange_n(
+            p, &vOld, vNew, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static int32_t load32(volatile int32_t *p) {
+  return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static void store32(volatile int32_t *p, int32_t v) {
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int32_t add32(volatile int32_t *p, int32_t d) {
+  return __atomic_add_fetch(p, d, __ATOMIC_SEQ_CST);
+}
+
+#endif
+
+/*
+ * Get pointers to the two header words of the frame at a position.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ *   pos - the frame position
+ * 
+ * Return:
+ * 
+ *   pointer to the state word or the length word
+ */
+static volatile int32_t *frameState(AKSRING *pr, uint64_t pos) {
+  return (volatile int32_t *) (pr->pData + (pos & pr->mask));
+}
+
+static int32_t *frameLen(AKSRING *pr, uint64_t pos) {
+  return (int32_t *) (pr->pData + (pos & pr->mask) + 4);
+}
+
+/*
+ * Zero the data area between two positions.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ *   first - the first position to clear
+ * 
+ *   last - one past the last position to clear
+ */
+static void clearRange(AKSRING *pr, uint64_t first, uint64_t last) {
+
+  uint64_t off = 0;
+  uint64_t n = 0;
+
+  while (first < last) {
+    off = first & pr->mask;
+    n = ((uint64_t) pr->cap) - off;
+    if (n > last - first) {
+      n = last - first;
+    }
+    memset(pr->pData + off, 0, (size_t) n);
+    first += n;
+  }
+}
+
+/*
+ * Increment the event count and wake any waiters.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ */
+static void signalEvent(AKSRING *pr) {
+  add32(pr->pEvent, 1);
+  if (load32(pr->pWaiters) > 0) {
+#ifdef RING_FUTEX
+    syscall(SYS_futex, pr->pEvent, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+  }
+}
+
+#ifndef RING_FUTEX
+/*
+ * Sleep for one polling interval of one millisecond.
+ * 
+ * Return:
+ * 
+ *   the number of milliseconds slept
+ */
+static int pollSleep(void) {
+#ifdef AKS_WIN
+  Sleep(1);
+#else
+  struct timespec ts;
+  ts.tv_sec = 0;
+  ts.tv_nsec = 1000000L;
+  nanosleep(&ts, NULL);
+#endif
+  return 1;
+}
+#endif
+
+/*
+ * Open a ring file and map it.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the ring file
+ * 
+ *   perr - pointer to error code variable, which may not be NULL
+ * 
+ * Return:
+ * 
+ *   a new ring object, or NULL if the function failed
+ */
+static AKSRING *attach(const char *pPath, int *perr) {
+
+  int status = 1;
+  AKSRING *pr = NULL;
+  int64_t flen = 0;
+
+  /* Allocate the structure */
+  pr = (AKSRING *) calloc(1, sizeof(AKSRING));
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the existing file */
+  pr->pv = aksview_create(pPath, AKSVIEW_EXISTING | AKSVIEW_SHARE, NULL);
+  if (pr->pv == NULL) {
+    status = 0;
+    *perr = AKSRING_ERR_OPEN;
+  }
+
+  /* Check the header */
+  if (status) {
+    flen = aksview_getlen(pr->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pr->cap = aksview_read64s(pr->pv, HDR_OFF_CAP, 1);
+    pr->mode = (int) aksview_read32s(pr->pv, HDR_OFF_MODE, 1);
+    if ((aksview_read64u(pr->pv, HDR_OFF_MAGIC, 1) != RING_MAGIC) ||
+        (pr->cap < AKSRING_MINCAP) || (pr->cap > AKSRING_MAXCAP) ||
+        ((pr->cap & (pr->cap - 1)) != 0) ||
+        (flen != HDR_SIZE + pr->cap) ||
+        ((pr->mode != AKSRING_SPSC) && (pr->mode != AKSRING_MPSC))) {
+      status = 0;
+    }
+  }
+  if ((!status) && (*perr == AKSRING_ERR_NONE)) {
+    *perr = AKSRING_ERR_FORMAT;
+  }
+
+  /* Map the whole file and locate the shared counters */
+  if (status) {
+    pr->pBase = aksview_wspan(pr->pv, 0, (int32_t) flen);
+    pr->pData = pr->pBase + HDR_SIZE;
+    pr->mask = ((uint64_t) pr->cap) - 1;
+    pr->pTail = (volatile uint64_t *) (pr->pBase + HDR_OFF_TAIL);
+    pr->pHead = (volatile uint64_t *) (pr->pBase + HDR_OFF_HEAD);
+    pr->pPend = (volatile uint64_t *) (pr->pBase + HDR_OFF_PEND);
+    pr->pEvent = (volatile int32_t *) (pr->pBase + HDR_OFF_EVENT);
+    pr->pWaiters = (volatile int32_t *) (pr->pBase + HDR_OFF_WAITERS);
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pr->pv);
+    free(pr);
+    pr = NULL;
+  }
+
+  /* Return ring object or NULL */
+  return pr;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksring_onerror function.
+ */
+void aksring_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksring_errstr function.
+ */
+const char *aksring_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSRING_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSRING_ERR_OPEN:
+      pResult = "Failed to open ring file";
+      break;
+
+    case AKSRING_ERR_FORMAT:
+      pResult = "Ring file has invalid format";
+      break;
+
+    case AKSRING_ERR_RESIZE:
+      pResult = "Failed to resize ring file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksring_create function.
+ */
+int aksring_create(const char *pPath, int64_t cap, int mode, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pv = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+  if ((cap < AKSRING_MINCAP) || (cap > AKSRING_MAXCAP) ||
+      ((cap & (cap - 1)) != 0) ||
+      ((mode != AKSRING_SPSC) && (mode != AKSRING_MPSC))) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRING_ERR_NONE;
+
+  /* Create the file, which starts out zero-filled */
+  pv = aksview_create(pPath, AKSVIEW_EXCLUSIVE, NULL);
+  if (pv == NULL) {
+    status = 0;
+    *perr = AKSRING_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pv, HDR_SIZE + cap)) {
+      status = 0;
+      *perr = AKSRING_ERR_RESIZE;
+    }
+  }
+
+  /* Write the header, with the magic number last */
+  if (status) {
+    aksview_write64s(pv, HDR_OFF_CAP, 1, cap);
+    aksview_write32s(pv, HDR_OFF_MODE, 1, (int32_t) mode);
+    aksview_flush(pv);
+    aksview_write64u(pv, HDR_OFF_MAGIC, 1, RING_MAGIC);
+  }
+
+  /* Close the file */
+  aksview_close(pv);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksring_open function.
+ */
+AKSRING *aksring_open(const char *pPath, int *perr) {
+
+  int dummy = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRING_ERR_NONE;
+
+  /* Open and map the file */
+  return attach(pPath, perr);
+}
+
+/*
+ * aksring_close function.
+ */
+void aksring_close(AKSRING *pr) {
+  if (pr != NULL) {
+    aksview_close(pr->pv);
+    free(pr->pBatch);
+    free(pr);
+  }
+}
+
+/*
+ * aksring_mode function.
+ */
+int aksring_mode(AKSRING *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return pr->mode;
+}
+
+/*
+ * aksring_capacity function.
+ */
+int64_t aksring_capacity(AKSRING *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return pr->cap;
+}
+
+/*
+ * aksring_reserve function.
+ */
+uint8_t *aksring_reserve(AKSRING *pr, int32_t len) {
+
+  uint8_t *pResult = NULL;
+  uint64_t *pNew = NULL;
+  uint64_t t = 0;
+  uint64_t h = 0;
+  uint64_t fsize = 0;
+  uint64_t pad = 0;
+  uint64_t room = 0;
+  int claimed = 0;
+
+  /* Check parameters */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > pr->cap / 4)) {
+    fault(__LINE__);
+  }
+
+  /* Make room in the batch list */
+  if (pr->nbatch >= pr->bcap) {
+    pr->bcap = (pr->bcap > 0) ? (pr->bcap * 2) : BATCH_INIT;
+    pNew = (uint64_t *) realloc(
+              pr->pBatch, ((size_t) pr->bcap) * sizeof(uint64_t));
+    if (pNew == NULL) {
+      fault(__LINE__);
+    }
+    pr->pBatch = pNew;
+  }
+
+  /* Compute the frame size */
+  fsize = (uint64_t) (FRAME_HDR + len);
+  if ((fsize % FRAME_ALIGN) != 0) {
+    fsize += FRAME_ALIGN - (fsize % FRAME_ALIGN);
+  }
+
+  /* Claim the frame, plus padding if it does not fit before the end */
+  for(;;) {
+    t = load64(pr->pTail);
+    h = load64(pr->pHead);
+
+    room = ((uint64_t) pr->cap) - (t & pr->mask);
+    pad = (fsize > room) ? room : 0;
+    if (t + pad + fsize - h > (uint64_t) pr->cap) {
+      break;
+    }
+
+    if (pr->mode == AKSRING_SPSC) {
+      store64(pr->pTail, t + pad + fsize);
+      claimed = 1;
+      break;
+    }
+    if (cas64(pr->pTail, t, t + pad + fsize)) {
+      claimed = 1;
+      break;
+    }
+  }
+
+  if (claimed) {
+    /* Padding frames are committed as soon as they are claimed */
+    if (pad > 0) {
+      *frameLen(pr, t) = FRAME_PAD;
+      store32(frameState(pr, t), (int32_t) pad);
+      t += pad;
+    }
+
+    /* Mark the frame reserved and remember it for commit */
+    *frameLen(pr, t) = len;
+    store32(frameState(pr, t), -((int32_t) fsize));
+    (pr->pBatch)[pr->nbatch] = t;
+    (pr->nbatch)++;
+
+    pResult = pr->pData + (t & pr->mask) + FRAME_HDR;
+  }
+
+  /* Return pointer or NULL */
+  return pResult;
+}
+
+/*
+ * aksring_commit function.
+ */
+void aksring_commit(AKSRING *pr) {
+
+  int32_t i = 0;
+  volatile int32_t *ps = NULL;
+
+  /* Check parameter */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Flip each reserved frame to committed */
+  if (pr->nbatch > 0) {
+    for(i = 0; i < pr->nbatch; i++) {
+      ps = frameState(pr, (pr->pBatch)[i]);
+      store32(ps, -(*ps));
+    }
+    pr->nbatch = 0;
+    signalEvent(pr);
+  }
+}
+
+/*
+ * aksring_peek function.
+ */
+const uint8_t *aksring_peek(AKSRING *pr, int32_t *plen) {
+
+  const uint8_t *pResult = NULL;
+  uint64_t h = 0;
+  int32_t st = 0;
+  int32_t len = 0;
+
+  /* Check parameters */
+  if ((pr == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Start from the head the first time */
+  if (!(pr->cvalid)) {
+    pr->cursor = load64(pr->pHead);
+    pr->cvalid = 1;
+  }
+
+  /* Skip padding until a record or an uncommitted frame, stopping a
+   * full lap past the head, where the frames have not been released */
+  h = load64(pr->pHead);
+  while (pResult == NULL) {
+    if (pr->cursor - h >= (uint64_t) pr->cap) {
+      break;
+    }
+    st = load32(frameState(pr, pr->cursor));
+    if (st <= 0) {
+      break;
+    }
+    if ((st < FRAME_HDR) || ((st % FRAME_ALIGN) != 0) ||
+        (((uint64_t) st) > ((uint64_t) pr->cap) - (pr->cursor & pr->mask))) {
+      fault(__LINE__);
+    }
+
+    len = *frameLen(pr, pr->cursor);
+    if (len != FRAME_PAD) {
+      if ((len < 0) || (len > st - FRAME_HDR)) {
+        fault(__LINE__);
+      }
+      pResult = pr->pData + (pr->cursor & pr->mask) + FRAME_HDR;
+      *plen = len;
+    }
+    pr->cursor += (uint64_t) st;
+  }
+
+  /* Return record or NULL */
+  return pResult;
+}
+
+/*
+ * aksring_release function.
+ */
+void aksring_release(AKSRING *pr) {
+
+  uint64_t h = 0;
+
+  /* Check parameter */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Clear the peeked frames and advance the head, recording the new
+   * head first so that a crash in between can be recovered */
+  if (pr->cvalid) {
+    h = load64(pr->pHead);
+    if (pr->cursor > h) {
+      store64(pr->pPend, pr->cursor);
+      clearRange(pr, h, pr->cursor);
+      store64(pr->pHead, pr->cursor);
+      signalEvent(pr);
+    }
+  }
+}
+
+/*
+ * aksring_event function.
+ */
+uint32_t aksring_event(AKSRING *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return (uint32_t) load32(pr->pEvent);
+}
+
+/*
+ * aksring_wait function.
+ */
+int aksring_wait(AKSRING *pr, uint32_t ev, int32_t ms) {
+
+  int result = 0;
+#ifdef RING_FUTEX
+  RING_TIMEOUT ts;
+#else
+  int32_t waited = 0;
+#endif
+
+  /* Check parameters */
+  if ((pr == NULL) || (ms < 0)) {
+    fault(__LINE__);
+  }
+
+  /* Register as a waiter, so that signallers make the wake call */
+  add32(pr->pWaiters, 1);
+
+#ifdef RING_FUTEX
+  if (((uint32_t) load32(pr->pEvent)) == ev) {
+    ts.tv_sec = (long) (ms / 1000);
+    ts.tv_nsec = ((long) (ms % 1000)) * 1000000L;
+    syscall(SYS_futex, pr->pEvent, FUTEX_WAIT, (int) ev, &ts, NULL, 0);
+  }
+#else
+  while ((((uint32_t) load32(pr->pEvent)) == ev) && (waited < ms)) {
+    waited += pollSleep();
+  }
+#endif
+
+  add32(pr->pWaiters, -1);
+
+  /* Report whether the event count changed */
+  if (((uint32_t) load32(pr->pEvent)) != ev) {
+    result = 1;
+  }
+  return result;
+}
+
+/*
+ * aksring_recover function.
+ */
+int aksring_recover(const char *pPath, int *perr) {
+
+  int dummy = 0;
+  AKSRING *pr = NULL;
+  uint64_t h = 0;
+  uint64_t t = 0;
+  uint64_t pos = 0;
+  int32_t st = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRING_ERR_NONE;
+
+  /* Open the ring */
+  pr = attach(pPath, perr);
+  if (pr != NULL) {
+
+    /* Finish an interrupted release */
+    h = load64(pr->pHead);
+    t = load64(pr->pTail);
+    pos = load64(pr->pPend);
+    if ((pos > h) && (pos <= t)) {
+      clearRange(pr, h, pos);
+      h = pos;
+      store64(pr->pHead, h);
+    }
+    if ((t < h) || (t - h > (uint64_t) pr->cap)) {
+      clearRange(pr, h, h + ((uint64_t) pr->cap));
+      store64(pr->pTail, h);
+      t = h;
+    }
+
+    /* Walk the frames, turning abandoned reservations into padding */
+    for(pos = h; pos < t; pos += (uint64_t) st) {
+      st = load32(frameState(pr, pos));
+      if (st < 0) {
+        st = -st;
+        *frameLen(pr, pos) = FRAME_PAD;
+      }
+      if ((st < FRAME_HDR) || ((st % FRAME_ALIGN) != 0) ||
+          (((uint64_t) st) > ((uint64_t) pr->cap) - (pos & pr->mask)) ||
+          (((uint64_t) st) > t - pos)) {
+        break;
+      }
+      store32(frameState(pr, pos), st);
+    }
+
+    /* Truncate at the first frame that was never marked */
+    if (pos < t) {
+      clearRange(pr, pos, t);
+      store64(pr->pTail, pos);
+    }
+    store64(pr->pPend, h);
+    store32(pr->pWaiters, 0);
+
+    aksring_close(pr);
+  }
+
+  /* Return status */
+  return ((*perr == AKSRING_ERR_NONE) ? 1 : 0);
+}
@@ -0,0 +1,349 @@
+#ifndef AKSRING_H_INCLUDED
+#define AKSRING_H_INCLUDED
+
+/*
+ * aksring.h
+ * =========
+ * 
+ * Persistent ring buffer for passing records between processes through
+ * a shared AKSView mapping.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The minimum and maximum data capacity of a ring in bytes.
+ * 
+ * The capacity must be a power of two within this range.  The maximum
+ * is limited so that the whole ring file fits in a single span.
+ */
+#define AKSRING_MINCAP (INT64_C(4096))
+#define AKSRING_MAXCAP (INT64_C(268435456))
+
+/*
+ * Ring modes.
+ * 
+ * AKSRING_SPSC rings allow one producer and one consumer at a time.
+ * AKSRING_MPSC rings allow any number of producers and one consumer.
+ */
+#define AKSRING_SPSC (1)
+#define AKSRING_MPSC (2)
+
+/*
+ * Structure prototype for AKSRING.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSRING_TAG;
+typedef struct AKSRING_TAG AKSRING;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksring_errstr() to convert these to error messages.
+ */
+#define AKSRING_ERR_NONE   (0)
+#define AKSRING_ERR_OPEN   (1)
+#define AKSRING_ERR_FORMAT (2)
+#define AKSRING_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksring.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksring_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSRING_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksring_errstr(int code);
+
+/*
+ * Create a new ring file.
+ * 
+ * The file at pPath must not already exist.  cap is the data capacity in
+ * bytes, which must be a power of two in range [AKSRING_MINCAP,
+ * AKSRING_MAXCAP].  mode is AKSRING_SPSC or AKSRING_MPSC.
+ * 
+ * Create the ring in one process before any process opens it with
+ * aksring_open().
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSRING_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the ring file to create
+ * 
+ *   cap - the data capacity in bytes
+ * 
+ *   mode - the ring mode
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksring_create(const char *pPath, int64_t cap, int mode, int *perr);
+
+/*
+ * Open a ring file.
+ * 
+ * Each producer and each consumer needs its own ring object, even
+ * within a single process, because the objects hold private batch
+ * state.  A ring object may only be used by one thread at a time.
+ * 
+ * The whole file is mapped as a single span when the ring is opened, and
+ * the mapping is shared with every other process that opens the file,
+ * so records are exchanged at memory speed.  On Windows, the file is
+ * opened with AKSVIEW_SHARE for this purpose.  The shared counters are
+ * stored in native byte order, so a ring file may only be shared
+ * between processes on platforms of the same byte order.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksring_create().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the ring file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new ring object, or NULL if the function failed
+ */
+AKSRING *aksring_open(const char *pPath, int *perr);
+
+/*
+ * Close a ring object.
+ * 
+ * If NULL is passed, nothing is done.  A producer's reserved records
+ * that have not been committed are left in the claimed state, and must
+ * be cleaned up with aksring_recover().
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object, or NULL
+ */
+void aksring_close(AKSRING *pr);
+
+/*
+ * Get the mode of a ring.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ * Return:
+ * 
+ *   AKSRING_SPSC or AKSRING_MPSC
+ */
+int aksring_mode(AKSRING *pr);
+
+/*
+ * Get the data capacity of a ring in bytes.
+ * 
+ * Each record occupies its length rounded up to a multiple of eight,
+ * plus an eight-byte frame header.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ * Return:
+ * 
+ *   the data capacity
+ */
+int64_t aksring_capacity(AKSRING *pr);
+
+/*
+ * Reserve space for a record at the end of the ring.
+ * 
+ * len is the length of the record in bytes, which must be in range zero
+ * up to one quarter of the capacity.
+ * 
+ * If there is space, a pointer to len bytes in the shared mapping is
+ * returned, and the caller should write the record there.  The record
+ * is not visible to the consumer until aksring_commit() is called.
+ * Several records may be reserved before a single commit, which commits
+ * them all as a batch.
+ * 
+ * If there is not enough free space, NULL is returned.  Commit any
+ * records that are already reserved, since the consumer cannot move
+ * past them until they are committed, then wait for the consumer with
+ * aksring_wait() and try again.
+ * 
+ * In AKSRING_SPSC rings, only one producer may be active at a time.  In
+ * AKSRING_MPSC rings, space is claimed with an atomic compare-and-swap,
+ * so any number of producers may reserve at the same time.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ *   len - the length of the record
+ * 
+ * Return:
+ * 
+ *   pointer to the record space, or NULL if the ring is full
+ */
+uint8_t *aksring_reserve(AKSRING *pr, int32_t len);
+
+/*
+ * Commit all records reserved since the last commit.
+ * 
+ * The records become visible to the consumer, and a waiting consumer is
+ * woken.  If nothing is reserved, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ */
+void aksring_commit(AKSRING *pr);
+
+/*
+ * Get the next committed record from the ring.
+ * 
+ * Only one consumer may be active at a time.
+ * 
+ * If a record is available, a pointer to it in the shared mapping is
+ * returned and its length is written to *plen.  Each call moves on to
+ * the next record, so several records may be peeked before a single
+ * call to aksring_release() frees them all as a batch.  The pointers
+ * stay valid until that release.
+ * 
+ * If no further record has been committed, NULL is returned.  Records
+ * are always returned in the order that their space was reserved, so a
+ * record whose producer has not yet committed holds back the records
+ * after it.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ *   plen - receives the length of the record
+ * 
+ * Return:
+ * 
+ *   pointer to the record, or NULL if none is available
+ */
+const uint8_t *aksring_peek(AKSRING *pr, int32_t *plen);
+
+/*
+ * Release all records peeked since the last release.
+ * 
+ * The space is cleared and returned to the producers, and a waiting
+ * producer is woken.  If a consumer crashes before releasing, the
+ * records it peeked are delivered again to the next consumer.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ */
+void aksring_release(AKSRING *pr);
+
+/*
+ * Get the current event count of a ring.
+ * 
+ * The event count is incremented on every commit and release.  To wait
+ * without missing a wakeup, read the event count, then check whether
+ * the ring is ready, and only then call aksring_wait() with the count.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ * Return:
+ * 
+ *   the current event count
+ */
+uint32_t aksring_event(AKSRING *pr);
+
+/*
+ * Wait for the event count of a ring to change.
+ * 
+ * If the event count is no longer equal to ev, the function returns at
+ * once.  Otherwise, it blocks until a commit or release in any process
+ * changes the count, or until ms milliseconds have passed.
+ * 
+ * On Linux, the wait uses a futex on the shared mapping, and commits
+ * and releases only make a system call when some process is waiting.
+ * On other platforms, the wait polls the event count every millisecond.
+ * 
+ * Parameters:
+ * 
+ *   pr - the ring object
+ * 
+ *   ev - the event count read with aksring_event()
+ * 
+ *   ms - the maximum time to wait in milliseconds, zero or greater
+ * 
+ * Return:
+ * 
+ *   non-zero if the event count changed, zero if the wait timed out
+ */
+int aksring_wait(AKSRING *pr, uint32_t ev, int32_t ms);
+
+/*
+ * Recover a ring file after a crash.
+ * 
+ * This must only be called while no process has the ring open.
+ * 
+ * A consumer that crashed during a release has the release finished.
+ * Records that were reserved by a producer that crashed before
+ * committing are turned into padding that the consumer skips.  If a
+ * producer crashed before it could even mark its reservation, the ring
+ * is truncated at that point, and any later records are lost.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksring_create().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the ring file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksring_recover(const char *pPath, int *perr);
+
+#endif
@@ -0,0 +1,1121 @@
+/*
+ * aksroar.c
+ * =========
+ * 
+ * Implementation of aksroar.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksroar.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Bits are counted with the processor's population count instruction
+ * when the compiler provides it, and with a portable routine otherwise.
+ * 
+ * GCC and Clang only emit the instruction on x86 when the target has it,
+ * for example with -mpopcnt or -march=native, and otherwise call a
+ * library routine that is slower than the portable one, so x86 targets
+ * without it keep the portable routine.
+ */
+#if defined(_MSC_VER) && defined(_M_X64)
+#define ROAR_POPCNT_MSC
+#include <intrin.h>
+#elif defined(__GNUC__) && \
+      (defined(__POPCNT__) || \
+        (!defined(__x86_64__) && !defined(__i386__)))
+#define ROAR_POPCNT_GCC
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a serialized bitmap.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the bitmap
+ * begins with the ASCII string "AKSROAR1".
+ */
+#define ROAR_MAGIC (UINT64_C(0x3152414f52534b41))
+
+/*
+ * Header layout.
+ * 
+ * The header gives the number of containers, the total number of
+ * values, and the offset of the container directory relative to the
+ * start of the bitmap.  Container payloads begin immediately after the
+ * header, and the directory follows the last payload.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_NCONT (8)
+#define HDR_OFF_CARD  (16)
+#define HDR_OFF_DIR   (24)
+#define HDR_SIZE      (32)
+
+/*
+ * Directory entry layout.
+ * 
+ * There is one entry per container, in ascending key order.  Each entry
+ * gives the high 16 bits shared by the values in the container, the
+ * container type, the number of values, the number of 16-bit items or
+ * 64-bit words in the payload, and the offset of the payload relative
+ * to the start of the bitmap.
+ */
+#define ENT_OFF_KEY  (0)
+#define ENT_OFF_TYPE (2)
+#define ENT_OFF_CARD (4)
+#define ENT_OFF_N    (8)
+#define ENT_OFF_OFF  (12)
+#define ENT_SIZE     (16)
+#define ENT_WORDS    (4)
+
+/*
+ * Container types.
+ * 
+ * An array container holds its values as sorted 16-bit integers.  A
+ * bitmap container holds 1024 64-bit words, with bit (v % 64) of word
+ * (v / 64) set for each value v.  A run container holds pairs of 16-bit
+ * integers, giving the first value of each run and one less than the
+ * length of the run.
+ */
+#define TYPE_ARRAY  (1)
+#define TYPE_BITMAP (2)
+#define TYPE_RUN    (3)
+
+/*
+ * The number of 64-bit words in a bitmap container.
+ */
+#define BITMAP_WORDS (1024)
+
+/*
+ * The size in bytes of a bitmap container.
+ * 
+ * Array and run containers are only used when they are smaller than
+ * this, so an array holds at most 4096 values and a run container holds
+ * at most 2048 runs.
+ */
+#define BITMAP_BYTES (BITMAP_WORDS * 8)
+#define MAX_ITEMS    (BITMAP_BYTES / 2)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSROAR structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSROAR_TAG {
+
+  /*
+   * The viewer holding the bitmap.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The file offset of the bitmap and of its directory.
+   */
+  int64_t base;
+  int64_t dir;
+
+  /*
+   * The number of containers and the total number of values.
+   */
+  int32_t ncont;
+  int64_t card;
+};
+
+/*
+ * EMITTER structure.
+ * 
+ * Tracks a bitmap that is being serialized one container at a time.
+ */
+typedef struct {
+
+  /*
+   * The viewer being written and the file offset of the bitmap.
+   */
+  AKSVIEW *pv;
+  int64_t base;
+
+  /*
+   * The offset relative to base where the next payload is written.
+   */
+  int64_t cur;
+
+  /*
+   * The total number of values written so far.
+   */
+  int64_t card;
+
+  /*
+   * The directory being built in memory.
+   * 
+   * This is an array of 32-bit words in exactly the format of the
+   * directory in the file.  ncont is the number of entries and dcap is
+   * the allocated capacity in entries.
+   */
+  uint32_t *pDir;
+  int32_t ncont;
+  int32_t dcap;
+
+} EMITTER;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksroar fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksroar warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local data
+ * ==========
+ */
+
+/*
+ * De Bruijn table for finding the lowest set bit of a 64-bit word.
+ */
+static const int m_debruijn[64] = {
+   0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+  62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+  63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+  46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+};
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t popCount(uint64_t w);
+static int32_t lowBit(uint64_t w);
+static void setRange(uint64_t *pw, int32_t lo, int32_t hi);
+static int32_t nextBit(const uint64_t *pw, int32_t b, int set);
+static void emitInit(EMITTER *pe, AKSVIEW *pv, int64_t pos);
+static int emitWords(EMITTER *pe, uint32_t key, const uint64_t *pw);
+static int64_t emitFinish(EMITTER *pe, int status);
+static int64_t entryPos(AKSROAR *pr, int32_t i);
+static int32_t lowerKey(AKSROAR *pr, uint32_t key);
+static int32_t readEntry(
+    AKSROAR  * pr,
+    int32_t    i,
+    int      * pType,
+    int64_t  * pPay);
+static void loadContainer(AKSROAR *pr, int32_t i, uint64_t *pw);
+
+/*
+ * Count the set bits in a 64-bit word.
+ * 
+ * Parameters:
+ * 
+ *   w - the word
+ * 
+ * Return:
+ * 
+ *   the number of set bits
+ */
+static int32_t popCount(uint64_t w) {
+#if defined(ROAR_POPCNT_MSC)
+  return (int32_t) __popcnt64(w);
+#elif defined(ROAR_POPCNT_GCC)
+  return (int32_t) __builtin_popcountll((unsigned long long) w);
+#else
+  w = w - ((w >> 1) & UINT64_C(0x5555555555555555));
+  w = (w & UINT64_C(0x3333333333333333)) +
+        ((w >> 2) & UINT64_C(0x3333333333333333));
+  w = (w + (w >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (int32_t) ((w * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/*
+ * Find the lowest set bit in a non-zero 64-bit word.
+ * 
+ * Parameters:
+ * 
+ *   w - the word, which must not be zero
+ * 
+ * Return:
+ * 
+ *   the index of the lowest set bit
+ */
+static int32_t lowBit(uint64_t w) {
+  return m_debruijn[
+          ((w & (~w + 1)) * UINT64_C(0x03f79d71b4cb0a89)) >> 58];
+}
+
+/*
+ * Set a range of bits in a bitmap container.
+ * 
+ * Parameters:
+ * 
+ *   pw - the bitmap words
+ * 
+ *   lo - the first bit to set
+ * 
+ *   hi - the last bit to set, which is not less than lo
+ */
+static void setRange(uint64_t *pw, int32_t lo, int32_t hi) {
+
+  int32_t wlo = lo >> 6;
+  int32_t whi = hi >> 6;
+  uint64_t mlo = ~((uint64_t) 0) << (lo & 63);
+  uint64_t mhi = ~((uint64_t) 0) >> (63 - (hi & 63));
+  int32_t i = 0;
+
+  if (wlo == whi) {
+    pw[wlo] |= mlo & mhi;
+  } else {
+    pw[wlo] |= mlo;
+    for(i = wlo + 1; i < whi; i++) {
+      pw[i] = ~((uint64_t) 0);
+    }
+    pw[whi] |= mhi;
+  }
+}
+
+/*
+ * Find the next set or clear bit in a bitmap container.
+ * 
+ * Parameters:
+ * 
+ *   pw - the bitmap words
+ * 
+ *   b - the bit to start at, in range [0, 65536]
+ * 
+ *   set - non-zero to find a set bit, zero to find a clear bit
+ * 
+ * Return:
+ * 
+ *   the index of the first matching bit not less than b, or 65536 if
+ *   there is none
+ */
+static int32_t nextBit(const uint64_t *pw, int32_t b, int set) {
+
+  int32_t result = 65536;
+  int32_t i = b >> 6;
+  uint64_t w = 0;
+
+  if (b < 65536) {
+    w = set ? pw[i] : ~pw[i];
+    w &= ~((uint64_t) 0) << (b & 63);
+    while ((w == 0) && (i < BITMAP_WORDS - 1)) {
+      i++;
+      w = set ? pw[i] : ~pw[i];
+    }
+    if (w != 0) {
+      result = (i * 64) + lowBit(w);
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Begin serializing a bitmap.
+ * 
+ * Parameters:
+ * 
+ *   pe - the emitter to initialize
+ * 
+ *   pv - the viewer to write to
+ * 
+ *   pos - the file offset of the bitmap
+ */
+static void emitInit(EMITTER *pe, AKSVIEW *pv, int64_t pos) {
+
+  if ((pv == NULL) || (pos < 0)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(pv)) {
+    fault(__LINE__);
+  }
+
+  memset(pe, 0, sizeof(EMITTER));
+  pe->pv = pv;
+  pe->base = pos;
+  pe->cur = HDR_SIZE;
+  pe->dcap = 64;
+  pe->pDir = (uint32_t *) malloc((size_t) (pe->dcap * ENT_SIZE));
+  if (pe->pDir == NULL) {
+    fault(__LINE__);
+  }
+}
+
+/*
+ * Write one container, given as bitmap words.
+ * 
+ * Containers must be written in ascending key order.  The container is
+ * stored in whichever of the three forms is smallest.  Nothing is
+ * written if the container is empty.
+ * 
+ * Parameters:
+ * 
+ *   pe - the emitter
+ * 
+ *   key - the high 16 bits of the values in the container
+ * 
+ *   pw - the bitmap words of the container
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int emitWords(EMITTER *pe, uint32_t key, const uint64_t *pw) {
+
+  int status = 1;
+  uint16_t buf[MAX_ITEMS];
+  int32_t card = 0;
+  int32_t nrun = 0;
+  int32_t n = 0;
+  int type = 0;
+  int64_t size = 0;
+  uint64_t w = 0;
+  uint64_t carry = 0;
+  int32_t i = 0;
+  int32_t b = 0;
+  int32_t e = 0;
+  int32_t ncap = 0;
+  uint32_t *pNew = NULL;
+  uint32_t *pEnt = NULL;
+
+  /* Count the values and the runs */
+  for(i = 0; i < BITMAP_WORDS; i++) {
+    card += popCount(pw[i]);
+    nrun += popCount(pw[i] & ~((pw[i] << 1) | carry));
+    carry = pw[i] >> 63;
+  }
+
+  if (card > 0) {
+    /* Choose the smallest form, preferring arrays and then runs */
+    if ((card * 2 <= nrun * 4) && (card * 2 < BITMAP_BYTES)) {
+      type = TYPE_ARRAY;
+      n = card;
+      size = ((int64_t) n) * 2;
+    } else if (nrun * 4 < BITMAP_BYTES) {
+      type = TYPE_RUN;
+      n = nrun;
+      size = ((int64_t) n) * 4;
+    } else {
+      type = TYPE_BITMAP;
+      n = BITMAP_WORDS;
+      size = BITMAP_BYTES;
+    }
+
+    /* Make room for the payload */
+    if (pe->base > AKSVIEW_MAXLEN - pe->cur - size) {
+      fault(__LINE__);
+    }
+    if (!aksview_reserve(pe->pv, pe->base + pe->cur + size)) {
+      status = 0;
+    }
+  }
+
+  /* Write the payload */
+  if (status && (card > 0)) {
+    if (type == TYPE_BITMAP) {
+      aksview_writev64u(pe->pv, pe->base + pe->cur, 1, pw, BITMAP_WORDS);
+
+    } else if (type == TYPE_ARRAY) {
+      n = 0;
+      for(i = 0; i < BITMAP_WORDS; i++) {
+        w = pw[i];
+        while (w != 0) {
+          buf[n] = (uint16_t) ((i * 64) + lowBit(w));
+          n++;
+          w &= w - 1;
+        }
+      }
+      aksview_writev16u(pe->pv, pe->base + pe->cur, 1, buf, n);
+
+    } else {
+      n = 0;
+      b = nextBit(pw, 0, 1);
+      while (b < 65536) {
+        e = nextBit(pw, b, 0);
+        buf[2 * n] = (uint16_t) b;
+        buf[(2 * n) + 1] = (uint16_t) (e - 1 - b);
+        n++;
+        b = nextBit(pw, e, 1);
+      }
+      aksview_writev16u(pe->pv, pe->base + pe->cur, 1, buf,
+                        ((int64_t) n) * 2);
+    }
+
+    /* Record the directory entry */
+    if (pe->ncont >= pe->dcap) {
+      ncap = pe->dcap * 2;
+      pNew = (uint32_t *) realloc(pe->pDir, (size_t) (ncap * ENT_SIZE));
+      if (pNew == NULL) {
+        fault(__LINE__);
+      }
+      pe->pDir = pNew;
+      pe->dcap = ncap;
+    }
+    pEnt = &((pe->pDir)[pe->ncont * ENT_WORDS]);
+    pEnt[0] = key | (((uint32_t) type) << 16);
+    pEnt[1] = (uint32_t) card;
+    pEnt[2] = (uint32_t) n;
+    pEnt[3] = (uint32_t) pe->cur;
+
+    (pe->ncont)++;
+    pe->cur += size;
+    pe->card += card;
+  }
+
+  return status;
+}
+
+/*
+ * Finish serializing a bitmap.
+ * 
+ * If status is non-zero, the directory and header are written.  In all
+ * cases, the emitter's memory is released.
+ * 
+ * Parameters:
+ * 
+ *   pe - the emitter
+ * 
+ *   status - non-zero if every container was written
+ * 
+ * Return:
+ * 
+ *   the length of the serialized bitmap, or -1 if status was zero or
+ *   the file could not be enlarged
+ */
+static int64_t emitFinish(EMITTER *pe, int status) {
+
+  int64_t result = -1;
+  int64_t dsize = 0;
+
+  if (status) {
+    dsize = ((int64_t) pe->ncont) * ENT_SIZE;
+    if (pe->base > AKSVIEW_MAXLEN - pe->cur - dsize) {
+      fault(__LINE__);
+    }
+    if (!aksview_reserve(pe->pv, pe->base + pe->cur + dsize)) {
+      status = 0;
+    }
+  }
+
+  /* Write the directory, and then the header with the magic last */
+  if (status) {
+    aksview_writev32u(pe->pv, pe->base + pe->cur, 1, pe->pDir,
+                      ((int64_t) pe->ncont) * ENT_WORDS);
+    aksview_write32s(pe->pv, pe->base + HDR_OFF_NCONT, 1, pe->ncont);
+    aksview_write32s(pe->pv, pe->base + HDR_OFF_NCONT + 4, 1, 0);
+    aksview_write64s(pe->pv, pe->base + HDR_OFF_CARD, 1, pe->card);
+    aksview_write64s(pe->pv, pe->base + HDR_OFF_DIR, 1, pe->cur);
+    aksview_write64u(pe->pv, pe->base + HDR_OFF_MAGIC, 1, ROAR_MAGIC);
+    result = pe->cur + dsize;
+  }
+
+  free(pe->pDir);
+  pe->pDir = NULL;
+
+  return result;
+}
+
+/*
+ * Get the file offset of a directory entry.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   i - the container index
+ * 
+ * Return:
+ * 
+ *   the file offset of the entry
+ */
+static int64_t entryPos(AKSROAR *pr, int32_t i) {
+  return pr->dir + (((int64_t) i) * ENT_SIZE);
+}
+
+/*
+ * Find the first container whose key is not less than a given key.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   key - the key
+ * 
+ * Return:
+ * 
+ *   the container index, or the number of containers if there is none
+ */
+static int32_t lowerKey(AKSROAR *pr, uint32_t key) {
+
+  int32_t lo = 0;
+  int32_t hi = pr->ncont;
+  int32_t mid = 0;
+
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    if (aksview_read16u(pr->pv, entryPos(pr, mid) + ENT_OFF_KEY, 1) < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  return lo;
+}
+
+/*
+ * Read and check a directory entry.
+ * 
+ * A fault occurs if the entry is not valid.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   i - the container index
+ * 
+ *   pType - receives the container type
+ * 
+ *   pPay - receives the file offset of the payload
+ * 
+ * Return:
+ * 
+ *   the number of items in the payload
+ */
+static int32_t readEntry(
+    AKSROAR  * pr,
+    int32_t    i,
+    int      * pType,
+    int64_t  * pPay) {
+
+  int64_t epos = 0;
+  int32_t n = 0;
+  int64_t off = 0;
+  int64_t size = 0;
+
+  epos = entryPos(pr, i);
+  *pType = (int) aksview_read16u(pr->pv, epos + ENT_OFF_TYPE, 1);
+  n = aksview_read32s(pr->pv, epos + ENT_OFF_N, 1);
+  off = (int64_t) aksview_read32u(pr->pv, epos + ENT_OFF_OFF, 1);
+
+  if (*pType == TYPE_ARRAY) {
+    if ((n < 1) || (n >= MAX_ITEMS)) {
+      fault(__LINE__);
+    }
+    size = ((int64_t) n) * 2;
+
+  } else if (*pType == TYPE_RUN) {
+    if ((n < 1) || (n * 2 >= MAX_ITEMS)) {
+      fault(__LINE__);
+    }
+    size = ((int64_t) n) * 4;
+
+  } else if (*pType == TYPE_BITMAP) {
+    if (n != BITMAP_WORDS) {
+      fault(__LINE__);
+    }
+    size = BITMAP_BYTES;
+
+  } else {
+    fault(__LINE__);
+  }
+
+  if ((off < HDR_SIZE) || (off > pr->dir - pr->base - size)) {
+    fault(__LINE__);
+  }
+
+  *pPay = pr->base + off;
+  return n;
+}
+
+/*
+ * Load a container into bitmap words.
+ * 
+ * The payload is copied out of the file with a bulk load, so no span
+ * is held after this function returns.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   i - the container index
+ * 
+ *   pw - receives BITMAP_WORDS words
+ */
+static void loadContainer(AKSROAR *pr, int32_t i, uint64_t *pw) {
+
+  uint16_t buf[MAX_ITEMS];
+  int type = 0;
+  int64_t pay = 0;
+  int32_t n = 0;
+  int32_t j = 0;
+
+  n = readEntry(pr, i, &type, &pay);
+
+  if (type == TYPE_BITMAP) {
+    aksview_readv64u(pr->pv, pay, 1, pw, BITMAP_WORDS);
+
+  } else if (type == TYPE_ARRAY) {
+    memset(pw, 0, BITMAP_BYTES);
+    aksview_readv16u(pr->pv, pay, 1, buf, n);
+    for(j = 0; j < n; j++) {
+      pw[buf[j] >> 6] |= ((uint64_t) 1) << (buf[j] & 63);
+    }
+
+  } else {
+    memset(pw, 0, BITMAP_BYTES);
+    aksview_readv16u(pr->pv, pay, 1, buf, ((int64_t) n) * 2);
+    for(j = 0; j < n; j++) {
+      if (((int32_t) buf[2 * j]) + ((int32_t) buf[(2 * j) + 1]) > 65535) {
+        fault(__LINE__);
+      }
+      setRange(pw, buf[2 * j], buf[2 * j] + buf[(2 * j) + 1]);
+    }
+  }
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksroar_onerror function.
+ */
+void aksroar_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksroar_errstr function.
+ */
+const char *aksroar_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSROAR_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSROAR_ERR_FORMAT:
+      pResult = "Bitmap has invalid format";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksroar_build function.
+ */
+int64_t aksroar_build(
+    AKSVIEW        * pv,
+    int64_t          pos,
+    const uint32_t * pVals,
+    int64_t          n) {
+
+  int status = 1;
+  EMITTER e;
+  uint64_t w[BITMAP_WORDS];
+  uint32_t key = 0;
+  int64_t i = 0;
+
+  /* Check parameters */
+  if (((pVals == NULL) && (n > 0)) || (n < 0)) {
+    fault(__LINE__);
+  }
+  emitInit(&e, pv, pos);
+
+  /* Gather the values of each key into bitmap words and emit them */
+  i = 0;
+  while (status && (i < n)) {
+    key = pVals[i] >> 16;
+    memset(w, 0, sizeof(w));
+    for( ; (i < n) && ((pVals[i] >> 16) == key); i++) {
+      if ((i > 0) && (pVals[i] <= pVals[i - 1])) {
+        fault(__LINE__);
+      }
+      w[(pVals[i] & 0xffff) >> 6] |= ((uint64_t) 1) << (pVals[i] & 63);
+    }
+    status = emitWords(&e, key, w);
+  }
+
+  return emitFinish(&e, status);
+}
+
+/*
+ * aksroar_open function.
+ */
+AKSROAR *aksroar_open(AKSVIEW *pv, int64_t pos, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSROAR *pr = NULL;
+  int64_t flen = 0;
+  int64_t doff = 0;
+
+  /* Check parameters */
+  if ((pv == NULL) || (pos < 0)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSROAR_ERR_NONE;
+
+  /* Allocate the structure */
+  pr = (AKSROAR *) calloc(1, sizeof(AKSROAR));
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  pr->pv = pv;
+  pr->base = pos;
+
+  /* Read and check the header */
+  flen = aksview_getlen(pv);
+  if (pos > flen - HDR_SIZE) {
+    status = 0;
+  }
+  if (status) {
+    pr->ncont = aksview_read32s(pv, pos + HDR_OFF_NCONT, 1);
+    pr->card = aksview_read64s(pv, pos + HDR_OFF_CARD, 1);
+    doff = aksview_read64s(pv, pos + HDR_OFF_DIR, 1);
+    if ((aksview_read64u(pv, pos + HDR_OFF_MAGIC, 1) != ROAR_MAGIC) ||
+        (pr->ncont < 0) || (pr->ncont > 65536) ||
+        (pr->card < 0) || (pr->card > INT64_C(4294967296)) ||
+        (doff < HDR_SIZE) ||
+        (doff > flen - pos - (((int64_t) pr->ncont) * ENT_SIZE))) {
+      status = 0;
+    }
+    pr->dir = pos + doff;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    *perr = AKSROAR_ERR_FORMAT;
+    free(pr);
+    pr = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pr;
+}
+
+/*
+ * aksroar_close function.
+ */
+void aksroar_close(AKSROAR *pr) {
+  if (pr != NULL) {
+    free(pr);
+  }
+}
+
+/*
+ * aksroar_count function.
+ */
+int64_t aksroar_count(AKSROAR *pr) {
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+  return pr->card;
+}
+
+/*
+ * aksroar_contains function.
+ */
+int aksroar_contains(AKSROAR *pr, uint32_t v) {
+
+  int result = 0;
+  uint32_t key = v >> 16;
+  int32_t low = (int32_t) (v & 0xffff);
+  int32_t i = 0;
+  int type = 0;
+  int64_t pay = 0;
+  int32_t n = 0;
+  int32_t lo = 0;
+  int32_t hi = 0;
+  int32_t mid = 0;
+  int32_t x = 0;
+
+  /* Check parameters */
+  if (pr == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Find the container */
+  i = lowerKey(pr, key);
+  if (i < pr->ncont) {
+    if (aksview_read16u(pr->pv, entryPos(pr, i) + ENT_OFF_KEY, 1) == key) {
+      n = readEntry(pr, i, &type, &pay);
+
+      if (type == TYPE_BITMAP) {
+        result = (aksview_read8u(pr->pv, pay + (low >> 3)) >> (low & 7)) & 1;
+
+      } else if (type == TYPE_ARRAY) {
+        /* Binary search the sorted values */
+        lo = 0;
+        hi = n;
+        while (lo < hi) {
+          mid = lo + ((hi - lo) / 2);
+          x = (int32_t) aksview_read16u(pr->pv, pay + (mid * 2), 1);
+          if (x < low) {
+            lo = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+        if (lo < n) {
+          if ((int32_t) aksview_read16u(pr->pv, pay + (lo * 2), 1) == low) {
+            result = 1;
+          }
+        }
+
+      } else {
+        /* Binary search for the last run starting at or before low */
+        lo = 0;
+        hi = n;
+        while (lo < hi) {
+          mid = lo + ((hi - lo) / 2);
+          x = (int32_t) aksview_read16u(pr->pv, pay + (mid * 4), 1);
+          if (x <= low) {
+            lo = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+        if (lo > 0) {
+          x = (int32_t) aksview_read16u(pr->pv, pay + ((lo - 1) * 4), 1);
+          x += (int32_t) aksview_read16u(pr->pv, pay + ((lo - 1) * 4) + 2, 1);
+          if (low <= x) {
+            result = 1;
+          }
+        }
+      }
+    }
+  }
+
+  return result;
+}
+
+/*
+ * aksroar_values function.
+ */
+int32_t aksroar_values(
+    AKSROAR  * pr,
+    int64_t    from,
+    uint32_t * pBuf,
+    int32_t    max) {
+
+  int32_t count = 0;
+  uint16_t buf[MAX_ITEMS];
+  uint64_t w[BITMAP_WORDS];
+  uint64_t x = 0;
+  uint32_t key = 0;
+  int32_t low = 0;
+  int32_t i = 0;
+  int32_t j = 0;
+  int type = 0;
+  int64_t pay = 0;
+  int32_t n = 0;
+
+  /* Check parameters */
+  if ((pr == NULL) || (pBuf == NULL)) {
+    fault(__LINE__);
+  }
+  if ((from < 0) || (from > INT64_C(4294967296)) || (max < 1)) {
+    fault(__LINE__);
+  }
+
+  if (from < INT64_C(4294967296)) {
+    i = lowerKey(pr, (uint32_t) (from >> 16));
+  } else {
+    i = pr->ncont;
+  }
+
+  for( ; (i < pr->ncont) && (count < max); i++) {
+    key = aksview_read16u(pr->pv, entryPos(pr, i) + ENT_OFF_KEY, 1);
+    low = 0;
+    if (((int64_t) key) == (from >> 16)) {
+      low = (int32_t) (from & 0xffff);
+    }
+
+    n = readEntry(pr, i, &type, &pay);
+    if (type == TYPE_ARRAY) {
+      /* Copy the sorted values directly */
+      aksview_readv16u(pr->pv, pay, 1, buf, n);
+      for(j = 0; (j < n) && (count < max); j++) {
+        if ((int32_t) buf[j] >= low) {
+          pBuf[count] = (key << 16) | buf[j];
+          count++;
+        }
+      }
+
+    } else {
+      /* Walk the set bits, starting at low */
+      loadContainer(pr, i, w);
+      w[low >> 6] &= ~((uint64_t) 0) << (low & 63);
+      for(j = 0; j < (low >> 6); j++) {
+        w[j] = 0;
+      }
+      for(j = low >> 6; (j < BITMAP_WORDS) && (count < max); j++) {
+        x = w[j];
+        while ((x != 0) && (count < max)) {
+          pBuf[count] = (key << 16) | (uint32_t) ((j * 64) + lowBit(x));
+          count++;
+          x &= x - 1;
+        }
+      }
+    }
+  }
+
+  return count;
+}
+
+/*
+ * aksroar_and function.
+ */
+int64_t aksroar_and(AKSROAR *pa, AKSROAR *pb, AKSVIEW *pv, int64_t pos) {
+
+  int status = 1;
+  EMITTER e;
+  uint64_t wa[BITMAP_WORDS];
+  uint64_t wb[BITMAP_WORDS];
+  int32_t i = 0;
+  int32_t j = 0;
+  int32_t k = 0;
+  uint32_t ka = 0;
+  uint32_t kb = 0;
+
+  /* Check parameters */
+  if ((pa == NULL) || (pb == NULL)) {
+    fault(__LINE__);
+  }
+  emitInit(&e, pv, pos);
+
+  /* Only containers whose keys appear in both inputs are read */
+  while (status && (i < pa->ncont) && (j < pb->ncont)) {
+    ka = aksview_read16u(pa->pv, entryPos(pa, i) + ENT_OFF_KEY, 1);
+    kb = aksview_read16u(pb->pv, entryPos(pb, j) + ENT_OFF_KEY, 1);
+    if (ka < kb) {
+      i = lowerKey(pa, kb);
+    } else if (kb < ka) {
+      j = lowerKey(pb, ka);
+    } else {
+      loadContainer(pa, i, wa);
+      loadContainer(pb, j, wb);
+      for(k = 0; k < BITMAP_WORDS; k++) {
+        wa[k] &= wb[k];
+      }
+      status = emitWords(&e, ka, wa);
+      i++;
+      j++;
+    }
+  }
+
+  return emitFinish(&e, status);
+}
+
+/*
+ * aksroar_or function.
+ */
+int64_t aksroar_or(AKSROAR *pa, AKSROAR *pb, AKSVIEW *pv, int64_t pos) {
+
+  int status = 1;
+  EMITTER e;
+  uint64_t wa[BITMAP_WORDS];
+  uint64_t wb[BITMAP_WORDS];
+  int32_t i = 0;
+  int32_t j = 0;
+  int32_t k = 0;
+  uint32_t ka = 0;
+  uint32_t kb = 0;
+
+  /* Check parameters */
+  if ((pa == NULL) || (pb == NULL)) {
+    fault(__LINE__);
+  }
+  emitInit(&e, pv, pos);
+
+  /* Merge the containers of both inputs in key order */
+  while (status && ((i < pa->ncont) || (j < pb->ncont))) {
+    ka = 65536;
+    kb = 65536;
+    if (i < pa->ncont) {
+      ka = aksview_read16u(pa->pv, entryPos(pa, i) + ENT_OFF_KEY, 1);
+    }
+    if (j < pb->ncont) {
+      kb = aksview_read16u(pb->pv, entryPos(pb, j) + ENT_OFF_KEY, 1);
+    }
+
+    if (ka < kb) {
+      loadContainer(pa, i, wa);
+      status = emitWords(&e, ka, wa);
+      i++;
+    } else if (kb < ka) {
+      loadContainer(pb, j, wb);
+      status = emitWords(&e, kb, wb);
+      j++;
+    } else {
+      loadContainer(pa, i, wa);
+      loadContainer(pb, j, wb);
+      for(k = 0; k < BITMAP_WORDS; k++) {
+        wa[k] |= wb[k];
+      }
+      status = emitWords(&e, ka, wa);
+      i++;
+      j++;
+    }
+  }
+
+  return emitFinish(&e, status);
+}
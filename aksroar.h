@@ -0,0 +1,242 @@
+#ifndef AKSROAR_H_INCLUDED
+#define AKSROAR_H_INCLUDED
+
+/*
+ * aksroar.h
+ * =========
+ * 
+ * Roaring bitmaps stored in AKSView files and read in place.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * Structure prototype for AKSROAR.
+ * 
+ * AKSROAR is a reader for one serialized bitmap at a given position in
+ * a viewed file.  It holds only the position and a few header fields,
+ * never the contents of the bitmap.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSROAR_TAG;
+typedef struct AKSROAR_TAG AKSROAR;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksroar_errstr() to convert these to error messages.
+ */
+#define AKSROAR_ERR_NONE   (0)
+#define AKSROAR_ERR_FORMAT (1)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksroar.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksroar_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSROAR_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksroar_errstr(int code);
+
+/*
+ * Serialize a bitmap into a viewed file.
+ * 
+ * pVals points to n 32-bit values, which must be strictly ascending, or
+ * a fault occurs.  n may be zero, which writes an empty bitmap.
+ * 
+ * The values are split into containers by their high 16 bits.  Each
+ * container is stored as whichever of a sorted array, a 65536-bit
+ * bitmap, or a list of runs is smallest.
+ * 
+ * The bitmap is written starting at file offset pos, and the file is
+ * grown with aksview_reserve() as necessary, so pv must be writable.
+ * Bytes beyond the end of the bitmap are not modified, so the caller
+ * can write several bitmaps one after another into the same file.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer to write to
+ * 
+ *   pos - the file offset to write the bitmap at
+ * 
+ *   pVals - the values in the bitmap
+ * 
+ *   n - the number of values
+ * 
+ * Return:
+ * 
+ *   the length of the serialized bitmap in bytes, or -1 if the file
+ *   could not be enlarged
+ */
+int64_t aksroar_build(
+    AKSVIEW        * pv,
+    int64_t          pos,
+    const uint32_t * pVals,
+    int64_t          n);
+
+/*
+ * Open a reader for a serialized bitmap.
+ * 
+ * Only the header of the bitmap is read.  The reader refers to pv, so
+ * the viewer must stay open for as long as the reader is used.  Several
+ * readers may share one viewer.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSROAR_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer holding the bitmap
+ * 
+ *   pos - the file offset of the bitmap
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new bitmap reader or NULL if the function failed
+ */
+AKSROAR *aksroar_open(AKSVIEW *pv, int64_t pos, int *perr);
+
+/*
+ * Close a bitmap reader.
+ * 
+ * The viewer is not closed.  If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader, or NULL
+ */
+void aksroar_close(AKSROAR *pr);
+
+/*
+ * Get the number of values in a bitmap.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ * Return:
+ * 
+ *   the number of values
+ */
+int64_t aksroar_count(AKSROAR *pr);
+
+/*
+ * Check whether a bitmap contains a value.
+ * 
+ * The container directory is binary searched, and then at most one
+ * container is probed in place.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   v - the value
+ * 
+ * Return:
+ * 
+ *   non-zero if the value is in the bitmap, zero otherwise
+ */
+int aksroar_contains(AKSROAR *pr, uint32_t v);
+
+/*
+ * Iterate over the values of a bitmap.
+ * 
+ * The values of the bitmap that are greater than or equal to from are
+ * written to pBuf in ascending order, until max values have been
+ * written or there are no more values.  To iterate over a whole bitmap,
+ * start with from set to zero and then set it to one more than the last
+ * value returned, until the function returns zero.
+ * 
+ * Parameters:
+ * 
+ *   pr - the bitmap reader
+ * 
+ *   from - the smallest value to return, in range [0, 2^32]
+ * 
+ *   pBuf - receives the values
+ * 
+ *   max - the capacity of pBuf, at least one
+ * 
+ * Return:
+ * 
+ *   the number of values written
+ */
+int32_t aksroar_values(
+    AKSROAR  * pr,
+    int64_t    from,
+    uint32_t * pBuf,
+    int32_t    max);
+
+/*
+ * Compute the intersection or the union of two bitmaps.
+ * 
+ * aksroar_and() computes the values in both pa and pb, and aksroar_or()
+ * computes the values in either.  The result is serialized into pv at
+ * pos in the same way as for aksroar_build().
+ * 
+ * The operation proceeds one container at a time, reading the input
+ * containers directly from their files, so memory use is bounded
+ * regardless of the size of the bitmaps.  Containers whose keys appear
+ * in only one input are skipped by aksroar_and() without being read.
+ * 
+ * pv may be the same viewer as the inputs, provided that the result
+ * does not overlap either input.
+ * 
+ * Parameters:
+ * 
+ *   pa - the first bitmap
+ * 
+ *   pb - the second bitmap
+ * 
+ *   pv - the viewer to write the result to
+ * 
+ *   pos - the file offset to write the result at
+ * 
+ * Return:
+ * 
+ *   the length of the serialized result in bytes, or -1 if the file
+ *   could not be enlarged
+ */
+int64_t aksroar_and(AKSROAR *pa, AKSROAR *pb, AKSVIEW *pv, int64_t pos);
+int64_t aksroar_or(AKSROAR *pa, AKSROAR *pb, AKSVIEW *pv, int64_t pos);
+
+#endif
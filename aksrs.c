@@ -0,0 +1,882 @@
+/*
+ * aksrs.c
+ * =======
+ * 
+ * Implementation of aksrs.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksrs.h"
+#include "akspool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The region multiply uses byte shuffles when the compiler targets a
+ * processor that has them, and portable table lookups otherwise.
+ */
+#if defined(__AVX2__)
+#define RS_AVX2
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#define RS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * The reduction polynomial of the Galois field GF(2^8), which is
+ * x^8 + x^4 + x^3 + x^2 + 1.
+ */
+#define GF_POLY (0x11d)
+
+/*
+ * The number of bytes of each shard that one task encodes per batch.
+ * 
+ * A batch spans one stripe per task, and every shard has the whole
+ * batch mapped at once.
+ */
+#define STRIPE_LEN (INT32_C(1048576))
+
+/*
+ * The number of bytes of each shard that a task processes at a time.
+ * 
+ * This is small enough that the pieces of all the input shards stay in
+ * the processor cache while every output shard is computed from them.
+ */
+#define SUB_LEN (INT32_C(8192))
+
+/*
+ * The number of bytes of multiplication tables for each coefficient.
+ * 
+ * The first 16 bytes are the products of the coefficient with each
+ * possible low nibble, and the next 16 bytes are the products with each
+ * possible high nibble.  Since multiplication distributes over XOR, the
+ * product with any byte is the XOR of one entry from each half.
+ */
+#define TAB_LEN (32)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A task that computes a stripe of the output shards of a batch.
+ */
+typedef struct {
+
+  /*
+   * Pointers to the start of the batch in each input shard and each
+   * output shard, shared by all tasks of the batch.
+   */
+  const uint8_t **ppIn;
+  uint8_t **ppOut;
+  int32_t nin;
+  int32_t nout;
+
+  /*
+   * The multiplication tables, for output shard r and input shard c at
+   * offset ((r * nin) + c) * TAB_LEN.
+   */
+  const uint8_t *pTab;
+
+  /*
+   * The offset of the stripe within the batch, and its length.
+   */
+  int32_t off;
+  int32_t n;
+} RS_TASK;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksrs fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksrs warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint8_t gfMul(uint8_t a, uint8_t b);
+static uint8_t gfInv(uint8_t a);
+static void genRow(int32_t k, int32_t s, uint8_t *pRow);
+static void invert(uint8_t *pMat, int32_t n, uint8_t *pInv);
+static void mulRegion(
+    uint8_t       * pDst,
+    const uint8_t * pSrc,
+    int32_t         n,
+    const uint8_t * pTab,
+    int             add);
+static void codeTask(void *pArg);
+static void checkShards(AKSVIEW **ppv, int32_t n);
+static int runCode(
+    AKSVIEW      ** ppIn,
+    int32_t         nin,
+    AKSVIEW      ** ppOut,
+    int32_t         nout,
+    const uint8_t * pCoef,
+    int64_t         pos,
+    int64_t         len,
+    int             nthreads,
+    int           * perr);
+
+/*
+ * Multiply two elements of GF(2^8).
+ * 
+ * This is only used to build tables and matrices, so it uses the
+ * simple shift-and-add method rather than lookup tables.
+ * 
+ * Parameters:
+ * 
+ *   a - the first element
+ * 
+ *   b - the second element
+ * 
+ * Return:
+ * 
+ *   the product
+ */
+static uint8_t gfMul(uint8_t a, uint8_t b) {
+
+  int32_t x = a;
+  int32_t result = 0;
+
+  while (b != 0) {
+    if (b & 1) {
+      result ^= x;
+    }
+    x <<= 1;
+    if (x & 0x100) {
+      x ^= GF_POLY;
+    }
+    b >>= 1;
+  }
+
+  return (uint8_t) result;
+}
+
+/*
+ * Find the multiplicative inverse of a non-zero element of GF(2^8).
+ * 
+ * The multiplicative group has order 255, so the inverse is a raised to
+ * the power 254.
+ * 
+ * Parameters:
+ * 
+ *   a - the element, which must not be zero
+ * 
+ * Return:
+ * 
+ *   the inverse
+ */
+static uint8_t gfInv(uint8_t a) {
+
+  uint8_t result = 1;
+  uint8_t sq = a;
+  int e = 254;
+
+  if (a == 0) {
+    fault(__LINE__);
+  }
+
+  while (e > 0) {
+    if (e & 1) {
+      result = gfMul(result, sq);
+    }
+    sq = gfMul(sq, sq);
+    e >>= 1;
+  }
+
+  return result;
+}
+
+/*
+ * Get the row of the generator matrix for a given shard.
+ * 
+ * The row gives the coefficients that shard s is computed with from
+ * the k data shards.  Data shards have unit rows, so they are stored
+ * as they are.  Parity shard i has the Cauchy row whose element for
+ * data shard j is 1 / ((k + i) XOR j), which makes every k by k
+ * submatrix of the generator matrix invertible.
+ * 
+ * Parameters:
+ * 
+ *   k - the number of data shards
+ * 
+ *   s - the shard, with data shards first
+ * 
+ *   pRow - receives the k coefficients
+ */
+static void genRow(int32_t k, int32_t s, uint8_t *pRow) {
+
+  int32_t j = 0;
+
+  for(j = 0; j < k; j++) {
+    if (s < k) {
+      pRow[j] = (uint8_t) ((j == s) ? 1 : 0);
+    } else {
+      pRow[j] = gfInv((uint8_t) (s ^ j));
+    }
+  }
+}
+
+/*
+ * Invert a square matrix over GF(2^8) by Gauss-Jordan elimination.
+ * 
+ * The matrix is destroyed.  A fault occurs if it is singular, which can
+ * not happen for submatrices of the generator matrix.
+ * 
+ * Parameters:
+ * 
+ *   pMat - the n by n matrix in row-major order
+ * 
+ *   n - the size of the matrix
+ * 
+ *   pInv - receives the n by n inverse in row-major order
+ */
+static void invert(uint8_t *pMat, int32_t n, uint8_t *pInv) {
+
+  uint8_t t = 0;
+  int32_t r = 0;
+  int32_t c = 0;
+  int32_t i = 0;
+  int32_t p = 0;
+
+  /* Start the inverse as the identity */
+  memset(pInv, 0, (size_t) (n * n));
+  for(i = 0; i < n; i++) {
+    pInv[(i * n) + i] = 1;
+  }
+
+  for(c = 0; c < n; c++) {
+
+    /* Find a pivot row and swap it into place */
+    for(p = c; p < n; p++) {
+      if (pMat[(p * n) + c] != 0) {
+        break;
+      }
+    }
+    if (p >= n) {
+      fault(__LINE__);
+    }
+    if (p != c) {
+      for(i = 0; i < n; i++) {
+        t = pMat[(p * n) + i];
+        pMat[(p * n) + i] = pMat[(c * n) + i];
+        pMat[(c * n) + i] = t;
+        t = pInv[(p * n) + i];
+        pInv[(p * n) + i] = pInv[(c * n) + i];
+        pInv[(c * n) + i] = t;
+      }
+    }
+
+    /* Scale the pivot row so the pivot is one */
+    t = gfInv(pMat[(c * n) + c]);
+    for(i = 0; i < n; i++) {
+      pMat[(c * n) + i] = gfMul(pMat[(c * n) + i], t);
+      pInv[(c * n) + i] = gfMul(pInv[(c * n) + i], t);
+    }
+
+    /* Eliminate the column from every other row */
+    for(r = 0; r < n; r++) {
+      t = pMat[(r * n) + c];
+      if ((r != c) && (t != 0)) {
+        for(i = 0; i < n; i++) {
+          pMat[(r * n) + i] ^= gfMul(pMat[(c * n) + i], t);
+          pInv[(r * n) + i] ^= gfMul(pInv[(c * n) + i], t);
+        }
+      }
+    }
+  }
+}
+
+/*
+ * Multiply a region of bytes by a constant in GF(2^8).
+ * 
+ * With SSSE3 or AVX2, each nibble table is loaded into a vector
+ * register and byte shuffles look up 16 or 32 nibbles at once.
+ * Otherwise, the same tables are indexed one byte at a time.
+ * 
+ * Parameters:
+ * 
+ *   pDst - the destination region
+ * 
+ *   pSrc - the source region
+ * 
+ *   n - the number of bytes
+ * 
+ *   pTab - the TAB_LEN bytes of tables for the constant
+ * 
+ *   add - non-zero to XOR the products into the destination, zero to
+ *   overwrite the destination
+ */
+static void mulRegion(
+    uint8_t       * pDst,
+    const uint8_t * pSrc,
+    int32_t         n,
+    const uint8_t * pTab,
+    int             add) {
+
+  int32_t i = 0;
+  uint8_t v = 0;
+#if defined(RS_AVX2)
+  __m256i tlo;
+  __m256i thi;
+  __m256i mask;
+  __m256i x;
+  __m256i y;
+
+  tlo = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *) pTab));
+  thi = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128((const __m128i *) (pTab + 16)));
+  mask = _mm256_set1_epi8(0x0f);
+  for( ; i + 32 <= n; i += 32) {
+    x = _mm256_loadu_si256((const __m256i *) (pSrc + i));
+    y = _mm256_xor_si256(
+          _mm256_shuffle_epi8(tlo, _mm256_and_si256(x, mask)),
+          _mm256_shuffle_epi8(thi,
+            _mm256_and_si256(_mm256_srli_epi64(x, 4), mask)));
+    if (add) {
+      y = _mm256_xor_si256(y,
+            _mm256_loadu_si256((const __m256i *) (pDst + i)));
+    }
+    _mm256_storeu_si256((__m256i *) (pDst + i), y);
+  }
+#elif defined(RS_SSSE3)
+  __m128i tlo;
+  __m128i thi;
+  __m128i mask;
+  __m128i x;
+  __m128i y;
+
+  tlo = _mm_loadu_si128((const __m128i *) pTab);
+  thi = _mm_loadu_si128((const __m128i *) (pTab + 16));
+  mask = _mm_set1_epi8(0x0f);
+  for( ; i + 16 <= n; i += 16) {
+    x = _mm_loadu_si128((const __m128i *) (pSrc + i));
+    y = _mm_xor_si128(
+          _mm_shuffle_epi8(tlo, _mm_and_si128(x, mask)),
+          _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(x, 4), mask)));
+    if (add) {
+      y = _mm_xor_si128(y, _mm_loadu_si128((const __m128i *) (pDst + i)));
+    }
+    _mm_storeu_si128((__m128i *) (pDst + i), y);
+  }
+#endif
+
+  /* Remaining bytes, or all of them without vector support */
+  for( ; i < n; i++) {
+    v = (uint8_t) (pTab[pSrc[i] & 0x0f] ^ pTab[16 + (pSrc[i] >> 4)]);
+    if (add) {
+      v ^= pDst[i];
+    }
+    pDst[i] = v;
+  }
+}
+
+/*
+ * Compute a stripe of the output shards of a batch.
+ * 
+ * The stripe is processed in pieces of SUB_LEN bytes, and each output
+ * piece is the sum of the products of all the input pieces with their
+ * coefficients.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the RS_TASK
+ */
+static void codeTask(void *pArg) {
+
+  RS_TASK *pt = (RS_TASK *) pArg;
+  int32_t s = 0;
+  int32_t sl = 0;
+  int32_t r = 0;
+  int32_t c = 0;
+
+  for(s = pt->off; s < pt->off + pt->n; s += SUB_LEN) {
+    sl = pt->off + pt->n - s;
+    if (sl > SUB_LEN) {
+      sl = SUB_LEN;
+    }
+    for(r = 0; r < pt->nout; r++) {
+      for(c = 0; c < pt->nin; c++) {
+        mulRegion(
+          (pt->ppOut)[r] + s,
+          (pt->ppIn)[c] + s,
+          sl,
+          pt->pTab + (((r * pt->nin) + c) * TAB_LEN),
+          (c > 0));
+      }
+    }
+  }
+}
+
+/*
+ * Check that no viewer appears more than once in an array.
+ * 
+ * NULL entries are ignored.  A fault occurs if there is a duplicate,
+ * since only one window of each viewer can be mapped at a time.
+ * 
+ * Parameters:
+ * 
+ *   ppv - the array of viewers
+ * 
+ *   n - the number of viewers
+ */
+static void checkShards(AKSVIEW **ppv, int32_t n) {
+
+  int32_t i = 0;
+  int32_t j = 0;
+
+  for(i = 0; i < n; i++) {
+    for(j = i + 1; j < n; j++) {
+      if ((ppv[i] != NULL) && (ppv[i] == ppv[j])) {
+        fault(__LINE__);
+      }
+    }
+  }
+}
+
+/*
+ * Compute a range of output shards as linear combinations of input
+ * shards.
+ * 
+ * Output shard r is the sum over input shards c of the product of
+ * input shard c with the coefficient pCoef[(r * nin) + c].  Output
+ * shards are extended to cover the range if necessary.
+ * 
+ * Parameters:
+ * 
+ *   ppIn - the input shards
+ * 
+ *   nin - the number of input shards
+ * 
+ *   ppOut - the output shards
+ * 
+ *   nout - the number of output shards
+ * 
+ *   pCoef - the nout by nin coefficients in row-major order
+ * 
+ *   pos - the file offset of the range
+ * 
+ *   len - the length of the range
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ *   perr - pointer to error code variable
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+static int runCode(
+    AKSVIEW      ** ppIn,
+    int32_t         nin,
+    AKSVIEW      ** ppOut,
+    int32_t         nout,
+    const uint8_t * pCoef,
+    int64_t         pos,
+    int64_t         len,
+    int             nthreads,
+    int           * perr) {
+
+  int status = 1;
+  AKSPOOL *pPool = NULL;
+  RS_TASK *pTasks = NULL;
+  const uint8_t **ppInSpan = NULL;
+  uint8_t **ppOutSpan = NULL;
+  uint8_t *pTab = NULL;
+  int64_t p = 0;
+  int32_t blen = 0;
+  int32_t per = 0;
+  int32_t ntask = 0;
+  int32_t i = 0;
+  int32_t t = 0;
+  int x = 0;
+
+  /* Check that every input covers the range, and extend the outputs */
+  for(i = 0; i < nin; i++) {
+    if (aksview_getlen(ppIn[i]) < pos + len) {
+      fault(__LINE__);
+    }
+  }
+  for(i = 0; status && (i < nout); i++) {
+    if (aksview_getlen(ppOut[i]) < pos + len) {
+      if (!aksview_setlen(ppOut[i], pos + len)) {
+        status = 0;
+        *perr = AKSRS_ERR_RESIZE;
+      }
+    }
+  }
+
+  /* Build the multiplication tables */
+  if (status) {
+    pTab = (uint8_t *) malloc(((size_t) (nout * nin)) * TAB_LEN);
+    if (pTab == NULL) {
+      fault(__LINE__);
+    }
+    for(i = 0; i < nout * nin; i++) {
+      for(x = 0; x < 16; x++) {
+        pTab[(i * TAB_LEN) + x] = gfMul(pCoef[i], (uint8_t) x);
+        pTab[(i * TAB_LEN) + 16 + x] = gfMul(pCoef[i], (uint8_t) (x << 4));
+      }
+    }
+  }
+
+  /* Start the worker threads */
+  if (status && (nthreads > 0)) {
+    pPool = akspool_new(nthreads);
+    if (pPool == NULL) {
+      status = 0;
+      *perr = AKSRS_ERR_THREAD;
+    }
+  }
+
+  /* Allocate the tasks and the span arrays they share */
+  if (status) {
+    ntask = (nthreads > 0) ? ((int32_t) nthreads) : 1;
+    pTasks = (RS_TASK *) calloc((size_t) ntask, sizeof(RS_TASK));
+    ppInSpan = (const uint8_t **) calloc(
+                  (size_t) nin, sizeof(const uint8_t *));
+    ppOutSpan = (uint8_t **) calloc((size_t) nout, sizeof(uint8_t *));
+    if ((pTasks == NULL) || (ppInSpan == NULL) || (ppOutSpan == NULL)) {
+      fault(__LINE__);
+    }
+  }
+
+  /* Process the range one batch at a time, with one stripe per task */
+  for(p = pos; status && (p < pos + len); p += blen) {
+    blen = ntask * STRIPE_LEN;
+    if (blen > pos + len - p) {
+      blen = (int32_t) (pos + len - p);
+    }
+
+    /* Map the batch in every shard; each shard is a different viewer,
+     * so all these spans stay valid together */
+    for(i = 0; i < nin; i++) {
+      ppInSpan[i] = aksview_rspan(ppIn[i], p, blen);
+    }
+    for(i = 0; i < nout; i++) {
+      ppOutSpan[i] = aksview_wspan(ppOut[i], p, blen);
+    }
+
+    /* Split the batch into stripes, aligned for the vector loops */
+    per = (blen + ntask - 1) / ntask;
+    per = ((per + 63) / 64) * 64;
+    for(t = 0; t < ntask; t++) {
+      (pTasks[t]).ppIn = ppInSpan;
+      (pTasks[t]).ppOut = ppOutSpan;
+      (pTasks[t]).nin = nin;
+      (pTasks[t]).nout = nout;
+      (pTasks[t]).pTab = pTab;
+      (pTasks[t]).off = 0;
+      (pTasks[t]).n = 0;
+      if (per * t < blen) {
+        (pTasks[t]).off = per * t;
+        (pTasks[t]).n = blen - (per * t);
+        if ((pTasks[t]).n > per) {
+          (pTasks[t]).n = per;
+        }
+      }
+    }
+
+    /* Run the stripes */
+    for(t = 0; t < ntask; t++) {
+      if (pPool != NULL) {
+        akspool_submit(pPool, &codeTask, &(pTasks[t]));
+      } else {
+        codeTask(&(pTasks[t]));
+      }
+    }
+    if (pPool != NULL) {
+      akspool_wait(pPool);
+    }
+  }
+
+  /* Release everything */
+  akspool_free(pPool);
+  free(pTasks);
+  free(ppInSpan);
+  free(ppOutSpan);
+  free(pTab);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksrs_onerror function.
+ */
+void aksrs_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksrs_errstr function.
+ */
+const char *aksrs_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSRS_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSRS_ERR_RESIZE:
+      pResult = "Failed to resize shard file";
+      break;
+
+    case AKSRS_ERR_THREAD:
+      pResult = "Failed to start worker threads";
+      break;
+
+    case AKSRS_ERR_LOST:
+      pResult = "Too many shards lost to rebuild";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksrs_encode function.
+ */
+int aksrs_encode(
+    AKSVIEW ** ppData,
+    int32_t    k,
+    AKSVIEW ** ppParity,
+    int32_t    m,
+    int64_t    pos,
+    int64_t    len,
+    int        nthreads,
+    int      * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pAll[AKSRS_MAXDATA + AKSRS_MAXPARITY];
+  uint8_t *pCoef = NULL;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if ((ppData == NULL) || (ppParity == NULL)) {
+    fault(__LINE__);
+  }
+  if ((k < 1) || (k > AKSRS_MAXDATA) || (m < 1) || (m > AKSRS_MAXPARITY)) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (len < 0) || (pos > AKSVIEW_MAXLEN - len) ||
+      (nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD)) {
+    fault(__LINE__);
+  }
+  for(i = 0; i < k; i++) {
+    if (ppData[i] == NULL) {
+      fault(__LINE__);
+    }
+    pAll[i] = ppData[i];
+  }
+  for(i = 0; i < m; i++) {
+    if (ppParity[i] == NULL) {
+      fault(__LINE__);
+    }
+    if (!aksview_writable(ppParity[i])) {
+      fault(__LINE__);
+    }
+    pAll[k + i] = ppParity[i];
+  }
+  checkShards(pAll, k + m);
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRS_ERR_NONE;
+
+  /* The coefficients are the parity rows of the generator matrix */
+  pCoef = (uint8_t *) malloc((size_t) (m * k));
+  if (pCoef == NULL) {
+    fault(__LINE__);
+  }
+  for(i = 0; i < m; i++) {
+    genRow(k, k + i, pCoef + (i * k));
+  }
+
+  /* Compute the parity */
+  status = runCode(ppData, k, ppParity, m, pCoef, pos, len, nthreads, perr);
+
+  /* Release the coefficients */
+  free(pCoef);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksrs_repair function.
+ */
+int aksrs_repair(
+    AKSVIEW   ** ppShard,
+    const int  * pLost,
+    int32_t      k,
+    int32_t      m,
+    int64_t      pos,
+    int64_t      len,
+    int          nthreads,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pIn[AKSRS_MAXDATA];
+  AKSVIEW *pOut[AKSRS_MAXDATA + AKSRS_MAXPARITY];
+  int32_t src[AKSRS_MAXDATA];
+  uint8_t row[AKSRS_MAXDATA];
+  uint8_t *pMat = NULL;
+  uint8_t *pInv = NULL;
+  uint8_t *pCoef = NULL;
+  int32_t nin = 0;
+  int32_t nout = 0;
+  int32_t i = 0;
+  int32_t j = 0;
+  int32_t c = 0;
+
+  /* Check parameters */
+  if ((ppShard == NULL) || (pLost == NULL)) {
+    fault(__LINE__);
+  }
+  if ((k < 1) || (k > AKSRS_MAXDATA) || (m < 1) || (m > AKSRS_MAXPARITY)) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (len < 0) || (pos > AKSVIEW_MAXLEN - len) ||
+      (nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD)) {
+    fault(__LINE__);
+  }
+  for(i = 0; i < k + m; i++) {
+    if (pLost[i]) {
+      if (ppShard[i] == NULL) {
+        fault(__LINE__);
+      }
+      if (!aksview_writable(ppShard[i])) {
+        fault(__LINE__);
+      }
+    }
+  }
+  checkShards(ppShard, k + m);
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRS_ERR_NONE;
+
+  /* Pick the first k surviving shards as inputs, and gather the shards
+   * to rebuild as outputs */
+  for(i = 0; i < k + m; i++) {
+    if (pLost[i]) {
+      pOut[nout] = ppShard[i];
+      nout++;
+    } else if ((ppShard[i] != NULL) && (nin < k)) {
+      pIn[nin] = ppShard[i];
+      src[nin] = i;
+      nin++;
+    }
+  }
+  if (nin < k) {
+    status = 0;
+    *perr = AKSRS_ERR_LOST;
+  }
+
+  /* Only proceed if there is anything to rebuild */
+  if (status && (nout > 0)) {
+
+    /* Invert the generator rows of the inputs, which gives the data
+     * shards in terms of the inputs */
+    pMat = (uint8_t *) malloc((size_t) (k * k));
+    pInv = (uint8_t *) malloc((size_t) (k * k));
+    pCoef = (uint8_t *) malloc((size_t) (nout * k));
+    if ((pMat == NULL) || (pInv == NULL) || (pCoef == NULL)) {
+      fault(__LINE__);
+    }
+    for(i = 0; i < k; i++) {
+      genRow(k, src[i], pMat + (i * k));
+    }
+    invert(pMat, k, pInv);
+
+    /* Each output is its generator row times the inverse */
+    nout = 0;
+    for(i = 0; i < k + m; i++) {
+      if (pLost[i]) {
+        genRow(k, i, row);
+        for(c = 0; c < k; c++) {
+          pCoef[(nout * k) + c] = 0;
+          for(j = 0; j < k; j++) {
+            pCoef[(nout * k) + c] ^= gfMul(row[j], pInv[(j * k) + c]);
+          }
+        }
+        nout++;
+      }
+    }
+
+    /* Rebuild the outputs */
+    status = runCode(pIn, k, pOut, nout, pCoef, pos, len, nthreads, perr);
+
+    free(pMat);
+    free(pInv);
+    free(pCoef);
+  }
+
+  /* Return status */
+  return status;
+}
@@ -0,0 +1,186 @@
+#ifndef AKSRS_H_INCLUDED
+#define AKSRS_H_INCLUDED
+
+/*
+ * aksrs.h
+ * =======
+ * 
+ * Reed-Solomon erasure coding across AKSView files, for parity files
+ * that can rebuild lost data on local disks.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum number of data shards and parity shards in a code.
+ */
+#define AKSRS_MAXDATA   (128)
+#define AKSRS_MAXPARITY (32)
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksrs_errstr() to convert these to error messages.
+ */
+#define AKSRS_ERR_NONE   (0)
+#define AKSRS_ERR_RESIZE (1)
+#define AKSRS_ERR_THREAD (2)
+#define AKSRS_ERR_LOST   (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksrs.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksrs_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSRS_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksrs_errstr(int code);
+
+/*
+ * Compute parity shards over a range of data shards.
+ * 
+ * A code has k data shards and m parity shards, where k is in range
+ * [1, AKSRS_MAXDATA] and m is in range [1, AKSRS_MAXPARITY].  Each
+ * shard is a separate viewer, normally on a file on a different disk.
+ * Byte i of each parity shard is computed from byte i of all the data
+ * shards, so that byte i of any k of the k + m shards is enough to
+ * recover byte i of all the others.
+ * 
+ * ppData is an array of k viewers holding the data shards, and ppParity
+ * is an array of m writable viewers that receive the parity shards.
+ * The range of len bytes starting at file offset pos is encoded, so
+ * every data shard must be at least pos + len bytes long.  Parity
+ * shards that are shorter than that are extended.  The same viewer may
+ * not appear more than once.  Ranges may be encoded separately, for
+ * example after some of the data has been updated.
+ * 
+ * The range is processed in batches that are mapped from every shard at
+ * once.  Each batch is split into stripes that are encoded on nthreads
+ * worker threads, which must be in range [0, AKSPOOL_MAXTHREAD] (see
+ * akspool.h).  If nthreads is zero, everything runs on the calling
+ * thread.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSRS_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   ppData - the data shards
+ * 
+ *   k - the number of data shards
+ * 
+ *   ppParity - the parity shards
+ * 
+ *   m - the number of parity shards
+ * 
+ *   pos - the file offset of the range
+ * 
+ *   len - the length of the range in bytes, zero or greater
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksrs_encode(
+    AKSVIEW ** ppData,
+    int32_t    k,
+    AKSVIEW ** ppParity,
+    int32_t    m,
+    int64_t    pos,
+    int64_t    len,
+    int        nthreads,
+    int      * perr);
+
+/*
+ * Rebuild a range of lost shards from the surviving shards.
+ * 
+ * ppShard is an array of k + m viewers, with the k data shards first,
+ * followed by the m parity shards, in the same order as they were
+ * passed to aksrs_encode().  pLost is an array of k + m flags.
+ * 
+ * A shard with a non-zero flag is rebuilt: its viewer must be writable,
+ * and the range of len bytes at file offset pos is overwritten with the
+ * recovered bytes, extending the file if necessary.  This viewer may be
+ * on a replacement file.  A NULL entry in ppShard is a shard that is
+ * unavailable and is not rebuilt, and its flag must be zero.  Every
+ * other shard survives, and must be at least pos + len bytes long.
+ * 
+ * At least k shards must survive, or the function fails with
+ * AKSRS_ERR_LOST without writing anything.  The first k surviving
+ * shards are used.
+ * 
+ * nthreads and perr work in the same way as for aksrs_encode().
+ * 
+ * Parameters:
+ * 
+ *   ppShard - the data shards followed by the parity shards
+ * 
+ *   pLost - flags for the shards to rebuild
+ * 
+ *   k - the number of data shards
+ * 
+ *   m - the number of parity shards
+ * 
+ *   pos - the file offset of the range
+ * 
+ *   len - the length of the range in bytes, zero or greater
+ * 
+ *   nthreads - the number of worker threads
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksrs_repair(
+    AKSVIEW   ** ppShard,
+    const int  * pLost,
+    int32_t      k,
+    int32_t      m,
+    int64_t      pos,
+    int64_t      len,
+    int          nthreads,
+    int        * perr);
+
+#endif
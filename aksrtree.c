@@ -0,0 +1,928 @@
+/*
+ * aksrtree.c
+ * ==========
+ * 
+ * Implementation of aksrtree.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksrtree.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a tree file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSRTRE1".
+ */
+#define RT_MAGIC (UINT64_C(0x3145525452534b41))
+
+/*
+ * The maximum number of entries in a node.
+ */
+#define FANOUT (16)
+
+/*
+ * The maximum number of levels in a tree.
+ * 
+ * With FANOUT entries per node, this is enough for any record count
+ * that fits in a signed 64-bit integer.
+ */
+#define MAXLEVEL (16)
+
+/*
+ * Node layout.
+ * 
+ * Each node holds four arrays of FANOUT floats giving the minimum x,
+ * minimum y, maximum x, and maximum y of each entry, followed by an
+ * array of FANOUT 64-bit references.  In leaves, the references are
+ * record offsets.  Otherwise, they are the indices of child nodes.
+ * Unused entries at the end of the last node in a level are zero.
+ * 
+ * Storing each coordinate in its own array lets a node be tested
+ * against a query box with one straight loop over the entries, which
+ * compilers can turn into vector comparisons.
+ */
+#define NODE_OFF_REF (FANOUT * 4 * 4)
+#define NODE_SIZE    (NODE_OFF_REF + (FANOUT * 8))
+
+/*
+ * Header layout.
+ * 
+ * The header gives the number of records, the number of nodes, the
+ * number of levels, and the bounding box of all the records.  It is
+ * followed by the level table, which gives the index of the first node
+ * and the number of nodes in each level, from the root down to the
+ * leaves.  The nodes follow the header, in level order.
+ */
+#define HDR_OFF_MAGIC  (0)
+#define HDR_OFF_COUNT  (8)
+#define HDR_OFF_NNODE  (16)
+#define HDR_OFF_NLEVEL (24)
+#define HDR_OFF_BOUNDS (32)
+#define HDR_OFF_LEVELS (64)
+#define HDR_SIZE       (HDR_OFF_LEVELS + (MAXLEVEL * 16))
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSRTREE structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSRTREE_TAG {
+
+  /*
+   * The viewer on the tree file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of records, the number of levels, and the bounding box
+   * of all the records.
+   */
+  int64_t count;
+  int32_t nlevel;
+  float bounds[4];
+
+  /*
+   * The index of the first node, the number of nodes, and the number of
+   * entries in each level, from the root down.
+   */
+  int64_t lstart[MAXLEVEL];
+  int64_t lnode[MAXLEVEL];
+  int64_t lent[MAXLEVEL];
+
+  /*
+   * The current query box.
+   */
+  float q[4];
+
+  /*
+   * The query stack.
+   * 
+   * depth is the number of levels on the stack, which is zero when no
+   * query is in progress.  For each level on the stack, smask has a bit
+   * set for each entry of the node at that level that matches the query
+   * and has not been visited yet, and sref holds the references of the
+   * entries of that node.
+   */
+  int32_t depth;
+  uint32_t smask[MAXLEVEL];
+  int64_t sref[MAXLEVEL][FANOUT];
+};
+
+/*
+ * RT_ENTRY structure.
+ * 
+ * An entry being packed into a node during the build.  box is in the
+ * same order as AKSRTREE_BOX records, and ref is a record offset or a
+ * node index.
+ */
+typedef struct {
+  float box[4];
+  int64_t ref;
+} RT_ENTRY;
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksrtree fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksrtree warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t levelSizes(int64_t n, int64_t *pEnt);
+static int64_t ceilSqrt(int64_t v);
+static int cmpX(const void *pA, const void *pB);
+static int cmpY(const void *pA, const void *pB);
+static void strSort(RT_ENTRY *pe, int64_t c);
+static void writeNode(
+    AKSVIEW        * pv,
+    int64_t          node,
+    const RT_ENTRY * pe,
+    int32_t          c,
+    RT_ENTRY       * pParent);
+static void pushNode(AKSRTREE *pt, int64_t node);
+
+/*
+ * Compute the number of entries in each level of a tree with n records.
+ * 
+ * The counts are written to pEnt from the root down, so the last count
+ * is n.  pEnt must have room for MAXLEVEL counts.
+ * 
+ * Parameters:
+ * 
+ *   n - the number of records
+ * 
+ *   pEnt - receives the entry counts
+ * 
+ * Return:
+ * 
+ *   the number of levels, which is zero if n is zero
+ */
+static int32_t levelSizes(int64_t n, int64_t *pEnt) {
+
+  int64_t up[MAXLEVEL];
+  int64_t c = 0;
+  int32_t nlevel = 0;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if ((n < 0) || (pEnt == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Go up from the leaves until a level fits in a single node */
+  c = n;
+  while (c > 0) {
+    up[nlevel] = c;
+    nlevel++;
+    if (c > FANOUT) {
+      c = ((c - 1) / FANOUT) + 1;
+    } else {
+      c = 0;
+    }
+  }
+
+  /* Reverse the counts so the root comes first */
+  for(i = 0; i < nlevel; i++) {
+    pEnt[i] = up[nlevel - 1 - i];
+  }
+
+  return nlevel;
+}
+
+/*
+ * Compute the smallest integer whose square is at least v.
+ * 
+ * Parameters:
+ * 
+ *   v - the value, which must be at least one
+ * 
+ * Return:
+ * 
+ *   the rounded-up square root of v
+ */
+static int64_t ceilSqrt(int64_t v) {
+
+  int64_t lo = 1;
+  int64_t hi = INT64_C(3037000500);
+  int64_t mid = 0;
+
+  /* Check parameters */
+  if (v < 1) {
+    fault(__LINE__);
+  }
+
+  /* Binary search for the smallest square that is at least v */
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    if (mid * mid >= v) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+
+  return lo;
+}
+
+/*
+ * Comparison functions for qsort().
+ * 
+ * cmpX orders entries by the x coordinate of their center, and cmpY by
+ * the y coordinate.  Ties are broken by reference so that the build is
+ * deterministic.
+ */
+static int cmpX(const void *pA, const void *pB) {
+
+  const RT_ENTRY *pa = (const RT_ENTRY *) pA;
+  const RT_ENTRY *pb = (const RT_ENTRY *) pB;
+  double ca = 0.0;
+  double cb = 0.0;
+  int result = 0;
+
+  ca = (double) (pa->box)[0] + (double) (pa->box)[2];
+  cb = (double) (pb->box)[0] + (double) (pb->box)[2];
+
+  if (ca < cb) {
+    result = -1;
+  } else if (ca > cb) {
+    result = 1;
+  } else if (pa->ref < pb->ref) {
+    result = -1;
+  } else if (pa->ref > pb->ref) {
+    result = 1;
+  }
+
+  return result;
+}
+
+static int cmpY(const void *pA, const void *pB) {
+
+  const RT_ENTRY *pa = (const RT_ENTRY *) pA;
+  const RT_ENTRY *pb = (const RT_ENTRY *) pB;
+  double ca = 0.0;
+  double cb = 0.0;
+  int result = 0;
+
+  ca = (double) (pa->box)[1] + (double) (pa->box)[3];
+  cb = (double) (pb->box)[1] + (double) (pb->box)[3];
+
+  if (ca < cb) {
+    result = -1;
+  } else if (ca > cb) {
+    result = 1;
+  } else if (pa->ref < pb->ref) {
+    result = -1;
+  } else if (pa->ref > pb->ref) {
+    result = 1;
+  }
+
+  return result;
+}
+
+/*
+ * Order the entries of one level with Sort-Tile-Recursive.
+ * 
+ * The entries are sorted by x into vertical slices that each fill about
+ * the square root of the node count, and then each slice is sorted by
+ * y, so that each run of FANOUT entries forms a compact node.
+ * 
+ * Parameters:
+ * 
+ *   pe - the entries
+ * 
+ *   c - the number of entries
+ */
+static void strSort(RT_ENTRY *pe, int64_t c) {
+
+  int64_t slice = 0;
+  int64_t i = 0;
+  int64_t m = 0;
+
+  /* Check parameters */
+  if ((pe == NULL) || (c < 1)) {
+    fault(__LINE__);
+  }
+
+  /* Sort into slices by x, then sort each slice by y */
+  slice = ceilSqrt(((c - 1) / FANOUT) + 1) * FANOUT;
+  qsort(pe, (size_t) c, sizeof(RT_ENTRY), &cmpX);
+  for(i = 0; i < c; i += slice) {
+    m = c - i;
+    if (m > slice) {
+      m = slice;
+    }
+    qsort(&(pe[i]), (size_t) m, sizeof(RT_ENTRY), &cmpY);
+  }
+}
+
+/*
+ * Write a node and compute its entry in the parent level.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer on the tree file
+ * 
+ *   node - the index of the node
+ * 
+ *   pe - the entries of the node
+ * 
+ *   c - the number of entries, in range [1, FANOUT]
+ * 
+ *   pParent - receives the parent entry
+ */
+static void writeNode(
+    AKSVIEW        * pv,
+    int64_t          node,
+    const RT_ENTRY * pe,
+    int32_t          c,
+    RT_ENTRY       * pParent) {
+
+  float f[FANOUT * 4];
+  int64_t r[FANOUT];
+  int64_t npos = 0;
+  int32_t i = 0;
+  int j = 0;
+
+  /* Check parameters */
+  if ((pv == NULL) || (node < 0) || (pe == NULL) || (pParent == NULL)) {
+    fault(__LINE__);
+  }
+  if ((c < 1) || (c > FANOUT)) {
+    fault(__LINE__);
+  }
+
+  /* Transpose the entries into coordinate arrays, and take the union
+   * of their boxes */
+  memset(f, 0, sizeof(f));
+  memset(r, 0, sizeof(r));
+  memcpy(pParent->box, pe[0].box, sizeof(pParent->box));
+  pParent->ref = node;
+  for(i = 0; i < c; i++) {
+    for(j = 0; j < 4; j++) {
+      f[(j * FANOUT) + i] = (pe[i].box)[j];
+    }
+    r[i] = pe[i].ref;
+
+    for(j = 0; j < 2; j++) {
+      if ((pe[i].box)[j] < (pParent->box)[j]) {
+        (pParent->box)[j] = (pe[i].box)[j];
+      }
+      if ((pe[i].box)[j + 2] > (pParent->box)[j + 2]) {
+        (pParent->box)[j + 2] = (pe[i].box)[j + 2];
+      }
+    }
+  }
+
+  /* Write the node with bulk stores */
+  npos = HDR_SIZE + (node * NODE_SIZE);
+  aksview_writev32f(pv, npos, 1, f, FANOUT * 4);
+  aksview_writev64s(pv, npos + NODE_OFF_REF, 1, r, FANOUT);
+}
+
+/*
+ * Test a node against the current query and push it onto the query
+ * stack.
+ * 
+ * The node is at the level given by the current stack depth, which
+ * must be less than the number of levels.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree
+ * 
+ *   node - the index of the node
+ */
+static void pushNode(AKSRTREE *pt, int64_t node) {
+
+  float f[FANOUT * 4];
+  const float *pMinX = NULL;
+  const float *pMinY = NULL;
+  const float *pMaxX = NULL;
+  const float *pMaxY = NULL;
+  int64_t npos = 0;
+  int64_t c = 0;
+  uint32_t m = 0;
+  int32_t lv = 0;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  lv = pt->depth;
+  if ((lv < 0) || (lv >= pt->nlevel)) {
+    fault(__LINE__);
+  }
+  if ((node < (pt->lstart)[lv]) ||
+      (node >= (pt->lstart)[lv] + (pt->lnode)[lv])) {
+    fault(__LINE__);
+  }
+
+  /* Read the coordinate arrays of the node */
+  npos = HDR_SIZE + (node * NODE_SIZE);
+  aksview_readv32f(pt->pv, npos, 1, f, FANOUT * 4);
+  pMinX = &(f[0]);
+  pMinY = &(f[FANOUT]);
+  pMaxX = &(f[FANOUT * 2]);
+  pMaxY = &(f[FANOUT * 3]);
+
+  /* Test every entry without branching, so the loop can be vectorized;
+   * comparisons with a NaN query coordinate are always false */
+  for(i = 0; i < FANOUT; i++) {
+    m |= ((uint32_t) (
+            (pMinX[i] <= (pt->q)[2]) & (pMaxX[i] >= (pt->q)[0]) &
+            (pMinY[i] <= (pt->q)[3]) & (pMaxY[i] >= (pt->q)[1])
+          )) << i;
+  }
+
+  /* Clear the bits of unused entries in the last node of the level */
+  c = (pt->lent)[lv] - ((node - (pt->lstart)[lv]) * FANOUT);
+  if (c < FANOUT) {
+    m &= (((uint32_t) 1) << c) - 1;
+  }
+
+  /* Only read the references if something matched */
+  if (m != 0) {
+    aksview_readv64s(pt->pv, npos + NODE_OFF_REF, 1,
+                      (pt->sref)[lv], FANOUT);
+  }
+
+  (pt->smask)[lv] = m;
+  (pt->depth)++;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksrtree_onerror function.
+ */
+void aksrtree_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksrtree_errstr function.
+ */
+const char *aksrtree_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSRTREE_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSRTREE_ERR_OPEN:
+      pResult = "Failed to open tree file";
+      break;
+
+    case AKSRTREE_ERR_FORMAT:
+      pResult = "Tree file has invalid format";
+      break;
+
+    case AKSRTREE_ERR_RESIZE:
+      pResult = "Failed to resize tree file";
+      break;
+
+    case AKSRTREE_ERR_RECORD:
+      pResult = "Record has invalid coordinates";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksrtree_build function.
+ */
+int aksrtree_build(
+    AKSVIEW    * pRec,
+    int64_t      pos,
+    int64_t      n,
+    int32_t      stride,
+    int32_t      boxoff,
+    int          kind,
+    const char * pPath,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSVIEW *pv = NULL;
+  RT_ENTRY *pCur = NULL;
+  RT_ENTRY *pNext = NULL;
+  RT_ENTRY *pSwap = NULL;
+  RT_ENTRY root;
+  int64_t lent[MAXLEVEL];
+  int64_t lstart[MAXLEVEL];
+  int64_t lnode[MAXLEVEL];
+  int64_t nnode = 0;
+  int64_t c = 0;
+  int64_t i = 0;
+  int64_t m = 0;
+  int32_t nlevel = 0;
+  int32_t lv = 0;
+  int j = 0;
+
+  /* Check parameters */
+  if ((pRec == NULL) || (pPath == NULL)) {
+    fault(__LINE__);
+  }
+  if ((kind != AKSRTREE_POINT) && (kind != AKSRTREE_BOX)) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (n < 0) || (stride < 1) || (boxoff < 0) ||
+      (boxoff > stride - ((kind == AKSRTREE_POINT) ? 8 : 16))) {
+    fault(__LINE__);
+  }
+  if (n > (aksview_getlen(pRec) - pos) / stride) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRTREE_ERR_NONE;
+
+  /* Lay out the levels from the root down */
+  memset(&root, 0, sizeof(RT_ENTRY));
+  memset(lstart, 0, sizeof(lstart));
+  memset(lnode, 0, sizeof(lnode));
+  nlevel = levelSizes(n, lent);
+  for(lv = 0; lv < nlevel; lv++) {
+    lstart[lv] = nnode;
+    lnode[lv] = ((lent[lv] - 1) / FANOUT) + 1;
+    nnode += lnode[lv];
+  }
+
+  /* Read the boxes of all the records */
+  if (n > 0) {
+    pCur = (RT_ENTRY *) malloc((size_t) n * sizeof(RT_ENTRY));
+    pNext = (RT_ENTRY *) malloc((size_t) lnode[nlevel - 1] *
+                                  sizeof(RT_ENTRY));
+    if ((pCur == NULL) || (pNext == NULL)) {
+      fault(__LINE__);
+    }
+  }
+  for(i = 0; status && (i < n); i++) {
+    pCur[i].ref = pos + (i * stride);
+    if (kind == AKSRTREE_POINT) {
+      aksview_readv32f(pRec, pCur[i].ref + boxoff, 1, pCur[i].box, 2);
+      (pCur[i].box)[2] = (pCur[i].box)[0];
+      (pCur[i].box)[3] = (pCur[i].box)[1];
+    } else {
+      aksview_readv32f(pRec, pCur[i].ref + boxoff, 1, pCur[i].box, 4);
+    }
+
+    for(j = 0; j < 4; j++) {
+      if (!isfinite((pCur[i].box)[j])) {
+        status = 0;
+      }
+    }
+    if (((pCur[i].box)[0] > (pCur[i].box)[2]) ||
+        ((pCur[i].box)[1] > (pCur[i].box)[3])) {
+      status = 0;
+    }
+    if (!status) {
+      *perr = AKSRTREE_ERR_RECORD;
+    }
+  }
+
+  /* Open the tree file, discarding any existing contents, and size it */
+  if (status) {
+    pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+    if (pv == NULL) {
+      status = 0;
+      *perr = AKSRTREE_ERR_OPEN;
+    }
+  }
+  if (status) {
+    if (!aksview_setlen(pv, 0)) {
+      status = 0;
+      *perr = AKSRTREE_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    if (nnode > (AKSVIEW_MAXLEN - HDR_SIZE) / NODE_SIZE) {
+      fault(__LINE__);
+    }
+    if (!aksview_setlen(pv, HDR_SIZE + (nnode * NODE_SIZE))) {
+      status = 0;
+      *perr = AKSRTREE_ERR_RESIZE;
+    }
+  }
+
+  /* Pack each level from the leaves up, turning each node into an
+   * entry of the level above */
+  for(lv = nlevel - 1; status && (lv >= 0); lv--) {
+    c = lent[lv];
+    strSort(pCur, c);
+    for(i = 0; i < lnode[lv]; i++) {
+      m = c - (i * FANOUT);
+      if (m > FANOUT) {
+        m = FANOUT;
+      }
+      writeNode(pv, lstart[lv] + i, &(pCur[i * FANOUT]), (int32_t) m,
+                &(pNext[i]));
+    }
+
+    pSwap = pCur;
+    pCur = pNext;
+    pNext = pSwap;
+  }
+  if (status && (nlevel > 0)) {
+    root = pCur[0];
+  }
+
+  /* Write the header, with the magic number last */
+  if (status) {
+    aksview_write64s(pv, HDR_OFF_COUNT, 1, n);
+    aksview_write64s(pv, HDR_OFF_NNODE, 1, nnode);
+    aksview_write64s(pv, HDR_OFF_NLEVEL, 1, nlevel);
+    aksview_writev32f(pv, HDR_OFF_BOUNDS, 1, root.box, 4);
+    for(lv = 0; lv < nlevel; lv++) {
+      aksview_write64s(pv, HDR_OFF_LEVELS + (lv * 16), 1, lstart[lv]);
+      aksview_write64s(pv, HDR_OFF_LEVELS + (lv * 16) + 8, 1, lnode[lv]);
+    }
+    aksview_write64u(pv, HDR_OFF_MAGIC, 1, RT_MAGIC);
+  }
+
+  /* Release everything */
+  aksview_close(pv);
+  free(pCur);
+  free(pNext);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksrtree_open function.
+ */
+AKSRTREE *aksrtree_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSRTREE *pt = NULL;
+  int64_t flen = 0;
+  int64_t nnode = 0;
+  int64_t nlevel = 0;
+  int64_t start = 0;
+  int64_t lnode = 0;
+  int32_t lv = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSRTREE_ERR_NONE;
+
+  /* Allocate the structure */
+  pt = (AKSRTREE *) calloc(1, sizeof(AKSRTREE));
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pt->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pt->pv == NULL) {
+    status = 0;
+    *perr = AKSRTREE_ERR_OPEN;
+  }
+
+  /* A query touches a path of nodes from the start of the file to the
+   * end, so use the largest window to avoid remapping on each level */
+  if (status) {
+    aksview_sethint(pt->pv, AKSVIEW_MAXSPAN);
+  }
+
+  /* Read the header and check that the levels have the sizes implied by
+   * the record count */
+  if (status) {
+    flen = aksview_getlen(pt->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pt->count = aksview_read64s(pt->pv, HDR_OFF_COUNT, 1);
+    nnode = aksview_read64s(pt->pv, HDR_OFF_NNODE, 1);
+    nlevel = aksview_read64s(pt->pv, HDR_OFF_NLEVEL, 1);
+    aksview_readv32f(pt->pv, HDR_OFF_BOUNDS, 1, pt->bounds, 4);
+
+    if ((aksview_read64u(pt->pv, HDR_OFF_MAGIC, 1) != RT_MAGIC) ||
+        (pt->count < 0) ||
+        (nnode < 0) || (nnode > (flen - HDR_SIZE) / NODE_SIZE) ||
+        (flen != HDR_SIZE + (nnode * NODE_SIZE))) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pt->nlevel = levelSizes(pt->count, pt->lent);
+    if (nlevel != pt->nlevel) {
+      status = 0;
+    }
+  }
+  for(lv = 0; status && (lv < pt->nlevel); lv++) {
+    (pt->lstart)[lv] = aksview_read64s(pt->pv,
+                          HDR_OFF_LEVELS + (lv * 16), 1);
+    (pt->lnode)[lv] = aksview_read64s(pt->pv,
+                          HDR_OFF_LEVELS + (lv * 16) + 8, 1);
+    lnode = (((pt->lent)[lv] - 1) / FANOUT) + 1;
+    if (((pt->lstart)[lv] != start) || ((pt->lnode)[lv] != lnode)) {
+      status = 0;
+    }
+    start += lnode;
+  }
+  if (status && (start != nnode)) {
+    status = 0;
+  }
+  if ((!status) && (pt->pv != NULL)) {
+    *perr = AKSRTREE_ERR_FORMAT;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pt->pv);
+    free(pt);
+    pt = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pt;
+}
+
+/*
+ * aksrtree_close function.
+ */
+void aksrtree_close(AKSRTREE *pt) {
+  if (pt != NULL) {
+    aksview_close(pt->pv);
+    free(pt);
+  }
+}
+
+/*
+ * aksrtree_count function.
+ */
+int64_t aksrtree_count(AKSRTREE *pt) {
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  return pt->count;
+}
+
+/*
+ * aksrtree_bounds function.
+ */
+int aksrtree_bounds(AKSRTREE *pt, float *pBox) {
+
+  int result = 0;
+
+  /* Check parameters */
+  if ((pt == NULL) || (pBox == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Copy the box if the tree has any records */
+  if (pt->count > 0) {
+    memcpy(pBox, pt->bounds, sizeof(pt->bounds));
+    result = 1;
+  }
+
+  return result;
+}
+
+/*
+ * aksrtree_query function.
+ */
+void aksrtree_query(AKSRTREE *pt, const float *pBox) {
+
+  /* Check parameters */
+  if ((pt == NULL) || (pBox == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Abandon any query in progress and test the root */
+  memcpy(pt->q, pBox, sizeof(pt->q));
+  pt->depth = 0;
+  if (pt->nlevel > 0) {
+    pushNode(pt, 0);
+  }
+}
+
+/*
+ * aksrtree_next function.
+ */
+int64_t aksrtree_next(AKSRTREE *pt) {
+
+  int64_t result = -1;
+  int64_t ref = 0;
+  uint32_t m = 0;
+  int32_t lv = 0;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Descend depth-first until a matching leaf entry is found or the
+   * stack is empty */
+  while ((result < 0) && (pt->depth > 0)) {
+    lv = pt->depth - 1;
+    m = (pt->smask)[lv];
+
+    if (m == 0) {
+      /* Node exhausted, so go back up */
+      (pt->depth)--;
+
+    } else {
+      /* Take the lowest remaining entry */
+      i = 0;
+      while (((m >> i) & 1) == 0) {
+        i++;
+      }
+      (pt->smask)[lv] = m & (m - 1);
+      ref = (pt->sref)[lv][i];
+
+      /* Leaf entries are results; child references outside the next
+       * level can only come from a corrupt file, so they are skipped */
+      if (lv == pt->nlevel - 1) {
+        result = ref;
+
+      } else if ((ref >= (pt->lstart)[lv + 1]) &&
+                  (ref < (pt->lstart)[lv + 1] + (pt->lnode)[lv + 1])) {
+        pushNode(pt, ref);
+      }
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,263 @@
+#ifndef AKSRTREE_H_INCLUDED
+#define AKSRTREE_H_INCLUDED
+
+/*
+ * aksrtree.h
+ * ==========
+ * 
+ * Packed static R-tree over fixed-width spatial records stored in
+ * AKSView files.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * Record kinds.
+ * 
+ * AKSRTREE_POINT records hold a point as two little-endian 32-bit
+ * floats x and y.  AKSRTREE_BOX records hold a box as four little-endian
+ * 32-bit floats, in order minimum x, minimum y, maximum x, maximum y.
+ */
+#define AKSRTREE_POINT (1)
+#define AKSRTREE_BOX   (2)
+
+/*
+ * Structure prototype for AKSRTREE.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSRTREE_TAG;
+typedef struct AKSRTREE_TAG AKSRTREE;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksrtree_errstr() to convert these to error messages.
+ */
+#define AKSRTREE_ERR_NONE   (0)
+#define AKSRTREE_ERR_OPEN   (1)
+#define AKSRTREE_ERR_FORMAT (2)
+#define AKSRTREE_ERR_RESIZE (3)
+#define AKSRTREE_ERR_RECORD (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksrtree.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksrtree_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSRTREE_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksrtree_errstr(int code);
+
+/*
+ * Build an R-tree file for an array of spatial records.
+ * 
+ * The records are the n fixed-width records in pRec starting at file
+ * offset pos, each of which is stride bytes long.  The coordinates of
+ * each record are at byte offset boxoff within the record, and kind is
+ * AKSRTREE_POINT or AKSRTREE_BOX to select how they are stored (see the
+ * constants above).  The coordinates must fit within the record.
+ * 
+ * The tree is bulk loaded with the Sort-Tile-Recursive algorithm, so
+ * that records that are close together share leaves and every node
+ * except the last one on each level is full.  The records themselves
+ * are not copied.  Each leaf entry holds the file offset of a record in
+ * pRec, so the tree file is only valid as long as the records are not
+ * moved.  The bounding boxes and offsets of all the records are held in
+ * memory during the build, which takes about 24 * n bytes.
+ * 
+ * The tree file at pPath is created if it does not exist, and truncated
+ * to length zero if it does.  It takes about 26 * n bytes.
+ * 
+ * If any record has a coordinate that is infinite or not a number, or a
+ * box whose minimum is greater than its maximum, the function fails
+ * with AKSRTREE_ERR_RECORD.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSRTREE_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pRec - the viewer holding the records
+ * 
+ *   pos - the file offset of the first record
+ * 
+ *   n - the number of records
+ * 
+ *   stride - the length of each record in bytes
+ * 
+ *   boxoff - the offset of the coordinates within each record
+ * 
+ *   kind - AKSRTREE_POINT or AKSRTREE_BOX
+ * 
+ *   pPath - path to the tree file to write
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksrtree_build(
+    AKSVIEW    * pRec,
+    int64_t      pos,
+    int64_t      n,
+    int32_t      stride,
+    int32_t      boxoff,
+    int          kind,
+    const char * pPath,
+    int        * perr);
+
+/*
+ * Open an R-tree file for querying.
+ * 
+ * The file is opened read-only.  Only the header is read, and nodes are
+ * then read directly from the mapped file as queries visit them.  The
+ * file is mapped with a window hint of AKSVIEW_MAXSPAN, since a query
+ * descends from the top levels at the start of the file to the leaves
+ * at the end of it.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksrtree_build().
+ * 
+ * If a tree is successfully opened, you should close it eventually with
+ * aksrtree_close().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the tree file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new tree object or NULL if the function failed
+ */
+AKSRTREE *aksrtree_open(const char *pPath, int *perr);
+
+/*
+ * Close an R-tree.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree, or NULL
+ */
+void aksrtree_close(AKSRTREE *pt);
+
+/*
+ * Get the number of records indexed by an R-tree.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree
+ * 
+ * Return:
+ * 
+ *   the number of records
+ */
+int64_t aksrtree_count(AKSRTREE *pt);
+
+/*
+ * Get the bounding box of all the records indexed by an R-tree.
+ * 
+ * pBox points to an array of four floats that receives the box, in the
+ * same order as AKSRTREE_BOX records.  If the tree is empty, the array
+ * is not modified.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree
+ * 
+ *   pBox - receives the bounding box
+ * 
+ * Return:
+ * 
+ *   non-zero if the box was written, zero if the tree is empty
+ */
+int aksrtree_bounds(AKSRTREE *pt, float *pBox);
+
+/*
+ * Start a query on an R-tree.
+ * 
+ * pBox points to an array of four floats that gives the query box, in
+ * the same order as AKSRTREE_BOX records.  The query matches every
+ * record whose box intersects the query box, including records that
+ * only touch its edges.  A query box whose minimum is greater than its
+ * maximum, or that has a coordinate that is not a number, matches
+ * nothing.
+ * 
+ * Use aksrtree_next() to iterate through the matching records.  Any
+ * query that is in progress is abandoned.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree
+ * 
+ *   pBox - the query box
+ */
+void aksrtree_query(AKSRTREE *pt, const float *pBox);
+
+/*
+ * Get the next record matching the current query.
+ * 
+ * The return value is the file offset of the record in the viewer the
+ * tree was built from, so the client can read the record in place.
+ * Records are returned in tree order, which groups records that are
+ * close together.  Each matching record is returned exactly once.
+ * 
+ * Only the nodes whose boxes intersect the query box are read, and the
+ * entries of each node are tested against the query box in a single
+ * pass over its coordinate arrays.
+ * 
+ * If no query has been started, -1 is returned.
+ * 
+ * Parameters:
+ * 
+ *   pt - the tree
+ * 
+ * Return:
+ * 
+ *   the file offset of the next matching record, or -1 if there are no
+ *   more matches
+ */
+int64_t aksrtree_next(AKSRTREE *pt);
+
+#endif
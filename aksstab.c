@@ -0,0 +1,789 @@
+/*
+ * aksstab.c
+ * =========
+ * 
+ * Implementation of aksstab.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksstab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a string table file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSSTABL".
+ */
+#define STAB_MAGIC (UINT64_C(0x4c42415453534b41))
+
+/*
+ * Header layout.
+ * 
+ * The string heap begins immediately after the header.  The offset
+ * table and the hash index follow the heap, and their positions are
+ * recorded in the header.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_COUNT (8)
+#define HDR_OFF_OTAB  (16)
+#define HDR_OFF_HTAB  (24)
+#define HDR_OFF_NSLOT (32)
+#define HDR_SIZE      (64)
+
+/*
+ * The value of an empty hash slot.
+ */
+#define SLOT_EMPTY (UINT32_C(0xffffffff))
+
+/*
+ * The initial number of hash slots and offset table entries in a
+ * builder.
+ */
+#define INIT_SLOTS (INT64_C(1024))
+#define INIT_OFFS  (INT64_C(1024))
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSSTAB structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSSTAB_TAG {
+
+  /*
+   * The viewer on the string table file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of strings.
+   */
+  int64_t count;
+
+  /*
+   * File offset of the offset table.
+   * 
+   * The offset table has count + 1 little-endian 64-bit entries.  Entry
+   * i is the file offset of string i, and the final entry is the file
+   * offset immediately after the heap.
+   */
+  int64_t otab;
+
+  /*
+   * File offset of the hash index.
+   * 
+   * The hash index has nslot little-endian 32-bit entries, each of
+   * which is either a string ID or SLOT_EMPTY.
+   */
+  int64_t htab;
+
+  /*
+   * The number of hash slots.
+   * 
+   * This is always a power of two.
+   */
+  int64_t nslot;
+};
+
+/*
+ * AKSSTABW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSSTABW_TAG {
+
+  /*
+   * The viewer on the string table file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The number of strings added so far.
+   */
+  int64_t count;
+
+  /*
+   * The in-memory offset table.
+   * 
+   * Has count + 1 valid entries, with the last entry being the file
+   * offset immediately after the heap.  ocap is the allocated capacity
+   * in entries.
+   */
+  int64_t *pOff;
+  int64_t ocap;
+
+  /*
+   * The in-memory hash index.
+   * 
+   * Has nslot entries, which is always a power of two.  Each entry is
+   * either a string ID or SLOT_EMPTY.
+   */
+  uint32_t *pSlot;
+  int64_t nslot;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksstab fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksstab warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static uint64_t hashBytes(const uint8_t *pb, int32_t len);
+static int sameBytes(
+    AKSVIEW       * pv,
+    int64_t         pos,
+    int64_t         plen,
+    const uint8_t * pb,
+    int32_t         len);
+static void rehash(AKSSTABW *pw);
+
+/*
+ * Compute the hash of a string.
+ * 
+ * This is 64-bit FNV-1a, which only depends on the byte values, so the
+ * hash index is portable between platforms.
+ * 
+ * Parameters:
+ * 
+ *   pb - the string, which may be NULL only if len is zero
+ * 
+ *   len - the length of the string in bytes
+ * 
+ * Return:
+ * 
+ *   the hash value
+ */
+static uint64_t hashBytes(const uint8_t *pb, int32_t len) {
+
+  uint64_t h = UINT64_C(0xcbf29ce484222325);
+  int32_t i = 0;
+
+  /* Check parameters */
+  if ((len < 0) || ((pb == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Hash each byte */
+  for(i = 0; i < len; i++) {
+    h ^= (uint64_t) pb[i];
+    h *= UINT64_C(0x100000001b3);
+  }
+
+  /* Return result */
+  return h;
+}
+
+/*
+ * Check whether a string stored in a viewed file is identical to a
+ * string in memory.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the stored string
+ * 
+ *   plen - the length of the stored string in bytes
+ * 
+ *   pb - the string in memory, which may be NULL only if len is zero
+ * 
+ *   len - the length of the string in memory in bytes
+ * 
+ * Return:
+ * 
+ *   non-zero if the strings are identical, zero otherwise
+ */
+static int sameBytes(
+    AKSVIEW       * pv,
+    int64_t         pos,
+    int64_t         plen,
+    const uint8_t * pb,
+    int32_t         len) {
+
+  int result = 0;
+
+  /* Check parameters */
+  if ((pv == NULL) || (len < 0) || ((pb == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Compare lengths first, then compare the contents in place */
+  if (plen == (int64_t) len) {
+    if (len > 0) {
+      if (memcmp(aksview_rspan(pv, pos, len), pb, (size_t) len) == 0) {
+        result = 1;
+      }
+    } else {
+      result = 1;
+    }
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * Double the size of the hash index in a builder.
+ * 
+ * Each string is hashed again by reading it back from the heap that has
+ * already been written to the file.
+ * 
+ * Parameters:
+ * 
+ *   pw - the string table builder
+ */
+static void rehash(AKSSTABW *pw) {
+
+  uint32_t *pNew = NULL;
+  int64_t nslot = 0;
+  int64_t id = 0;
+  int64_t len = 0;
+  uint64_t slot = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Allocate the new table and mark all slots empty */
+  nslot = pw->nslot * 2;
+  pNew = (uint32_t *) malloc((size_t) (nslot * 4));
+  if (pNew == NULL) {
+    fault(__LINE__);
+  }
+  memset(pNew, 0xff, (size_t) (nslot * 4));
+
+  /* Reinsert each string */
+  for(id = 0; id < pw->count; id++) {
+    len = pw->pOff[id + 1] - pw->pOff[id] - 1;
+    if (len > 0) {
+      slot = hashBytes(
+              aksview_rspan(pw->pv, pw->pOff[id], (int32_t) len),
+              (int32_t) len);
+    } else {
+      slot = hashBytes(NULL, 0);
+    }
+    slot &= (uint64_t) (nslot - 1);
+
+    while (pNew[slot] != SLOT_EMPTY) {
+      slot = (slot + 1) & ((uint64_t) (nslot - 1));
+    }
+    pNew[slot] = (uint32_t) id;
+  }
+
+  /* Replace the old table */
+  free(pw->pSlot);
+  pw->pSlot = pNew;
+  pw->nslot = nslot;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksstab_onerror function.
+ */
+void aksstab_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksstab_errstr function.
+ */
+const char *aksstab_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSSTAB_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSSTAB_ERR_OPEN:
+      pResult = "Failed to open string table file";
+      break;
+
+    case AKSSTAB_ERR_FORMAT:
+      pResult = "String table file has invalid format";
+      break;
+
+    case AKSSTAB_ERR_RESIZE:
+      pResult = "Failed to resize string table file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksstabw_new function.
+ */
+AKSSTABW *aksstabw_new(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSSTABW *pw = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSSTAB_ERR_NONE;
+
+  /* Allocate the builder structure */
+  pw = (AKSSTABW *) calloc(1, sizeof(AKSSTABW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  pw->pv = NULL;
+  pw->pOff = NULL;
+  pw->pSlot = NULL;
+
+  /* Open the file */
+  pw->pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pw->pv == NULL) {
+    status = 0;
+    *perr = AKSSTAB_ERR_OPEN;
+  }
+
+  /* Discard any existing contents and make room for the header */
+  if (status) {
+    if (!aksview_setlen(pw->pv, 0)) {
+      status = 0;
+      *perr = AKSSTAB_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    if (!aksview_reserve(pw->pv, HDR_SIZE)) {
+      status = 0;
+      *perr = AKSSTAB_ERR_RESIZE;
+    }
+  }
+
+  /* Allocate the in-memory tables */
+  if (status) {
+    pw->ocap = INIT_OFFS;
+    pw->pOff = (int64_t *) malloc((size_t) (pw->ocap * 8));
+    if (pw->pOff == NULL) {
+      fault(__LINE__);
+    }
+    pw->pOff[0] = HDR_SIZE;
+
+    pw->nslot = INIT_SLOTS;
+    pw->pSlot = (uint32_t *) malloc((size_t) (pw->nslot * 4));
+    if (pw->pSlot == NULL) {
+      fault(__LINE__);
+    }
+    memset(pw->pSlot, 0xff, (size_t) (pw->nslot * 4));
+
+    pw->count = 0;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pw->pv);
+    free(pw);
+    pw = NULL;
+  }
+
+  /* Return builder or NULL */
+  return pw;
+}
+
+/*
+ * aksstabw_add function.
+ */
+int64_t aksstabw_add(AKSSTABW *pw, const char *ps, int32_t len) {
+
+  int64_t result = -1;
+  int64_t hend = 0;
+  uint64_t slot = 0;
+  uint32_t id = 0;
+  int64_t *pNewOff = NULL;
+  uint8_t *pDest = NULL;
+
+  /* Check parameters */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSSTAB_MAXSTR) ||
+      ((ps == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Look for an existing identical string */
+  slot = hashBytes((const uint8_t *) ps, len)
+            & ((uint64_t) (pw->nslot - 1));
+  while (pw->pSlot[slot] != SLOT_EMPTY) {
+    id = pw->pSlot[slot];
+    if (sameBytes(
+          pw->pv,
+          pw->pOff[id],
+          pw->pOff[id + 1] - pw->pOff[id] - 1,
+          (const uint8_t *) ps,
+          len)) {
+      result = (int64_t) id;
+      break;
+    }
+    slot = (slot + 1) & ((uint64_t) (pw->nslot - 1));
+  }
+
+  /* If not found, append the new string */
+  if (result < 0) {
+
+    /* Check that there is room for another ID */
+    if (pw->count >= AKSSTAB_MAXCOUNT) {
+      fault(__LINE__);
+    }
+
+    /* Make room in the file for the string and its terminating nul */
+    hend = pw->pOff[pw->count];
+    if (hend > AKSVIEW_MAXLEN - ((int64_t) len) - 1) {
+      fault(__LINE__);
+    }
+    if (aksview_reserve(pw->pv, hend + ((int64_t) len) + 1)) {
+
+      /* Write the string and the nul */
+      pDest = aksview_wspan(pw->pv, hend, len + 1);
+      if (len > 0) {
+        memcpy(pDest, ps, (size_t) len);
+      }
+      pDest[len] = 0;
+
+      /* Make room for another offset entry */
+      if (pw->count + 2 > pw->ocap) {
+        pNewOff = (int64_t *) realloc(
+                                pw->pOff, (size_t) (pw->ocap * 2 * 8));
+        if (pNewOff == NULL) {
+          fault(__LINE__);
+        }
+        pw->pOff = pNewOff;
+        pw->ocap *= 2;
+      }
+
+      /* Record the string */
+      pw->pSlot[slot] = (uint32_t) pw->count;
+      pw->pOff[pw->count + 1] = hend + ((int64_t) len) + 1;
+      result = pw->count;
+      (pw->count)++;
+
+      /* Keep the hash index at most half full */
+      if (pw->count * 2 > pw->nslot) {
+        rehash(pw);
+      }
+    }
+  }
+
+  /* Return ID or -1 */
+  return result;
+}
+
+/*
+ * aksstabw_finish function.
+ */
+int aksstabw_finish(AKSSTABW *pw) {
+
+  int status = 1;
+  int64_t otab = 0;
+  int64_t htab = 0;
+  int64_t flen = 0;
+  int64_t i = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Figure out the layout, with the offset table aligned after the
+   * heap */
+  otab = pw->pOff[pw->count];
+  if ((otab % 8) != 0) {
+    otab = ((otab / 8) + 1) * 8;
+  }
+  htab = otab + ((pw->count + 1) * 8);
+  flen = htab + (pw->nslot * 4);
+
+  /* Size the file exactly */
+  if (!aksview_setlen(pw->pv, flen)) {
+    status = 0;
+  }
+
+  /* Write the offset table and the hash index */
+  if (status) {
+    for(i = 0; i <= pw->count; i++) {
+      aksview_write64s(pw->pv, otab + (i * 8), 1, pw->pOff[i]);
+    }
+    for(i = 0; i < pw->nslot; i++) {
+      aksview_write32u(pw->pv, htab + (i * 4), 1, pw->pSlot[i]);
+    }
+  }
+
+  /* Write the header last, so an incomplete file is never mistaken for
+   * a valid table */
+  if (status) {
+    aksview_write64s(pw->pv, HDR_OFF_COUNT, 1, pw->count);
+    aksview_write64s(pw->pv, HDR_OFF_OTAB, 1, otab);
+    aksview_write64s(pw->pv, HDR_OFF_HTAB, 1, htab);
+    aksview_write64s(pw->pv, HDR_OFF_NSLOT, 1, pw->nslot);
+    aksview_write64u(pw->pv, HDR_OFF_MAGIC, 1, STAB_MAGIC);
+  }
+
+  /* Release the builder */
+  aksview_close(pw->pv);
+  free(pw->pOff);
+  free(pw->pSlot);
+  free(pw);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksstab_open function.
+ */
+AKSSTAB *aksstab_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSSTAB *pt = NULL;
+  int64_t flen = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSSTAB_ERR_NONE;
+
+  /* Allocate the structure */
+  pt = (AKSSTAB *) calloc(1, sizeof(AKSSTAB));
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pt->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pt->pv == NULL) {
+    status = 0;
+    *perr = AKSSTAB_ERR_OPEN;
+  }
+
+  /* Read and check the header */
+  if (status) {
+    flen = aksview_getlen(pt->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+      *perr = AKSSTAB_ERR_FORMAT;
+    }
+  }
+  if (status) {
+    if (aksview_read64u(pt->pv, HDR_OFF_MAGIC, 1) != STAB_MAGIC) {
+      status = 0;
+      *perr = AKSSTAB_ERR_FORMAT;
+    }
+  }
+  if (status) {
+    pt->count = aksview_read64s(pt->pv, HDR_OFF_COUNT, 1);
+    pt->otab = aksview_read64s(pt->pv, HDR_OFF_OTAB, 1);
+    pt->htab = aksview_read64s(pt->pv, HDR_OFF_HTAB, 1);
+    pt->nslot = aksview_read64s(pt->pv, HDR_OFF_NSLOT, 1);
+
+    if ((pt->count < 0) || (pt->count > AKSSTAB_MAXCOUNT) ||
+        (pt->otab < HDR_SIZE) || (pt->otab > flen) ||
+        (pt->htab != pt->otab + ((pt->count + 1) * 8)) ||
+        (pt->nslot < 1) || ((pt->nslot & (pt->nslot - 1)) != 0) ||
+        (pt->nslot <= pt->count) ||
+        (pt->nslot > (flen - pt->htab) / 4)) {
+      status = 0;
+      *perr = AKSSTAB_ERR_FORMAT;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pt->pv);
+    free(pt);
+    pt = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pt;
+}
+
+/*
+ * aksstab_close function.
+ */
+void aksstab_close(AKSSTAB *pt) {
+  if (pt != NULL) {
+    aksview_close(pt->pv);
+    free(pt);
+  }
+}
+
+/*
+ * aksstab_count function.
+ */
+int64_t aksstab_count(AKSSTAB *pt) {
+
+  /* Check parameter */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Return cached value */
+  return pt->count;
+}
+
+/*
+ * aksstab_get function.
+ */
+const char *aksstab_get(AKSSTAB *pt, uint32_t id, int32_t *plen) {
+
+  int64_t spos = 0;
+  int64_t send = 0;
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  if ((int64_t) id >= pt->count) {
+    fault(__LINE__);
+  }
+
+  /* Look up the string and its successor in the offset table */
+  spos = aksview_read64s(pt->pv, pt->otab + (((int64_t) id) * 8), 1);
+  send = aksview_read64s(
+            pt->pv, pt->otab + (((int64_t) id) * 8) + 8, 1);
+  if ((spos < HDR_SIZE) || (send <= spos) || (send > pt->otab) ||
+      (send - spos > AKSVIEW_MAXSPAN)) {
+    fault(__LINE__);
+  }
+
+  /* Return the length and a span including the terminating nul */
+  if (plen != NULL) {
+    *plen = (int32_t) (send - spos - 1);
+  }
+  return (const char *) aksview_rspan(
+                          pt->pv, spos, (int32_t) (send - spos));
+}
+
+/*
+ * aksstab_find function.
+ */
+int64_t aksstab_find(AKSSTAB *pt, const char *ps, int32_t len) {
+
+  int64_t result = -1;
+  uint64_t slot = 0;
+  uint32_t id = 0;
+  int64_t spos = 0;
+  int64_t send = 0;
+  int64_t probes = 0;
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSSTAB_MAXSTR) ||
+      ((ps == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Probe the hash index until we find the string or an empty slot */
+  slot = hashBytes((const uint8_t *) ps, len)
+            & ((uint64_t) (pt->nslot - 1));
+  for(probes = 0; probes < pt->nslot; probes++) {
+    id = aksview_read32u(pt->pv, pt->htab + (((int64_t) slot) * 4), 1);
+    if (id == SLOT_EMPTY) {
+      break;
+    }
+    if ((int64_t) id >= pt->count) {
+      fault(__LINE__);
+    }
+
+    spos = aksview_read64s(pt->pv, pt->otab + (((int64_t) id) * 8), 1);
+    send = aksview_read64s(
+              pt->pv, pt->otab + (((int64_t) id) * 8) + 8, 1);
+    if ((spos < HDR_SIZE) || (send <= spos) || (send > pt->otab)) {
+      fault(__LINE__);
+    }
+
+    if (sameBytes(
+          pt->pv, spos, send - spos - 1, (const uint8_t *) ps, len)) {
+      result = (int64_t) id;
+      break;
+    }
+
+    slot = (slot + 1) & ((uint64_t) (pt->nslot - 1));
+  }
+
+  /* Return result */
+  return result;
+}
@@ -0,0 +1,268 @@
+#ifndef AKSSTAB_H_INCLUDED
+#define AKSSTAB_H_INCLUDED
+
+/*
+ * aksstab.h
+ * =========
+ * 
+ * Memory-mapped string table built on top of AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum number of strings in a string table.
+ * 
+ * String IDs are 32-bit, and the value 0xffffffff is reserved to mark
+ * empty hash slots.
+ */
+#define AKSSTAB_MAXCOUNT (INT64_C(4294967295))
+
+/*
+ * The maximum length in bytes of a single string.
+ * 
+ * Strings are returned as spans that include a terminating nul, so
+ * this is one less than the maximum span length.
+ */
+#define AKSSTAB_MAXSTR (AKSVIEW_MAXSPAN - 1)
+
+/*
+ * Structure prototypes for AKSSTAB and AKSSTABW.
+ * 
+ * AKSSTAB is a string table open for reading.  AKSSTABW is a string
+ * table that is being built.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSSTAB_TAG;
+typedef struct AKSSTAB_TAG AKSSTAB;
+
+struct AKSSTABW_TAG;
+typedef struct AKSSTABW_TAG AKSSTABW;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksstab_errstr() to convert these to error messages.
+ */
+#define AKSSTAB_ERR_NONE   (0)
+#define AKSSTAB_ERR_OPEN   (1)
+#define AKSSTAB_ERR_FORMAT (2)
+#define AKSSTAB_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksstab.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksstab_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSSTAB_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksstab_errstr(int code);
+
+/*
+ * Begin building a new string table.
+ * 
+ * The file at pPath is created if it does not exist, and truncated to
+ * length zero if it does.  The string heap is then written into the
+ * file sequentially as new strings are added with aksstabw_add().
+ * 
+ * During the build, a hash index and the table of string offsets are
+ * kept in memory, using 16 to 24 bytes of memory per distinct string.
+ * The hash index is written into the file by aksstabw_finish() so that
+ * readers can look up strings without rebuilding it.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSSTAB_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the string table file to build
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new string table builder or NULL if the function failed
+ */
+AKSSTABW *aksstabw_new(const char *pPath, int *perr);
+
+/*
+ * Intern a string into a string table that is being built.
+ * 
+ * ps points to the string and len is its length in bytes, which must be
+ * in range [0, AKSSTAB_MAXSTR].  The string may contain any bytes,
+ * including nul.  ps may be NULL only if len is zero.
+ * 
+ * If an identical string has already been added, its ID is returned
+ * and nothing is written.  Otherwise, the string is appended to the
+ * string heap and given the next ID, starting at zero.
+ * 
+ * A fault occurs if the table already has AKSSTAB_MAXCOUNT strings.
+ * 
+ * Parameters:
+ * 
+ *   pw - the string table builder
+ * 
+ *   ps - the string to intern
+ * 
+ *   len - the length of the string in bytes
+ * 
+ * Return:
+ * 
+ *   the string ID, or -1 if the file could not be enlarged
+ */
+int64_t aksstabw_add(AKSSTABW *pw, const char *ps, int32_t len);
+
+/*
+ * Finish building a string table.
+ * 
+ * The offset table and the hash index are written after the string
+ * heap, the header is completed, the file is trimmed to its exact
+ * length, and the builder is released.  The builder may not be used
+ * again after this call, regardless of whether it succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pw - the string table builder
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be resized
+ */
+int aksstabw_finish(AKSSTABW *pw);
+
+/*
+ * Open a string table for reading.
+ * 
+ * The file is opened read-only and only its header is read, so opening
+ * a table costs the same regardless of how many strings it holds.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksstabw_new().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the string table file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new string table object or NULL if the function failed
+ */
+AKSSTAB *aksstab_open(const char *pPath, int *perr);
+
+/*
+ * Close a string table.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pt - the string table, or NULL
+ */
+void aksstab_close(AKSSTAB *pt);
+
+/*
+ * Get the number of strings in a string table.
+ * 
+ * Valid string IDs are in range zero up to one less than this count.
+ * 
+ * Parameters:
+ * 
+ *   pt - the string table
+ * 
+ * Return:
+ * 
+ *   the number of strings
+ */
+int64_t aksstab_count(AKSSTAB *pt);
+
+/*
+ * Get a string from a string table by its ID.
+ * 
+ * id must be less than aksstab_count() or a fault occurs.
+ * 
+ * The returned pointer points directly into the mapped file.  The
+ * string is always followed by a nul byte in the file, so it can be
+ * used directly as a C string if it does not contain any nul bytes
+ * itself.  If plen is not NULL, the length of the string in bytes, not
+ * including the terminating nul, is written to *plen.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to
+ * any function on the same string table.
+ * 
+ * Parameters:
+ * 
+ *   pt - the string table
+ * 
+ *   id - the string ID
+ * 
+ *   plen - receives the length of the string, or NULL
+ * 
+ * Return:
+ * 
+ *   pointer to the string
+ */
+const char *aksstab_get(AKSSTAB *pt, uint32_t id, int32_t *plen);
+
+/*
+ * Find the ID of a string in a string table.
+ * 
+ * This uses the hash index stored in the file, so it touches a handful
+ * of pages regardless of the size of the table.
+ * 
+ * ps points to the string and len is its length in bytes, which must be
+ * in range [0, AKSSTAB_MAXSTR].  ps may be NULL only if len is zero.
+ * 
+ * Parameters:
+ * 
+ *   pt - the string table
+ * 
+ *   ps - the string to look up
+ * 
+ *   len - the length of the string in bytes
+ * 
+ * Return:
+ * 
+ *   the string ID, or -1 if the string is not in the table
+ */
+int64_t aksstab_find(AKSSTAB *pt, const char *ps, int32_t len);
+
+#endif
@@ -0,0 +1,1150 @@
+/*
+ * akstrie.c
+ * =========
+ * 
+ * Implementation of akstrie.h
+ * 
+ * See the header for further information.
+ */
+
+#include "akstrie.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a trie file.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSTRIE1".
+ */
+#define TRIE_MAGIC (UINT64_C(0x3145495254534b41))
+
+/*
+ * Header layout.
+ * 
+ * Nodes begin immediately after the header.  Nodes are written in
+ * post-order, so the root node is the last node in the file.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_ROOT  (8)
+#define HDR_OFF_COUNT (16)
+#define HDR_SIZE      (32)
+
+/*
+ * Node layout.
+ * 
+ * Each node begins with a flags byte followed by a little-endian 16-bit
+ * child count.  If the node is final (a key ends at this node), an
+ * 8-byte little-endian value follows.  Then there is an array of child
+ * labels, one byte per child in ascending order, and finally an array
+ * of child deltas, one per child.
+ * 
+ * Each delta is the file offset of the node minus the file offset of
+ * the child, which is always positive because children are written
+ * before their parents.  All deltas in a node have the same width,
+ * which is given by the width code in the flags byte and chosen to be
+ * as narrow as possible.
+ */
+#define NODE_FINAL     (1)   /* Flag: a key ends at this node */
+#define NODE_WSHIFT    (1)   /* Shift of the width code in flags */
+#define NODE_WMASK     (3)   /* Mask of the width code after shift */
+#define NODE_HDR       (3)   /* Bytes before the value or labels */
+#define NODE_MAXSIZE   (NODE_HDR + 8 + 256 + (256 * 8))
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A node that is still being built.
+ */
+typedef struct {
+
+  /*
+   * Non-zero if a key ends at this node.
+   */
+  int final;
+
+  /*
+   * The value of the key ending at this node, if final.
+   */
+  uint64_t val;
+
+  /*
+   * The number of children that have been completed so far.
+   */
+  int32_t nchild;
+
+  /*
+   * The labels and file offsets of completed children, in ascending
+   * label order.
+   */
+  uint8_t label[256];
+  int64_t off[256];
+
+} PENDNODE;
+
+/*
+ * Information about a node decoded from the file.
+ */
+typedef struct {
+
+  /*
+   * The file offset of the node.
+   */
+  int64_t off;
+
+  /*
+   * Non-zero if a key ends at this node.
+   */
+  int final;
+
+  /*
+   * The value of the key ending at this node, if final.
+   */
+  uint64_t val;
+
+  /*
+   * The number of children.
+   */
+  int32_t nchild;
+
+  /*
+   * The file offset of the label array.
+   */
+  int64_t lpos;
+
+  /*
+   * The file offset of the delta array and the width of each delta.
+   */
+  int64_t dpos;
+  int32_t dw;
+
+} NODEINFO;
+
+/*
+ * AKSTRIEW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSTRIEW_TAG {
+
+  /*
+   * The viewer on the trie file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The logical end of the file, where the next node is written.
+   */
+  int64_t fend;
+
+  /*
+   * The number of keys added so far.
+   */
+  int64_t count;
+
+  /*
+   * Pending nodes along the path of the previous key.
+   * 
+   * Element zero is the root, and element i is the node reached after
+   * the first i bytes of the previous key.  ncap is the allocated
+   * capacity in elements.
+   */
+  PENDNODE *pNode;
+  int32_t ncap;
+
+  /*
+   * The previous key and its length.
+   * 
+   * klen is -1 if no key has been added yet.  kcap is the allocated
+   * capacity of the key buffer.
+   */
+  uint8_t *pKey;
+  int32_t klen;
+  int32_t kcap;
+};
+
+/*
+ * AKSTRIE structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSTRIE_TAG {
+
+  /*
+   * The viewer on the trie file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The file offset of the root node.
+   */
+  int64_t root;
+
+  /*
+   * The number of keys.
+   */
+  int64_t count;
+};
+
+/*
+ * AKSTRIEI structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSTRIEI_TAG {
+
+  /*
+   * The trie being iterated.
+   */
+  AKSTRIE *pt;
+
+  /*
+   * The stack of nodes on the path from the prefix node.
+   * 
+   * Element i is the node reached by the first plen + i bytes of the
+   * key buffer.  pIdx holds the next child to visit for each node, or
+   * -1 if the node itself has not been visited yet.  depth is the
+   * number of elements on the stack and cap is the allocated capacity.
+   */
+  int64_t *pNode;
+  int32_t *pIdx;
+  int32_t depth;
+  int32_t cap;
+
+  /*
+   * The key buffer, which begins with the prefix.
+   * 
+   * Has cap + plen bytes allocated.
+   */
+  uint8_t *pKey;
+  int32_t plen;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "akstrie fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "akstrie warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t writeNode(AKSTRIEW *pw, PENDNODE *pn);
+static int freezeTo(AKSTRIEW *pw, int32_t depth);
+static void readNode(AKSTRIE *pt, int64_t off, NODEINFO *pn);
+static int64_t childAt(AKSTRIE *pt, const NODEINFO *pn, int32_t i);
+static int64_t findChild(AKSTRIE *pt, const NODEINFO *pn, uint8_t c);
+
+/*
+ * Write a completed node to the end of the trie file.
+ * 
+ * Parameters:
+ * 
+ *   pw - the trie builder
+ * 
+ *   pn - the completed node
+ * 
+ * Return:
+ * 
+ *   the file offset of the node, or -1 if the file could not be
+ *   enlarged
+ */
+static int64_t writeNode(AKSTRIEW *pw, PENDNODE *pn) {
+
+  uint8_t buf[NODE_MAXSIZE];
+  int64_t result = -1;
+  int64_t maxd = 0;
+  int64_t d = 0;
+  int32_t dw = 0;
+  int32_t wc = 0;
+  int32_t blen = 0;
+  int32_t i = 0;
+  int32_t j = 0;
+
+  /* Check parameters */
+  if ((pw == NULL) || (pn == NULL)) {
+    fault(__LINE__);
+  }
+  if ((pn->nchild < 0) || (pn->nchild > 256)) {
+    fault(__LINE__);
+  }
+
+  /* Find the largest delta, which is from the earliest child */
+  for(i = 0; i < pn->nchild; i++) {
+    d = pw->fend - pn->off[i];
+    if (d < 1) {
+      fault(__LINE__);
+    }
+    if (d > maxd) {
+      maxd = d;
+    }
+  }
+
+  /* Choose the narrowest delta width */
+  if (maxd <= INT64_C(0xff)) {
+    dw = 1;
+    wc = 0;
+  } else if (maxd <= INT64_C(0xffff)) {
+    dw = 2;
+    wc = 1;
+  } else if (maxd <= INT64_C(0xffffffff)) {
+    dw = 4;
+    wc = 2;
+  } else {
+    dw = 8;
+    wc = 3;
+  }
+
+  /* Encode the node header */
+  buf[0] = (uint8_t) (wc << NODE_WSHIFT);
+  if (pn->final) {
+    buf[0] |= NODE_FINAL;
+  }
+  buf[1] = (uint8_t) (pn->nchild & 0xff);
+  buf[2] = (uint8_t) ((pn->nchild >> 8) & 0xff);
+  blen = NODE_HDR;
+
+  /* Encode the value */
+  if (pn->final) {
+    for(j = 0; j < 8; j++) {
+      buf[blen + j] = (uint8_t) ((pn->val >> (j * 8)) & 0xff);
+    }
+    blen += 8;
+  }
+
+  /* Encode the labels and deltas */
+  if (pn->nchild > 0) {
+    memcpy(&(buf[blen]), pn->label, (size_t) pn->nchild);
+    blen += pn->nchild;
+  }
+  for(i = 0; i < pn->nchild; i++) {
+    d = pw->fend - pn->off[i];
+    for(j = 0; j < dw; j++) {
+      buf[blen + j] = (uint8_t) ((d >> (j * 8)) & 0xff);
+    }
+    blen += dw;
+  }
+
+  /* Append the node to the file */
+  if (pw->fend > AKSVIEW_MAXLEN - blen) {
+    fault(__LINE__);
+  }
+  if (aksview_reserve(pw->pv, pw->fend + blen)) {
+    aksview_writebuf(pw->pv, pw->fend, buf, blen);
+    result = pw->fend;
+    pw->fend += blen;
+  }
+
+  /* Return offset or -1 */
+  return result;
+}
+
+/*
+ * Write out all pending nodes along the previous key that are deeper
+ * than a given depth, attaching each to its parent.
+ * 
+ * Parameters:
+ * 
+ *   pw - the trie builder
+ * 
+ *   depth - the depth of the deepest node to keep pending
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int freezeTo(AKSTRIEW *pw, int32_t depth) {
+
+  int status = 1;
+  int32_t d = 0;
+  int64_t off = 0;
+  PENDNODE *pp = NULL;
+
+  /* Check parameters */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  if (depth < 0) {
+    fault(__LINE__);
+  }
+
+  /* Write nodes from the deepest upwards */
+  for(d = pw->klen; d > depth; d--) {
+    off = writeNode(pw, &((pw->pNode)[d]));
+    if (off < 0) {
+      status = 0;
+      break;
+    }
+
+    pp = &((pw->pNode)[d - 1]);
+    if (pp->nchild >= 256) {
+      fault(__LINE__);
+    }
+    (pp->label)[pp->nchild] = (pw->pKey)[d - 1];
+    (pp->off)[pp->nchild] = off;
+    (pp->nchild)++;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Decode the header of a node in the trie file.
+ * 
+ * A fault occurs if the node is not entirely within the file.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ *   off - the file offset of the node
+ * 
+ *   pn - receives the decoded node information
+ */
+static void readNode(AKSTRIE *pt, int64_t off, NODEINFO *pn) {
+
+  const uint8_t *ph = NULL;
+  uint8_t f = 0;
+  int64_t p = 0;
+
+  /* Check parameters */
+  if ((pt == NULL) || (pn == NULL)) {
+    fault(__LINE__);
+  }
+  if ((off < HDR_SIZE) || (off > pt->root)) {
+    fault(__LINE__);
+  }
+
+  /* Decode the fixed header */
+  ph = aksview_rspan(pt->pv, off, NODE_HDR);
+  f = ph[0];
+  pn->off = off;
+  pn->final = (f & NODE_FINAL) ? 1 : 0;
+  pn->nchild = ((int32_t) ph[1]) | (((int32_t) ph[2]) << 8);
+  pn->dw = 1 << ((f >> NODE_WSHIFT) & NODE_WMASK);
+  if (pn->nchild > 256) {
+    fault(__LINE__);
+  }
+
+  /* Decode the value, if present */
+  p = off + NODE_HDR;
+  pn->val = 0;
+  if (pn->final) {
+    pn->val = aksview_read64u(pt->pv, p, 1);
+    p += 8;
+  }
+
+  /* Locate the arrays */
+  pn->lpos = p;
+  pn->dpos = p + pn->nchild;
+
+  /* Check that the whole node is within the file */
+  if (pn->dpos + (((int64_t) pn->nchild) * pn->dw)
+        > aksview_getlen(pt->pv)) {
+    fault(__LINE__);
+  }
+}
+
+/*
+ * Get the file offset of a child of a decoded node.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ *   pn - the decoded node
+ * 
+ *   i - the index of the child
+ * 
+ * Return:
+ * 
+ *   the file offset of the child node
+ */
+static int64_t childAt(AKSTRIE *pt, const NODEINFO *pn, int32_t i) {
+
+  int64_t p = 0;
+  int64_t d = 0;
+
+  /* Check parameters */
+  if ((pt == NULL) || (pn == NULL)) {
+    fault(__LINE__);
+  }
+  if ((i < 0) || (i >= pn->nchild)) {
+    fault(__LINE__);
+  }
+
+  /* Read the delta with the appropriate width */
+  p = pn->dpos + (((int64_t) i) * pn->dw);
+  switch (pn->dw) {
+    case 1:
+      d = (int64_t) aksview_read8u(pt->pv, p);
+      break;
+
+    case 2:
+      d = (int64_t) aksview_read16u(pt->pv, p, 1);
+      break;
+
+    case 4:
+      d = (int64_t) aksview_read32u(pt->pv, p, 1);
+      break;
+
+    default:
+      d = aksview_read64s(pt->pv, p, 1);
+  }
+
+  /* Check and convert to an absolute offset */
+  if ((d < 1) || (d > pn->off - HDR_SIZE)) {
+    fault(__LINE__);
+  }
+  return pn->off - d;
+}
+
+/*
+ * Find the child of a decoded node that has a given label.
+ * 
+ * The label array is searched in place in the mapped file.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ *   pn - the decoded node
+ * 
+ *   c - the label to look for
+ * 
+ * Return:
+ * 
+ *   the file offset of the child node, or -1 if there is no such child
+ */
+static int64_t findChild(AKSTRIE *pt, const NODEINFO *pn, uint8_t c) {
+
+  int64_t result = -1;
+  const uint8_t *pl = NULL;
+  const uint8_t *pm = NULL;
+
+  /* Check parameters */
+  if ((pt == NULL) || (pn == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Search the labels */
+  if (pn->nchild > 0) {
+    pl = aksview_rspan(pt->pv, pn->lpos, pn->nchild);
+    pm = (const uint8_t *) memchr(pl, c, (size_t) pn->nchild);
+    if (pm != NULL) {
+      result = childAt(pt, pn, (int32_t) (pm - pl));
+    }
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * akstrie_onerror function.
+ */
+void akstrie_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * akstrie_errstr function.
+ */
+const char *akstrie_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSTRIE_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSTRIE_ERR_OPEN:
+      pResult = "Failed to open trie file";
+      break;
+
+    case AKSTRIE_ERR_FORMAT:
+      pResult = "Trie file has invalid format";
+      break;
+
+    case AKSTRIE_ERR_RESIZE:
+      pResult = "Failed to resize trie file";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * akstriew_new function.
+ */
+AKSTRIEW *akstriew_new(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSTRIEW *pw = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSTRIE_ERR_NONE;
+
+  /* Allocate the builder structure */
+  pw = (AKSTRIEW *) calloc(1, sizeof(AKSTRIEW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file, discarding any existing contents */
+  pw->pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+  if (pw->pv == NULL) {
+    status = 0;
+    *perr = AKSTRIE_ERR_OPEN;
+  }
+  if (status) {
+    if (!aksview_setlen(pw->pv, 0)) {
+      status = 0;
+      *perr = AKSTRIE_ERR_RESIZE;
+    }
+  }
+
+  /* Allocate the pending node stack with an empty root, and the key
+   * buffer */
+  if (status) {
+    pw->ncap = 64;
+    pw->pNode = (PENDNODE *) calloc(
+                              (size_t) pw->ncap, sizeof(PENDNODE));
+    if (pw->pNode == NULL) {
+      fault(__LINE__);
+    }
+
+    pw->kcap = 64;
+    pw->pKey = (uint8_t *) malloc((size_t) pw->kcap);
+    if (pw->pKey == NULL) {
+      fault(__LINE__);
+    }
+
+    pw->klen = -1;
+    pw->fend = HDR_SIZE;
+    pw->count = 0;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pw->pv);
+    free(pw);
+    pw = NULL;
+  }
+
+  /* Return builder or NULL */
+  return pw;
+}
+
+/*
+ * akstriew_add function.
+ */
+int akstriew_add(
+    AKSTRIEW      * pw,
+    const uint8_t * pKey,
+    int32_t         len,
+    uint64_t        val) {
+
+  int status = 1;
+  int32_t cp = 0;
+  int32_t d = 0;
+  int32_t ncap = 0;
+  PENDNODE *pNew = NULL;
+  uint8_t *pNewKey = NULL;
+
+  /* Check parameters */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSTRIE_MAXKEY) ||
+      ((pKey == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Find the length of the common prefix with the previous key and
+   * check that the new key sorts after it */
+  if (pw->klen >= 0) {
+    while ((cp < len) && (cp < pw->klen) &&
+            (pKey[cp] == (pw->pKey)[cp])) {
+      cp++;
+    }
+    if (cp >= len) {
+      /* New key is equal to or a prefix of the previous key */
+      fault(__LINE__);
+    }
+    if (cp < pw->klen) {
+      if (pKey[cp] < (pw->pKey)[cp]) {
+        fault(__LINE__);
+      }
+    }
+  }
+
+  /* Write out the nodes of the previous key below the common prefix */
+  if (pw->klen > cp) {
+    status = freezeTo(pw, cp);
+  }
+
+  /* Make room for pending nodes and the key */
+  if (status) {
+    if (len + 1 > pw->ncap) {
+      ncap = pw->ncap;
+      while (len + 1 > ncap) {
+        ncap *= 2;
+      }
+      pNew = (PENDNODE *) realloc(
+                            pw->pNode, ((size_t) ncap) * sizeof(PENDNODE));
+      if (pNew == NULL) {
+        fault(__LINE__);
+      }
+      pw->pNode = pNew;
+      pw->ncap = ncap;
+    }
+    if (len > pw->kcap) {
+      pNewKey = (uint8_t *) realloc(pw->pKey, (size_t) len);
+      if (pNewKey == NULL) {
+        fault(__LINE__);
+      }
+      pw->pKey = pNewKey;
+      pw->kcap = len;
+    }
+  }
+
+  /* Start fresh pending nodes for the new part of the key, and mark the
+   * node at the end of the key final */
+  if (status) {
+    for(d = cp + 1; d <= len; d++) {
+      (pw->pNode)[d].final = 0;
+      (pw->pNode)[d].val = 0;
+      (pw->pNode)[d].nchild = 0;
+    }
+    (pw->pNode)[len].final = 1;
+    (pw->pNode)[len].val = val;
+
+    if (len > 0) {
+      memcpy(pw->pKey, pKey, (size_t) len);
+    }
+    pw->klen = len;
+    (pw->count)++;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akstriew_finish function.
+ */
+int akstriew_finish(AKSTRIEW *pw) {
+
+  int status = 1;
+  int64_t root = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Write out everything below the root, then the root */
+  if (pw->klen > 0) {
+    status = freezeTo(pw, 0);
+  }
+  if (status) {
+    root = writeNode(pw, &((pw->pNode)[0]));
+    if (root < 0) {
+      status = 0;
+    }
+  }
+
+  /* Trim the file and write the header, magic number last */
+  if (status) {
+    if (!aksview_setlen(pw->pv, pw->fend)) {
+      status = 0;
+    }
+  }
+  if (status) {
+    aksview_write64s(pw->pv, HDR_OFF_ROOT, 1, root);
+    aksview_write64s(pw->pv, HDR_OFF_COUNT, 1, pw->count);
+    aksview_write64s(pw->pv, HDR_OFF_COUNT + 8, 1, 0);
+    aksview_write64u(pw->pv, HDR_OFF_MAGIC, 1, TRIE_MAGIC);
+  }
+
+  /* Release the builder */
+  aksview_close(pw->pv);
+  free(pw->pNode);
+  free(pw->pKey);
+  free(pw);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akstrie_open function.
+ */
+AKSTRIE *akstrie_open(const char *pPath, int *perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSTRIE *pt = NULL;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSTRIE_ERR_NONE;
+
+  /* Allocate the structure */
+  pt = (AKSTRIE *) calloc(1, sizeof(AKSTRIE));
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pt->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pt->pv == NULL) {
+    status = 0;
+    *perr = AKSTRIE_ERR_OPEN;
+  }
+
+  /* Read and check the header */
+  if (status) {
+    if (aksview_getlen(pt->pv) < HDR_SIZE + NODE_HDR) {
+      status = 0;
+      *perr = AKSTRIE_ERR_FORMAT;
+    }
+  }
+  if (status) {
+    if (aksview_read64u(pt->pv, HDR_OFF_MAGIC, 1) != TRIE_MAGIC) {
+      status = 0;
+      *perr = AKSTRIE_ERR_FORMAT;
+    }
+  }
+  if (status) {
+    pt->root = aksview_read64s(pt->pv, HDR_OFF_ROOT, 1);
+    pt->count = aksview_read64s(pt->pv, HDR_OFF_COUNT, 1);
+    if ((pt->root < HDR_SIZE) ||
+        (pt->root > aksview_getlen(pt->pv) - NODE_HDR) ||
+        (pt->count < 0)) {
+      status = 0;
+      *perr = AKSTRIE_ERR_FORMAT;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pt->pv);
+    free(pt);
+    pt = NULL;
+  }
+
+  /* Return structure or NULL */
+  return pt;
+}
+
+/*
+ * akstrie_close function.
+ */
+void akstrie_close(AKSTRIE *pt) {
+  if (pt != NULL) {
+    aksview_close(pt->pv);
+    free(pt);
+  }
+}
+
+/*
+ * akstrie_count function.
+ */
+int64_t akstrie_count(AKSTRIE *pt) {
+
+  /* Check parameter */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Return cached value */
+  return pt->count;
+}
+
+/*
+ * akstrie_get function.
+ */
+int akstrie_get(
+    AKSTRIE       * pt,
+    const uint8_t * pKey,
+    int32_t         len,
+    uint64_t      * pVal) {
+
+  int result = 0;
+  NODEINFO ni;
+  int64_t off = 0;
+  int32_t i = 0;
+
+  /* Initialize structures */
+  memset(&ni, 0, sizeof(NODEINFO));
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSTRIE_MAXKEY) ||
+      ((pKey == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Walk down from the root */
+  off = pt->root;
+  for(i = 0; i < len; i++) {
+    readNode(pt, off, &ni);
+    off = findChild(pt, &ni, pKey[i]);
+    if (off < 0) {
+      break;
+    }
+  }
+
+  /* If we reached the end of the key, check whether it is final */
+  if (off >= 0) {
+    readNode(pt, off, &ni);
+    if (ni.final) {
+      result = 1;
+      if (pVal != NULL) {
+        *pVal = ni.val;
+      }
+    }
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * akstrie_prefix function.
+ */
+AKSTRIEI *akstrie_prefix(
+    AKSTRIE       * pt,
+    const uint8_t * pPrefix,
+    int32_t         len) {
+
+  AKSTRIEI *pi = NULL;
+  NODEINFO ni;
+  int64_t off = 0;
+  int32_t i = 0;
+
+  /* Initialize structures */
+  memset(&ni, 0, sizeof(NODEINFO));
+
+  /* Check parameters */
+  if (pt == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSTRIE_MAXKEY) ||
+      ((pPrefix == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+
+  /* Allocate the iterator */
+  pi = (AKSTRIEI *) calloc(1, sizeof(AKSTRIEI));
+  if (pi == NULL) {
+    fault(__LINE__);
+  }
+  pi->pt = pt;
+  pi->cap = 64;
+  pi->plen = len;
+  pi->pNode = (int64_t *) malloc(((size_t) pi->cap) * sizeof(int64_t));
+  pi->pIdx = (int32_t *) malloc(((size_t) pi->cap) * sizeof(int32_t));
+  pi->pKey = (uint8_t *) malloc((size_t) (pi->cap + len));
+  if ((pi->pNode == NULL) || (pi->pIdx == NULL) || (pi->pKey == NULL)) {
+    fault(__LINE__);
+  }
+  if (len > 0) {
+    memcpy(pi->pKey, pPrefix, (size_t) len);
+  }
+
+  /* Walk down to the node for the prefix */
+  off = pt->root;
+  for(i = 0; i < len; i++) {
+    readNode(pt, off, &ni);
+    off = findChild(pt, &ni, pPrefix[i]);
+    if (off < 0) {
+      break;
+    }
+  }
+
+  /* If the prefix node exists, it is the bottom of the stack;
+   * otherwise, the stack is empty and the iterator is exhausted */
+  if (off >= 0) {
+    (pi->pNode)[0] = off;
+    (pi->pIdx)[0] = -1;
+    pi->depth = 1;
+  } else {
+    pi->depth = 0;
+  }
+
+  /* Return iterator */
+  return pi;
+}
+
+/*
+ * akstriei_next function.
+ */
+int akstriei_next(
+    AKSTRIEI       * pi,
+    const uint8_t ** ppKey,
+    int32_t        * plen,
+    uint64_t       * pVal) {
+
+  int result = 0;
+  NODEINFO ni;
+  int32_t top = 0;
+  int32_t ncap = 0;
+  int64_t *pNewNode = NULL;
+  int32_t *pNewIdx = NULL;
+  uint8_t *pNewKey = NULL;
+
+  /* Initialize structures */
+  memset(&ni, 0, sizeof(NODEINFO));
+
+  /* Check parameters */
+  if ((pi == NULL) || (ppKey == NULL) || (plen == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* Depth-first traversal until a final node is visited */
+  while (pi->depth > 0) {
+    top = pi->depth - 1;
+    readNode(pi->pt, (pi->pNode)[top], &ni);
+
+    if ((pi->pIdx)[top] < 0) {
+      /* First visit to this node, so report it if it is final */
+      (pi->pIdx)[top] = 0;
+      if (ni.final) {
+        *ppKey = pi->pKey;
+        *plen = pi->plen + top;
+        if (pVal != NULL) {
+          *pVal = ni.val;
+        }
+        result = 1;
+        break;
+      }
+
+    } else if ((pi->pIdx)[top] < ni.nchild) {
+      /* Descend into the next child, growing the stack if needed */
+      if (pi->depth >= pi->cap) {
+        ncap = pi->cap * 2;
+        pNewNode = (int64_t *) realloc(
+                      pi->pNode, ((size_t) ncap) * sizeof(int64_t));
+        pNewIdx = (int32_t *) realloc(
+                      pi->pIdx, ((size_t) ncap) * sizeof(int32_t));
+        if ((pNewNode == NULL) || (pNewIdx == NULL)) {
+          fault(__LINE__);
+        }
+        pi->pNode = pNewNode;
+        pi->pIdx = pNewIdx;
+
+        pNewKey = (uint8_t *) realloc(
+                      pi->pKey, (size_t) (ncap + pi->plen));
+        if (pNewKey == NULL) {
+          fault(__LINE__);
+        }
+        pi->pKey = pNewKey;
+        pi->cap = ncap;
+      }
+
+      (pi->pKey)[pi->plen + top] = aksview_read8u(
+                            pi->pt->pv, ni.lpos + (pi->pIdx)[top]);
+      (pi->pNode)[pi->depth] = childAt(pi->pt, &ni, (pi->pIdx)[top]);
+      (pi->pIdx)[pi->depth] = -1;
+      ((pi->pIdx)[top])++;
+      (pi->depth)++;
+
+    } else {
+      /* All children visited, so pop this node */
+      (pi->depth)--;
+    }
+  }
+
+  /* Return result */
+  return result;
+}
+
+/*
+ * akstriei_free function.
+ */
+void akstriei_free(AKSTRIEI *pi) {
+  if (pi != NULL) {
+    free(pi->pNode);
+    free(pi->pIdx);
+    free(pi->pKey);
+    free(pi);
+  }
+}
@@ -0,0 +1,318 @@
+#ifndef AKSTRIE_H_INCLUDED
+#define AKSTRIE_H_INCLUDED
+
+/*
+ * akstrie.h
+ * =========
+ * 
+ * Static memory-mapped trie built on top of AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum length in bytes of a key.
+ */
+#define AKSTRIE_MAXKEY (INT32_C(65535))
+
+/*
+ * Structure prototypes for AKSTRIE, AKSTRIEW, and AKSTRIEI.
+ * 
+ * AKSTRIE is a trie open for reading.  AKSTRIEW is a trie that is being
+ * built.  AKSTRIEI is an iterator over the keys of a trie that share a
+ * common prefix.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSTRIE_TAG;
+typedef struct AKSTRIE_TAG AKSTRIE;
+
+struct AKSTRIEW_TAG;
+typedef struct AKSTRIEW_TAG AKSTRIEW;
+
+struct AKSTRIEI_TAG;
+typedef struct AKSTRIEI_TAG AKSTRIEI;
+
+/*
+ * Error code definitions.
+ * 
+ * Use akstrie_errstr() to convert these to error messages.
+ */
+#define AKSTRIE_ERR_NONE   (0)
+#define AKSTRIE_ERR_OPEN   (1)
+#define AKSTRIE_ERR_FORMAT (2)
+#define AKSTRIE_ERR_RESIZE (3)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the akstrie.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void akstrie_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSTRIE_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *akstrie_errstr(int code);
+
+/*
+ * Begin building a new trie.
+ * 
+ * The file at pPath is created if it does not exist, and truncated to
+ * length zero if it does.  Keys are then added in sorted order with
+ * akstriew_add().  Each trie node is written to the file as soon as it
+ * is complete, so the file is written sequentially and the memory used
+ * by the builder only depends on the length of the longest key.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSTRIE_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the trie file to build
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new trie builder or NULL if the function failed
+ */
+AKSTRIEW *akstriew_new(const char *pPath, int *perr);
+
+/*
+ * Add a key to a trie that is being built.
+ * 
+ * Keys must be added in strictly ascending order, comparing bytes as
+ * unsigned values, with a key that is a prefix of another key sorting
+ * first.  This is the order produced by sorting with memcmp() and
+ * breaking ties by length.  A fault occurs if a key is not greater than
+ * the key before it.
+ * 
+ * pKey points to the key and len is its length in bytes, which must be
+ * in range [0, AKSTRIE_MAXKEY].  pKey may be NULL only if len is zero.
+ * 
+ * val is a 64-bit value that is associated with the key.  It is
+ * returned by lookups and iteration.
+ * 
+ * Parameters:
+ * 
+ *   pw - the trie builder
+ * 
+ *   pKey - the key
+ * 
+ *   len - the length of the key in bytes
+ * 
+ *   val - the value associated with the key
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int akstriew_add(
+    AKSTRIEW      * pw,
+    const uint8_t * pKey,
+    int32_t         len,
+    uint64_t        val);
+
+/*
+ * Finish building a trie.
+ * 
+ * All remaining nodes are written, the header is completed, the file is
+ * trimmed to its exact length, and the builder is released.  The
+ * builder may not be used again after this call, regardless of whether
+ * it succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pw - the trie builder
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be resized
+ */
+int akstriew_finish(AKSTRIEW *pw);
+
+/*
+ * Open a trie for reading.
+ * 
+ * The file is opened read-only and only its header is read, so opening
+ * a trie costs nothing beyond aksview_create().
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for akstriew_new().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the trie file
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new trie object or NULL if the function failed
+ */
+AKSTRIE *akstrie_open(const char *pPath, int *perr);
+
+/*
+ * Close a trie.
+ * 
+ * If NULL is passed, nothing is done.  All iterators on the trie must
+ * be freed before it is closed.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie, or NULL
+ */
+void akstrie_close(AKSTRIE *pt);
+
+/*
+ * Get the number of keys in a trie.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ * Return:
+ * 
+ *   the number of keys
+ */
+int64_t akstrie_count(AKSTRIE *pt);
+
+/*
+ * Look up a key in a trie.
+ * 
+ * The lookup traverses the trie directly in the mapped file, visiting
+ * one node per byte of the key.
+ * 
+ * pKey points to the key and len is its length in bytes, which must be
+ * in range [0, AKSTRIE_MAXKEY].  pKey may be NULL only if len is zero.
+ * 
+ * If the key is found and pVal is not NULL, the value associated with
+ * the key is written to *pVal.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ *   pKey - the key
+ * 
+ *   len - the length of the key in bytes
+ * 
+ *   pVal - receives the value, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if the key was found, zero if not
+ */
+int akstrie_get(
+    AKSTRIE       * pt,
+    const uint8_t * pKey,
+    int32_t         len,
+    uint64_t      * pVal);
+
+/*
+ * Begin iterating over all the keys in a trie that begin with a given
+ * prefix.
+ * 
+ * pPrefix points to the prefix and len is its length in bytes, which
+ * must be in range [0, AKSTRIE_MAXKEY].  pPrefix may be NULL only if
+ * len is zero.  An empty prefix iterates over all keys.
+ * 
+ * The iterator must be released with akstriei_free() before the trie is
+ * closed.  The iterator only stores the path from the prefix node to
+ * the current key, so no memory is used in proportion to the number of
+ * keys matched.
+ * 
+ * Parameters:
+ * 
+ *   pt - the trie
+ * 
+ *   pPrefix - the prefix
+ * 
+ *   len - the length of the prefix in bytes
+ * 
+ * Return:
+ * 
+ *   a new iterator
+ */
+AKSTRIEI *akstrie_prefix(
+    AKSTRIE       * pt,
+    const uint8_t * pPrefix,
+    int32_t         len);
+
+/*
+ * Get the next key from a prefix iterator.
+ * 
+ * Keys are returned in the same ascending order in which they were
+ * added to the trie.
+ * 
+ * If there is another key, a pointer to it is written to *ppKey, its
+ * length is written to *plen, and its value is written to *pVal (if
+ * pVal is not NULL).  The key pointer refers to memory owned by the
+ * iterator, and it is only valid until the next call on the iterator.
+ * 
+ * Parameters:
+ * 
+ *   pi - the iterator
+ * 
+ *   ppKey - receives a pointer to the key
+ * 
+ *   plen - receives the length of the key
+ * 
+ *   pVal - receives the value, or NULL
+ * 
+ * Return:
+ * 
+ *   non-zero if a key was returned, zero if there are no more keys
+ */
+int akstriei_next(
+    AKSTRIEI       * pi,
+    const uint8_t ** ppKey,
+    int32_t        * plen,
+    uint64_t       * pVal);
+
+/*
+ * Release a prefix iterator.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pi - the iterator, or NULL
+ */
+void akstriei_free(AKSTRIEI *pi);
+
+#endif
@@ -0,0 +1,672 @@
+/*
+ * aksts.c
+ * =======
+ * 
+ * Implementation of aksts.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksts.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic numbers at the start of the data and index files.
+ * 
+ * These are stored as little-endian 64-bit integers, so that the files
+ * begin with the ASCII strings "AKSTSDAT" and "AKSTSIDX".
+ */
+#define DATA_MAGIC  (UINT64_C(0x5441445354534b41))
+#define INDEX_MAGIC (UINT64_C(0x5844495354534b41))
+
+/*
+ * Data file header layout.
+ * 
+ * Blocks begin immediately after the header.  Each block holds
+ * blocklen timestamps followed by blocklen times nval values, all
+ * stored as 64-bit little-endian words.
+ */
+#define DATA_OFF_MAGIC (0)
+#define DATA_OFF_NVAL  (8)
+#define DATA_OFF_BLEN  (12)
+#define DATA_OFF_COUNT (16)
+#define DATA_HEADER    (32)
+
+/*
+ * Index file header layout.
+ * 
+ * The header is followed by one 64-bit little-endian timestamp for each
+ * block, which is the timestamp of the first sample in the block.
+ */
+#define INDEX_OFF_MAGIC (0)
+#define INDEX_OFF_NBLK  (8)
+#define INDEX_HEADER    (16)
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * AKSTS structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSTS_TAG {
+
+  /*
+   * The viewers on the data file and the index file.
+   */
+  AKSVIEW *pData;
+  AKSVIEW *pIndex;
+
+  /*
+   * The number of values per sample, the number of samples per block,
+   * and the size of each block in bytes.
+   */
+  int32_t nval;
+  int32_t blocklen;
+  int64_t bsize;
+
+  /*
+   * The number of samples.
+   * 
+   * The copy in the data file header is only updated by aksts_sync().
+   */
+  int64_t count;
+
+  /*
+   * The timestamp of the last sample, if count is greater than zero.
+   */
+  int64_t tlast;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksts fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksts warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int64_t nblocks(AKSTS *ps);
+static int64_t timePos(AKSTS *ps, int64_t i);
+static int64_t valPos(AKSTS *ps, int64_t i);
+static int initFiles(AKSTS *ps, int32_t nval, int32_t blocklen);
+static int loadHeaders(AKSTS *ps, int32_t nval, int32_t blocklen);
+
+/*
+ * Get the number of blocks in use.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ * Return:
+ * 
+ *   the number of blocks holding at least one sample
+ */
+static int64_t nblocks(AKSTS *ps) {
+  return (ps->count + ps->blocklen - 1) / ps->blocklen;
+}
+
+/*
+ * Get the file offsets of the timestamp and of the first value of a
+ * sample in the data file.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ *   i - the sample index
+ * 
+ * Return:
+ * 
+ *   the file offset
+ */
+static int64_t timePos(AKSTS *ps, int64_t i) {
+  return DATA_HEADER + ((i / ps->blocklen) * ps->bsize)
+            + ((i % ps->blocklen) * 8);
+}
+
+static int64_t valPos(AKSTS *ps, int64_t i) {
+  return DATA_HEADER + ((i / ps->blocklen) * ps->bsize)
+            + (((int64_t) ps->blocklen) * 8)
+            + ((i % ps->blocklen) * ((int64_t) ps->nval) * 8);
+}
+
+/*
+ * Initialize a new, empty store in empty files.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store, with both viewers open
+ * 
+ *   nval - the number of values per sample
+ * 
+ *   blocklen - the number of samples per block
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the files could not be resized
+ */
+static int initFiles(AKSTS *ps, int32_t nval, int32_t blocklen) {
+
+  int status = 1;
+
+  /* Check parameters */
+  if ((nval < 1) || (nval > AKSTS_MAXVAL) ||
+      (blocklen < 1) || (blocklen > AKSTS_MAXBLOCK)) {
+    fault(__LINE__);
+  }
+  if (((int64_t) blocklen) * (((int64_t) nval) + 1) * 8
+        > (int64_t) AKSVIEW_MAXSPAN) {
+    fault(__LINE__);
+  }
+
+  /* Size the files for their headers */
+  if (!aksview_setlen(ps->pData, DATA_HEADER)) {
+    status = 0;
+  }
+  if (status) {
+    if (!aksview_setlen(ps->pIndex, INDEX_HEADER)) {
+      status = 0;
+    }
+  }
+
+  /* Write the headers */
+  if (status) {
+    aksview_write32s(ps->pData, DATA_OFF_NVAL, 1, nval);
+    aksview_write32s(ps->pData, DATA_OFF_BLEN, 1, blocklen);
+    aksview_write64s(ps->pData, DATA_OFF_COUNT, 1, 0);
+    aksview_write64u(ps->pData, DATA_OFF_MAGIC, 1, DATA_MAGIC);
+
+    aksview_write64s(ps->pIndex, INDEX_OFF_NBLK, 1, 0);
+    aksview_write64u(ps->pIndex, INDEX_OFF_MAGIC, 1, INDEX_MAGIC);
+
+    ps->nval = nval;
+    ps->blocklen = blocklen;
+    ps->bsize = ((int64_t) blocklen) * (((int64_t) nval) + 1) * 8;
+    ps->count = 0;
+    ps->tlast = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Load and check the headers of an existing store.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store, with both viewers open
+ * 
+ *   nval - the expected number of values per sample, or zero
+ * 
+ *   blocklen - the expected number of samples per block, or zero
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the files have an invalid format
+ */
+static int loadHeaders(AKSTS *ps, int32_t nval, int32_t blocklen) {
+
+  int status = 1;
+
+  /* Check parameters */
+  if ((nval < 0) || (blocklen < 0)) {
+    fault(__LINE__);
+  }
+
+  /* Check the magic numbers */
+  if ((aksview_getlen(ps->pData) < DATA_HEADER) ||
+      (aksview_getlen(ps->pIndex) < INDEX_HEADER)) {
+    status = 0;
+  }
+  if (status) {
+    if ((aksview_read64u(ps->pData, DATA_OFF_MAGIC, 1) != DATA_MAGIC) ||
+        (aksview_read64u(ps->pIndex, INDEX_OFF_MAGIC, 1) != INDEX_MAGIC)) {
+      status = 0;
+    }
+  }
+
+  /* Read and check the data file header */
+  if (status) {
+    ps->nval = aksview_read32s(ps->pData, DATA_OFF_NVAL, 1);
+    ps->blocklen = aksview_read32s(ps->pData, DATA_OFF_BLEN, 1);
+    ps->count = aksview_read64s(ps->pData, DATA_OFF_COUNT, 1);
+    if ((ps->nval < 1) || (ps->nval > AKSTS_MAXVAL) ||
+        (ps->blocklen < 1) || (ps->blocklen > AKSTS_MAXBLOCK) ||
+        ((nval != 0) && (nval != ps->nval)) ||
+        ((blocklen != 0) && (blocklen != ps->blocklen)) ||
+        (ps->count < 0)) {
+      status = 0;
+    }
+  }
+  if (status) {
+    ps->bsize = ((int64_t) ps->blocklen) * (((int64_t) ps->nval) + 1) * 8;
+    if ((ps->bsize > (int64_t) AKSVIEW_MAXSPAN) ||
+        (ps->count / ps->blocklen
+          > (aksview_getlen(ps->pData) - DATA_HEADER) / ps->bsize)) {
+      status = 0;
+    }
+  }
+
+  /* Check that the sparse index covers every block in use */
+  if (status) {
+    if ((aksview_read64s(ps->pIndex, INDEX_OFF_NBLK, 1) < nblocks(ps)) ||
+        (nblocks(ps)
+          > (aksview_getlen(ps->pIndex) - INDEX_HEADER) / 8) ||
+        (timePos(ps, (ps->count > 0) ? ps->count - 1 : 0) + 8
+          > aksview_getlen(ps->pData))) {
+      status = 0;
+    }
+  }
+
+  /* Cache the last timestamp */
+  if (status && (ps->count > 0)) {
+    ps->tlast = aksview_read64s(ps->pData, timePos(ps, ps->count - 1), 1);
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksts_onerror function.
+ */
+void aksts_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksts_errstr function.
+ */
+const char *aksts_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSTS_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSTS_ERR_BADMODE:
+      pResult = "Invalid time-series store mode";
+      break;
+
+    case AKSTS_ERR_OPEN:
+      pResult = "Failed to open time-series store files";
+      break;
+
+    case AKSTS_ERR_FORMAT:
+      pResult = "Time-series store has invalid format";
+      break;
+
+    case AKSTS_ERR_RESIZE:
+      pResult = "Failed to resize time-series store files";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksts_open function.
+ */
+AKSTS *aksts_open(
+    const char * pDataPath,
+    const char * pIndexPath,
+    int          mode,
+    int32_t      nval,
+    int32_t      blocklen,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSTS *ps = NULL;
+
+  /* Check parameters */
+  if ((pDataPath == NULL) || (pIndexPath == NULL)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSTS_ERR_NONE;
+
+  /* Check that mode is recognized */
+  if ((mode != AKSVIEW_READONLY) &&
+      (mode != AKSVIEW_EXISTING) &&
+      (mode != AKSVIEW_REGULAR) &&
+      (mode != AKSVIEW_EXCLUSIVE)) {
+    status = 0;
+    *perr = AKSTS_ERR_BADMODE;
+  }
+
+  /* Allocate the structure */
+  if (status) {
+    ps = (AKSTS *) calloc(1, sizeof(AKSTS));
+    if (ps == NULL) {
+      fault(__LINE__);
+    }
+  }
+
+  /* Open the viewers */
+  if (status) {
+    ps->pData = aksview_create(pDataPath, mode, NULL);
+    if (ps->pData == NULL) {
+      status = 0;
+      *perr = AKSTS_ERR_OPEN;
+    }
+  }
+  if (status) {
+    ps->pIndex = aksview_create(pIndexPath, mode, NULL);
+    if (ps->pIndex == NULL) {
+      status = 0;
+      *perr = AKSTS_ERR_OPEN;
+    }
+  }
+
+  /* Initialize a new store or load the existing one */
+  if (status) {
+    if ((aksview_getlen(ps->pData) == 0) &&
+        (aksview_getlen(ps->pIndex) == 0) &&
+        (mode != AKSVIEW_READONLY)) {
+      if (!initFiles(ps, nval, blocklen)) {
+        status = 0;
+        *perr = AKSTS_ERR_RESIZE;
+      }
+
+    } else {
+      if (!loadHeaders(ps, nval, blocklen)) {
+        status = 0;
+        *perr = AKSTS_ERR_FORMAT;
+      }
+    }
+  }
+
+  /* If function failed, close any viewers and release structure */
+  if ((!status) && (ps != NULL)) {
+    aksview_close(ps->pData);
+    aksview_close(ps->pIndex);
+    free(ps);
+    ps = NULL;
+  }
+
+  /* Return structure or NULL */
+  return ps;
+}
+
+/*
+ * aksts_close function.
+ */
+void aksts_close(AKSTS *ps) {
+  if (ps != NULL) {
+
+    /* If writable, record the count and trim the files */
+    if (aksview_writable(ps->pData)) {
+      aksts_sync(ps);
+      if (!aksview_setlen(ps->pData,
+                DATA_HEADER + (nblocks(ps) * ps->bsize))) {
+        warn(__LINE__);
+      }
+      if (!aksview_setlen(ps->pIndex,
+                INDEX_HEADER + (nblocks(ps) * 8))) {
+        warn(__LINE__);
+      }
+    }
+
+    aksview_close(ps->pData);
+    aksview_close(ps->pIndex);
+    free(ps);
+  }
+}
+
+/*
+ * aksts_sync function.
+ */
+void aksts_sync(AKSTS *ps) {
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  if (aksview_writable(ps->pData)) {
+    aksview_write64s(ps->pIndex, INDEX_OFF_NBLK, 1, nblocks(ps));
+    aksview_flush(ps->pIndex);
+    aksview_flush(ps->pData);
+    aksview_write64s(ps->pData, DATA_OFF_COUNT, 1, ps->count);
+    aksview_flush(ps->pData);
+  }
+}
+
+/*
+ * aksts_count function.
+ */
+int64_t aksts_count(AKSTS *ps) {
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  return ps->count;
+}
+
+/*
+ * aksts_nval function.
+ */
+int32_t aksts_nval(AKSTS *ps) {
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  return ps->nval;
+}
+
+/*
+ * aksts_append function.
+ */
+int aksts_append(AKSTS *ps, int64_t t, const double *pVals) {
+
+  int status = 1;
+  int64_t blk = 0;
+
+  /* Check parameters */
+  if ((ps == NULL) || (pVals == NULL)) {
+    fault(__LINE__);
+  }
+  if ((ps->count > 0) && (t < ps->tlast)) {
+    fault(__LINE__);
+  }
+  if (!aksview_writable(ps->pData)) {
+    fault(__LINE__);
+  }
+
+  /* When starting a new block, grow both files and add an index entry */
+  if ((ps->count % ps->blocklen) == 0) {
+    blk = ps->count / ps->blocklen;
+    if (blk >= (AKSVIEW_MAXLEN - DATA_HEADER) / ps->bsize - 1) {
+      fault(__LINE__);
+    }
+    if (!aksview_reserve(ps->pData, DATA_HEADER + ((blk + 1) * ps->bsize))) {
+      status = 0;
+    }
+    if (status) {
+      if (!aksview_reserve(ps->pIndex, INDEX_HEADER + ((blk + 1) * 8))) {
+        status = 0;
+      }
+    }
+    if (status) {
+      aksview_write64s(ps->pIndex, INDEX_HEADER + (blk * 8), 1, t);
+    }
+  }
+
+  /* Store the sample */
+  if (status) {
+    aksview_write64s(ps->pData, timePos(ps, ps->count), 1, t);
+    aksview_writev64f(ps->pData, valPos(ps, ps->count), 1, pVals, ps->nval);
+    (ps->count)++;
+    ps->tlast = t;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksts_time function.
+ */
+int64_t aksts_time(AKSTS *ps, int64_t i) {
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  if ((i < 0) || (i >= ps->count)) {
+    fault(__LINE__);
+  }
+  return aksview_read64s(ps->pData, timePos(ps, i), 1);
+}
+
+/*
+ * aksts_find function.
+ */
+int64_t aksts_find(AKSTS *ps, int64_t t) {
+
+  int64_t lo = 0;
+  int64_t hi = 0;
+  int64_t mid = 0;
+  int64_t blk = 0;
+
+  /* Check parameter */
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Find the last block whose first timestamp is less than t; the
+   * answer is in that block or is the first sample of the next one */
+  lo = 0;
+  hi = nblocks(ps);
+  while (lo < hi) {
+    mid = lo + ((hi - lo) / 2);
+    if (aksview_read64s(ps->pIndex, INDEX_HEADER + (mid * 8), 1) < t) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  blk = lo - 1;
+
+  /* Binary search the timestamps in that block */
+  if (blk >= 0) {
+    lo = blk * ((int64_t) ps->blocklen);
+    hi = lo + ps->blocklen;
+    if (hi > ps->count) {
+      hi = ps->count;
+    }
+    while (lo < hi) {
+      mid = lo + ((hi - lo) / 2);
+      if (aksview_read64s(ps->pData, timePos(ps, mid), 1) < t) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  }
+
+  /* Return result */
+  return lo;
+}
+
+/*
+ * aksts_read function.
+ */
+void aksts_read(
+    AKSTS   * ps,
+    int64_t   first,
+    int64_t   n,
+    int64_t * pTimes,
+    double  * pVals) {
+
+  int64_t k = 0;
+
+  /* Check parameters */
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  if ((first < 0) || (n < 0) || (first > ps->count - n)) {
+    fault(__LINE__);
+  }
+
+  /* Read the range one block at a time */
+  while (n > 0) {
+    k = ps->blocklen - (first % ps->blocklen);
+    if (k > n) {
+      k = n;
+    }
+
+    if (pTimes != NULL) {
+      aksview_readv64s(ps->pData, timePos(ps, first), 1, pTimes, k);
+      pTimes += k;
+    }
+    if (pVals != NULL) {
+      aksview_readv64f(ps->pData, valPos(ps, first), 1, pVals,
+                        k * ps->nval);
+      pVals += k * ps->nval;
+    }
+
+    first += k;
+    n -= k;
+  }
+}
@@ -0,0 +1,285 @@
+#ifndef AKSTS_H_INCLUDED
+#define AKSTS_H_INCLUDED
+
+/*
+ * aksts.h
+ * =======
+ * 
+ * Time-series append store with a sparse time index, built on top of
+ * AKSView.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The maximum number of values in each sample.
+ */
+#define AKSTS_MAXVAL (1024)
+
+/*
+ * The maximum number of samples in each block.
+ * 
+ * Each block has one entry in the sparse time index.
+ */
+#define AKSTS_MAXBLOCK (1048576)
+
+/*
+ * Structure prototype for AKSTS.
+ * 
+ * Definition given in the implementation file.
+ */
+struct AKSTS_TAG;
+typedef struct AKSTS_TAG AKSTS;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksts_errstr() to convert these to error messages.
+ */
+#define AKSTS_ERR_NONE    (0)
+#define AKSTS_ERR_BADMODE (1)
+#define AKSTS_ERR_OPEN    (2)
+#define AKSTS_ERR_FORMAT  (3)
+#define AKSTS_ERR_RESIZE  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksts.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksts_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSTS_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksts_errstr(int code);
+
+/*
+ * Open a time-series store.
+ * 
+ * A store consists of two files.  The data file holds the samples in
+ * blocks of blocklen samples.  Each sample is a 64-bit integer
+ * timestamp followed by nval double-precision values.  Within a block,
+ * the timestamps are stored together, followed by the values, so that
+ * each can be read with a single bulk load.  The index file holds the
+ * timestamp of the first sample in each block, which is a sparse index
+ * with one entry for every blocklen samples.
+ * 
+ * mode is one of the AKSVIEW_ modes accepted by aksview_create(), and
+ * it is applied to both files.  If both files are empty when they are
+ * opened and the mode is not AKSVIEW_READONLY, a new, empty store is
+ * initialized with the given nval and blocklen, which must be in range
+ * [1, AKSTS_MAXVAL] and [1, AKSTS_MAXBLOCK].  Otherwise, the existing
+ * store is opened, and nval and blocklen must either be zero or match
+ * the existing store, or the open fails with a format error.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSTS_ERR_ constants.
+ * 
+ * Parameters:
+ * 
+ *   pDataPath - path to the data file
+ * 
+ *   pIndexPath - path to the index file
+ * 
+ *   mode - the file mode for opening
+ * 
+ *   nval - the number of values per sample, or zero
+ * 
+ *   blocklen - the number of samples per block, or zero
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new store object or NULL if the function failed
+ */
+AKSTS *aksts_open(
+    const char * pDataPath,
+    const char * pIndexPath,
+    int          mode,
+    int32_t      nval,
+    int32_t      blocklen,
+    int        * perr);
+
+/*
+ * Close a time-series store.
+ * 
+ * If NULL is passed, nothing is done.
+ * 
+ * For writable stores, the sample count is written with aksts_sync(),
+ * and the files are trimmed to exactly the length that is in use.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store, or NULL
+ */
+void aksts_close(AKSTS *ps);
+
+/*
+ * Write the sample count to the store and flush both files.
+ * 
+ * The sample count in the data file header is only updated by this
+ * function and by aksts_close(), so that appending never has to remap
+ * the start of the file.  Samples appended after the last sync are lost
+ * if the process stops without closing the store.
+ * 
+ * Does nothing on read-only stores.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ */
+void aksts_sync(AKSTS *ps);
+
+/*
+ * Get the number of samples in a store.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ * Return:
+ * 
+ *   the number of samples
+ */
+int64_t aksts_count(AKSTS *ps);
+
+/*
+ * Get the number of values in each sample of a store.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ * Return:
+ * 
+ *   the number of values per sample
+ */
+int32_t aksts_nval(AKSTS *ps);
+
+/*
+ * Append a sample to a store.
+ * 
+ * A fault occurs if the store was opened read-only, or if t is less
+ * than the timestamp of the last sample in the store.  Equal timestamps
+ * are allowed.
+ * 
+ * pVals points to aksts_nval() values.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ *   t - the timestamp of the sample
+ * 
+ *   pVals - the values of the sample
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the files could not be enlarged
+ */
+int aksts_append(AKSTS *ps, int64_t t, const double *pVals);
+
+/*
+ * Get the timestamp of a sample.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ *   i - the sample index, in range zero up to one less than the count
+ * 
+ * Return:
+ * 
+ *   the timestamp of the sample
+ */
+int64_t aksts_time(AKSTS *ps, int64_t i);
+
+/*
+ * Find the first sample at or after a given time.
+ * 
+ * The sparse index is binary searched for the block that contains the
+ * sample, and then the timestamps within that block are binary
+ * searched.  Only the index and one block of timestamps are touched.
+ * 
+ * To get the samples in a time range [t0, t1), find the start with t0
+ * and the end with t1, and read the samples in between.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ *   t - the time to search for
+ * 
+ * Return:
+ * 
+ *   the index of the first sample with a timestamp at or after t, or the
+ *   sample count if there is no such sample
+ */
+int64_t aksts_find(AKSTS *ps, int64_t t);
+
+/*
+ * Read a range of samples.
+ * 
+ * n samples starting at index first are read.  The range must be within
+ * the sample count.  The timestamps are written to pTimes, and the
+ * values are written to pVals, with the nval values of each sample
+ * stored consecutively.  Either buffer may be NULL if it is not needed.
+ * 
+ * Each block that the range touches is read with one bulk load for the
+ * timestamps and one for the values.
+ * 
+ * Parameters:
+ * 
+ *   ps - the store
+ * 
+ *   first - the index of the first sample to read
+ * 
+ *   n - the number of samples to read, zero or greater
+ * 
+ *   pTimes - receives n timestamps, or NULL
+ * 
+ *   pVals - receives n times nval values, or NULL
+ */
+void aksts_read(
+    AKSTS   * ps,
+    int64_t   first,
+    int64_t   n,
+    int64_t * pTimes,
+    double  * pVals);
+
+#endif
@@ -22,6 +22,7 @@
 
 #else
 /* POSIX headers */
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -30,6 +31,79 @@
 #include <utime.h>
 #endif
 
+/*
+ * (Linux only) Open file description lock commands.
+ * 
+ * These are part of the kernel interface since Linux 3.15, but the C
+ * library only declares them when _GNU_SOURCE is defined.  Kernels that
+ * do not know them fail with EINVAL, in which case lockRange() falls
+ * back to classic record locks.
+ */
+#if defined(AKS_POSIX) && defined(__linux__) && !defined(F_OFD_SETLK)
+#define F_OFD_SETLK (37)
+#define F_OFD_SETLKW (38)
+#endif
+
+/*
+ * (Linux only) Performance counter headers.
+ * 
+ * The C library only declares syscall() when _DEFAULT_SOURCE or
+ * _GNU_SOURCE is defined, so it is declared here as well.
+ */
+#if defined(AKS_POSIX) && defined(__linux__)
+#define PROF_PERF
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+long syscall(long number, ...);
+#endif
+
+/*
+ * (POSIX only) Warm-start profiles are only kept where posix_fadvise()
+ * can prefetch them.  On Linux, mincore() finds the resident pages.
+ * 
+ * Linux always has both, but the C library only declares mincore() when
+ * _DEFAULT_SOURCE or _GNU_SOURCE is defined, and posix_fadvise() when
+ * _POSIX_C_SOURCE is at least 200112L, so under strict C99 they are
+ * declared here as well.  With 32-bit file offsets in the C library,
+ * the 64-bit offset version of posix_fadvise() is used.
+ */
+#if defined(AKS_POSIX) && \
+    (defined(__linux__) || defined(POSIX_FADV_WILLNEED))
+#define WARM_PREFETCH
+#ifdef __linux__
+#define WARM_MINCORE
+int mincore(void *addr, size_t length, unsigned char *vec);
+#ifndef POSIX_FADV_WILLNEED
+#define POSIX_FADV_WILLNEED (3)
+#ifndef __LP64__
+#define posix_fadvise posix_fadvise64
+#endif
+int posix_fadvise(int fd, off_t offset, off_t len, int advice);
+#endif
+#endif
+#endif
+
+/*
+ * (POSIX only) Slurp buffers are anonymous mappings where the platform
+ * has them.  On Linux, large ones are aligned to huge pages and marked
+ * for transparent huge pages.  The C library only declares
+ * MAP_ANONYMOUS, MADV_HUGEPAGE, and madvise() when _DEFAULT_SOURCE or
+ * _GNU_SOURCE is defined, so they are declared here as well.
+ */
+#if defined(AKS_POSIX) && defined(__linux__)
+#define SLURP_ANON
+#define SLURP_THP
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS (0x20)
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE (14)
+#endif
+int madvise(void *addr, size_t length, int advice);
+#elif defined(AKS_POSIX) && defined(MAP_ANONYMOUS)
+#define SLURP_ANON
+#endif
+
 /*
  * Constants
  * =========
@@ -42,6 +116,7 @@
 #define FLAG_LE (2)   /* Platform is little endian */
 #define FLAG_DT (4)   /* Dirty window */
 #define FLAG_UT (8)   /* Update timestamp on close */
+#define FLAG_SL (16)  /* Whole file slurped into a buffer */
 
 /*
  * (POSIX only) Read-write permissions for everyone.
@@ -50,11 +125,115 @@
 #define RWRWRW (S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)
 #endif
 
+/*
+ * The number of performance counters used for profiling.
+ * 
+ * The counters are, in order: CPU cycles, instructions, last-level
+ * cache misses, data TLB misses, and page faults.
+ */
+#define PROF_NCTR (5)
+
+/*
+ * (Linux only) The size of a huge page in bytes.
+ * 
+ * Slurp buffers of at least this size are aligned to it, so that
+ * transparent huge pages can back them.
+ */
+#define SLURP_HUGE (INT64_C(2097152))
+
+/*
+ * Warm-start profiles.
+ * 
+ * WARM_CHUNK is the size in bytes of the chunks of the file that
+ * mapping counts are kept for.
+ * 
+ * A profile file starts with a header of WARM_HDR bytes, holding the
+ * magic number WARM_MAGIC ("AKSWARM1"), the length of the viewed file
+ * when the profile was written, and the number of ranges.  The ranges
+ * follow, hottest first, each WARM_REC bytes holding its file offset and
+ * length.  All fields are 64-bit little endian.
+ */
+#define WARM_CHUNK (INT64_C(1048576))
+#define WARM_MAGIC (UINT64_C(0x314d524157534b41))
+#define WARM_HDR (24)
+#define WARM_REC (16)
+
 /*
  * Type declarations
  * =================
  */
 
+/*
+ * Profiling state of a viewer.
+ */
+typedef struct {
+  
+  /*
+   * (Linux only) The performance counter file descriptors, or -1 for
+   * counters that are not open.
+   * 
+   * All open counters are in one group, so that they can be read
+   * together from the group leader at fd[lead].
+   */
+#ifdef PROF_PERF
+  int fd[PROF_NCTR];
+  int lead;
+#endif
+  
+  /*
+   * The position of each counter in a read of the group, or -1 for
+   * counters that are not open.
+   */
+  int slot[PROF_NCTR];
+  
+  /*
+   * The number of open counters, which is zero if profiling is
+   * disabled.
+   */
+  int nslot;
+  
+  /*
+   * Non-zero if the counters include kernel events.  The leader of the
+   * group decides this, and every other counter follows it.
+   */
+  int kernel;
+  
+  /*
+   * For each operation type, how deeply operations of that type are
+   * nested, and the counter values and the times that the group was
+   * enabled and running when the outermost one started.
+   * 
+   * Nested operations of the same type are counted as part of the
+   * outermost one.
+   */
+  int depth[AKSVIEW_PROF_OPS];
+  uint64_t base[AKSVIEW_PROF_OPS][PROF_NCTR];
+  uint64_t tbase[AKSVIEW_PROF_OPS][2];
+  
+  /*
+   * For each operation type, the number of operations measured, the
+   * summed counts for each counter scaled up for the time the group was
+   * not running, or -1 for counters that are not available, the summed
+   * times that the group was enabled and running, and the number of
+   * operations during which the group never ran.
+   */
+  int64_t calls[AKSVIEW_PROF_OPS];
+  int64_t sum[AKSVIEW_PROF_OPS][PROF_NCTR];
+  int64_t enabled[AKSVIEW_PROF_OPS];
+  int64_t running[AKSVIEW_PROF_OPS];
+  int64_t missed[AKSVIEW_PROF_OPS];
+  
+} PROF_STATE;
+
+/*
+ * A chunk of the file and its mapping count, for ordering the ranges of
+ * a warm-start profile.
+ */
+typedef struct {
+  int64_t idx;
+  int32_t heat;
+} WARM_ORD;
+
 /*
  * AKSVIEW structure.
  * 
@@ -135,9 +314,21 @@ struct AKSVIEW_TAG {
    * Pointer to the mapped window.
    * 
    * May be NULL if nothing is currently mapped.
+   * 
+   * If FLAG_SL is set, this is instead a buffer holding a copy of the
+   * whole file, which is NULL only if the file is empty.  The buffer
+   * then counts as a window from the start to the end of the file, so
+   * it is never remapped.
    */
   uint8_t *pw;
   
+  /*
+   * If FLAG_SL is set, the length in bytes of the anonymous mapping that
+   * holds the buffer, or zero if the buffer came from malloc() or there
+   * is no buffer.
+   */
+  int64_t scap;
+  
   /*
    * The file offset of the first byte that is mapped in the window at
    * pw, or -1 if nothing is mapped.
@@ -150,6 +341,32 @@ struct AKSVIEW_TAG {
    */
   int64_t wlast;
   
+  /*
+   * The profiling state, or NULL if profiling has never been enabled.
+   */
+  PROF_STATE *pProf;
+  
+  /*
+   * (Warm-start platforms only) The path of the warm-start profile
+   * file, or NULL if the viewer does not keep a profile.
+   */
+#ifdef WARM_PREFETCH
+  char *pWarmPath;
+#endif
+  
+  /*
+   * (Warm-start platforms only) The number of times that each
+   * WARM_CHUNK-sized chunk of the file has been mapped into the window,
+   * for nheat chunks from the start of the file.
+   * 
+   * pHeat is NULL and nheat is zero until the first window is mapped
+   * while a profile is kept.
+   */
+#ifdef WARM_PREFETCH
+  int32_t *pHeat;
+  int64_t nheat;
+#endif
+  
 };
 
 /*
@@ -182,6 +399,62 @@ static void (*m_fpWarn)(int) = &default_warn_handler;
 #define fault(line) m_fpFault(line)
 #define warn(line) m_fpWarn(line)
 
+/*
+ * Checking level
+ * ==============
+ * 
+ * AKSVIEW_CHECK may be defined when compiling this file to select how
+ * much validation is performed on the hot path, meaning the load and
+ * store functions, the span and buffer functions, and the window
+ * mapping functions beneath them:
+ * 
+ *   2 - full checking (the default), which faults on every invalid
+ *       parameter and broken internal invariant
+ * 
+ *   1 - bounds only, which still faults on file offsets and lengths
+ *       that are out of range, but skips NULL pointer, read-only, and
+ *       internal invariant checks
+ * 
+ *   0 - trusted, which turns every check into an assumption that the
+ *       compiler may use for optimization, so invalid calls have
+ *       undefined behavior
+ * 
+ * All other functions always perform full checking.
+ * 
+ * On the hot path, checkFull() wraps conditions that are only checked
+ * at the full level, and checkBound() wraps conditions that are checked
+ * at the bounds level and above.
+ */
+#ifndef AKSVIEW_CHECK
+#define AKSVIEW_CHECK (2)
+#endif
+
+#if (AKSVIEW_CHECK < 0) || (AKSVIEW_CHECK > 2)
+#error aksview: AKSVIEW_CHECK must be 0, 1, or 2
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define assume(c) do { if (!(c)) { __builtin_unreachable(); } } while (0)
+#elif defined(_MSC_VER)
+#define assume(c) __assume(c)
+#else
+#define assume(c) ((void) 0)
+#endif
+
+#if (AKSVIEW_CHECK == 2)
+#define checkFull(c) do { if (!(c)) { fault(__LINE__); } } while (0)
+#elif (AKSVIEW_CHECK == 1)
+#define checkFull(c) ((void) 0)
+#else
+#define checkFull(c) assume(c)
+#endif
+
+#if (AKSVIEW_CHECK >= 1)
+#define checkBound(c) do { if (!(c)) { fault(__LINE__); } } while (0)
+#else
+#define checkBound(c) assume(c)
+#endif
+
 /*
  * Local functions
  * ===============
@@ -193,9 +466,47 @@ static int32_t getPageSize(void);
 static int loadFileSize(AKSVIEW *pv);
 static int computeWindow(AKSVIEW *pv);
 
+static uint8_t *slurpAlloc(AKSVIEW *pv, int64_t len, int64_t *pcap);
+static void slurpFree(uint8_t *pBuf, int64_t cap);
+static int slurpLoad(AKSVIEW *pv);
+static void slurpStore(AKSVIEW *pv);
+static void unslurp(AKSVIEW *pv);
+
 static void unmap(AKSVIEW *pv);
 static void unview(AKSVIEW *pv);
 static void mapByte(AKSVIEW *pv, int64_t b);
+static void mapAt(AKSVIEW *pv, int64_t w, int64_t ws);
+static void mapRange(AKSVIEW *pv, int64_t pos, int32_t len);
+static int32_t chunkLen(AKSVIEW *pv, int64_t pos, int64_t remain);
+
+static void swapElements(uint8_t *pb, int64_t n, int32_t w);
+static void bulkRead(
+    AKSVIEW *pv, int64_t pos, int le, void *pa, int64_t n, int32_t w);
+static void bulkWrite(
+    AKSVIEW    * pv,
+    int64_t      pos,
+    int          le,
+    const void * pa,
+    int64_t      n,
+    int32_t      w);
+
+#ifdef AKS_POSIX
+static int lockRange(AKSVIEW *pv, struct flock *pfl, int wait);
+#endif
+
+static void profOpen(PROF_STATE *ps);
+static void profClose(PROF_STATE *ps);
+static void profRead(PROF_STATE *ps, uint64_t *pc, uint64_t *pt);
+static void profEnter(AKSVIEW *pv, int op);
+static void profLeave(AKSVIEW *pv, int op);
+
+#ifdef WARM_PREFETCH
+static void warmCount(AKSVIEW *pv, int64_t w, int64_t ws);
+static int warmCmp(const void *pA, const void *pB);
+static int warmPut(AKSVIEW *pw, int64_t *prpos, int64_t pos, int64_t len);
+static void warmSave(AKSVIEW *pv);
+static void warmLoad(AKSVIEW *pv);
+#endif
 
 /*
  * Determine whether the current system is little endian or big endian.
@@ -458,209 +769,1666 @@ static int computeWindow(AKSVIEW *pv) {
 }
 
 /*
- * Completely close any open file mapping.
+ * Allocate a buffer for a slurped file.
  * 
- * On POSIX, this is equivalent to unview().  On Windows, this will
- * first unview() and then close any open file mapping object (but leave
- * the file handle open).
+ * The buffer is an anonymous mapping where the platform has them, so it
+ * starts on a page boundary and shares no pages with other heap data.
+ * On Linux, buffers of at least SLURP_HUGE bytes are also aligned to a
+ * huge page and marked for transparent huge pages, so that the whole
+ * buffer takes only a few TLB entries.  On Windows, large pages are
+ * tried first, which only succeeds if the process may lock memory.  If
+ * no mapping can be made, the buffer comes from malloc() instead.
+ * 
+ * The contents of the buffer are undefined.
  * 
  * Parameters:
  * 
- *   pv - the viewer object
+ *   pv - the viewer structure
+ * 
+ *   len - the number of bytes needed, greater than zero
+ * 
+ *   pcap - receives the length of the mapping, or zero if the buffer
+ *   came from malloc()
+ * 
+ * Return:
+ * 
+ *   the buffer
  */
-static void unmap(AKSVIEW *pv) {
+static uint8_t *slurpAlloc(AKSVIEW *pv, int64_t len, int64_t *pcap) {
+  
+  uint8_t *pBuf = NULL;
+#if defined(AKS_WIN)
+  SIZE_T large = 0;
+  SIZE_T size = 0;
+#elif defined(SLURP_ANON)
+  void *pMap = NULL;
+  int64_t align = 0;
+  int64_t size = 0;
+  int64_t extra = 0;
+  int64_t lead = 0;
+#endif
   
-  /* Always begin by unviewing */
-  unview(pv);
+  /* Check parameters */
+  if ((pv == NULL) || (len < 1) || (pcap == NULL)) {
+    fault(__LINE__);
+  }
+  *pcap = 0;
+  
+#if defined(AKS_WIN)
+  /* Try large pages first, then normal pages */
+  large = GetLargePageMinimum();
+  if ((large > 0) && (len >= (int64_t) large)) {
+    size = (((SIZE_T) len + large - 1) / large) * large;
+    pBuf = (uint8_t *) VirtualAlloc(
+                        NULL,
+                        size,
+                        MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                        PAGE_READWRITE);
+  }
+  if (pBuf == NULL) {
+    size = (SIZE_T) len;
+    pBuf = (uint8_t *) VirtualAlloc(
+                        NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  }
+  if (pBuf != NULL) {
+    *pcap = (int64_t) size;
+  }
   
-  /* (Windows only) If there is a file mapping handle, close it */
-#ifdef AKS_WIN
-  if (pv->fh_map != NULL) {
-    if (!CloseHandle(pv->fh_map)) {
-      warn(__LINE__);
+#elif defined(SLURP_ANON)
+  /* Round up to whole pages, or to whole huge pages for large buffers on
+   * Linux */
+  align = pv->pgsize;
+#ifdef SLURP_THP
+  if (len >= SLURP_HUGE) {
+    align = SLURP_HUGE;
+  }
+#endif
+  size = ((len + align - 1) / align) * align;
+  
+  /* Map enough extra pages that an aligned range of the size fits, and
+   * then unmap the pages on either side of it */
+  extra = align - pv->pgsize;
+  pMap = mmap(
+          NULL,
+          (size_t) (size + extra),
+          PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS,
+          -1,
+          0);
+  if (pMap != MAP_FAILED) {
+    lead = (align - ((int64_t) (((uintptr_t) pMap) % ((uintptr_t) align))))
+              % align;
+    if (lead > 0) {
+      if (munmap(pMap, (size_t) lead)) {
+        warn(__LINE__);
+      }
     }
-    pv->fh_map = NULL;
+    if (extra - lead > 0) {
+      if (munmap(((uint8_t *) pMap) + lead + size, (size_t) (extra - lead))) {
+        warn(__LINE__);
+      }
+    }
+    pBuf = ((uint8_t *) pMap) + lead;
+    *pcap = size;
+    
+    /* Transparent huge pages are only a hint, so failure is ignored */
+#ifdef SLURP_THP
+    if (align == SLURP_HUGE) {
+      madvise(pBuf, (size_t) size, MADV_HUGEPAGE);
+    }
+#endif
   }
 #endif
+  
+  /* Fall back to the heap */
+  if (pBuf == NULL) {
+    pBuf = (uint8_t *) malloc((size_t) len);
+    if (pBuf == NULL) {
+      fault(__LINE__);
+    }
+  }
+  
+  /* Return the buffer */
+  return pBuf;
 }
 
 /*
- * If there is a mapped window, unmap it.
+ * Release a buffer allocated with slurpAlloc().
  * 
- * If there is currently something mapped, it will be flushed before
- * being unmapped.
+ * Parameters:
+ * 
+ *   pBuf - the buffer, or NULL
+ * 
+ *   cap - the length of the mapping returned by slurpAlloc()
+ */
+static void slurpFree(uint8_t *pBuf, int64_t cap) {
+  if (pBuf != NULL) {
+    if (cap > 0) {
+#if defined(AKS_WIN)
+      if (!VirtualFree(pBuf, 0, MEM_RELEASE)) {
+        warn(__LINE__);
+      }
+#elif defined(SLURP_ANON)
+      if (munmap(pBuf, (size_t) cap)) {
+        warn(__LINE__);
+      }
+#endif
+    } else {
+      free(pBuf);
+    }
+  }
+}
+
+/*
+ * Read the whole file into a buffer and make it the window.
+ * 
+ * This is intended only for use during initialization of the structure.
+ * The fh and flen fields must be filled in, and nothing may be mapped.
+ * If successful, FLAG_SL is set.  Empty files get no buffer.
  * 
  * Parameters:
  * 
- *   pv - the viewer object
+ *   pv - the viewer structure
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
  */
-static void unview(AKSVIEW *pv) {
+static int slurpLoad(AKSVIEW *pv) {
   
-  /* Check parameter */
+  int status = 1;
+  int64_t done = 0;
+  int64_t k = 0;
+#ifdef AKS_POSIX
+  ssize_t got = 0;
+#else
+  DWORD got = 0;
+#endif
+  
+  /* Check parameter and state */
   if (pv == NULL) {
     fault(__LINE__);
   }
+  if ((pv->flen < 0) || (pv->flen > AKSVIEW_SLURPMAX) ||
+      (pv->pw != NULL)) {
+    fault(__LINE__);
+  }
   
-  /* Only proceed if a window is mapped */
-  if (pv->pw != NULL) {
+  /* Allocate the buffer */
+  pv->scap = 0;
+  if (pv->flen > 0) {
+    pv->pw = slurpAlloc(pv, pv->flen, &(pv->scap));
+  }
   
-    /* Flush view */
-    aksview_flush(pv);
+  /* Read the file from the start with as few calls as possible */
+  if (pv->flen > 0) {
+#ifdef AKS_POSIX
+    if (lseek(pv->fh, 0, SEEK_SET) == -1) {
+      status = 0;
+    }
+#else
+    if (SetFilePointer(pv->fh, 0, NULL, FILE_BEGIN) ==
+          INVALID_SET_FILE_POINTER) {
+      status = 0;
+    }
+#endif
+  }
+  while (status && (done < pv->flen)) {
+    k = pv->flen - done;
+    if (k > INT64_C(1073741824)) {
+      k = INT64_C(1073741824);
+    }
+#ifdef AKS_POSIX
+    got = read(pv->fh, pv->pw + done, (size_t) k);
+    if (got < 1) {
+      status = 0;
+    } else {
+      done += (int64_t) got;
+    }
+#else
+    if (!ReadFile(pv->fh, pv->pw + done, (DWORD) k, &got, NULL)) {
+      status = 0;
+    } else if (got < 1) {
+      status = 0;
+    } else {
+      done += (int64_t) got;
+    }
+#endif
+  }
   
-    /* Unmap the view */
-#ifdef AKS_WIN
-    if (!UnmapViewOfFile(pv->pw)) {
+  /* Make the buffer the window, or release it if the read failed */
+  if (status) {
+    pv->flags |= FLAG_SL;
+    if (pv->flen > 0) {
+      pv->wfirst = 0;
+      pv->wlast = pv->flen - 1;
+    }
+  } else {
+    slurpFree(pv->pw, pv->scap);
+    pv->pw = NULL;
+    pv->scap = 0;
+  }
+  
+  /* Return status */
+  return status;
+}
+
+/*
+ * Write the whole buffer of a slurped viewer back to the file.
+ * 
+ * FLAG_SL must be set.  The buffer is written regardless of the dirty
+ * flag, which is left unchanged.  Write errors cause a warning.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ */
+static void slurpStore(AKSVIEW *pv) {
+  
+  int status = 1;
+  int64_t done = 0;
+  int64_t k = 0;
+#ifdef AKS_POSIX
+  ssize_t put = 0;
+#else
+  DWORD put = 0;
+#endif
+  
+  /* Check parameter and state */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if (!(pv->flags & FLAG_SL)) {
+    fault(__LINE__);
+  }
+  
+  /* Write the buffer from the start of the file */
+  if (pv->flen > 0) {
+#ifdef AKS_POSIX
+    if (lseek(pv->fh, 0, SEEK_SET) == -1) {
+      status = 0;
+    }
+#else
+    if (SetFilePointer(pv->fh, 0, NULL, FILE_BEGIN) ==
+          INVALID_SET_FILE_POINTER) {
+      status = 0;
+    }
+#endif
+  }
+  while (status && (done < pv->flen)) {
+    k = pv->flen - done;
+    if (k > INT64_C(1073741824)) {
+      k = INT64_C(1073741824);
+    }
+#ifdef AKS_POSIX
+    put = write(pv->fh, pv->pw + done, (size_t) k);
+    if (put < 1) {
+      status = 0;
+    } else {
+      done += (int64_t) put;
+    }
+#else
+    if (!WriteFile(pv->fh, pv->pw + done, (DWORD) k, &put, NULL)) {
+      status = 0;
+    } else if (put < 1) {
+      status = 0;
+    } else {
+      done += (int64_t) put;
+    }
+#endif
+  }
+  
+  /* Warn if the file could not be written */
+  if (!status) {
+    warn(__LINE__);
+  }
+}
+
+/*
+ * Leave slurp mode, writing the buffer back if it is dirty and then
+ * releasing it.
+ * 
+ * If FLAG_SL is not set, this function does nothing.  Afterwards,
+ * nothing is mapped and the viewer maps windows normally.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ */
+static void unslurp(AKSVIEW *pv) {
+  
+  /* Check parameter */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if slurped */
+  if (pv->flags & FLAG_SL) {
+    aksview_flush(pv);
+    
+    slurpFree(pv->pw, pv->scap);
+    pv->pw = NULL;
+    pv->scap = 0;
+    pv->wfirst = -1;
+    pv->wlast = -1;
+    pv->flags &= ~FLAG_SL;
+  }
+}
+
+/*
+ * Completely close any open file mapping.
+ * 
+ * On POSIX, this is equivalent to unview().  On Windows, this will
+ * first unview() and then close any open file mapping object (but leave
+ * the file handle open).
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ */
+static void unmap(AKSVIEW *pv) {
+  
+  /* Always begin by unviewing */
+  unview(pv);
+  
+  /* (Windows only) If there is a file mapping handle, close it */
+#ifdef AKS_WIN
+  if (pv->fh_map != NULL) {
+    if (!CloseHandle(pv->fh_map)) {
+      warn(__LINE__);
+    }
+    pv->fh_map = NULL;
+  }
+#endif
+}
+
+/*
+ * If there is a mapped window, unmap it.
+ * 
+ * If there is currently something mapped, it will be flushed before
+ * being unmapped.
+ * 
+ * The buffer of a slurped viewer is not a window of the file, so it is
+ * left alone.  Use unslurp() to release it.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ */
+static void unview(AKSVIEW *pv) {
+  
+  /* Check parameter */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if a window is mapped */
+  if ((pv->pw != NULL) && (!(pv->flags & FLAG_SL))) {
+  
+    /* Flush view */
+    aksview_flush(pv);
+  
+    /* Unmap the view */
+#ifdef AKS_WIN
+    if (!UnmapViewOfFile(pv->pw)) {
+      warn(__LINE__);
+    }
+#else
+    if (munmap(pv->pw, (size_t) (pv->wlast - pv->wfirst + 1))) {
+      warn(__LINE__);
+    }
+#endif
+
+    /* Update structure */
+    pv->pw = NULL;
+    pv->wfirst = -1;
+    pv->wlast = -1;
+  }
+}
+
+/*
+ * Ensure that a window is mapped in the given viewer that includes the
+ * given byte offset.
+ * 
+ * If there is currently a window mapped that includes the byte, this
+ * function does nothing.  If there is currently a window mapped but it
+ * doesn't include the byte, the window is unmapped and a window
+ * including the byte is mapped.  If there is no current window mapped,
+ * a window including the byte is mapped.
+ * 
+ * b must be greater than or equal to zero and less than the file length
+ * or a fault occurs.
+ * 
+ * Windows are always aligned to at least eight-byte boundaries, so any
+ * aligned integer up to 64-bit size that includes b will be fully
+ * contained within the window.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   b - the byte offset to map
+ */
+static void mapByte(AKSVIEW *pv, int64_t b) {
+  
+  int64_t w = 0;
+  int64_t r = 0;
+  int32_t ws = 0;
+  
+  /* Check parameters */
+  checkFull(pv != NULL);
+  checkBound((b >= 0) && (b < pv->flen));
+  
+  /* Only proceed if byte not currently mapped */
+  if ((b < pv->wfirst) || (b > pv->wlast)) {
+    
+    /* We need to change the view so first of all unmap any view that
+     * may be mapped */
+    profEnter(pv, AKSVIEW_PROF_MAP);
+    unview(pv);
+    
+    /* Figure out which window the byte is in and get its starting
+     * offset */
+    w = b / ((int64_t) pv->wlen);
+    w = w * ((int64_t) pv->wlen);
+    
+    /* Figure out how much remains in the file starting at this
+     * window */
+    r = pv->flen - w;
+    
+    /* Start with a window size equal to the computed window size */
+    ws = pv->wlen;
+    
+    /* If remainder is less than window size, set adjusted window size
+     * to remainder so we don't go past the end of the file */
+    if (r < ws) {
+      ws = (int32_t) r;
+    }
+    
+    /* Map the window */
+    mapAt(pv, w, (int64_t) ws);
+    profLeave(pv, AKSVIEW_PROF_MAP);
+  }
+}
+
+/*
+ * Map a window of the given viewer that starts at a given file offset
+ * and has a given length.
+ * 
+ * Nothing may currently be mapped in the viewer when this function is
+ * called, so callers should unview() first.
+ * 
+ * w is the file offset of the start of the window.  It must be aligned
+ * to the system page size.  ws is the length of the window in bytes.
+ * It must be at least one, and w + ws must not exceed the file length.
+ * 
+ * The wfirst and wlast fields are updated to reflect the new window.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   w - the file offset of the start of the window
+ * 
+ *   ws - the length of the window in bytes
+ */
+static void mapAt(AKSVIEW *pv, int64_t w, int64_t ws) {
+  
+  /* Check parameters and state */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if ((w < 0) || (ws < 1) || (w > pv->flen - ws)) {
+    fault(__LINE__);
+  }
+  if ((w % ((int64_t) pv->pgsize)) != 0) {
+    fault(__LINE__);
+  }
+  if (pv->pw != NULL) {
+    fault(__LINE__);
+  }
+  
+  /* (Windows only) If no current file mapping object, open one */
+#ifdef AKS_WIN
+  if (pv->fh_map == NULL) {
+    if (pv->flags & FLAG_RO) {
+      pv->fh_map = CreateFileMapping(
+                    pv->fh,
+                    NULL,
+                    PAGE_READONLY,
+                    0,
+                    0,
+                    NULL);
+    } else {
+      pv->fh_map = CreateFileMapping(
+                    pv->fh,
+                    NULL,
+                    PAGE_READWRITE,
+                    0,
+                    0,
+                    NULL);
+    }
+    if (pv->fh_map == NULL) {
+      fault(__LINE__);
+    }
+  }
+#endif
+
+  /* Map the window */
+#ifdef AKS_POSIX
+  if (pv->flags & FLAG_RO) {
+    pv->pw = (uint8_t *) mmap(
+                          (void *) 0,
+                          (size_t) ws,
+                          PROT_READ,
+                          MAP_PRIVATE,
+                          pv->fh,
+                          (off_t) w);
+  } else {
+    pv->pw = (uint8_t *) mmap(
+                          (void *) 0,
+                          (size_t) ws,
+                          PROT_READ | PROT_WRITE,
+                          MAP_SHARED,
+                          pv->fh,
+                          (off_t) w);
+  }
+  if (pv->pw == MAP_FAILED) {
+    fault(__LINE__);
+  }
+#else
+  if (pv->flags & FLAG_RO) {
+    pv->pw = (uint8_t *) MapViewOfFile(
+                          pv->fh_map,
+                          FILE_MAP_READ,
+                          (DWORD) (w >> 32),
+                          (DWORD) (w & INT64_C(0xffffffff)),
+                          (SIZE_T) ws);
+  } else {
+    pv->pw = (uint8_t *) MapViewOfFile(
+                          pv->fh_map,
+                          FILE_MAP_READ | FILE_MAP_WRITE,
+                          (DWORD) (w >> 32),
+                          (DWORD) (w & INT64_C(0xffffffff)),
+                          (SIZE_T) ws);
+  }
+  if (pv->pw == NULL) {
+    fault(__LINE__);
+  }
+#endif
+  
+  
+  /* Update the window boundaries */
+  pv->wfirst = w;
+  pv->wlast = (w - 1) + ws;
+  
+  /* Count the mapping if keeping a warm-start profile */
+#ifdef WARM_PREFETCH
+  if (pv->pWarmPath != NULL) {
+    warmCount(pv, w, ws);
+  }
+#endif
+}
+
+/*
+ * Ensure that a window is mapped in the given viewer that includes the
+ * whole given range of bytes.
+ * 
+ * This is the multi-byte equivalent of mapByte().  If the range is
+ * already within the current window, this function does nothing.
+ * Otherwise, the window containing the first byte of the range is
+ * mapped, extended as far as necessary (in whole system pages) so that
+ * it also includes the last byte of the range.  Such an extended window
+ * is an ordinary window as far as mapByte() is concerned, so subsequent
+ * accesses within it will not remap.
+ * 
+ * pos must be greater than or equal to zero, len must be in range [1,
+ * AKSVIEW_MAXSPAN], and the range must be entirely within the file or
+ * a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first byte of the range
+ * 
+ *   len - the length of the range in bytes
+ */
+static void mapRange(AKSVIEW *pv, int64_t pos, int32_t len) {
+  
+  int64_t w = 0;
+  int64_t ws = 0;
+  int64_t pend = 0;
+  
+  /* Check parameters */
+  checkFull(pv != NULL);
+  checkBound((len >= 1) && (len <= AKSVIEW_MAXSPAN));
+  checkBound((pos >= 0) && (pos <= pv->flen - ((int64_t) len)));
+  
+  /* Compute the file offset immediately after the range */
+  pend = pos + ((int64_t) len);
+  
+  /* Only proceed if range not currently mapped */
+  if ((pos < pv->wfirst) || (pend - 1 > pv->wlast)) {
+    
+    /* We need to change the view so first of all unmap any view that
+     * may be mapped */
+    profEnter(pv, AKSVIEW_PROF_MAP);
+    unview(pv);
+    
+    /* Figure out which window the first byte is in and get its starting
+     * offset */
+    w = pos / ((int64_t) pv->wlen);
+    w = w * ((int64_t) pv->wlen);
+    
+    /* Start with the regular window size */
+    ws = (int64_t) pv->wlen;
+    
+    /* If the range goes beyond the regular window, extend the window to
+     * the next page boundary after the range */
+    if (pend > w + ws) {
+      ws = pend - w;
+      if ((ws % ((int64_t) pv->pgsize)) != 0) {
+        ws = ws / ((int64_t) pv->pgsize);
+        ws++;
+        ws = ws * ((int64_t) pv->pgsize);
+      }
+    }
+    
+    /* Do not let the window go past the end of the file */
+    if (ws > pv->flen - w) {
+      ws = pv->flen - w;
+    }
+    
+    /* Map the window */
+    mapAt(pv, w, ws);
+    profLeave(pv, AKSVIEW_PROF_MAP);
+  }
+}
+
+/*
+ * Determine how many bytes of a range can be processed starting at a
+ * given file offset without crossing a window boundary.
+ * 
+ * This is used to decompose bulk operations into pieces that each fit
+ * within a regular window, so that mapRange() never has to extend a
+ * window for them.
+ * 
+ * pos must be in range [0, flen - 1] and remain must be at least one,
+ * or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the start of the piece
+ * 
+ *   remain - the number of bytes remaining in the whole operation
+ * 
+ * Return:
+ * 
+ *   the length of the piece, in range [1, remain]
+ */
+static int32_t chunkLen(AKSVIEW *pv, int64_t pos, int64_t remain) {
+  
+  int64_t wend = 0;
+  
+  /* Check parameters */
+  checkFull(pv != NULL);
+  checkFull((pos >= 0) && (pos < pv->flen) && (remain >= 1));
+  
+  /* Figure out the file offset immediately after the window that
+   * contains pos */
+  wend = pos / ((int64_t) pv->wlen);
+  wend = (wend + 1) * ((int64_t) pv->wlen);
+  
+  /* Limit the remaining length to the end of the window */
+  if (remain > wend - pos) {
+    remain = wend - pos;
+  }
+  
+  /* Return result */
+  return (int32_t) remain;
+}
+
+/*
+ * Reverse the byte order of each element in an array.
+ * 
+ * Parameters:
+ * 
+ *   pb - the array
+ * 
+ *   n - the number of elements
+ * 
+ *   w - the width of each element in bytes, which must be 2, 4, or 8
+ */
+static void swapElements(uint8_t *pb, int64_t n, int32_t w) {
+  
+  int64_t i = 0;
+  int32_t j = 0;
+  uint8_t t = 0;
+  
+  /* Check parameters */
+  if ((pb == NULL) || (n < 0) || ((w != 2) && (w != 4) && (w != 8))) {
+    fault(__LINE__);
+  }
+  
+  /* Swap each element by exchanging bytes from both ends */
+  for(i = 0; i < n; i++) {
+    for(j = 0; j < w / 2; j++) {
+      t = pb[j];
+      pb[j] = pb[w - 1 - j];
+      pb[w - 1 - j] = t;
+    }
+    pb += w;
+  }
+}
+
+/*
+ * Load an array of elements from a viewer.
+ * 
+ * This is the shared implementation of the aksview_readv functions.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first element
+ * 
+ *   le - non-zero for little endian, zero for big endian
+ * 
+ *   pa - the array to load into
+ * 
+ *   n - the number of elements
+ * 
+ *   w - the width of each element in bytes, which must be 2, 4, or 8
+ */
+static void bulkRead(
+    AKSVIEW *pv, int64_t pos, int le, void *pa, int64_t n, int32_t w) {
+  
+  /* Check parameters */
+  if ((pv == NULL) || (pa == NULL) || (n < 0)) {
+    fault(__LINE__);
+  }
+  if ((w != 2) && (w != 4) && (w != 8)) {
+    fault(__LINE__);
+  }
+  if (n > AKSVIEW_MAXLEN / w) {
+    fault(__LINE__);
+  }
+  
+  /* If le parameter is non-zero, replace it with FLAG_LE so we can do
+   * an XOR check later */
+  if (le) {
+    le = FLAG_LE;
+  }
+  
+  /* Copy the raw bytes, which also checks the range */
+  profEnter(pv, AKSVIEW_PROF_BULK);
+  aksview_readbuf(pv, pos, pa, n * w);
+  
+  /* Swap if platform endianness and requested endianness are
+   * different */
+  if ((le ^ pv->flags) & FLAG_LE) {
+    swapElements((uint8_t *) pa, n, w);
+  }
+  profLeave(pv, AKSVIEW_PROF_BULK);
+}
+
+/*
+ * Store an array of elements into a viewer.
+ * 
+ * This is the shared implementation of the aksview_writev functions.
+ * If byte swapping is required, the elements are swapped in a small
+ * temporary buffer so the caller's array is not modified.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first element
+ * 
+ *   le - non-zero for little endian, zero for big endian
+ * 
+ *   pa - the array to store from
+ * 
+ *   n - the number of elements
+ * 
+ *   w - the width of each element in bytes, which must be 2, 4, or 8
+ */
+static void bulkWrite(
+    AKSVIEW    * pv,
+    int64_t      pos,
+    int          le,
+    const void * pa,
+    int64_t      n,
+    int32_t      w) {
+  
+  uint8_t buf[4096];
+  const uint8_t *pb = NULL;
+  int64_t k = 0;
+  
+  /* Check parameters */
+  if ((pv == NULL) || (pa == NULL) || (n < 0)) {
+    fault(__LINE__);
+  }
+  if ((w != 2) && (w != 4) && (w != 8)) {
+    fault(__LINE__);
+  }
+  if (n > AKSVIEW_MAXLEN / w) {
+    fault(__LINE__);
+  }
+  
+  /* If le parameter is non-zero, replace it with FLAG_LE so we can do
+   * an XOR check later */
+  if (le) {
+    le = FLAG_LE;
+  }
+  
+  /* Different handling depending on whether swapping is required */
+  profEnter(pv, AKSVIEW_PROF_BULK);
+  if ((le ^ pv->flags) & FLAG_LE) {
+    /* Swap through the temporary buffer, one buffer at a time */
+    pb = (const uint8_t *) pa;
+    while (n > 0) {
+      k = n;
+      if (k > ((int64_t) sizeof(buf)) / w) {
+        k = ((int64_t) sizeof(buf)) / w;
+      }
+      memcpy(buf, pb, (size_t) (k * w));
+      swapElements(buf, k, w);
+      aksview_writebuf(pv, pos, buf, k * w);
+      
+      pb += k * w;
+      pos += k * w;
+      n -= k;
+    }
+    
+  } else {
+    /* No swapping, so copy the raw bytes directly */
+    aksview_writebuf(pv, pos, pa, n * w);
+  }
+  profLeave(pv, AKSVIEW_PROF_BULK);
+}
+
+/*
+ * (POSIX only) Apply a record lock request to the file of a viewer.
+ * 
+ * Open file description locks are used where available, so that locks
+ * belong to the viewer rather than to the whole process.  If they are
+ * not declared, or the kernel does not support them, classic process
+ * record locks are used instead.  Interrupted calls are retried.
+ * 
+ * The l_pid field of the request must be zero.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer
+ * 
+ *   pfl - the lock request
+ * 
+ *   wait - non-zero to block until the request can be granted
+ * 
+ * Return:
+ * 
+ *   zero if successful, otherwise the errno value of the failure
+ */
+#ifdef AKS_POSIX
+static int lockRange(AKSVIEW *pv, struct flock *pfl, int wait) {
+  
+  int result = 0;
+  
+  /* Check parameters */
+  if ((pv == NULL) || (pfl == NULL)) {
+    fault(__LINE__);
+  }
+  
+  /* Issue the request, retrying if interrupted by a signal */
+  do {
+    result = 0;
+#ifdef F_OFD_SETLK
+    if (fcntl(pv->fh, wait ? F_OFD_SETLKW : F_OFD_SETLK, pfl) == -1) {
+      result = errno;
+    }
+    if (result == EINVAL) {
+      result = 0;
+      if (fcntl(pv->fh, wait ? F_SETLKW : F_SETLK, pfl) == -1) {
+        result = errno;
+      }
+    }
+#else
+    if (fcntl(pv->fh, wait ? F_SETLKW : F_SETLK, pfl) == -1) {
+      result = errno;
+    }
+#endif
+  } while (result == EINTR);
+  
+  /* Return result */
+  return result;
+}
+#endif
+
+/*
+ * Open the performance counters for profiling.
+ * 
+ * Every counter that the system supports is opened for the calling
+ * thread, in a single group.  Kernel events are counted too if the
+ * system allows it for the leader of the group, and then for every
+ * other counter as well.  Counters that cannot be opened are skipped.
+ * 
+ * The group is read with the times that it was enabled and running, so
+ * that counts can be scaled when the kernel multiplexes the counters.
+ * 
+ * On platforms other than Linux, no counters are opened.
+ * 
+ * Parameters:
+ * 
+ *   ps - the profiling state, which must not have any open counters
+ */
+static void profOpen(PROF_STATE *ps) {
+  
+  int i = 0;
+#ifdef PROF_PERF
+  struct perf_event_attr attr;
+  uint32_t type = 0;
+  uint64_t config = 0;
+  int k = 0;
+  int kfirst = 0;
+  int klast = 0;
+  int kern = 0;
+  int fd = -1;
+#endif
+  
+  /* Check parameter */
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Start with no counters */
+  for(i = 0; i < PROF_NCTR; i++) {
+    (ps->slot)[i] = -1;
+  }
+  ps->nslot = 0;
+  ps->kernel = 0;
+  
+#ifdef PROF_PERF
+  for(i = 0; i < PROF_NCTR; i++) {
+    (ps->fd)[i] = -1;
+  }
+  ps->lead = -1;
+  
+  /* Open each counter, with the first one that opens as the leader of
+   * the group */
+  for(i = 0; i < PROF_NCTR; i++) {
+    if (i == 0) {
+      type = PERF_TYPE_HARDWARE;
+      config = PERF_COUNT_HW_CPU_CYCLES;
+    } else if (i == 1) {
+      type = PERF_TYPE_HARDWARE;
+      config = PERF_COUNT_HW_INSTRUCTIONS;
+    } else if (i == 2) {
+      type = PERF_TYPE_HARDWARE;
+      config = PERF_COUNT_HW_CACHE_MISSES;
+    } else if (i == 3) {
+      type = PERF_TYPE_HW_CACHE;
+      config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    } else {
+      type = PERF_TYPE_SOFTWARE;
+      config = PERF_COUNT_SW_PAGE_FAULTS;
+    }
+    
+    /* Until the leader is open, try with kernel events first, then
+     * without; after that, only try the way the leader was opened */
+    kfirst = 0;
+    klast = 1;
+    if (ps->lead >= 0) {
+      kfirst = (ps->kernel) ? 0 : 1;
+      klast = kfirst;
+    }
+    
+    fd = -1;
+    for(k = kfirst; (k <= klast) && (fd == -1); k++) {
+      memset(&attr, 0, sizeof(struct perf_event_attr));
+      attr.size = sizeof(struct perf_event_attr);
+      attr.type = type;
+      attr.config = config;
+      attr.read_format = PERF_FORMAT_GROUP |
+                          PERF_FORMAT_TOTAL_TIME_ENABLED |
+                          PERF_FORMAT_TOTAL_TIME_RUNNING;
+      attr.exclude_hv = 1;
+      kern = 1;
+      if (k > 0) {
+        attr.exclude_kernel = 1;
+        kern = 0;
+      }
+      
+      fd = (int) syscall(
+                  SYS_perf_event_open,
+                  &attr,
+                  0,
+                  -1,
+                  (ps->lead >= 0) ? (ps->fd)[ps->lead] : -1,
+                  0UL);
+    }
+    
+    if (fd != -1) {
+      (ps->fd)[i] = fd;
+      if (ps->lead < 0) {
+        ps->lead = i;
+        ps->kernel = kern;
+      }
+      (ps->slot)[i] = ps->nslot;
+      (ps->nslot)++;
+    }
+  }
+#endif
+}
+
+/*
+ * Close the performance counters for profiling.
+ * 
+ * The statistics are not changed.
+ * 
+ * Parameters:
+ * 
+ *   ps - the profiling state
+ */
+static void profClose(PROF_STATE *ps) {
+  
+  int i = 0;
+  
+  /* Check parameter */
+  if (ps == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Close the members of the group before the leader */
+#ifdef PROF_PERF
+  for(i = PROF_NCTR - 1; i >= 0; i--) {
+    if ((ps->fd)[i] != -1) {
+      if (close((ps->fd)[i])) {
+        warn(__LINE__);
+      }
+      (ps->fd)[i] = -1;
+    }
+  }
+  ps->lead = -1;
+#endif
+  
+  /* Mark every counter as closed */
+  for(i = 0; i < PROF_NCTR; i++) {
+    (ps->slot)[i] = -1;
+  }
+  ps->nslot = 0;
+}
+
+/*
+ * Read the current values of the performance counters.
+ * 
+ * Counters that are not open read as zero, and so do the times if no
+ * counter is open.
+ * 
+ * Parameters:
+ * 
+ *   ps - the profiling state
+ * 
+ *   pc - the array of PROF_NCTR values to receive the counters
+ * 
+ *   pt - the array of two values to receive the times in nanoseconds
+ *   that the group has been enabled and running
+ */
+static void profRead(PROF_STATE *ps, uint64_t *pc, uint64_t *pt) {
+  
+  int i = 0;
+#ifdef PROF_PERF
+  uint64_t buf[PROF_NCTR + 3];
+  ssize_t r = 0;
+#endif
+  
+  /* Check parameters */
+  if ((ps == NULL) || (pc == NULL) || (pt == NULL)) {
+    fault(__LINE__);
+  }
+  
+  /* Clear the values */
+  for(i = 0; i < PROF_NCTR; i++) {
+    pc[i] = 0;
+  }
+  pt[0] = 0;
+  pt[1] = 0;
+  
+  /* Read the whole group from the leader, which gives the number of
+   * counters, the enabled and running times, and then their values */
+#ifdef PROF_PERF
+  if (ps->nslot > 0) {
+    r = read((ps->fd)[ps->lead], buf, sizeof(buf));
+    if ((r < (ssize_t) (((size_t) (ps->nslot + 3)) * sizeof(uint64_t))) ||
+        (buf[0] != (uint64_t) ps->nslot)) {
+      warn(__LINE__);
+    } else {
+      pt[0] = buf[1];
+      pt[1] = buf[2];
+      for(i = 0; i < PROF_NCTR; i++) {
+        if ((ps->slot)[i] >= 0) {
+          pc[i] = buf[(ps->slot)[i] + 3];
+        }
+      }
+    }
+  }
+#endif
+}
+
+/*
+ * Start measuring an operation on a viewer.
+ * 
+ * Nothing is done unless profiling is enabled.  Each call must be
+ * matched by a call to profLeave() with the same operation type.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer
+ * 
+ *   op - the AKSVIEW_PROF_ operation type
+ */
+static void profEnter(AKSVIEW *pv, int op) {
+  
+  PROF_STATE *ps = NULL;
+  
+  /* Only proceed if profiling is enabled */
+  ps = pv->pProf;
+  if ((ps != NULL) && (ps->nslot > 0)) {
+    
+    /* Read the starting values unless nested in the same type */
+    if ((ps->depth)[op] < 1) {
+      profRead(ps, (ps->base)[op], (ps->tbase)[op]);
+    }
+    ((ps->depth)[op])++;
+  }
+}
+
+/*
+ * Finish measuring an operation on a viewer, and add the differences in
+ * the counters to the statistics of the operation type.
+ * 
+ * If the kernel multiplexed the group with other counters during the
+ * operation, so that it ran for only part of the time it was enabled,
+ * the differences are scaled up in proportion.  If the group never ran
+ * during the operation, nothing can be estimated, and the operation is
+ * only counted as missed.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer
+ * 
+ *   op - the AKSVIEW_PROF_ operation type
+ */
+static void profLeave(AKSVIEW *pv, int op) {
+  
+  PROF_STATE *ps = NULL;
+  uint64_t now[PROF_NCTR];
+  uint64_t tnow[2];
+  uint64_t en = 0;
+  uint64_t run = 0;
+  uint64_t d = 0;
+  int i = 0;
+  
+  /* Only proceed if profiling is enabled and the operation is being
+   * measured */
+  ps = pv->pProf;
+  if ((ps != NULL) && (ps->nslot > 0) && ((ps->depth)[op] > 0)) {
+    
+    /* Only the outermost operation of a type is counted */
+    ((ps->depth)[op])--;
+    if ((ps->depth)[op] < 1) {
+      profRead(ps, now, tnow);
+      en = tnow[0] - (ps->tbase)[op][0];
+      run = tnow[1] - (ps->tbase)[op][1];
+      (ps->enabled)[op] += (int64_t) en;
+      (ps->running)[op] += (int64_t) run;
+      
+      if ((run > 0) || (en < 1)) {
+        for(i = 0; i < PROF_NCTR; i++) {
+          if ((ps->slot)[i] >= 0) {
+            d = now[i] - (ps->base)[op][i];
+            if (run < en) {
+              d = (uint64_t) (((double) d) * ((double) en) / ((double) run));
+            }
+            (ps->sum)[op][i] += (int64_t) d;
+          }
+        }
+      } else {
+        ((ps->missed)[op])++;
+      }
+      ((ps->calls)[op])++;
+    }
+  }
+}
+
+/*
+ * (Warm-start platforms only) Count a window mapping in the chunk
+ * mapping counts of a viewer.
+ * 
+ * The counts array is enlarged as needed.  Counts saturate at
+ * INT32_MAX.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer
+ * 
+ *   w - the file offset of the window
+ * 
+ *   ws - the length of the window in bytes
+ */
+#ifdef WARM_PREFETCH
+static void warmCount(AKSVIEW *pv, int64_t w, int64_t ws) {
+  
+  int64_t first = 0;
+  int64_t last = 0;
+  int64_t ncap = 0;
+  int64_t i = 0;
+  int32_t *pNew = NULL;
+  
+  /* Check parameters */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if ((w < 0) || (ws < 1) || (w > AKSVIEW_MAXLEN - ws)) {
+    fault(__LINE__);
+  }
+  
+  /* Determine the range of chunks that the window covers */
+  first = w / WARM_CHUNK;
+  last = (w + ws - 1) / WARM_CHUNK;
+  
+  /* Enlarge the counts array if necessary, at least doubling it */
+  if (last >= pv->nheat) {
+    ncap = pv->nheat * 2;
+    if (ncap <= last) {
+      ncap = last + 1;
+    }
+    pNew = (int32_t *) realloc(
+                        pv->pHeat, ((size_t) ncap) * sizeof(int32_t));
+    if (pNew == NULL) {
+      fault(__LINE__);
+    }
+    memset(
+      pNew + pv->nheat,
+      0,
+      ((size_t) (ncap - pv->nheat)) * sizeof(int32_t));
+    pv->pHeat = pNew;
+    pv->nheat = ncap;
+  }
+  
+  /* Count the mapping in each chunk */
+  for(i = first; i <= last; i++) {
+    if ((pv->pHeat)[i] < INT32_MAX) {
+      ((pv->pHeat)[i])++;
+    }
+  }
+}
+#endif
+
+/*
+ * (Warm-start platforms only) Compare two chunks for qsort(), so that
+ * they are ordered hottest first, and by file offset for equal counts.
+ * 
+ * Parameters:
+ * 
+ *   pA - the first WARM_ORD
+ * 
+ *   pB - the second WARM_ORD
+ * 
+ * Return:
+ * 
+ *   less than, equal to, or greater than zero as the first chunk goes
+ *   before, with, or after the second
+ */
+#ifdef WARM_PREFETCH
+static int warmCmp(const void *pA, const void *pB) {
+  
+  const WARM_ORD *pa = (const WARM_ORD *) pA;
+  const WARM_ORD *pb = (const WARM_ORD *) pB;
+  int result = 0;
+  
+  if (pa->heat != pb->heat) {
+    if (pa->heat > pb->heat) {
+      result = -1;
+    } else {
+      result = 1;
+    }
+  } else if (pa->idx != pb->idx) {
+    if (pa->idx < pb->idx) {
+      result = -1;
+    } else {
+      result = 1;
+    }
+  }
+  
+  return result;
+}
+#endif
+
+/*
+ * (Warm-start platforms only) Append a range to a profile file that is
+ * being written.
+ * 
+ * If the range continues the last range in the file, that range is
+ * extended instead, so that neighbouring chunks of the same heat take
+ * only one range.
+ * 
+ * Parameters:
+ * 
+ *   pw - the viewer on the profile file
+ * 
+ *   prpos - the file offset to append at, which is advanced past the
+ *   new range
+ * 
+ *   pos - the file offset of the range in the viewed file
+ * 
+ *   len - the length of the range in bytes
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the profile file could not be
+ *   enlarged
+ */
+#ifdef WARM_PREFETCH
+static int warmPut(AKSVIEW *pw, int64_t *prpos, int64_t pos, int64_t len) {
+  
+  int status = 1;
+  int merged = 0;
+  int64_t lpos = 0;
+  int64_t llen = 0;
+  
+  /* Check parameters */
+  if ((pw == NULL) || (prpos == NULL)) {
+    fault(__LINE__);
+  }
+  if ((*prpos < WARM_HDR) || (*prpos > AKSVIEW_MAXLEN - WARM_REC)) {
+    fault(__LINE__);
+  }
+  
+  /* Extend the last range if this one continues it */
+  if (*prpos > WARM_HDR) {
+    lpos = aksview_read64s(pw, *prpos - WARM_REC, 1);
+    llen = aksview_read64s(pw, *prpos - WARM_REC + 8, 1);
+    if (lpos + llen == pos) {
+      aksview_write64s(pw, *prpos - WARM_REC + 8, 1, llen + len);
+      merged = 1;
+    }
+  }
+  
+  /* Otherwise, make room for the range, then write it */
+  if (!merged) {
+    if (!aksview_reserve(pw, *prpos + WARM_REC)) {
+      status = 0;
+    }
+  }
+  if (status && (!merged)) {
+    aksview_write64s(pw, *prpos, 1, pos);
+    aksview_write64s(pw, *prpos + 8, 1, len);
+    *prpos += WARM_REC;
+  }
+  
+  /* Return status */
+  return status;
+}
+#endif
+
+/*
+ * (Warm-start platforms only) Write the warm-start profile of a viewer.
+ * 
+ * The chunks that have been mapped at least once are ordered hottest
+ * first.  On Linux, the runs of pages of each chunk that are in the
+ * page cache are written as ranges.  Elsewhere, or if residency cannot
+ * be determined, each chunk is written whole.
+ * 
+ * If no chunk has been mapped, any existing profile is left alone.  If
+ * the profile cannot be written, a warning is issued.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer, which must keep a profile
+ */
+#ifdef WARM_PREFETCH
+static void warmSave(AKSVIEW *pv) {
+  
+  int status = 1;
+  int whole = 0;
+  WARM_ORD *pOrd = NULL;
+  AKSVIEW *pw = NULL;
+  int64_t nord = 0;
+  int64_t i = 0;
+  int64_t cs = 0;
+  int64_t ce = 0;
+  int64_t rpos = WARM_HDR;
+#ifdef WARM_MINCORE
+  unsigned char *pVec = NULL;
+  void *pMap = NULL;
+  int64_t pg = 0;
+  int64_t np = 0;
+  int64_t run = 0;
+  int64_t j = 0;
+#endif
+  
+  /* Check parameter */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if (pv->pWarmPath == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if any chunk has been mapped */
+  for(i = 0; i < pv->nheat; i++) {
+    if ((pv->pHeat)[i] > 0) {
+      nord++;
+    }
+  }
+  if (nord < 1) {
+    status = 0;
+  }
+  
+  /* Order the mapped chunks, hottest first */
+  if (status) {
+    pOrd = (WARM_ORD *) malloc(((size_t) nord) * sizeof(WARM_ORD));
+    if (pOrd == NULL) {
+      fault(__LINE__);
+    }
+    nord = 0;
+    for(i = 0; i < pv->nheat; i++) {
+      if ((pv->pHeat)[i] > 0) {
+        pOrd[nord].idx = i;
+        pOrd[nord].heat = (pv->pHeat)[i];
+        nord++;
+      }
+    }
+    qsort(pOrd, (size_t) nord, sizeof(WARM_ORD), &warmCmp);
+  }
+  
+  /* Open the profile file, discarding the old profile, and reserve the
+   * header */
+  if (status) {
+    pw = aksview_create(pv->pWarmPath, AKSVIEW_REGULAR, NULL);
+    if (pw == NULL) {
+      status = 0;
+      warn(__LINE__);
+    }
+  }
+  if (status) {
+    if ((!aksview_setlen(pw, 0)) || (!aksview_reserve(pw, WARM_HDR))) {
+      status = 0;
+      warn(__LINE__);
+    }
+  }
+  
+  /* (Linux only) Allocate the residency vector for one chunk, if chunks
+   * are whole pages */
+#ifdef WARM_MINCORE
+  pg = (int64_t) pv->pgsize;
+  if (status && ((WARM_CHUNK % pg) == 0)) {
+    pVec = (unsigned char *) malloc((size_t) (WARM_CHUNK / pg));
+    if (pVec == NULL) {
+      fault(__LINE__);
+    }
+  }
+#endif
+  
+  /* Write the ranges of each chunk, skipping chunks past the end of a
+   * file that has shrunk */
+  for(i = 0; status && (i < nord); i++) {
+    cs = pOrd[i].idx * WARM_CHUNK;
+    if (cs >= pv->flen) {
+      continue;
+    }
+    ce = cs + WARM_CHUNK;
+    if (ce > pv->flen) {
+      ce = pv->flen;
+    }
+    whole = 1;
+    
+    /* (Linux only) Map the chunk to find which of its pages are
+     * resident, and write the runs of resident pages */
+#ifdef WARM_MINCORE
+    if (pVec != NULL) {
+      pMap = mmap(
+              (void *) 0,
+              (size_t) (ce - cs),
+              PROT_READ,
+              MAP_SHARED,
+              pv->fh,
+              (off_t) cs);
+      if (pMap != MAP_FAILED) {
+        if (mincore(pMap, (size_t) (ce - cs), pVec) == 0) {
+          whole = 0;
+          np = ((ce - cs) + pg - 1) / pg;
+          run = -1;
+          for(j = 0; status && (j <= np); j++) {
+            if ((j < np) && (pVec[j] & 1)) {
+              if (run < 0) {
+                run = j;
+              }
+            } else if (run >= 0) {
+              if ((cs + (j * pg)) < ce) {
+                status = warmPut(pw, &rpos, cs + (run * pg), (j - run) * pg);
+              } else {
+                status = warmPut(pw, &rpos, cs + (run * pg),
+                                  ce - (cs + (run * pg)));
+              }
+              run = -1;
+            }
+          }
+        }
+        if (munmap(pMap, (size_t) (ce - cs))) {
+          warn(__LINE__);
+        }
+      }
+    }
+#endif
+    
+    /* Otherwise, write the whole chunk */
+    if (whole) {
+      status = warmPut(pw, &rpos, cs, ce - cs);
+    }
+    
+    if (!status) {
       warn(__LINE__);
     }
-#else
-    if (munmap(pv->pw, (size_t) (pv->wlast - pv->wfirst + 1))) {
+  }
+  
+  /* Trim the profile file and write the header, with the magic number
+   * last */
+  if (status) {
+    if (!aksview_setlen(pw, rpos)) {
+      status = 0;
       warn(__LINE__);
     }
+  }
+  if (status) {
+    aksview_write64s(pw, 8, 1, pv->flen);
+    aksview_write64s(pw, 16, 1, (rpos - WARM_HDR) / WARM_REC);
+    aksview_flush(pw);
+    aksview_write64u(pw, 0, 1, WARM_MAGIC);
+  }
+  
+  /* Release resources */
+  aksview_close(pw);
+#ifdef WARM_MINCORE
+  if (pVec != NULL) {
+    free(pVec);
+    pVec = NULL;
+  }
 #endif
-
-    /* Update structure */
-    pv->pw = NULL;
-    pv->wfirst = -1;
-    pv->wlast = -1;
+  if (pOrd != NULL) {
+    free(pOrd);
+    pOrd = NULL;
   }
 }
+#endif
 
 /*
- * Ensure that a window is mapped in the given viewer that includes the
- * given byte offset.
- * 
- * If there is currently a window mapped that includes the byte, this
- * function does nothing.  If there is currently a window mapped but it
- * doesn't include the byte, the window is unmapped and a window
- * including the byte is mapped.  If there is no current window mapped,
- * a window including the byte is mapped.
- * 
- * b must be greater than or equal to zero and less than the file length
- * or a fault occurs.
+ * (Warm-start platforms only) Prefetch the ranges listed in the
+ * warm-start profile of a viewer.
  * 
- * Windows are always aligned to at least eight-byte boundaries, so any
- * aligned integer up to 64-bit size that includes b will be fully
- * contained within the window.
+ * The ranges are handed to posix_fadvise() in profile order, which
+ * starts reading them in the background.  Ranges are clipped to the
+ * current length of the file.  If there is no valid profile, nothing
+ * is done.
  * 
  * Parameters:
  * 
- *   pv - the viewer object
- * 
- *   b - the byte offset to map
+ *   pv - the viewer, which must keep a profile
  */
-static void mapByte(AKSVIEW *pv, int64_t b) {
+#ifdef WARM_PREFETCH
+static void warmLoad(AKSVIEW *pv) {
   
-  int64_t w = 0;
-  int64_t r = 0;
-  int32_t ws = 0;
+  AKSVIEW *pr = NULL;
+  int64_t plen = 0;
+  int64_t n = 0;
+  int64_t i = 0;
+  int64_t pos = 0;
+  int64_t len = 0;
   
-  /* Check parameters */
+  /* Check parameter */
   if (pv == NULL) {
     fault(__LINE__);
   }
-  if ((b < 0) || (b >= pv->flen)) {
+  if (pv->pWarmPath == NULL) {
     fault(__LINE__);
   }
   
-  /* Only proceed if byte not currently mapped */
-  if ((b < pv->wfirst) || (b > pv->wlast)) {
-    
-    /* We need to change the view so first of all unmap any view that
-     * may be mapped */
-    unview(pv);
-    
-    /* Figure out which window the byte is in and get its starting
-     * offset */
-    w = b / ((int64_t) pv->wlen);
-    w = w * ((int64_t) pv->wlen);
-    
-    /* Figure out how much remains in the file starting at this
-     * window */
-    r = pv->flen - w;
-    
-    /* Start with a window size equal to the computed window size */
-    ws = pv->wlen;
-    
-    /* If remainder is less than window size, set adjusted window size
-     * to remainder so we don't go past the end of the file */
-    if (r < ws) {
-      ws = (int32_t) r;
-    }
-    
-    /* (Windows only) If no current file mapping object, open one */
-#ifdef AKS_WIN
-    if (pv->fh_map == NULL) {
-      if (pv->flags & FLAG_RO)
-        pv->fh_map = CreateFileMapping(
-                      pv->fh,
-                      NULL,
-                      PAGE_READONLY,
-                      0,
-                      0,
-                      NULL);
-      } else {
-        pv->fh_map = CreateFileMapping(
-                      pv->fh,
-                      NULL,
-                      PAGE_READWRITE,
-                      0,
-                      0,
-                      NULL);
+  /* Only proceed if there is a profile whose header and length agree */
+  pr = aksview_create(pv->pWarmPath, AKSVIEW_READONLY, NULL);
+  if (pr != NULL) {
+    plen = aksview_getlen(pr);
+    if (plen >= WARM_HDR) {
+      if (aksview_read64u(pr, 0, 1) == WARM_MAGIC) {
+        n = aksview_read64s(pr, 16, 1);
       }
-      if (pv->fh_map == NULL) {
-        fault(__LINE__);
+      if ((n < 0) || (n != (plen - WARM_HDR) / WARM_REC) ||
+          (((plen - WARM_HDR) % WARM_REC) != 0)) {
+        n = 0;
       }
     }
-#endif
-
-    /* Map the window */
-#ifdef AKS_POSIX
-    if (pv->flags & FLAG_RO) {
-      pv->pw = (uint8_t *) mmap(
-                            (void *) 0,
-                            (size_t) ws,
-                            PROT_READ,
-                            MAP_PRIVATE,
-                            pv->fh,
-                            (off_t) w);
-    } else {
-      pv->pw = (uint8_t *) mmap(
-                            (void *) 0,
-                            (size_t) ws,
-                            PROT_READ | PROT_WRITE,
-                            MAP_SHARED,
-                            pv->fh,
-                            (off_t) w);
-    }
-    if (pv->pw == MAP_FAILED) {
-      fault(__LINE__);
-    }
-#else
-    if (pv->flags & FLAG_RO) {
-      pv->pw = (uint8_t *) MapViewOfFile(
-                            pv->fh_map,
-                            FILE_MAP_READ,
-                            (DWORD) (w >> 32),
-                            (DWORD) (w & INT64_C(0xffffffff)),
-                            (SIZE_T) ws);
-    } else {
-      pv->pw = (uint8_t *) MapViewOfFile(
-                            pv->fh_map,
-                            FILE_MAP_READ | FILE_MAP_WRITE,
-                            (DWORD) (w >> 32),
-                            (DWORD) (w & INT64_C(0xffffffff)),
-                            (SIZE_T) ws);
-    }
-    if (pv->pw == NULL) {
-      fault(__LINE__);
+    
+    /* Start reading each range that is still within the file */
+    for(i = 0; i < n; i++) {
+      pos = aksview_read64s(pr, WARM_HDR + (i * WARM_REC), 1);
+      len = aksview_read64s(pr, WARM_HDR + (i * WARM_REC) + 8, 1);
+      if ((pos >= 0) && (pos < pv->flen) && (len > 0)) {
+        if (len > pv->flen - pos) {
+          len = pv->flen - pos;
+        }
+        posix_fadvise(pv->fh, (off_t) pos, (off_t) len, POSIX_FADV_WILLNEED);
+      }
     }
-#endif
     
-    /* Update the window boundaries */
-    pv->wfirst = w;
-    pv->wlast = (w - 1) + ((int64_t) ws);
+    aksview_close(pr);
   }
 }
+#endif
 
 /*
  * Public function implementations
@@ -713,6 +2481,10 @@ const char *aksview_errstr(int code) {
       pResult = "Failed to query length of file";
       break;
     
+    case AKSVIEW_ERR_READ:
+      pResult = "Failed to read file contents";
+      break;
+    
     default:
       pResult = "Unknown error";
   }
@@ -727,11 +2499,16 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
   
   int status = 1;
   int dummy = 0;
+  int slurp = 0;
   AKSVIEW *pv = NULL;
 #ifdef AKS_POSIX
   int m = 0;
 #endif
+#ifdef WARM_PREFETCH
+  int warm = 0;
+#endif
 #ifdef AKS_WIN
+  int share = 0;
   DWORD da = 0;
   DWORD shm = 0;
   DWORD cdp = 0;
@@ -753,6 +2530,29 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
   /* Reset error return code */
   *perr = AKSVIEW_ERR_NONE;
   
+  /* Split off the slurp flag */
+  if (mode & AKSVIEW_SLURP) {
+    slurp = 1;
+    mode &= ~AKSVIEW_SLURP;
+  }
+  
+  /* Split off the share flag, which only matters on Windows */
+  if (mode & AKSVIEW_SHARE) {
+#ifdef AKS_WIN
+    share = 1;
+#endif
+    mode &= ~AKSVIEW_SHARE;
+  }
+  
+  /* Split off the warm-start flag, which only matters where profiles
+   * can be prefetched */
+  if (mode & AKSVIEW_WARM) {
+#ifdef WARM_PREFETCH
+    warm = 1;
+#endif
+    mode &= ~AKSVIEW_WARM;
+  }
+  
   /* Check that mode is recognized */
   if ((mode != AKSVIEW_READONLY) &&
       (mode != AKSVIEW_EXISTING) &&
@@ -796,8 +2596,15 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
     pv->hint = AKSVIEW_DEFAULT_HINT;
     pv->wlen = -1;
     pv->pw = NULL;
+    pv->scap = 0;
     pv->wfirst = -1;
     pv->wlast = -1;
+    pv->pProf = NULL;
+#ifdef WARM_PREFETCH
+    pv->pWarmPath = NULL;
+    pv->pHeat = NULL;
+    pv->nheat = 0;
+#endif
   }
   
   /* Set flags based on open mode and platform endianness */
@@ -890,6 +2697,11 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
       /* Shouldn't happen */
       fault(__LINE__);
     }
+    
+    /* Let other handles read and write the file if sharing */
+    if (share) {
+      shm = FILE_SHARE_READ | FILE_SHARE_WRITE;
+    }
 
     /* Open the file */
 #ifdef AKS_WIN_WAPI
@@ -934,6 +2746,32 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
     computeWindow(pv);
   }
   
+  /* If requested and the file is small enough, read it all into a
+   * buffer */
+  if (status && slurp && (pv->flen <= AKSVIEW_SLURPMAX)) {
+    if (!slurpLoad(pv)) {
+      status = 0;
+      *perr = AKSVIEW_ERR_READ;
+    }
+  }
+  
+  /* If keeping a warm-start profile, work out its path and prefetch
+   * what it lists, unless the whole file has just been read anyway */
+#ifdef WARM_PREFETCH
+  if (status && warm) {
+    pv->pWarmPath = (char *) malloc(strlen(pPath) + 6);
+    if (pv->pWarmPath == NULL) {
+      fault(__LINE__);
+    }
+    strcpy(pv->pWarmPath, pPath);
+    strcat(pv->pWarmPath, ".warm");
+    
+    if (!(pv->flags & FLAG_SL)) {
+      warmLoad(pv);
+    }
+  }
+#endif
+  
   /* (Windows Unicode only) Free translated path if allocated */
 #ifdef AKS_WIN_WAPI
   if (pPathTrans != NULL) {
@@ -954,6 +2792,14 @@ AKSVIEW *aksview_create(const char *pPath, int mode, int *perr) {
       }
 #endif
 
+      /* (Warm-start platforms only) Free profile path if allocated */
+#ifdef WARM_PREFETCH
+      if (pv->pWarmPath != NULL) {
+        free(pv->pWarmPath);
+        pv->pWarmPath = NULL;
+      }
+#endif
+
       /* Close file handle if open */
 #ifdef AKS_WIN
       if (pv->fh != INVALID_HANDLE_VALUE) {
@@ -1005,8 +2851,24 @@ void aksview_close(AKSVIEW *pv) {
   /* Only proceed if non-NULL value passed */
   if (pv != NULL) {
   
-    /* Completely unmap and view and file mapping object, which will
-     * also flush if necessary */
+    /* Write the warm-start profile while the hot pages are still
+     * resident, then release its state */
+#ifdef WARM_PREFETCH
+    if (pv->pWarmPath != NULL) {
+      warmSave(pv);
+      free(pv->pWarmPath);
+      pv->pWarmPath = NULL;
+    }
+    if (pv->pHeat != NULL) {
+      free(pv->pHeat);
+      pv->pHeat = NULL;
+      pv->nheat = 0;
+    }
+#endif
+    
+    /* Release any slurped buffer and completely unmap and view and file
+     * mapping object, which will also flush if necessary */
+    unslurp(pv);
     unmap(pv);
     
     /* If the update timestamp flag is set, update last-modified
@@ -1040,6 +2902,13 @@ void aksview_close(AKSVIEW *pv) {
 #endif
     }
     
+    /* Release any profiling state */
+    if (pv->pProf != NULL) {
+      profClose(pv->pProf);
+      free(pv->pProf);
+      pv->pProf = NULL;
+    }
+    
     /* (POSIX only) Free the path copy */
 #ifdef AKS_POSIX
     if (pv->pPathCopy != NULL) {
@@ -1113,6 +2982,8 @@ int64_t aksview_getlen(AKSVIEW *pv) {
 int aksview_setlen(AKSVIEW *pv, int64_t newlen) {
   
   int status = 1;
+  uint8_t *pBuf = NULL;
+  int64_t cap = 0;
 #ifdef AKS_POSIX
   uint8_t dummy = 0;
 #endif
@@ -1134,7 +3005,13 @@ int aksview_setlen(AKSVIEW *pv, int64_t newlen) {
   /* Only proceed if new length is actually different */
   if (newlen != pv->flen) {
   
-    /* Begin by unmapping everything and flushing if necessary */
+    /* A slurped file that grows too large goes back to being mapped */
+    if (newlen > AKSVIEW_SLURPMAX) {
+      unslurp(pv);
+    }
+    
+    /* Begin by unmapping everything and flushing if necessary; the
+     * buffer of a slurped file stays dirty and is resized below */
     unmap(pv);
     
     /* Change length of file */
@@ -1197,6 +3074,35 @@ int aksview_setlen(AKSVIEW *pv, int64_t newlen) {
       /* Set the update timestamp flag */
       pv->flags |= FLAG_UT;
       
+      /* Resize the buffer of a slurped file, moving it to a new buffer
+       * unless it is a mapping that is already large enough, and zeroing
+       * any new bytes to match the file */
+      if (pv->flags & FLAG_SL) {
+        if (newlen > 0) {
+          if (newlen > pv->scap) {
+            pBuf = slurpAlloc(pv, newlen, &cap);
+            if (pv->flen > 0) {
+              memcpy(pBuf, pv->pw,
+                (size_t) ((pv->flen < newlen) ? pv->flen : newlen));
+            }
+            slurpFree(pv->pw, pv->scap);
+            pv->pw = pBuf;
+            pv->scap = cap;
+          }
+          if (newlen > pv->flen) {
+            memset(pv->pw + pv->flen, 0, (size_t) (newlen - pv->flen));
+          }
+          pv->wfirst = 0;
+          pv->wlast = newlen - 1;
+        } else {
+          slurpFree(pv->pw, pv->scap);
+          pv->pw = NULL;
+          pv->scap = 0;
+          pv->wfirst = -1;
+          pv->wlast = -1;
+        }
+      }
+      
       /* Update the length recorded in the structure */
       pv->flen = newlen;
       
@@ -1205,60 +3111,371 @@ int aksview_setlen(AKSVIEW *pv, int64_t newlen) {
     }
   }
   
-  /* Return status */
-  return status;
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksview_reserve function.
+ */
+int aksview_reserve(AKSVIEW *pv, int64_t need) {
+  
+  int status = 1;
+  int64_t newlen = 0;
+  
+  /* Check parameters and state */
+  if ((pv == NULL) || (need < 0) || (need > AKSVIEW_MAXLEN)) {
+    fault(__LINE__);
+  }
+  if (pv->flags & FLAG_RO) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if file is not long enough */
+  if (need > pv->flen) {
+    
+    /* Start with the larger of doubling and the minimum step */
+    if (pv->flen > AKSVIEW_MINGROW) {
+      newlen = pv->flen;
+      if (newlen > AKSVIEW_MAXLEN / 2) {
+        newlen = AKSVIEW_MAXLEN;
+      } else {
+        newlen = newlen * 2;
+      }
+    } else {
+      newlen = pv->flen + AKSVIEW_MINGROW;
+    }
+    
+    /* Make sure we have at least what is needed */
+    if (newlen < need) {
+      newlen = need;
+    }
+    
+    /* Resize */
+    status = aksview_setlen(pv, newlen);
+  }
+  
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksview_refresh function.
+ */
+int aksview_refresh(AKSVIEW *pv) {
+  
+  int status = 1;
+  int64_t oldlen = 0;
+  
+  /* Check parameters and state */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if (pv->flags & FLAG_SL) {
+    fault(__LINE__);
+  }
+  
+  /* Query the current length */
+  oldlen = pv->flen;
+  if (!loadFileSize(pv)) {
+    status = 0;
+  }
+  
+  /* If the length changed, drop the window and recompute its size */
+  if (status && (pv->flen != oldlen)) {
+    unmap(pv);
+    computeWindow(pv);
+  }
+  
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksview_sethint function.
+ */
+void aksview_sethint(AKSVIEW *pv, int32_t wlen) {
+  
+  /* Check parameters */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if new hint is actually different */
+  if (wlen != pv->hint) {
+    /* Write the new hint */
+    pv->hint = wlen;
+    
+    /* Recompute the window size with the new hint, and if the window
+     * size therefore changes, unmap any view that may be mapped */
+    if (computeWindow(pv)) {
+      unview(pv);
+    }
+  }
+}
+
+/*
+ * aksview_flush function.
+ */
+void aksview_flush(AKSVIEW *pv) {
+  
+  /* Check parameters */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  
+  /* Only proceed if the viewer object is has dirty flag set AND there
+   * is currently a mapped window */
+  if ((pv->flags & FLAG_DT) && (pv->pw != NULL)) {
+    
+    /* Flush any changes out to disk, writing the whole buffer back if
+     * the file is slurped */
+    profEnter(pv, AKSVIEW_PROF_FLUSH);
+    if (pv->flags & FLAG_SL) {
+      slurpStore(pv);
+    } else {
+#ifdef AKS_WIN
+      if (!FlushViewOfFile(pv->pw, 0)) {
+        warn(__LINE__);
+      }
+#else
+      if (msync(pv->pw, (size_t) (pv->wlast - pv->wfirst + 1), MS_SYNC)) {
+        warn(__LINE__);
+      }
+#endif
+    }
+    profLeave(pv, AKSVIEW_PROF_FLUSH);
+
+    /* Invert the dirty flag to clear */
+    pv->flags ^= FLAG_DT;
+  }
+}
+
+/*
+ * aksview_lock function.
+ */
+int aksview_lock(
+    AKSVIEW * pv,
+    int64_t   pos,
+    int64_t   len,
+    int       excl,
+    int       wait) {
+  
+  int result = 1;
+#ifdef AKS_WIN
+  OVERLAPPED ov;
+  DWORD fl = 0;
+#else
+  struct flock fl;
+  int e = 0;
+#endif
+  
+  /* Check parameters */
+  if (pv == NULL) {
+    fault(__LINE__);
+  }
+  if ((pos < 0) || (len < 1) || (pos > AKSVIEW_MAXLEN - len)) {
+    fault(__LINE__);
+  }
+  if (excl && (pv->flags & FLAG_RO)) {
+    fault(__LINE__);
+  }
+  
+#ifdef AKS_WIN
+  /* Windows -- describe the range and the kind of lock */
+  memset(&ov, 0, sizeof(OVERLAPPED));
+  ov.Offset = (DWORD) (pos & INT64_C(0xffffffff));
+  ov.OffsetHigh = (DWORD) (pos >> 32);
+  
+  if (excl) {
+    fl |= LOCKFILE_EXCLUSIVE_LOCK;
+  }
+  if (!wait) {
+    fl |= LOCKFILE_FAIL_IMMEDIATELY;
+  }
+  
+  /* Take the lock, which only fails without a warning if it is held
+   * elsewhere and we are not waiting */
+  if (!LockFileEx(
+          pv->fh,
+          fl,
+          0,
+          (DWORD) (len & INT64_C(0xffffffff)),
+          (DWORD) (len >> 32),
+          &ov)) {
+    result = 0;
+    if (wait || (GetLastError() != ERROR_LOCK_VIOLATION)) {
+      warn(__LINE__);
+    }
+  }
+  
+#else
+  /* POSIX -- describe the range and the kind of lock */
+  memset(&fl, 0, sizeof(struct flock));
+  if (excl) {
+    fl.l_type = F_WRLCK;
+  } else {
+    fl.l_type = F_RDLCK;
+  }
+  fl.l_whence = SEEK_SET;
+  fl.l_start = (off_t) pos;
+  fl.l_len = (off_t) len;
+  fl.l_pid = 0;
+  
+  /* Take the lock, which only fails without a warning if it is held
+   * elsewhere and we are not waiting */
+  e = lockRange(pv, &fl, wait);
+  if (e != 0) {
+    result = 0;
+    if (wait || ((e != EAGAIN) && (e != EACCES))) {
+      warn(__LINE__);
+    }
+  }
+#endif
+  
+  /* Return result */
+  return result;
 }
 
 /*
- * aksview_sethint function.
+ * aksview_unlock function.
  */
-void aksview_sethint(AKSVIEW *pv, int32_t wlen) {
+void aksview_unlock(AKSVIEW *pv, int64_t pos, int64_t len) {
+  
+#ifdef AKS_WIN
+  OVERLAPPED ov;
+#else
+  struct flock fl;
+#endif
   
   /* Check parameters */
   if (pv == NULL) {
     fault(__LINE__);
   }
+  if ((pos < 0) || (len < 1) || (pos > AKSVIEW_MAXLEN - len)) {
+    fault(__LINE__);
+  }
   
-  /* Only proceed if new hint is actually different */
-  if (wlen != pv->hint) {
-    /* Write the new hint */
-    pv->hint = wlen;
-    
-    /* Recompute the window size with the new hint, and if the window
-     * size therefore changes, unmap any view that may be mapped */
-    if (computeWindow(pv)) {
-      unview(pv);
-    }
+#ifdef AKS_WIN
+  /* Windows -- release the range */
+  memset(&ov, 0, sizeof(OVERLAPPED));
+  ov.Offset = (DWORD) (pos & INT64_C(0xffffffff));
+  ov.OffsetHigh = (DWORD) (pos >> 32);
+  
+  if (!UnlockFileEx(
+          pv->fh,
+          0,
+          (DWORD) (len & INT64_C(0xffffffff)),
+          (DWORD) (len >> 32),
+          &ov)) {
+    warn(__LINE__);
+  }
+  
+#else
+  /* POSIX -- release the range */
+  memset(&fl, 0, sizeof(struct flock));
+  fl.l_type = F_UNLCK;
+  fl.l_whence = SEEK_SET;
+  fl.l_start = (off_t) pos;
+  fl.l_len = (off_t) len;
+  fl.l_pid = 0;
+  
+  if (lockRange(pv, &fl, 0) != 0) {
+    warn(__LINE__);
   }
+#endif
 }
 
 /*
- * aksview_flush function.
+ * aksview_profile function.
  */
-void aksview_flush(AKSVIEW *pv) {
+int aksview_profile(AKSVIEW *pv, int enable) {
+  
+  int result = 0;
+  PROF_STATE *ps = NULL;
+  int op = 0;
+  int i = 0;
   
   /* Check parameters */
   if (pv == NULL) {
     fault(__LINE__);
   }
   
-  /* Only proceed if the viewer object is has dirty flag set AND there
-   * is currently a mapped window */
-  if ((pv->flags & FLAG_DT) && (pv->pw != NULL)) {
+  if (enable) {
+    /* Allocate the profiling state if necessary, otherwise close any
+     * counters that are already open */
+    if (pv->pProf == NULL) {
+      pv->pProf = (PROF_STATE *) calloc(1, sizeof(PROF_STATE));
+      if (pv->pProf == NULL) {
+        fault(__LINE__);
+      }
+    } else {
+      profClose(pv->pProf);
+    }
+    ps = pv->pProf;
     
-    /* Flush any changes out to disk */
-#ifdef AKS_WIN
-    if (!FlushViewOfFile(pv->pw, 0)) {
-      warn(__LINE__);
+    /* Open the counters and reset the statistics */
+    profOpen(ps);
+    for(op = 0; op < AKSVIEW_PROF_OPS; op++) {
+      (ps->depth)[op] = 0;
+      (ps->calls)[op] = 0;
+      (ps->enabled)[op] = 0;
+      (ps->running)[op] = 0;
+      (ps->missed)[op] = 0;
+      for(i = 0; i < PROF_NCTR; i++) {
+        if ((ps->slot)[i] >= 0) {
+          (ps->sum)[op][i] = 0;
+        } else {
+          (ps->sum)[op][i] = -1;
+        }
+      }
     }
-#else
-    if (msync(pv->pw, (size_t) (pv->wlast - pv->wfirst + 1), MS_SYNC)) {
-      warn(__LINE__);
+    
+    if (ps->nslot > 0) {
+      result = 1;
     }
-#endif
+    
+  } else {
+    /* Close the counters but keep the statistics */
+    if (pv->pProf != NULL) {
+      profClose(pv->pProf);
+    }
+  }
+  
+  /* Return result */
+  return result;
+}
 
-    /* Invert the dirty flag to clear */
-    pv->flags ^= FLAG_DT;
+/*
+ * aksview_profstat function.
+ */
+void aksview_profstat(AKSVIEW *pv, int op, AKSVIEW_PROF *pStat) {
+  
+  PROF_STATE *ps = NULL;
+  
+  /* Check parameters */
+  if ((pv == NULL) || (pStat == NULL)) {
+    fault(__LINE__);
+  }
+  if ((op < 0) || (op >= AKSVIEW_PROF_OPS)) {
+    fault(__LINE__);
+  }
+  
+  /* Copy the statistics, which are all zero if profiling was never
+   * enabled */
+  memset(pStat, 0, sizeof(AKSVIEW_PROF));
+  ps = pv->pProf;
+  if (ps != NULL) {
+    pStat->calls = (ps->calls)[op];
+    pStat->cycles = (ps->sum)[op][0];
+    pStat->instrs = (ps->sum)[op][1];
+    pStat->llcmiss = (ps->sum)[op][2];
+    pStat->tlbmiss = (ps->sum)[op][3];
+    pStat->faults = (ps->sum)[op][4];
+    pStat->enabled = (ps->enabled)[op];
+    pStat->running = (ps->running)[op];
+    pStat->missed = (ps->missed)[op];
+    pStat->kernel = ps->kernel;
   }
 }
 
@@ -1298,9 +3515,7 @@ void aksview_write8u(AKSVIEW *pv, int64_t pos, uint8_t v) {
   mapByte(pv, pos);
   
   /* Check that not read-only */
-  if (pv->flags & FLAG_RO) {
-    fault(__LINE__);
-  }
+  checkFull(!(pv->flags & FLAG_RO));
   
   /* Set dirty and update timestamp flags */
   pv->flags |= FLAG_DT;
@@ -1318,9 +3533,7 @@ void aksview_write8s(AKSVIEW *pv, int64_t pos, int8_t v) {
   mapByte(pv, pos);
   
   /* Check that not read-only */
-  if (pv->flags & FLAG_RO) {
-    fault(__LINE__);
-  }
+  checkFull(!(pv->flags & FLAG_RO));
   
   /* Set dirty and update timestamp flags */
   pv->flags |= FLAG_DT;
@@ -1338,9 +3551,8 @@ uint16_t aksview_read16u(AKSVIEW *pv, int64_t pos, int le) {
   uint16_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1395,9 +3607,8 @@ int16_t aksview_read16s(AKSVIEW *pv, int64_t pos, int le) {
   int16_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1451,9 +3662,8 @@ void aksview_write16u(AKSVIEW *pv, int64_t pos, int le, uint16_t v) {
   uint8_t bb[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1472,9 +3682,7 @@ void aksview_write16u(AKSVIEW *pv, int64_t pos, int le, uint16_t v) {
     mapByte(pv, pos + 1);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -1513,9 +3721,8 @@ void aksview_write16s(AKSVIEW *pv, int64_t pos, int le, int16_t v) {
   uint8_t bb[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1534,9 +3741,7 @@ void aksview_write16s(AKSVIEW *pv, int64_t pos, int le, int16_t v) {
     mapByte(pv, pos + 1);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -1577,9 +3782,8 @@ uint32_t aksview_read32u(AKSVIEW *pv, int64_t pos, int le) {
   uint32_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1639,9 +3843,8 @@ int32_t aksview_read32s(AKSVIEW *pv, int64_t pos, int le) {
   int32_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1700,9 +3903,8 @@ void aksview_write32u(AKSVIEW *pv, int64_t pos, int le, uint32_t v) {
   uint16_t bw[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1721,9 +3923,7 @@ void aksview_write32u(AKSVIEW *pv, int64_t pos, int le, uint32_t v) {
     mapByte(pv, pos + 3);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -1767,9 +3967,8 @@ void aksview_write32s(AKSVIEW *pv, int64_t pos, int le, int32_t v) {
   uint16_t bw[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1788,9 +3987,7 @@ void aksview_write32s(AKSVIEW *pv, int64_t pos, int le, int32_t v) {
     mapByte(pv, pos + 3);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -1835,9 +4032,8 @@ uint64_t aksview_read64u(AKSVIEW *pv, int64_t pos, int le) {
   uint64_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1905,9 +4101,8 @@ int64_t aksview_read64s(AKSVIEW *pv, int64_t pos, int le) {
   int64_t result = 0;
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1974,9 +4169,8 @@ void aksview_write64u(AKSVIEW *pv, int64_t pos, int le, uint64_t v) {
   uint32_t bw[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -1995,9 +4189,7 @@ void aksview_write64u(AKSVIEW *pv, int64_t pos, int le, uint64_t v) {
     mapByte(pv, pos + 7);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -2049,9 +4241,8 @@ void aksview_write64s(AKSVIEW *pv, int64_t pos, int le, int64_t v) {
   uint32_t bw[2];
   
   /* Rough check of parameters */
-  if ((pos < 0) || (pos >= AKSVIEW_MAXLEN) || (pv == NULL)) {
-    fault(__LINE__);
-  }
+  checkFull(pv != NULL);
+  checkBound((pos >= 0) && (pos < AKSVIEW_MAXLEN));
   
   /* If le parameter is non-zero, replace it with FLAG_LE so we can do
    * an XOR check later */
@@ -2070,9 +4261,7 @@ void aksview_write64s(AKSVIEW *pv, int64_t pos, int le, int64_t v) {
     mapByte(pv, pos + 7);
     
     /* Check that not read-only */
-    if (pv->flags & FLAG_RO) {
-      fault(__LINE__);
-    }
+    checkFull(!(pv->flags & FLAG_RO));
     
     /* Write the bytes, flipping if platform endianness and requested
      * endianness are different */
@@ -2115,3 +4304,317 @@ void aksview_write64s(AKSVIEW *pv, int64_t pos, int le, int64_t v) {
     }
   }
 }
+
+/*
+ * aksview_readv16u function.
+ */
+void aksview_readv16u(
+    AKSVIEW *pv, int64_t pos, int le, uint16_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 2);
+}
+
+/*
+ * aksview_readv16s function.
+ */
+void aksview_readv16s(
+    AKSVIEW *pv, int64_t pos, int le, int16_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 2);
+}
+
+/*
+ * aksview_readv32u function.
+ */
+void aksview_readv32u(
+    AKSVIEW *pv, int64_t pos, int le, uint32_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_readv32s function.
+ */
+void aksview_readv32s(
+    AKSVIEW *pv, int64_t pos, int le, int32_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_readv64u function.
+ */
+void aksview_readv64u(
+    AKSVIEW *pv, int64_t pos, int le, uint64_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_readv64s function.
+ */
+void aksview_readv64s(
+    AKSVIEW *pv, int64_t pos, int le, int64_t *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_readv32f function.
+ */
+void aksview_readv32f(
+    AKSVIEW *pv, int64_t pos, int le, float *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_readv64f function.
+ */
+void aksview_readv64f(
+    AKSVIEW *pv, int64_t pos, int le, double *pa, int64_t n) {
+  bulkRead(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_writev16u function.
+ */
+void aksview_writev16u(
+    AKSVIEW *pv, int64_t pos, int le, const uint16_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 2);
+}
+
+/*
+ * aksview_writev16s function.
+ */
+void aksview_writev16s(
+    AKSVIEW *pv, int64_t pos, int le, const int16_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 2);
+}
+
+/*
+ * aksview_writev32u function.
+ */
+void aksview_writev32u(
+    AKSVIEW *pv, int64_t pos, int le, const uint32_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_writev32s function.
+ */
+void aksview_writev32s(
+    AKSVIEW *pv, int64_t pos, int le, const int32_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_writev64u function.
+ */
+void aksview_writev64u(
+    AKSVIEW *pv, int64_t pos, int le, const uint64_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_writev64s function.
+ */
+void aksview_writev64s(
+    AKSVIEW *pv, int64_t pos, int le, const int64_t *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_writev32f function.
+ */
+void aksview_writev32f(
+    AKSVIEW *pv, int64_t pos, int le, const float *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 4);
+}
+
+/*
+ * aksview_writev64f function.
+ */
+void aksview_writev64f(
+    AKSVIEW *pv, int64_t pos, int le, const double *pa, int64_t n) {
+  bulkWrite(pv, pos, le, pa, n, 8);
+}
+
+/*
+ * aksview_rspan function.
+ */
+const uint8_t *aksview_rspan(AKSVIEW *pv, int64_t pos, int32_t len) {
+  /* Map the range in the window, which also checks parameters */
+  mapRange(pv, pos, len);
+  
+  /* Return pointer into the window */
+  return &((pv->pw)[pos - pv->wfirst]);
+}
+
+/*
+ * aksview_wspan function.
+ */
+uint8_t *aksview_wspan(AKSVIEW *pv, int64_t pos, int32_t len) {
+  /* Map the range in the window, which also checks parameters */
+  mapRange(pv, pos, len);
+  
+  /* Check that not read-only */
+  checkFull(!(pv->flags & FLAG_RO));
+  
+  /* Set dirty and update timestamp flags */
+  pv->flags |= FLAG_DT;
+  pv->flags |= FLAG_UT;
+  
+  /* Return pointer into the window */
+  return &((pv->pw)[pos - pv->wfirst]);
+}
+
+/*
+ * aksview_readbuf function.
+ */
+void aksview_readbuf(AKSVIEW *pv, int64_t pos, void *pBuf, int64_t len) {
+  
+  uint8_t *pb = NULL;
+  int32_t n = 0;
+  
+  /* Check parameters */
+  checkFull((pv != NULL) && (pBuf != NULL));
+  checkBound((pos >= 0) && (len >= 0) && (pos <= pv->flen - len));
+  
+  /* Copy the range one window-sized piece at a time */
+  profEnter(pv, AKSVIEW_PROF_BULK);
+  pb = (uint8_t *) pBuf;
+  while (len > 0) {
+    n = chunkLen(pv, pos, len);
+    memcpy(pb, aksview_rspan(pv, pos, n), (size_t) n);
+    
+    pb += n;
+    pos += (int64_t) n;
+    len -= (int64_t) n;
+  }
+  profLeave(pv, AKSVIEW_PROF_BULK);
+}
+
+/*
+ * aksview_writebuf function.
+ */
+void aksview_writebuf(
+    AKSVIEW    * pv,
+    int64_t      pos,
+    const void * pBuf,
+    int64_t      len) {
+  
+  const uint8_t *pb = NULL;
+  int32_t n = 0;
+  
+  /* Check parameters */
+  checkFull((pv != NULL) && (pBuf != NULL));
+  checkBound((pos >= 0) && (len >= 0) && (pos <= pv->flen - len));
+  
+  /* Copy the range one window-sized piece at a time */
+  profEnter(pv, AKSVIEW_PROF_BULK);
+  pb = (const uint8_t *) pBuf;
+  while (len > 0) {
+    n = chunkLen(pv, pos, len);
+    memcpy(aksview_wspan(pv, pos, n), pb, (size_t) n);
+    
+    pb += n;
+    pos += (int64_t) n;
+    len -= (int64_t) n;
+  }
+  profLeave(pv, AKSVIEW_PROF_BULK);
+}
+
+/*
+ * aksview_copy function.
+ */
+void aksview_copy(
+    AKSVIEW * pDest,
+    int64_t   dpos,
+    AKSVIEW * pSrc,
+    int64_t   spos,
+    int64_t   len) {
+  
+  uint8_t *pBounce = NULL;
+  int64_t bl = 0;
+  int64_t n = 0;
+  int32_t sn = 0;
+  int32_t dn = 0;
+  
+  /* Check parameters */
+  if ((pDest == NULL) || (pSrc == NULL)) {
+    fault(__LINE__);
+  }
+  if ((dpos < 0) || (spos < 0) || (len < 0)) {
+    fault(__LINE__);
+  }
+  if ((dpos > pDest->flen - len) || (spos > pSrc->flen - len)) {
+    fault(__LINE__);
+  }
+  if (pDest->flags & FLAG_RO) {
+    fault(__LINE__);
+  }
+  
+  /* Measure the copy against the destination viewer */
+  profEnter(pDest, AKSVIEW_PROF_BULK);
+  
+  /* Different handling depending on whether copying within a single
+   * viewer */
+  if ((pDest == pSrc) && (len > 0) && (dpos != spos)) {
+    /* Only one window can be mapped at a time, so copy through a bounce
+     * buffer */
+    bl = len;
+    if (bl > AKSVIEW_COPYBUF) {
+      bl = AKSVIEW_COPYBUF;
+    }
+    pBounce = (uint8_t *) malloc((size_t) bl);
+    if (pBounce == NULL) {
+      fault(__LINE__);
+    }
+    
+    if ((dpos > spos) && (dpos < spos + len)) {
+      /* Destination overlaps the end of the source, so copy backwards
+       * from the end of the range */
+      while (len > 0) {
+        n = len;
+        if (n > bl) {
+          n = bl;
+        }
+        aksview_readbuf(pSrc, spos + len - n, pBounce, n);
+        aksview_writebuf(pDest, dpos + len - n, pBounce, n);
+        len -= n;
+      }
+      
+    } else {
+      /* Copy forwards from the start of the range */
+      while (len > 0) {
+        n = len;
+        if (n > bl) {
+          n = bl;
+        }
+        aksview_readbuf(pSrc, spos, pBounce, n);
+        aksview_writebuf(pDest, dpos, pBounce, n);
+        spos += n;
+        dpos += n;
+        len -= n;
+      }
+    }
+    
+    free(pBounce);
+    pBounce = NULL;
+    
+  } else if (pDest != pSrc) {
+    /* Different viewers, so copy directly from one mapped window to the
+     * other, one piece at a time */
+    while (len > 0) {
+      sn = chunkLen(pSrc, spos, len);
+      dn = chunkLen(pDest, dpos, len);
+      if (dn < sn) {
+        sn = dn;
+      }
+      
+      memcpy(
+        aksview_wspan(pDest, dpos, sn),
+        aksview_rspan(pSrc, spos, sn),
+        (size_t) sn);
+      
+      spos += (int64_t) sn;
+      dpos += (int64_t) sn;
+      len -= (int64_t) sn;
+    }
+  }
+  profLeave(pDest, AKSVIEW_PROF_BULK);
+}
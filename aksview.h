@@ -42,6 +42,32 @@
  */
 #define AKSVIEW_DEFAULT_HINT (INT32_C(16777216))
 
+/*
+ * The maximum length in bytes of a span.
+ * 
+ * See aksview_rspan() and aksview_wspan().
+ */
+#define AKSVIEW_MAXSPAN (INT32_C(536870912))
+
+/*
+ * The maximum size in bytes of the bounce buffer that aksview_copy()
+ * allocates when copying within a single viewer.
+ */
+#define AKSVIEW_COPYBUF (INT64_C(1048576))
+
+/*
+ * The minimum number of bytes by which aksview_reserve() grows a file.
+ */
+#define AKSVIEW_MINGROW (INT64_C(65536))
+
+/*
+ * The maximum length in bytes of a file that is read into memory when
+ * AKSVIEW_SLURP is given.
+ * 
+ * See aksview_create().
+ */
+#define AKSVIEW_SLURPMAX (INT64_C(16777216))
+
 /*
  * Structure prototype for AKSVIEW.
  * 
@@ -58,6 +84,25 @@ typedef struct AKSVIEW_TAG AKSVIEW;
 #define AKSVIEW_REGULAR   (3)
 #define AKSVIEW_EXCLUSIVE (4)
 
+/*
+ * Flag that may be combined with any of the modes for aksview_create()
+ * to read small files into memory instead of mapping them.
+ */
+#define AKSVIEW_SLURP (16)
+
+/*
+ * Flag that may be combined with any of the modes for aksview_create()
+ * to let other processes open the file for writing at the same time.
+ */
+#define AKSVIEW_SHARE (32)
+
+/*
+ * Flag that may be combined with any of the modes for aksview_create()
+ * to keep a profile of the hot parts of the file across runs, and
+ * prefetch them when the file is opened again.
+ */
+#define AKSVIEW_WARM (64)
+
 /*
  * Error code definitions.
  * 
@@ -68,6 +113,49 @@ typedef struct AKSVIEW_TAG AKSVIEW;
 #define AKSVIEW_ERR_TRANSLATE (2)
 #define AKSVIEW_ERR_OPEN      (3)
 #define AKSVIEW_ERR_LENQUERY  (4)
+#define AKSVIEW_ERR_READ      (5)
+
+/*
+ * Operation types that profiling statistics are kept for.
+ * 
+ * AKSVIEW_PROF_OPS is the number of operation types.
+ */
+#define AKSVIEW_PROF_MAP   (0)
+#define AKSVIEW_PROF_FLUSH (1)
+#define AKSVIEW_PROF_BULK  (2)
+#define AKSVIEW_PROF_OPS   (3)
+
+/*
+ * Profiling statistics for one operation type of a viewer.
+ * 
+ * calls is the number of operations that were measured.  The fields
+ * from cycles to faults are event counts summed over those operations.
+ * A count is -1 if its counter is not available on this system.
+ * 
+ * The kernel may share the counters with other users, such as a
+ * watchdog or another profiler, by running them for only part of the
+ * time.  enabled and running are the nanoseconds that the counters were
+ * enabled and actually running during the operations.  If running is
+ * less than enabled, the counts were scaled up in proportion and are
+ * estimates.  missed is the number of operations during which the
+ * counters never ran, which add nothing to the counts.
+ * 
+ * kernel is non-zero if the counts include events in the kernel, such
+ * as page fault handling and I/O, and zero if they only include events
+ * in user space.
+ */
+typedef struct {
+  int64_t calls;
+  int64_t cycles;
+  int64_t instrs;
+  int64_t llcmiss;
+  int64_t tlbmiss;
+  int64_t faults;
+  int64_t enabled;
+  int64_t running;
+  int64_t missed;
+  int kernel;
+} AKSVIEW_PROF;
 
 /*
  * Set the fault and warn handlers.
@@ -124,7 +212,8 @@ const char *aksview_errstr(int code);
  * (If you get translation errors, check that AKSView and the client
  * application are both compiled in the same mode.)
  * 
- * mode must be one of the following four:
+ * mode must be one of the following four, optionally combined with
+ * AKSVIEW_SLURP, AKSVIEW_SHARE, or AKSVIEW_WARM as described below:
  * 
  *   (1) AKSVIEW_READONLY
  *   (2) AKSVIEW_EXISTING
@@ -141,6 +230,49 @@ const char *aksview_errstr(int code);
  * new, empty file if none already exists.  (4) only creates a new,
  * empty file, and fails if the file already exists.
  * 
+ * Any of the modes may be combined with AKSVIEW_SLURP using bitwise OR.
+ * If the file is at most AKSVIEW_SLURPMAX bytes long, it is then read
+ * into a buffer with as few read calls as possible, instead of being
+ * memory mapped.  The buffer is an anonymous mapping, aligned to huge
+ * pages on Linux when it is large enough, or a malloc() block if no
+ * mapping can be made.  For small files, this is faster than setting
+ * up a mapping and taking a page fault for every page touched.  The
+ * viewer works exactly the same way, and spans point into the buffer.
+ * Changes are written back by writing the whole buffer to the file when
+ * the viewer is flushed or closed, so other processes and other viewers
+ * on the same file do not see them before then, and changes made by
+ * others after the file is read are not seen.  If the file is later
+ * made longer than AKSVIEW_SLURPMAX with aksview_setlen(), the buffer
+ * is written back and released, and the file is memory mapped from
+ * then on.  Files that are too long to begin with are mapped as usual.
+ * If the file cannot be read, the function fails with
+ * AKSVIEW_ERR_READ.
+ * 
+ * Any of the modes may also be combined with AKSVIEW_SHARE.  On
+ * Windows, writable files are otherwise opened without any sharing and
+ * read-only files are opened with read sharing only, so that no other
+ * viewer can write to a file while it is open.  AKSVIEW_SHARE opens the
+ * file with both read and write sharing, so that several viewers in
+ * different processes can write to the same file, normally coordinating
+ * with aksview_lock().  On POSIX, files are always shared and this flag
+ * has no effect.
+ * 
+ * Any of the modes may also be combined with AKSVIEW_WARM, so that the
+ * viewer keeps a warm-start profile in a file next to the viewed file,
+ * with ".warm" appended to its path.  While the viewer is open, it
+ * counts how often each megabyte of the file is mapped into the window.
+ * When the viewer is closed, the ranges of those megabytes that are
+ * still in the page cache are written to the profile, hottest first,
+ * replacing any earlier profile.  When a viewer is created with
+ * AKSVIEW_WARM and a profile exists, the ranges in it are handed to the
+ * operating system to be read ahead in the background, in profile
+ * order, and the function returns without waiting for them.  Profiles
+ * are only a hint, so a missing, damaged, or outdated profile is
+ * ignored, and failing to write one only causes a warning.  Residency
+ * is checked with mincore() on Linux, while elsewhere whole megabytes
+ * are recorded.  Prefetching uses posix_fadvise(), and on platforms
+ * without it, including Windows, this flag has no effect.
+ * 
  * perr is optionally a pointer to an integer that will receive an error
  * code.  If there is no error, AKSVIEW_ERR_NONE (0) is written.
  * Otherwise, one of the other AKSVIEW_ERR_ constants is written.  You
@@ -248,6 +380,60 @@ int64_t aksview_getlen(AKSVIEW *pv);
  */
 int aksview_setlen(AKSVIEW *pv, int64_t newlen);
 
+/*
+ * Make sure that the file opened in a viewer is at least a given
+ * length, growing it in large steps if it is not.
+ * 
+ * This is intended for files that are built by appending, where calling
+ * aksview_setlen() for each append would unmap the window every time.
+ * If the file is already at least need bytes long, nothing is done.
+ * Otherwise, the file is grown to the largest of need, double the
+ * current length, and the current length plus AKSVIEW_MINGROW, limited
+ * to AKSVIEW_MAXLEN.  The number of resizes is therefore logarithmic in
+ * the final size of the file.
+ * 
+ * Clients that grow files this way should keep track of the logical
+ * length themselves, and trim the file with aksview_setlen() when they
+ * are done.
+ * 
+ * A fault occurs if you call this on a viewer object that was opened
+ * read-only, or if need is negative or exceeds AKSVIEW_MAXLEN.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   need - the minimum length of the file in bytes
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if error
+ */
+int aksview_reserve(AKSVIEW *pv, int64_t need);
+
+/*
+ * Reload the length of the file opened in a viewer from the file
+ * system.
+ * 
+ * The length of the file is normally only queried when the viewer is
+ * created, and afterwards only changes through aksview_setlen() and
+ * aksview_reserve() on the same viewer.  Call this when another viewer,
+ * in this process or another one, may have resized the file.  If the
+ * length has changed, the window is unmapped, flushing if necessary.
+ * 
+ * A fault occurs if you call this on a viewer that holds a slurped
+ * copy of the file, since that copy would not match the new length.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the length could not be queried
+ */
+int aksview_refresh(AKSVIEW *pv);
+
 /*
  * Change the window size hint of the viewer.
  * 
@@ -303,12 +489,151 @@ void aksview_sethint(AKSVIEW *pv, int32_t wlen);
  * 
  * Viewer objects are automatically flushed before they are closed.
  * 
+ * If the file was read into memory with AKSVIEW_SLURP, the whole buffer
+ * is written to the file if anything in it has changed.
+ * 
  * Parameters:
  * 
  *   pv - the viewer object
  */
 void aksview_flush(AKSVIEW *pv);
 
+/*
+ * Lock a byte range of the file underlying a viewer.
+ * 
+ * The range of len bytes starting at file offset pos is locked.  len
+ * must be at least one, and the range must be within [0,
+ * AKSVIEW_MAXLEN], but it may extend past the end of the file.
+ * 
+ * If excl is non-zero, an exclusive lock is taken, which conflicts with
+ * every other lock on any overlapping range.  Otherwise, a shared lock
+ * is taken, which only conflicts with exclusive locks.  Exclusive locks
+ * require a writable viewer.
+ * 
+ * If wait is non-zero, the function blocks until the lock is acquired.
+ * Otherwise, it returns zero at once if a conflicting lock is held.
+ * 
+ * Locks are held by the viewer, so two viewers on the same file conflict
+ * with each other even if they are in the same process, and each thread
+ * should lock through its own viewer.  All locks held by a viewer are
+ * released when it is closed.  On POSIX, this uses open file
+ * description locks where the platform has them.  Elsewhere, it falls
+ * back to classic record locks, which are held by the whole process
+ * instead of the viewer, and which are all released when any descriptor
+ * for the file in the process is closed.  On Windows, this uses
+ * LockFileEx(), and the file should be opened with AKSVIEW_SHARE so
+ * that other processes can open it at all.
+ * 
+ * Locks are advisory.  They do not stop loads and stores, which only
+ * other processes that also take locks will respect.  Since viewers
+ * that were opened with AKSVIEW_SLURP write back the whole file, they
+ * should not be used for writing ranges under locks.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the range
+ * 
+ *   len - the length of the range in bytes
+ * 
+ *   excl - non-zero for an exclusive lock, zero for a shared lock
+ * 
+ *   wait - non-zero to block until the lock is acquired
+ * 
+ * Return:
+ * 
+ *   non-zero if the lock was acquired, zero if not
+ */
+int aksview_lock(
+    AKSVIEW * pv,
+    int64_t   pos,
+    int64_t   len,
+    int       excl,
+    int       wait);
+
+/*
+ * Release a byte range lock taken with aksview_lock().
+ * 
+ * pos and len must be exactly the range that was locked, since Windows
+ * cannot release part of a locked range.
+ * 
+ * Changes made under an exclusive lock are visible to other processes
+ * that map the same file as soon as they are made, so there is no need
+ * to flush before unlocking, unless they must also be durable.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the range
+ * 
+ *   len - the length of the range in bytes
+ */
+void aksview_unlock(AKSVIEW *pv, int64_t pos, int64_t len);
+
+/*
+ * Enable or disable profiling with hardware performance counters on a
+ * viewer.
+ * 
+ * While profiling is enabled, the counters are read before and after
+ * each operation of the following types on the viewer, and the
+ * differences are added to per-type statistics:
+ * 
+ *   (1) AKSVIEW_PROF_MAP - moving the window, including unmapping the
+ *       old window and any flush that requires
+ * 
+ *   (2) AKSVIEW_PROF_FLUSH - flushing changes to disk, whether with
+ *       aksview_flush() or when the window moves
+ * 
+ *   (3) AKSVIEW_PROF_BULK - the buffer, bulk typed, and copy functions,
+ *       including any window moves within them
+ * 
+ * The counted events are CPU cycles, instructions, last-level cache
+ * misses, data TLB misses, and page faults.  Single loads and stores
+ * are not measured, since reading the counters costs far more than
+ * they do, but the window moves that they cause are.  Page faults are
+ * taken when memory is first touched, which for single loads and stores
+ * is outside of any measured operation.
+ * 
+ * Profiling is only supported on Linux, where it uses perf_event_open().
+ * Events are only counted on the thread that enabled profiling, so the
+ * viewer should stay on that thread, and kernel events are included
+ * only if the system allows this, which aksview_profstat() reports.
+ * Counts are scaled when the counters are shared with other users, and
+ * aksview_profstat() reports how much they were.  Enabling profiling
+ * resets the statistics.  Disabling it keeps them, so that they can be
+ * read afterwards with aksview_profstat().
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   enable - non-zero to enable profiling, zero to disable it
+ * 
+ * Return:
+ * 
+ *   non-zero if profiling is enabled with at least one counter, zero if
+ *   profiling was disabled or no counter is available
+ */
+int aksview_profile(AKSVIEW *pv, int enable);
+
+/*
+ * Get the profiling statistics of a viewer for one operation type.
+ * 
+ * If profiling was never enabled on the viewer, every count is zero.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   op - one of the AKSVIEW_PROF_ operation types, except
+ *   AKSVIEW_PROF_OPS
+ * 
+ *   pStat - the structure to receive the statistics
+ */
+void aksview_profstat(AKSVIEW *pv, int op, AKSVIEW_PROF *pStat);
+
 /*
  * The load and store functions.
  * 
@@ -386,4 +711,186 @@ uint64_t aksview_read64u( AKSVIEW *pv, int64_t pos, int le);
     void aksview_write64u(AKSVIEW *pv, int64_t pos, int le, uint64_t v);
     void aksview_write64s(AKSVIEW *pv, int64_t pos, int le,  int64_t v);
 
+/*
+ * The bulk load and store functions.
+ * 
+ * These functions load or store whole arrays of integers or floating
+ * point values at consecutive positions in the file, which is much
+ * faster than calling the single-value load and store functions in a
+ * loop.  Each array is transferred with one memcpy per window, followed
+ * by an in-place byte swap of the memory array only if the requested
+ * endianness differs from the platform endianness.
+ * 
+ * pos is the file offset of the first element, and n is the number of
+ * elements, which may be zero.  All n elements must be within the
+ * boundaries of the file or a fault occurs.  pos does not need to be
+ * aligned.
+ * 
+ * le is non-zero for little endian and zero for big endian, just as for
+ * the single-value functions.
+ * 
+ * The 32f and 64f variants transfer float and double values.  These are
+ * stored in the file as their bit patterns in the requested byte order,
+ * which is IEEE 754 format on all platforms that AKSView supports.
+ * 
+ * The write functions may not be used with read-only viewer objects or
+ * a fault will occur.  Note that the write functions do not modify the
+ * memory array they are given, even if byte swapping is necessary.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first element
+ * 
+ *   le - non-zero for little endian, zero for big endian
+ * 
+ *   pa - the memory array to load into or store from
+ * 
+ *   n - the number of elements
+ */
+void aksview_readv16u(
+    AKSVIEW *pv, int64_t pos, int le, uint16_t *pa, int64_t n);
+void aksview_readv16s(
+    AKSVIEW *pv, int64_t pos, int le,  int16_t *pa, int64_t n);
+void aksview_readv32u(
+    AKSVIEW *pv, int64_t pos, int le, uint32_t *pa, int64_t n);
+void aksview_readv32s(
+    AKSVIEW *pv, int64_t pos, int le,  int32_t *pa, int64_t n);
+void aksview_readv64u(
+    AKSVIEW *pv, int64_t pos, int le, uint64_t *pa, int64_t n);
+void aksview_readv64s(
+    AKSVIEW *pv, int64_t pos, int le,  int64_t *pa, int64_t n);
+void aksview_readv32f(
+    AKSVIEW *pv, int64_t pos, int le,    float *pa, int64_t n);
+void aksview_readv64f(
+    AKSVIEW *pv, int64_t pos, int le,   double *pa, int64_t n);
+
+void aksview_writev16u(
+    AKSVIEW *pv, int64_t pos, int le, const uint16_t *pa, int64_t n);
+void aksview_writev16s(
+    AKSVIEW *pv, int64_t pos, int le, const  int16_t *pa, int64_t n);
+void aksview_writev32u(
+    AKSVIEW *pv, int64_t pos, int le, const uint32_t *pa, int64_t n);
+void aksview_writev32s(
+    AKSVIEW *pv, int64_t pos, int le, const  int32_t *pa, int64_t n);
+void aksview_writev64u(
+    AKSVIEW *pv, int64_t pos, int le, const uint64_t *pa, int64_t n);
+void aksview_writev64s(
+    AKSVIEW *pv, int64_t pos, int le, const  int64_t *pa, int64_t n);
+void aksview_writev32f(
+    AKSVIEW *pv, int64_t pos, int le, const    float *pa, int64_t n);
+void aksview_writev64f(
+    AKSVIEW *pv, int64_t pos, int le, const   double *pa, int64_t n);
+
+/*
+ * Get a pointer directly into the mapped window for a range of bytes.
+ * 
+ * This allows a range of the file to be accessed in place, without
+ * copying it into a separate buffer.  aksview_rspan() returns a
+ * read-only pointer and may be used with any viewer.  aksview_wspan()
+ * returns a writable pointer, and a fault occurs if it is used with a
+ * read-only viewer.  The whole range is considered modified by
+ * aksview_wspan(), so it will be written back on the next flush.
+ * 
+ * pos is the file offset of the first byte in the range and len is the
+ * number of bytes in the range.  len must be in range [1,
+ * AKSVIEW_MAXSPAN] and the whole range must be within the boundaries of
+ * the file, or a fault occurs.
+ * 
+ * If the range crosses a window boundary, the window is temporarily
+ * extended so that the whole range is mapped contiguously.  Spans that
+ * stay within a single window are cheaper, so larger window hints
+ * reduce the cost of spans.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to
+ * any function on the same viewer object other than aksview_getlen()
+ * and aksview_writable(), since any other call might remap the window.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first byte in the range
+ * 
+ *   len - the number of bytes in the range
+ * 
+ * Return:
+ * 
+ *   pointer to the first byte of the range in memory
+ */
+const uint8_t *aksview_rspan(AKSVIEW *pv, int64_t pos, int32_t len);
+uint8_t *aksview_wspan(AKSVIEW *pv, int64_t pos, int32_t len);
+
+/*
+ * Copy a range of bytes between the viewed file and a memory buffer.
+ * 
+ * aksview_readbuf() copies from the file into the buffer, and
+ * aksview_writebuf() copies from the buffer into the file.  A fault
+ * occurs if aksview_writebuf() is used with a read-only viewer.
+ * 
+ * pos is the file offset of the first byte in the range and len is the
+ * number of bytes in the range.  len may be zero, in which case the
+ * call does nothing.  The range must be within the boundaries of the
+ * file, or a fault occurs.  Unlike spans, there is no upper limit on
+ * len beyond the size of the file.
+ * 
+ * The copy is decomposed into one memcpy per window, so this is far
+ * more efficient than looping over the 8-bit load and store functions.
+ * 
+ * Parameters:
+ * 
+ *   pv - the viewer object
+ * 
+ *   pos - the file offset of the first byte in the range
+ * 
+ *   pBuf - the memory buffer
+ * 
+ *   len - the number of bytes to copy
+ */
+void aksview_readbuf(AKSVIEW *pv, int64_t pos, void *pBuf, int64_t len);
+void aksview_writebuf(
+    AKSVIEW    * pv,
+    int64_t      pos,
+    const void * pBuf,
+    int64_t      len);
+
+/*
+ * Copy a range of bytes from one viewed file to another.
+ * 
+ * pDest is the viewer to copy into, which must not be read-only or a
+ * fault occurs.  pSrc is the viewer to copy from.  These may be the
+ * same viewer object, in which case the copy goes through a temporary
+ * bounce buffer of at most AKSVIEW_COPYBUF bytes, and overlapping
+ * source and destination ranges are handled correctly, as with
+ * memmove().  Otherwise, data is copied directly from one mapped window
+ * to the other without any intermediate buffer.
+ * 
+ * Two different viewer objects on the same underlying file should not
+ * be used with overlapping ranges, since there is no way to detect that
+ * situation.
+ * 
+ * len is the number of bytes to copy, which may be zero.  Both the
+ * source and destination ranges must be entirely within their files,
+ * or a fault occurs.
+ * 
+ * Parameters:
+ * 
+ *   pDest - the viewer to copy into
+ * 
+ *   dpos - the file offset of the destination range
+ * 
+ *   pSrc - the viewer to copy from
+ * 
+ *   spos - the file offset of the source range
+ * 
+ *   len - the number of bytes to copy
+ */
+void aksview_copy(
+    AKSVIEW * pDest,
+    int64_t   dpos,
+    AKSVIEW * pSrc,
+    int64_t   spos,
+    int64_t   len);
+
 #endif
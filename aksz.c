@@ -0,0 +1,1799 @@
+/*
+ * aksz.c
+ * ======
+ * 
+ * Implementation of aksz.h
+ * 
+ * See the header for further information.
+ */
+
+#include "aksz.h"
+#include "akspool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Constants
+ * =========
+ */
+
+/*
+ * Magic number at the start of a compressed container.
+ * 
+ * This is stored as a little-endian 64-bit integer, so that the file
+ * begins with the ASCII string "AKSZBLK1".  It is written last when a
+ * container is finished, so that incomplete containers are rejected.
+ */
+#define Z_MAGIC (UINT64_C(0x314b4c425a534b41))
+
+/*
+ * Header layout.
+ */
+#define HDR_OFF_MAGIC (0)
+#define HDR_OFF_BLEN  (8)
+#define HDR_OFF_ULEN  (16)
+#define HDR_OFF_NBLK  (24)
+#define HDR_OFF_INDEX (32)
+#define HDR_SIZE      (48)
+
+/*
+ * Block index record layout.
+ * 
+ * There is one record for each block, giving the file offset of the
+ * stored block, its stored length, and flags.
+ */
+#define REC_OFF_POS   (0)
+#define REC_OFF_LEN   (8)
+#define REC_OFF_FLAGS (12)
+#define REC_SIZE      (16)
+
+/*
+ * Record flags.
+ */
+#define RECF_RAW (1)  /* Block is stored uncompressed */
+
+/*
+ * Codec parameters.
+ * 
+ * MIN_MATCH is the shortest match the codec encodes, MAX_DIST is the
+ * farthest back a match may start, and HASH_BITS is the size of the
+ * compressor's hash table as a power of two.
+ */
+#define MIN_MATCH (4)
+#define MAX_DIST  (65535)
+#define HASH_BITS (12)
+
+/*
+ * Cache slot states.
+ */
+#define SLOT_EMPTY   (0)  /* Slot holds no block */
+#define SLOT_READY   (1)  /* Slot holds a decompressed block */
+#define SLOT_LOADING (2)  /* Slot is being decompressed by a worker */
+
+/*
+ * Type declarations
+ * =================
+ */
+
+/*
+ * A block index entry held in memory by the writer.
+ */
+typedef struct {
+  int64_t pos;
+  int32_t len;
+  int32_t flags;
+} Z_REC;
+
+/*
+ * A block being compressed by the writer.
+ */
+typedef struct {
+
+  /*
+   * The uncompressed bytes of the block and the number of them.
+   */
+  uint8_t *pBuf;
+  int32_t nbuf;
+
+  /*
+   * The buffer that receives the compressed block, and the compressed
+   * length once compression has run.
+   */
+  uint8_t *pComp;
+  int32_t clen;
+} Z_JOB;
+
+/*
+ * A slot in the decompressed block cache.
+ */
+typedef struct {
+
+  /*
+   * The block held in this slot, or -1, and the slot state.
+   */
+  int64_t blk;
+  int state;
+
+  /*
+   * Links in the LRU list, as slot indices, or -1.
+   */
+  int32_t prev;
+  int32_t next;
+
+  /*
+   * The decompressed data buffer and the compressed input buffer, both
+   * allocated on first use.
+   */
+  uint8_t *pData;
+  uint8_t *pComp;
+
+  /*
+   * (Prefetch only) The compressed and decompressed lengths of the block
+   * being loaded, and the result of decompression.
+   */
+  int32_t clen;
+  int32_t dlen;
+  int ok;
+} Z_SLOT;
+
+/*
+ * AKSZW structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSZW_TAG {
+
+  /*
+   * The viewer on the file being written, and the logical end of the
+   * file, where the next block is written.
+   */
+  AKSVIEW *pv;
+  int64_t fend;
+
+  /*
+   * The block length, and the total number of uncompressed bytes that
+   * have been passed to the writer so far.
+   */
+  int32_t blocklen;
+  int64_t ulen;
+
+  /*
+   * The compression worker pool, or NULL to compress on the calling
+   * thread.
+   */
+  AKSPOOL *pPool;
+
+  /*
+   * The block jobs, as two groups of glen jobs each, or a single group
+   * of one job when there is no pool.
+   * 
+   * Bytes are buffered into the jobs of group cur, of which nfill are
+   * full.  When the group fills up, it is handed to the pool and the
+   * writer switches to the other group.  nbusy is the number of jobs in
+   * the other group that have been handed to the pool but not yet
+   * appended to the file.
+   */
+  Z_JOB *pJobs;
+  int32_t glen;
+  int32_t cur;
+  int32_t nfill;
+  int32_t nbusy;
+
+  /*
+   * Set once a block could not be appended, after which every later
+   * block is discarded and the container can not be finished.
+   */
+  int failed;
+
+  /*
+   * The block index, with nblk entries out of a capacity of icap.
+   */
+  Z_REC *pIdx;
+  int64_t nblk;
+  int64_t icap;
+};
+
+/*
+ * AKSZ structure.
+ * 
+ * Prototype given in header.
+ */
+struct AKSZ_TAG {
+
+  /*
+   * The viewer on the file.
+   */
+  AKSVIEW *pv;
+
+  /*
+   * The block length, the uncompressed length, the number of blocks,
+   * and the file offset of the block index.
+   */
+  int32_t blocklen;
+  int64_t ulen;
+  int64_t nblk;
+  int64_t idx;
+
+  /*
+   * The cache slots, and the LRU list, from the most recently used slot
+   * at the head to the least recently used at the tail.
+   */
+  Z_SLOT *pSlots;
+  int32_t ncache;
+  int32_t head;
+  int32_t tail;
+
+  /*
+   * For each block, the index of the cache slot holding it, or -1.
+   */
+  int32_t *pMap;
+
+  /*
+   * The prefetch worker pool, or NULL, and the number of slots that are
+   * in the SLOT_LOADING state.
+   */
+  AKSPOOL *pPool;
+  int32_t loading;
+
+  /*
+   * The buffer used for spans that cross block boundaries.
+   */
+  uint8_t *pSpan;
+  int32_t spancap;
+};
+
+/*
+ * Default fault and warn handlers
+ * ===============================
+ */
+
+static void default_fault_handler(int line) {
+  fprintf(stderr, "aksz fault line %d\n", line);
+  exit(EXIT_FAILURE);
+}
+
+static void default_warn_handler(int line) {
+  fprintf(stderr, "aksz warn line %d\n", line);
+}
+
+/*
+ * Fault and warn pointers
+ * =======================
+ */
+
+static void (*m_fpFault)(int) = &default_fault_handler;
+static void (*m_fpWarn)(int) = &default_warn_handler;
+
+/*
+ * Fault and warn macros
+ * =====================
+ */
+
+#define fault(line) m_fpFault(line)
+#define warn(line) m_fpWarn(line)
+
+/*
+ * Local data
+ * ==========
+ */
+
+/*
+ * A byte that zero-length spans can point to.
+ */
+static const uint8_t m_empty = 0;
+
+/*
+ * Local functions
+ * ===============
+ */
+
+/* Prototypes */
+static int32_t putLength(uint8_t *pDest, int32_t n);
+static void compressTask(void *pArg);
+static int storeJob(AKSZW *pw, Z_JOB *pj);
+static int drainGroup(AKSZW *pw);
+static int flushGroup(AKSZW *pw);
+static int32_t blockLen(AKSZ *pz, int64_t blk);
+static void readRecord(
+    AKSZ    * pz,
+    int64_t   blk,
+    int64_t * ppos,
+    int32_t * plen,
+    int     * praw);
+static void touchSlot(AKSZ *pz, int32_t s);
+static void allocSlot(Z_SLOT *ps, int32_t blocklen);
+static void finishPrefetch(AKSZ *pz);
+static int32_t evictSlot(AKSZ *pz, int32_t keep);
+static void decompressTask(void *pArg);
+static void prefetch(AKSZ *pz, int64_t blk, int32_t keep);
+static const uint8_t *getBlock(AKSZ *pz, int64_t blk);
+static void loadBytes(AKSZ *pz, int64_t pos, int32_t n, uint8_t *pOut);
+static uint64_t assemble(const uint8_t *pb, int32_t n, int le);
+
+/*
+ * Write an extended length field.
+ * 
+ * The codec stores lengths of 15 or more as the value 15 in a token
+ * nibble, followed by the remainder as a sequence of bytes that are
+ * added together, where every byte except the last is 255.
+ * 
+ * Parameters:
+ * 
+ *   pDest - where to write the extension bytes
+ * 
+ *   n - the remainder to encode, which is the length minus 15
+ * 
+ * Return:
+ * 
+ *   the number of bytes written
+ */
+static int32_t putLength(uint8_t *pDest, int32_t n) {
+
+  int32_t count = 0;
+
+  while (n >= 255) {
+    pDest[count] = (uint8_t) 255;
+    count++;
+    n -= 255;
+  }
+  pDest[count] = (uint8_t) n;
+  count++;
+
+  return count;
+}
+
+/*
+ * Compress the buffered bytes of a writer job.
+ * 
+ * This is run on a worker thread, or directly when the writer has no
+ * pool.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the Z_JOB to compress
+ */
+static void compressTask(void *pArg) {
+
+  Z_JOB *pj = (Z_JOB *) pArg;
+
+  pj->clen = aksz_compress(pj->pComp, pj->pBuf, pj->nbuf);
+}
+
+/*
+ * Append a compressed writer job to the file as a block.
+ * 
+ * If the job did not shrink when compressed, its uncompressed bytes
+ * are stored instead.  The job is emptied afterwards.
+ * 
+ * Once a block has failed to be appended, the writer is marked as
+ * failed and every later job is discarded, so that the blocks that are
+ * in the file are always a prefix of the data.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ *   pj - the job, which must have been compressed
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int storeJob(AKSZW *pw, Z_JOB *pj) {
+
+  int status = 1;
+  int32_t clen = 0;
+  int32_t flags = 0;
+  const uint8_t *pSrc = NULL;
+  Z_REC *pNew = NULL;
+
+  /* Check parameters */
+  if ((pw == NULL) || (pj == NULL)) {
+    fault(__LINE__);
+  }
+  if (pj->nbuf < 1) {
+    fault(__LINE__);
+  }
+
+  /* Discard the job if the writer has already failed */
+  if (pw->failed) {
+    status = 0;
+  }
+
+  /* Fall back to raw storage if nothing is gained */
+  if (status) {
+    clen = pj->clen;
+    if (clen < pj->nbuf) {
+      pSrc = pj->pComp;
+    } else {
+      pSrc = pj->pBuf;
+      clen = pj->nbuf;
+      flags = RECF_RAW;
+    }
+  }
+
+  /* Grow the index if necessary */
+  if (status && (pw->nblk >= pw->icap)) {
+    pNew = (Z_REC *) realloc(
+              pw->pIdx, ((size_t) (pw->icap * 2)) * sizeof(Z_REC));
+    if (pNew == NULL) {
+      fault(__LINE__);
+    }
+    pw->pIdx = pNew;
+    pw->icap = pw->icap * 2;
+  }
+
+  /* Append the block */
+  if (status && (pw->fend > AKSVIEW_MAXLEN - clen)) {
+    fault(__LINE__);
+  }
+  if (status) {
+    if (!aksview_reserve(pw->pv, pw->fend + clen)) {
+      status = 0;
+      pw->failed = 1;
+    }
+  }
+  if (status) {
+    aksview_writebuf(pw->pv, pw->fend, pSrc, clen);
+    (pw->pIdx)[pw->nblk].pos = pw->fend;
+    (pw->pIdx)[pw->nblk].len = clen;
+    (pw->pIdx)[pw->nblk].flags = flags;
+    (pw->nblk)++;
+    pw->fend += clen;
+  }
+
+  /* Empty the job */
+  pj->nbuf = 0;
+  pj->clen = 0;
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Wait for the group of jobs that was handed to the worker pool, and
+ * append its blocks to the file in order.
+ * 
+ * If no group is on the pool, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int drainGroup(AKSZW *pw) {
+
+  int status = 1;
+  Z_JOB *pj = NULL;
+  int32_t i = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Only proceed if a group is on the pool */
+  if (pw->nbusy > 0) {
+    akspool_wait(pw->pPool);
+
+    pj = &((pw->pJobs)[(1 - pw->cur) * pw->glen]);
+    for(i = 0; i < pw->nbusy; i++) {
+      if (!storeJob(pw, &(pj[i]))) {
+        status = 0;
+      }
+    }
+    pw->nbusy = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Compress the full jobs of the current group and append them as
+ * blocks.
+ * 
+ * Without a pool, the jobs are compressed and appended right away.
+ * With a pool, the group that was previously handed to the pool is
+ * drained first, then the current group is handed to the pool and the
+ * writer switches to buffering into the other group, so compression
+ * overlaps with buffering the next group and appending the last one.
+ * 
+ * If there are no full jobs, nothing is done.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+static int flushGroup(AKSZW *pw) {
+
+  int status = 1;
+  Z_JOB *pj = NULL;
+  int32_t i = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Only proceed if there are full jobs */
+  if (pw->nfill > 0) {
+    pj = &((pw->pJobs)[pw->cur * pw->glen]);
+
+    if (pw->pPool == NULL) {
+      /* No pool, so compress and append in place */
+      for(i = 0; i < pw->nfill; i++) {
+        compressTask(&(pj[i]));
+        if (!storeJob(pw, &(pj[i]))) {
+          status = 0;
+        }
+      }
+
+    } else {
+      /* Append the previous group, then hand over this one */
+      if (!drainGroup(pw)) {
+        status = 0;
+      }
+      for(i = 0; i < pw->nfill; i++) {
+        akspool_submit(pw->pPool, &compressTask, &(pj[i]));
+      }
+      pw->nbusy = pw->nfill;
+      pw->cur = 1 - pw->cur;
+    }
+
+    pw->nfill = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * Get the uncompressed length of a given block.
+ * 
+ * Every block is full except possibly the last one.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   blk - the block index
+ * 
+ * Return:
+ * 
+ *   the uncompressed length of the block
+ */
+static int32_t blockLen(AKSZ *pz, int64_t blk) {
+
+  int64_t result = 0;
+
+  result = pz->ulen - (blk * ((int64_t) pz->blocklen));
+  if (result > pz->blocklen) {
+    result = pz->blocklen;
+  }
+
+  return (int32_t) result;
+}
+
+/*
+ * Read and validate the index record of a block.
+ * 
+ * A fault occurs if the record is inconsistent with the file.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   blk - the block index
+ * 
+ *   ppos - receives the file offset of the stored block
+ * 
+ *   plen - receives the stored length of the block
+ * 
+ *   praw - receives non-zero if the block is stored uncompressed
+ */
+static void readRecord(
+    AKSZ    * pz,
+    int64_t   blk,
+    int64_t * ppos,
+    int32_t * plen,
+    int     * praw) {
+
+  int64_t rpos = 0;
+  int32_t dlen = 0;
+
+  rpos = pz->idx + (blk * REC_SIZE);
+  *ppos = aksview_read64s(pz->pv, rpos + REC_OFF_POS, 1);
+  *plen = aksview_read32s(pz->pv, rpos + REC_OFF_LEN, 1);
+  *praw = (int) (aksview_read32s(pz->pv, rpos + REC_OFF_FLAGS, 1)
+                  & RECF_RAW);
+
+  dlen = blockLen(pz, blk);
+  if ((*ppos < HDR_SIZE) || (*plen < 0) ||
+      (*plen > aksz_bound(dlen)) || (*ppos > pz->idx - *plen) ||
+      (*praw && (*plen != dlen))) {
+    fault(__LINE__);
+  }
+}
+
+/*
+ * Move a cache slot to the head of the LRU list.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   s - the slot index
+ */
+static void touchSlot(AKSZ *pz, int32_t s) {
+
+  Z_SLOT *pSlots = pz->pSlots;
+
+  if (pz->head != s) {
+    /* Unlink */
+    if (pSlots[s].prev >= 0) {
+      pSlots[pSlots[s].prev].next = pSlots[s].next;
+    }
+    if (pSlots[s].next >= 0) {
+      pSlots[pSlots[s].next].prev = pSlots[s].prev;
+    } else {
+      pz->tail = pSlots[s].prev;
+    }
+
+    /* Relink at head */
+    pSlots[s].prev = -1;
+    pSlots[s].next = pz->head;
+    pSlots[pz->head].prev = s;
+    pz->head = s;
+  }
+}
+
+/*
+ * Allocate the buffers of a cache slot if they have not been allocated
+ * yet.
+ * 
+ * Parameters:
+ * 
+ *   ps - the slot
+ * 
+ *   blocklen - the block length
+ */
+static void allocSlot(Z_SLOT *ps, int32_t blocklen) {
+  if (ps->pData == NULL) {
+    ps->pData = (uint8_t *) malloc((size_t) blocklen);
+    ps->pComp = (uint8_t *) malloc((size_t) aksz_bound(blocklen));
+    if ((ps->pData == NULL) || (ps->pComp == NULL)) {
+      fault(__LINE__);
+    }
+  }
+}
+
+/*
+ * Wait for all prefetches to finish and mark their slots ready.
+ * 
+ * A fault occurs if any prefetched block was corrupt.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ */
+static void finishPrefetch(AKSZ *pz) {
+
+  int32_t s = 0;
+
+  if (pz->loading > 0) {
+    akspool_wait(pz->pPool);
+    for(s = 0; s < pz->ncache; s++) {
+      if ((pz->pSlots)[s].state == SLOT_LOADING) {
+        if (!((pz->pSlots)[s].ok)) {
+          fault(__LINE__);
+        }
+        (pz->pSlots)[s].state = SLOT_READY;
+      }
+    }
+    pz->loading = 0;
+  }
+}
+
+/*
+ * Choose a cache slot to load a new block into.
+ * 
+ * The least recently used slot that is not being prefetched is chosen.
+ * If every slot is being prefetched, the prefetches are finished first.
+ * The block held in the chosen slot, if any, is removed from the cache.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   keep - a slot that must not be chosen, or -1
+ * 
+ * Return:
+ * 
+ *   the chosen slot, or -1 if the only available slot is keep
+ */
+static int32_t evictSlot(AKSZ *pz, int32_t keep) {
+
+  int32_t s = 0;
+
+  /* Search from the tail of the LRU list */
+  for(s = pz->tail; s >= 0; s = (pz->pSlots)[s].prev) {
+    if ((s != keep) && ((pz->pSlots)[s].state != SLOT_LOADING)) {
+      break;
+    }
+  }
+
+  /* If everything is loading, finish loading and search again */
+  if ((s < 0) && (pz->loading > 0)) {
+    finishPrefetch(pz);
+    for(s = pz->tail; s >= 0; s = (pz->pSlots)[s].prev) {
+      if (s != keep) {
+        break;
+      }
+    }
+  }
+
+  /* Remove the old block from the slot */
+  if (s >= 0) {
+    if ((pz->pSlots)[s].blk >= 0) {
+      (pz->pMap)[(pz->pSlots)[s].blk] = -1;
+    }
+    (pz->pSlots)[s].blk = -1;
+    (pz->pSlots)[s].state = SLOT_EMPTY;
+  }
+
+  /* Return slot or -1 */
+  return s;
+}
+
+/*
+ * Prefetch task run on a worker thread.
+ * 
+ * Parameters:
+ * 
+ *   pArg - the Z_SLOT to decompress
+ */
+static void decompressTask(void *pArg) {
+
+  Z_SLOT *ps = (Z_SLOT *) pArg;
+
+  ps->ok = aksz_decompress(ps->pData, ps->dlen, ps->pComp, ps->clen);
+}
+
+/*
+ * Queue the blocks following a given block for decompression on the
+ * worker pool.
+ * 
+ * The compressed bytes are read from the file on the calling thread,
+ * since viewer objects are not thread-safe, and only the decompression
+ * runs on the workers.  Blocks that are already cached, and blocks that
+ * are stored uncompressed, are not queued.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   blk - the block that was just loaded
+ * 
+ *   keep - the slot holding blk, which must not be evicted
+ */
+static void prefetch(AKSZ *pz, int64_t blk, int32_t keep) {
+
+  int64_t b = 0;
+  int64_t last = 0;
+  int64_t pos = 0;
+  int32_t clen = 0;
+  int raw = 0;
+  int32_t s = 0;
+  Z_SLOT *ps = NULL;
+
+  last = blk + akspool_size(pz->pPool);
+  if (last >= pz->nblk) {
+    last = pz->nblk - 1;
+  }
+
+  for(b = blk + 1; b <= last; b++) {
+    if ((pz->pMap)[b] >= 0) {
+      continue;
+    }
+    readRecord(pz, b, &pos, &clen, &raw);
+    if (raw) {
+      continue;
+    }
+
+    s = evictSlot(pz, keep);
+    if (s < 0) {
+      break;
+    }
+    ps = &((pz->pSlots)[s]);
+    allocSlot(ps, pz->blocklen);
+
+    aksview_readbuf(pz->pv, pos, ps->pComp, clen);
+    ps->clen = clen;
+    ps->dlen = blockLen(pz, b);
+    ps->ok = 0;
+    ps->blk = b;
+    ps->state = SLOT_LOADING;
+    (pz->pMap)[b] = s;
+    (pz->loading)++;
+
+    akspool_submit(pz->pPool, &decompressTask, ps);
+  }
+}
+
+/*
+ * Get the decompressed bytes of a block, loading it into the cache if
+ * necessary.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   blk - the block index
+ * 
+ * Return:
+ * 
+ *   pointer to the decompressed block
+ */
+static const uint8_t *getBlock(AKSZ *pz, int64_t blk) {
+
+  int32_t s = 0;
+  int64_t pos = 0;
+  int32_t clen = 0;
+  int raw = 0;
+  Z_SLOT *ps = NULL;
+
+  s = (pz->pMap)[blk];
+  if (s >= 0) {
+    /* Cache hit, possibly of a block still being prefetched */
+    if ((pz->pSlots)[s].state == SLOT_LOADING) {
+      finishPrefetch(pz);
+    }
+
+  } else {
+    /* Cache miss, so load the block on this thread */
+    s = evictSlot(pz, -1);
+    if (s < 0) {
+      fault(__LINE__);
+    }
+    ps = &((pz->pSlots)[s]);
+    allocSlot(ps, pz->blocklen);
+
+    readRecord(pz, blk, &pos, &clen, &raw);
+    if (raw) {
+      aksview_readbuf(pz->pv, pos, ps->pData, clen);
+    } else {
+      aksview_readbuf(pz->pv, pos, ps->pComp, clen);
+      if (!aksz_decompress(ps->pData, blockLen(pz, blk), ps->pComp, clen)) {
+        fault(__LINE__);
+      }
+    }
+    ps->blk = blk;
+    ps->state = SLOT_READY;
+    (pz->pMap)[blk] = s;
+
+    /* Queue the following blocks on the workers */
+    if (pz->pPool != NULL) {
+      prefetch(pz, blk, s);
+    }
+  }
+
+  touchSlot(pz, s);
+  return (pz->pSlots)[s].pData;
+}
+
+/*
+ * Copy a small number of uncompressed bytes into a local array.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   pos - the uncompressed offset
+ * 
+ *   n - the number of bytes, in range [1, 8]
+ * 
+ *   pOut - receives the bytes
+ */
+static void loadBytes(AKSZ *pz, int64_t pos, int32_t n, uint8_t *pOut) {
+
+  int64_t blk = 0;
+  int32_t off = 0;
+
+  if ((pos < 0) || (pos > pz->ulen - n)) {
+    fault(__LINE__);
+  }
+
+  blk = pos / pz->blocklen;
+  off = (int32_t) (pos % pz->blocklen);
+  if (off <= pz->blocklen - n) {
+    memcpy(pOut, getBlock(pz, blk) + off, (size_t) n);
+  } else {
+    aksz_readbuf(pz, pos, pOut, n);
+  }
+}
+
+/*
+ * Assemble an unsigned integer from bytes in a given byte order.
+ * 
+ * Parameters:
+ * 
+ *   pb - the bytes
+ * 
+ *   n - the number of bytes, in range [1, 8]
+ * 
+ *   le - non-zero for little endian, zero for big endian
+ * 
+ * Return:
+ * 
+ *   the assembled value
+ */
+static uint64_t assemble(const uint8_t *pb, int32_t n, int le) {
+
+  uint64_t result = 0;
+  int32_t i = 0;
+
+  for(i = 0; i < n; i++) {
+    if (le) {
+      result |= ((uint64_t) pb[i]) << (8 * i);
+    } else {
+      result = (result << 8) | ((uint64_t) pb[i]);
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Public function implementations
+ * ===============================
+ * 
+ * See the header for specifications.
+ */
+
+/*
+ * aksz_onerror function.
+ */
+void aksz_onerror(void (*fpFault)(int), void (*fpWarn)(int)) {
+  if (fpFault != NULL) {
+    m_fpFault = fpFault;
+  } else {
+    m_fpFault = &default_fault_handler;
+  }
+
+  if (fpWarn != NULL) {
+    m_fpWarn = fpWarn;
+  } else {
+    m_fpWarn = &default_warn_handler;
+  }
+}
+
+/*
+ * aksz_errstr function.
+ */
+const char *aksz_errstr(int code) {
+  const char *pResult = NULL;
+
+  switch (code) {
+    case AKSZ_ERR_NONE:
+      pResult = "No error";
+      break;
+
+    case AKSZ_ERR_OPEN:
+      pResult = "Failed to open compressed container";
+      break;
+
+    case AKSZ_ERR_FORMAT:
+      pResult = "Compressed container has invalid format";
+      break;
+
+    case AKSZ_ERR_RESIZE:
+      pResult = "Failed to resize compressed container";
+      break;
+
+    case AKSZ_ERR_THREAD:
+      pResult = "Failed to start prefetch threads";
+      break;
+
+    default:
+      pResult = "Unknown error";
+  }
+
+  return pResult;
+}
+
+/*
+ * aksz_bound function.
+ */
+int32_t aksz_bound(int32_t len) {
+  if ((len < 0) || (len > AKSZ_MAXBLOCK)) {
+    fault(__LINE__);
+  }
+  return len + (len / 255) + 16;
+}
+
+/*
+ * aksz_compress function.
+ */
+int32_t aksz_compress(uint8_t *pDest, const uint8_t *pSrc, int32_t len) {
+
+  int32_t ht[1 << HASH_BITS];
+  int32_t ip = 0;
+  int32_t anchor = 0;
+  int32_t op = 0;
+  int32_t ref = 0;
+  int32_t mlen = 0;
+  int32_t lit = 0;
+  int32_t tpos = 0;
+  uint32_t v = 0;
+  uint32_t w = 0;
+  uint32_t h = 0;
+
+  /* Check parameters */
+  if ((pDest == NULL) || ((pSrc == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSZ_MAXBLOCK)) {
+    fault(__LINE__);
+  }
+
+  /* Hash table entries are one greater than the position, zero empty */
+  memset(ht, 0, sizeof(ht));
+
+  /* Greedy parse, emitting a sequence at each match */
+  while (ip <= len - MIN_MATCH) {
+    memcpy(&v, pSrc + ip, 4);
+    h = (v * UINT32_C(2654435761)) >> (32 - HASH_BITS);
+    ref = ht[h] - 1;
+    ht[h] = ip + 1;
+
+    if (ref >= 0) {
+      memcpy(&w, pSrc + ref, 4);
+    }
+    if ((ref < 0) || (ip - ref > MAX_DIST) || (v != w)) {
+      ip++;
+      continue;
+    }
+
+    /* Extend the match as far as possible */
+    mlen = MIN_MATCH;
+    while ((ip + mlen < len) && (pSrc[ref + mlen] == pSrc[ip + mlen])) {
+      mlen++;
+    }
+
+    /* Token, literal length, literals, offset, match length */
+    lit = ip - anchor;
+    tpos = op;
+    op++;
+    pDest[tpos] = (uint8_t) (((lit < 15) ? lit : 15) << 4);
+    if (lit >= 15) {
+      op += putLength(pDest + op, lit - 15);
+    }
+    memcpy(pDest + op, pSrc + anchor, (size_t) lit);
+    op += lit;
+
+    pDest[op] = (uint8_t) ((ip - ref) & 0xff);
+    pDest[op + 1] = (uint8_t) ((ip - ref) >> 8);
+    op += 2;
+
+    if (mlen - MIN_MATCH < 15) {
+      pDest[tpos] |= (uint8_t) (mlen - MIN_MATCH);
+    } else {
+      pDest[tpos] |= (uint8_t) 15;
+      op += putLength(pDest + op, mlen - MIN_MATCH - 15);
+    }
+
+    ip += mlen;
+    anchor = ip;
+  }
+
+  /* The final sequence has only literals */
+  lit = len - anchor;
+  pDest[op] = (uint8_t) (((lit < 15) ? lit : 15) << 4);
+  op++;
+  if (lit >= 15) {
+    op += putLength(pDest + op, lit - 15);
+  }
+  if (lit > 0) {
+    memcpy(pDest + op, pSrc + anchor, (size_t) lit);
+  }
+  op += lit;
+
+  /* Return compressed length */
+  return op;
+}
+
+/*
+ * aksz_decompress function.
+ */
+int aksz_decompress(
+    uint8_t       * pDest,
+    int32_t         dlen,
+    const uint8_t * pSrc,
+    int32_t         slen) {
+
+  int status = 1;
+  int32_t ip = 0;
+  int32_t op = 0;
+  int32_t lit = 0;
+  int32_t mlen = 0;
+  int32_t dist = 0;
+  int32_t i = 0;
+  int t = 0;
+  int b = 0;
+
+  /* Check parameters */
+  if (((pDest == NULL) && (dlen > 0)) || ((pSrc == NULL) && (slen > 0))) {
+    fault(__LINE__);
+  }
+  if ((dlen < 0) || (slen < 0)) {
+    fault(__LINE__);
+  }
+
+  for(;;) {
+    /* Token */
+    if (ip >= slen) {
+      status = 0;
+      break;
+    }
+    t = pSrc[ip];
+    ip++;
+
+    /* Literal length and literals */
+    lit = t >> 4;
+    if (lit == 15) {
+      do {
+        if ((ip >= slen) || (lit > dlen)) {
+          status = 0;
+          break;
+        }
+        b = pSrc[ip];
+        ip++;
+        lit += b;
+      } while (b == 255);
+      if (!status) {
+        break;
+      }
+    }
+    if ((lit > slen - ip) || (lit > dlen - op)) {
+      status = 0;
+      break;
+    }
+    if (lit > 0) {
+      memcpy(pDest + op, pSrc + ip, (size_t) lit);
+    }
+    ip += lit;
+    op += lit;
+
+    /* The last sequence ends at the end of the input */
+    if (ip >= slen) {
+      break;
+    }
+
+    /* Offset */
+    if (slen - ip < 2) {
+      status = 0;
+      break;
+    }
+    dist = ((int32_t) pSrc[ip]) | (((int32_t) pSrc[ip + 1]) << 8);
+    ip += 2;
+    if ((dist < 1) || (dist > op)) {
+      status = 0;
+      break;
+    }
+
+    /* Match length and match */
+    mlen = t & 15;
+    if (mlen == 15) {
+      do {
+        if ((ip >= slen) || (mlen > dlen)) {
+          status = 0;
+          break;
+        }
+        b = pSrc[ip];
+        ip++;
+        mlen += b;
+      } while (b == 255);
+      if (!status) {
+        break;
+      }
+    }
+    mlen += MIN_MATCH;
+    if (mlen > dlen - op) {
+      status = 0;
+      break;
+    }
+    if (dist >= mlen) {
+      memcpy(pDest + op, pDest + op - dist, (size_t) mlen);
+    } else {
+      /* Overlapping match repeats the last dist bytes */
+      for(i = 0; i < mlen; i++) {
+        pDest[op + i] = pDest[op + i - dist];
+      }
+    }
+    op += mlen;
+  }
+
+  /* The output must be exactly the expected length */
+  if (status && (op != dlen)) {
+    status = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akszw_new function.
+ */
+AKSZW *akszw_new(const char *pPath, int32_t blocklen, int *perr) {
+  return akszw_newp(pPath, blocklen, 0, perr);
+}
+
+/*
+ * akszw_newp function.
+ */
+AKSZW *akszw_newp(
+    const char * pPath,
+    int32_t      blocklen,
+    int          nthreads,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSZW *pw = NULL;
+  int32_t njob = 0;
+  int32_t i = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+  if ((blocklen < AKSZ_MINBLOCK) || (blocklen > AKSZ_MAXBLOCK)) {
+    fault(__LINE__);
+  }
+  if ((nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSZ_ERR_NONE;
+
+  /* Allocate the writer structure and index */
+  pw = (AKSZW *) calloc(1, sizeof(AKSZW));
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+  pw->blocklen = blocklen;
+  pw->icap = 64;
+  pw->pIdx = (Z_REC *) malloc(((size_t) pw->icap) * sizeof(Z_REC));
+  if (pw->pIdx == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Allocate the jobs, two groups of one job per worker when there is a
+   * pool, or a single job otherwise */
+  if (nthreads > 0) {
+    pw->glen = (int32_t) nthreads;
+    njob = pw->glen * 2;
+  } else {
+    pw->glen = 1;
+    njob = 1;
+  }
+  pw->pJobs = (Z_JOB *) calloc((size_t) njob, sizeof(Z_JOB));
+  if (pw->pJobs == NULL) {
+    fault(__LINE__);
+  }
+  for(i = 0; i < njob; i++) {
+    (pw->pJobs)[i].pBuf = (uint8_t *) malloc((size_t) blocklen);
+    (pw->pJobs)[i].pComp = (uint8_t *) malloc(
+                              (size_t) aksz_bound(blocklen));
+    if (((pw->pJobs)[i].pBuf == NULL) || ((pw->pJobs)[i].pComp == NULL)) {
+      fault(__LINE__);
+    }
+  }
+
+  /* Start the compression workers */
+  if (nthreads > 0) {
+    pw->pPool = akspool_new(nthreads);
+    if (pw->pPool == NULL) {
+      status = 0;
+      *perr = AKSZ_ERR_THREAD;
+    }
+  }
+
+  /* Open the file, discarding any existing contents */
+  if (status) {
+    pw->pv = aksview_create(pPath, AKSVIEW_REGULAR, NULL);
+    if (pw->pv == NULL) {
+      status = 0;
+      *perr = AKSZ_ERR_OPEN;
+    }
+  }
+  if (status) {
+    if (!aksview_setlen(pw->pv, 0)) {
+      status = 0;
+      *perr = AKSZ_ERR_RESIZE;
+    }
+  }
+
+  /* Reserve the header, which is written when finished */
+  if (status) {
+    if (!aksview_reserve(pw->pv, HDR_SIZE)) {
+      status = 0;
+      *perr = AKSZ_ERR_RESIZE;
+    }
+  }
+  if (status) {
+    pw->fend = HDR_SIZE;
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksview_close(pw->pv);
+    akspool_free(pw->pPool);
+    for(i = 0; i < njob; i++) {
+      free((pw->pJobs)[i].pBuf);
+      free((pw->pJobs)[i].pComp);
+    }
+    free(pw->pJobs);
+    free(pw->pIdx);
+    free(pw);
+    pw = NULL;
+  }
+
+  /* Return writer or NULL */
+  return pw;
+}
+
+/*
+ * akszw_write function.
+ */
+int akszw_write(AKSZW *pw, const void *pData, int64_t len) {
+
+  int status = 1;
+  const uint8_t *pb = (const uint8_t *) pData;
+  Z_JOB *pj = NULL;
+  int64_t n = 0;
+
+  /* Check parameters */
+  if ((pw == NULL) || ((pData == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (pw->ulen > AKSVIEW_MAXLEN - len)) {
+    fault(__LINE__);
+  }
+
+  /* Fill jobs, compressing each group when it is full */
+  while (status && (len > 0)) {
+    pj = &((pw->pJobs)[(pw->cur * pw->glen) + pw->nfill]);
+
+    n = pw->blocklen - pj->nbuf;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(pj->pBuf + pj->nbuf, pb, (size_t) n);
+    pj->nbuf += (int32_t) n;
+    pw->ulen += n;
+    pb += n;
+    len -= n;
+
+    if (pj->nbuf >= pw->blocklen) {
+      (pw->nfill)++;
+      if (pw->nfill >= pw->glen) {
+        status = flushGroup(pw);
+      }
+    }
+  }
+
+  /* Report any earlier failure */
+  if (pw->failed) {
+    status = 0;
+  }
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * akszw_finish function.
+ */
+int akszw_finish(AKSZW *pw) {
+
+  int status = 1;
+  int64_t flen = 0;
+  int64_t rpos = 0;
+  int64_t i = 0;
+  int32_t njob = 0;
+
+  /* Check parameter */
+  if (pw == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Count any partial block as full, then write all remaining blocks in
+   * order */
+  if ((pw->pJobs)[(pw->cur * pw->glen) + pw->nfill].nbuf > 0) {
+    (pw->nfill)++;
+  }
+  if (!flushGroup(pw)) {
+    status = 0;
+  }
+  if (pw->pPool != NULL) {
+    if (!drainGroup(pw)) {
+      status = 0;
+    }
+  }
+  if (pw->failed) {
+    status = 0;
+  }
+
+  /* Size the file exactly to hold the index */
+  if (status) {
+    flen = pw->fend + (pw->nblk * REC_SIZE);
+    if (!aksview_setlen(pw->pv, flen)) {
+      status = 0;
+    }
+  }
+
+  /* Write the index, then the header, with the magic number last */
+  if (status) {
+    for(i = 0; i < pw->nblk; i++) {
+      rpos = pw->fend + (i * REC_SIZE);
+      aksview_write64s(pw->pv, rpos + REC_OFF_POS, 1, (pw->pIdx)[i].pos);
+      aksview_write32s(pw->pv, rpos + REC_OFF_LEN, 1, (pw->pIdx)[i].len);
+      aksview_write32s(pw->pv, rpos + REC_OFF_FLAGS, 1,
+                        (pw->pIdx)[i].flags);
+    }
+
+    aksview_write32s(pw->pv, HDR_OFF_BLEN, 1, pw->blocklen);
+    aksview_write64s(pw->pv, HDR_OFF_ULEN, 1, pw->ulen);
+    aksview_write64s(pw->pv, HDR_OFF_NBLK, 1, pw->nblk);
+    aksview_write64s(pw->pv, HDR_OFF_INDEX, 1, pw->fend);
+    aksview_flush(pw->pv);
+    aksview_write64u(pw->pv, HDR_OFF_MAGIC, 1, Z_MAGIC);
+  }
+
+  /* Release the writer */
+  if (pw->pPool != NULL) {
+    njob = pw->glen * 2;
+  } else {
+    njob = 1;
+  }
+  aksview_close(pw->pv);
+  akspool_free(pw->pPool);
+  for(i = 0; i < njob; i++) {
+    free((pw->pJobs)[i].pBuf);
+    free((pw->pJobs)[i].pComp);
+  }
+  free(pw->pJobs);
+  free(pw->pIdx);
+  free(pw);
+
+  /* Return status */
+  return status;
+}
+
+/*
+ * aksz_open function.
+ */
+AKSZ *aksz_open(
+    const char * pPath,
+    int32_t      cachelen,
+    int          nthreads,
+    int        * perr) {
+
+  int status = 1;
+  int dummy = 0;
+  AKSZ *pz = NULL;
+  int64_t flen = 0;
+  int64_t i = 0;
+
+  /* Check parameters */
+  if (pPath == NULL) {
+    fault(__LINE__);
+  }
+  if ((cachelen < 1) || (cachelen > AKSZ_MAXCACHE) ||
+      (nthreads < 0) || (nthreads > AKSPOOL_MAXTHREAD) ||
+      (nthreads >= cachelen)) {
+    fault(__LINE__);
+  }
+
+  /* If we weren't given an error return location, set it to dummy */
+  if (perr == NULL) {
+    perr = &dummy;
+  }
+  *perr = AKSZ_ERR_NONE;
+
+  /* Allocate the structure */
+  pz = (AKSZ *) calloc(1, sizeof(AKSZ));
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+
+  /* Open the file */
+  pz->pv = aksview_create(pPath, AKSVIEW_READONLY, NULL);
+  if (pz->pv == NULL) {
+    status = 0;
+    *perr = AKSZ_ERR_OPEN;
+  }
+
+  /* Read and check the header */
+  if (status) {
+    flen = aksview_getlen(pz->pv);
+    if (flen < HDR_SIZE) {
+      status = 0;
+    }
+  }
+  if (status) {
+    if (aksview_read64u(pz->pv, HDR_OFF_MAGIC, 1) != Z_MAGIC) {
+      status = 0;
+    }
+  }
+  if (status) {
+    pz->blocklen = aksview_read32s(pz->pv, HDR_OFF_BLEN, 1);
+    pz->ulen = aksview_read64s(pz->pv, HDR_OFF_ULEN, 1);
+    pz->nblk = aksview_read64s(pz->pv, HDR_OFF_NBLK, 1);
+    pz->idx = aksview_read64s(pz->pv, HDR_OFF_INDEX, 1);
+    if ((pz->blocklen < AKSZ_MINBLOCK) || (pz->blocklen > AKSZ_MAXBLOCK) ||
+        (pz->ulen < 0) || (pz->ulen > AKSVIEW_MAXLEN) ||
+        (pz->nblk != (pz->ulen + pz->blocklen - 1) / pz->blocklen) ||
+        (pz->idx < HDR_SIZE) || (pz->idx > flen) ||
+        (pz->nblk > (flen - pz->idx) / REC_SIZE)) {
+      status = 0;
+    }
+  }
+  if ((!status) && (*perr == AKSZ_ERR_NONE)) {
+    *perr = AKSZ_ERR_FORMAT;
+  }
+
+  /* Set up the cache */
+  if (status) {
+    pz->ncache = cachelen;
+    pz->pSlots = (Z_SLOT *) calloc((size_t) cachelen, sizeof(Z_SLOT));
+    pz->pMap = (int32_t *) malloc(
+                  ((size_t) (pz->nblk > 0 ? pz->nblk : 1)) * sizeof(int32_t));
+    if ((pz->pSlots == NULL) || (pz->pMap == NULL)) {
+      fault(__LINE__);
+    }
+    for(i = 0; i < pz->nblk; i++) {
+      (pz->pMap)[i] = -1;
+    }
+    for(i = 0; i < cachelen; i++) {
+      (pz->pSlots)[i].blk = -1;
+      (pz->pSlots)[i].state = SLOT_EMPTY;
+      (pz->pSlots)[i].prev = (int32_t) (i - 1);
+      (pz->pSlots)[i].next = (i < cachelen - 1) ? ((int32_t) (i + 1)) : -1;
+    }
+    pz->head = 0;
+    pz->tail = cachelen - 1;
+  }
+
+  /* Start the prefetch workers */
+  if (status && (nthreads > 0)) {
+    pz->pPool = akspool_new(nthreads);
+    if (pz->pPool == NULL) {
+      status = 0;
+      *perr = AKSZ_ERR_THREAD;
+    }
+  }
+
+  /* If function failed, release everything */
+  if (!status) {
+    aksz_close(pz);
+    pz = NULL;
+  }
+
+  /* Return reader or NULL */
+  return pz;
+}
+
+/*
+ * aksz_close function.
+ */
+void aksz_close(AKSZ *pz) {
+
+  int32_t s = 0;
+
+  if (pz != NULL) {
+    akspool_free(pz->pPool);
+    aksview_close(pz->pv);
+    if (pz->pSlots != NULL) {
+      for(s = 0; s < pz->ncache; s++) {
+        free((pz->pSlots)[s].pData);
+        free((pz->pSlots)[s].pComp);
+      }
+    }
+    free(pz->pSlots);
+    free(pz->pMap);
+    free(pz->pSpan);
+    free(pz);
+  }
+}
+
+/*
+ * aksz_getlen function.
+ */
+int64_t aksz_getlen(AKSZ *pz) {
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  return pz->ulen;
+}
+
+/*
+ * aksz_blocklen function.
+ */
+int32_t aksz_blocklen(AKSZ *pz) {
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  return pz->blocklen;
+}
+
+/*
+ * aksz_read8u function.
+ */
+uint8_t aksz_read8u(AKSZ *pz, int64_t pos) {
+  uint8_t b[1];
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  loadBytes(pz, pos, 1, b);
+  return b[0];
+}
+
+/*
+ * aksz_read8s function.
+ */
+int8_t aksz_read8s(AKSZ *pz, int64_t pos) {
+  return (int8_t) aksz_read8u(pz, pos);
+}
+
+/*
+ * aksz_read16u function.
+ */
+uint16_t aksz_read16u(AKSZ *pz, int64_t pos, int le) {
+  uint8_t b[2];
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  loadBytes(pz, pos, 2, b);
+  return (uint16_t) assemble(b, 2, le);
+}
+
+/*
+ * aksz_read16s function.
+ */
+int16_t aksz_read16s(AKSZ *pz, int64_t pos, int le) {
+  return (int16_t) aksz_read16u(pz, pos, le);
+}
+
+/*
+ * aksz_read32u function.
+ */
+uint32_t aksz_read32u(AKSZ *pz, int64_t pos, int le) {
+  uint8_t b[4];
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  loadBytes(pz, pos, 4, b);
+  return (uint32_t) assemble(b, 4, le);
+}
+
+/*
+ * aksz_read32s function.
+ */
+int32_t aksz_read32s(AKSZ *pz, int64_t pos, int le) {
+  return (int32_t) aksz_read32u(pz, pos, le);
+}
+
+/*
+ * aksz_read64u function.
+ */
+uint64_t aksz_read64u(AKSZ *pz, int64_t pos, int le) {
+  uint8_t b[8];
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  loadBytes(pz, pos, 8, b);
+  return assemble(b, 8, le);
+}
+
+/*
+ * aksz_read64s function.
+ */
+int64_t aksz_read64s(AKSZ *pz, int64_t pos, int le) {
+  return (int64_t) aksz_read64u(pz, pos, le);
+}
+
+/*
+ * aksz_rspan function.
+ */
+const uint8_t *aksz_rspan(AKSZ *pz, int64_t pos, int32_t len) {
+
+  const uint8_t *pResult = NULL;
+  int32_t off = 0;
+  int32_t ncap = 0;
+
+  /* Check parameters */
+  if (pz == NULL) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (len > AKSVIEW_MAXSPAN) ||
+      (pos < 0) || (pos > pz->ulen - len)) {
+    fault(__LINE__);
+  }
+
+  if (len < 1) {
+    pResult = &m_empty;
+
+  } else {
+    off = (int32_t) (pos % pz->blocklen);
+    if (off <= pz->blocklen - len) {
+      /* Span is within one block */
+      pResult = getBlock(pz, pos / pz->blocklen) + off;
+
+    } else {
+      /* Span crosses blocks, so assemble it in the span buffer */
+      if (pz->spancap < len) {
+        ncap = (pz->spancap > 0) ? pz->spancap : pz->blocklen;
+        while (ncap < len) {
+          ncap = (ncap <= AKSVIEW_MAXSPAN / 2) ? ncap * 2 : AKSVIEW_MAXSPAN;
+        }
+        free(pz->pSpan);
+        pz->pSpan = (uint8_t *) malloc((size_t) ncap);
+        if (pz->pSpan == NULL) {
+          fault(__LINE__);
+        }
+        pz->spancap = ncap;
+      }
+      aksz_readbuf(pz, pos, pz->pSpan, len);
+      pResult = pz->pSpan;
+    }
+  }
+
+  return pResult;
+}
+
+/*
+ * aksz_readbuf function.
+ */
+void aksz_readbuf(AKSZ *pz, int64_t pos, void *pBuf, int64_t len) {
+
+  uint8_t *pb = (uint8_t *) pBuf;
+  int32_t off = 0;
+  int32_t n = 0;
+
+  /* Check parameters */
+  if ((pz == NULL) || ((pBuf == NULL) && (len > 0))) {
+    fault(__LINE__);
+  }
+  if ((len < 0) || (pos < 0) || (pos > pz->ulen - len)) {
+    fault(__LINE__);
+  }
+
+  /* Copy one block at a time */
+  while (len > 0) {
+    off = (int32_t) (pos % pz->blocklen);
+    n = pz->blocklen - off;
+    if (n > len) {
+      n = (int32_t) len;
+    }
+    memcpy(pb, getBlock(pz, pos / pz->blocklen) + off, (size_t) n);
+    pb += n;
+    pos += n;
+    len -= n;
+  }
+}
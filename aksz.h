@@ -0,0 +1,420 @@
+#ifndef AKSZ_H_INCLUDED
+#define AKSZ_H_INCLUDED
+
+/*
+ * aksz.h
+ * ======
+ * 
+ * Block-compressed container files built on top of AKSView, with a
+ * read-only view over the uncompressed bytes.
+ * 
+ * See the README.md file for further information.
+ */
+
+#include "aksview.h"
+
+/*
+ * The minimum and maximum uncompressed block length in bytes.
+ */
+#define AKSZ_MINBLOCK (INT32_C(4096))
+#define AKSZ_MAXBLOCK (INT32_C(16777216))
+
+/*
+ * The maximum number of blocks held in the decompressed block cache.
+ */
+#define AKSZ_MAXCACHE (INT32_C(65536))
+
+/*
+ * Structure prototypes for AKSZ and AKSZW.
+ * 
+ * AKSZ is a reader for a compressed container, and AKSZW is a writer
+ * that builds a new container.
+ * 
+ * Definitions given in the implementation file.
+ */
+struct AKSZ_TAG;
+typedef struct AKSZ_TAG AKSZ;
+
+struct AKSZW_TAG;
+typedef struct AKSZW_TAG AKSZW;
+
+/*
+ * Error code definitions.
+ * 
+ * Use aksz_errstr() to convert these to error messages.
+ */
+#define AKSZ_ERR_NONE    (0)
+#define AKSZ_ERR_OPEN    (1)
+#define AKSZ_ERR_FORMAT  (2)
+#define AKSZ_ERR_RESIZE  (3)
+#define AKSZ_ERR_THREAD  (4)
+
+/*
+ * Set the fault and warn handlers.
+ * 
+ * Both functions take a single parameter that is the line number within
+ * the aksz.c source file.
+ * 
+ * The fault function must never return.  The warn function may return.
+ * 
+ * If you pass NULL for one or both parameters, the NULL handler will be
+ * replaced with a default handler.
+ * 
+ * The default handlers simply print a short message to stderr.  In
+ * addition, the fault handler then calls exit(EXIT_FAILURE).
+ * 
+ * CAUTION: This function is not thread-safe!
+ * 
+ * Parameters:
+ * 
+ *   fpFault - the fault handler to use, or NULL for default
+ * 
+ *   fpWarn - the warn handler to use, or NULL for default
+ */
+void aksz_onerror(void (*fpFault)(int), void (*fpWarn)(int));
+
+/*
+ * Given an error code, return an error message for it.
+ * 
+ * If AKSZ_ERR_NONE is passed, "No error" is returned.  If an
+ * unrecognized code is passed, "Unknown error" is returned.
+ * 
+ * The error message is statically allocated and should not be freed.
+ * 
+ * Parameters:
+ * 
+ *   code - the error code
+ * 
+ * Return:
+ * 
+ *   an error message for that code
+ */
+const char *aksz_errstr(int code);
+
+/*
+ * Compute the largest possible compressed size of a block.
+ * 
+ * Parameters:
+ * 
+ *   len - the uncompressed length, in range [0, AKSZ_MAXBLOCK]
+ * 
+ * Return:
+ * 
+ *   the largest number of bytes aksz_compress() may write
+ */
+int32_t aksz_bound(int32_t len);
+
+/*
+ * Compress a buffer with the built-in LZ codec.
+ * 
+ * The codec is a byte-oriented LZ77 variant with a 64 kilobyte window,
+ * in the same family as LZ4.  It favours decompression speed over
+ * compression ratio.
+ * 
+ * pDest must have room for aksz_bound(len) bytes.
+ * 
+ * Parameters:
+ * 
+ *   pDest - the buffer to receive the compressed data
+ * 
+ *   pSrc - the data to compress
+ * 
+ *   len - the number of bytes to compress, in range [0, AKSZ_MAXBLOCK]
+ * 
+ * Return:
+ * 
+ *   the number of compressed bytes written
+ */
+int32_t aksz_compress(uint8_t *pDest, const uint8_t *pSrc, int32_t len);
+
+/*
+ * Decompress a buffer compressed with aksz_compress().
+ * 
+ * Decompression is fully bounds-checked, so corrupt input can never
+ * read or write outside the given buffers.
+ * 
+ * Parameters:
+ * 
+ *   pDest - the buffer to receive the decompressed data
+ * 
+ *   dlen - the expected decompressed length
+ * 
+ *   pSrc - the compressed data
+ * 
+ *   slen - the number of compressed bytes
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the input is corrupt or does not
+ *   decompress to exactly dlen bytes
+ */
+int aksz_decompress(
+    uint8_t       * pDest,
+    int32_t         dlen,
+    const uint8_t * pSrc,
+    int32_t         slen);
+
+/*
+ * Create a new compressed container.
+ * 
+ * The file at pPath is created, or truncated if it already exists.
+ * 
+ * blocklen is the uncompressed length of each block, in range
+ * [AKSZ_MINBLOCK, AKSZ_MAXBLOCK].  Larger blocks compress better, while
+ * smaller blocks make random access cheaper, since a whole block must
+ * be decompressed to read any byte within it.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for aksview_create().  The error codes are
+ * the AKSZ_ERR_ constants.
+ * 
+ * The writer must eventually be passed to akszw_finish().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the container file
+ * 
+ *   blocklen - the uncompressed block length
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new writer, or NULL if the function failed
+ */
+AKSZW *akszw_new(const char *pPath, int32_t blocklen, int *perr);
+
+/*
+ * Create a new compressed container that is compressed in parallel.
+ * 
+ * This works like akszw_new(), except that blocks are compressed on a
+ * pool of nthreads worker threads, so that writing scales with the
+ * number of cores.  nthreads must be in range [0, AKSPOOL_MAXTHREAD],
+ * and zero is the same as akszw_new().
+ * 
+ * Bytes are buffered into groups of nthreads blocks.  When a group is
+ * full, it is handed to the workers, and the writer starts buffering
+ * the next group.  The blocks of each group are appended to the file in
+ * order once the following group is full, so compression overlaps with
+ * both buffering and appending.  The writer holds two groups, using
+ * about four times nthreads times the block length bytes of memory.
+ * 
+ * The file format is exactly the same as for akszw_new(), so the result
+ * can be read with aksz_open().  AKSZ_ERR_THREAD is reported if the
+ * worker threads could not be started.
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the container file
+ * 
+ *   blocklen - the uncompressed block length
+ * 
+ *   nthreads - the number of compression threads, or zero
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new writer, or NULL if the function failed
+ */
+AKSZW *akszw_newp(
+    const char * pPath,
+    int32_t      blocklen,
+    int          nthreads,
+    int        * perr);
+
+/*
+ * Append bytes to a compressed container.
+ * 
+ * The bytes are buffered, and each time a full block is buffered it is
+ * compressed and appended to the file, or for writers made with
+ * akszw_newp(), each time a full group of blocks is buffered it is
+ * handed to the workers.  Blocks that do not shrink when compressed are
+ * stored uncompressed.
+ * 
+ * Once a block could not be appended, every later call fails, and so
+ * does akszw_finish().
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ *   pData - the bytes to append
+ * 
+ *   len - the number of bytes, zero or greater
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be enlarged
+ */
+int akszw_write(AKSZW *pw, const void *pData, int64_t len);
+
+/*
+ * Finish a compressed container and release the writer.
+ * 
+ * Any partial final block is written, followed by the block offset
+ * index, and then the header.
+ * 
+ * The writer is released whether or not the function succeeds.
+ * 
+ * Parameters:
+ * 
+ *   pw - the writer
+ * 
+ * Return:
+ * 
+ *   non-zero if successful, zero if the file could not be written
+ */
+int akszw_finish(AKSZW *pw);
+
+/*
+ * Open a compressed container for reading.
+ * 
+ * cachelen is the number of decompressed blocks that are held in an
+ * LRU cache, in range [1, AKSZ_MAXCACHE].  The cache uses about two
+ * times cachelen times the block length bytes of memory.
+ * 
+ * nthreads is the number of background threads used to prefetch blocks,
+ * or zero to disable prefetching.  When prefetching is enabled, each
+ * cache miss also queues the next nthreads blocks for decompression on
+ * the background threads, so sequential scans decompress in parallel.
+ * cachelen must be greater than nthreads.
+ * 
+ * perr is optionally a pointer to an integer that will receive an error
+ * code, in the same way as for akszw_new().
+ * 
+ * Parameters:
+ * 
+ *   pPath - path to the container file
+ * 
+ *   cachelen - the number of blocks to cache
+ * 
+ *   nthreads - the number of prefetch threads, or zero
+ * 
+ *   perr - pointer to error code variable or NULL
+ * 
+ * Return:
+ * 
+ *   a new reader, or NULL if the function failed
+ */
+AKSZ *aksz_open(
+    const char * pPath,
+    int32_t      cachelen,
+    int          nthreads,
+    int        * perr);
+
+/*
+ * Close a compressed container.
+ * 
+ * If NULL is passed, nothing is done.  Any prefetches in progress are
+ * completed before the reader is released.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader, or NULL
+ */
+void aksz_close(AKSZ *pz);
+
+/*
+ * Get the uncompressed length of a container in bytes.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ * Return:
+ * 
+ *   the uncompressed length
+ */
+int64_t aksz_getlen(AKSZ *pz);
+
+/*
+ * Get the uncompressed block length of a container in bytes.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ * Return:
+ * 
+ *   the block length
+ */
+int32_t aksz_blocklen(AKSZ *pz);
+
+/*
+ * The load functions.
+ * 
+ * These work exactly like the corresponding aksview_ load functions,
+ * except that pos is an offset in the uncompressed bytes.  A fault
+ * occurs if the value is not within the uncompressed length, or if a
+ * block is found to be corrupt.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   pos - the uncompressed offset to read at
+ * 
+ *   le - (16-bit, 32-bit, 64-bit functions only) non-zero for little
+ *   endian, zero for big endian
+ * 
+ * Return:
+ * 
+ *   the value that was loaded
+ */
+ uint8_t aksz_read8u( AKSZ *pz, int64_t pos);
+  int8_t aksz_read8s( AKSZ *pz, int64_t pos);
+uint16_t aksz_read16u(AKSZ *pz, int64_t pos, int le);
+ int16_t aksz_read16s(AKSZ *pz, int64_t pos, int le);
+uint32_t aksz_read32u(AKSZ *pz, int64_t pos, int le);
+ int32_t aksz_read32s(AKSZ *pz, int64_t pos, int le);
+uint64_t aksz_read64u(AKSZ *pz, int64_t pos, int le);
+ int64_t aksz_read64s(AKSZ *pz, int64_t pos, int le);
+
+/*
+ * Get a read-only span of uncompressed bytes.
+ * 
+ * This works like aksview_rspan(), except that pos is an offset in the
+ * uncompressed bytes.  If the range lies within a single block, the
+ * returned pointer points directly into the cached block.  Otherwise,
+ * the range is assembled into a buffer owned by the reader.
+ * 
+ * len must be in range [0, AKSVIEW_MAXSPAN], and the whole range must be
+ * within the uncompressed length, or a fault occurs.
+ * 
+ * CAUTION: The returned pointer is only valid until the next call to any
+ * function on the same reader.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   pos - the uncompressed offset of the span
+ * 
+ *   len - the length of the span in bytes
+ * 
+ * Return:
+ * 
+ *   pointer to the span
+ */
+const uint8_t *aksz_rspan(AKSZ *pz, int64_t pos, int32_t len);
+
+/*
+ * Copy uncompressed bytes into memory.
+ * 
+ * This works like aksview_readbuf(), except that pos is an offset in the
+ * uncompressed bytes.
+ * 
+ * Parameters:
+ * 
+ *   pz - the reader
+ * 
+ *   pos - the uncompressed offset to copy from
+ * 
+ *   pBuf - the buffer to receive the bytes
+ * 
+ *   len - the number of bytes to copy, zero or greater
+ */
+void aksz_readbuf(AKSZ *pz, int64_t pos, void *pBuf, int64_t len);
+
+#endif